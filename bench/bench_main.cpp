@@ -0,0 +1,405 @@
+#include "benchmark.h"
+#include "benchmark_compare.h"
+#include "change_capture.h"
+#include "csv_writer.h"
+#include "database.h"
+#include "psv_parser.h"
+#include "query_engine.h"
+#include "string_compression.h"
+#include "transformation_engine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kRowsPerScale = 100000;
+constexpr size_t kDepartmentCount = 100;
+
+const std::vector<std::string> kEmployeeHeaders = {
+    "emp_id", "name", "position", "hire_date", "salary", "department", "dept_id", "notes"
+};
+
+const char* const kFirstNames[] = {"John", "Jane", "Bob", "Alice", "Charlie", "Diana", "Frank", "Grace"};
+const char* const kLastNames[] = {"Smith", "Johnson", "Brown", "Garcia", "Miller", "Davis", "Wilson", "Moore"};
+const char* const kPositions[] = {"Software Engineer", "Data Analyst", "Manager", "Designer", "Accountant"};
+const char* const kDepartments[] = {"Engineering", "Analytics", "Management", "Design", "Finance"};
+
+// Deterministic employee table; every 16th note needs CSV quoting
+std::unique_ptr<PsvTable> make_employees(const std::string& name, size_t rows, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    auto table = std::make_unique<PsvTable>();
+    table->name = name;
+    table->headers = kEmployeeHeaders;
+    table->records.reserve(rows);
+
+    for (size_t i = 0; i < rows; ++i) {
+        PsvRecord record;
+        record.fields = {
+            std::to_string(100000 + i),
+            std::string(kFirstNames[rng() % 8]) + " " + kLastNames[rng() % 8],
+            kPositions[rng() % 5],
+            "20" + std::to_string(10 + rng() % 14) + "-0" + std::to_string(1 + rng() % 9) + "-15",
+            std::to_string(40000 + rng() % 110000),
+            kDepartments[rng() % 5],
+            std::to_string(rng() % kDepartmentCount),
+            i % 16 == 0 ? "Transferred, see \"HR-" + std::to_string(i) + "\"" : "Regular employee"
+        };
+        table->records.push_back(std::move(record));
+    }
+    table->build_header_index();
+    return table;
+}
+
+std::unique_ptr<PsvTable> make_departments() {
+    auto table = std::make_unique<PsvTable>();
+    table->name = "departments";
+    table->headers = {"dept_id", "dept_name", "budget", "location"};
+    for (size_t i = 0; i < kDepartmentCount; ++i) {
+        table->records.push_back({{std::to_string(i), "Department " + std::to_string(i),
+                                   std::to_string(100000 + i * 2500), i % 2 ? "Building A" : "Building B"}});
+    }
+    table->build_header_index();
+    return table;
+}
+
+std::string join_fields(const std::vector<std::string>& fields) {
+    std::string line;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i > 0) line.push_back('|');
+        line.append(fields[i]);
+    }
+    return line;
+}
+
+void write_text_file(const std::filesystem::path& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+}
+
+// A fresh directory under the system temp directory, so concurrent bench runs
+// (such as the CTest regression gate next to a manual run) keep their files apart
+std::filesystem::path make_work_dir() {
+    std::random_device random;
+    for (;;) {
+        std::ostringstream name;
+        name << "agile-pasta-bench-" << std::hex << std::chrono::steady_clock::now().time_since_epoch().count()
+             << '-' << random();
+        auto path = std::filesystem::temp_directory_path() / name.str();
+        if (std::filesystem::create_directory(path)) {
+            return path;
+        }
+    }
+}
+
+void print_usage() {
+    std::cout << "Usage: agile-pasta-bench [--scale <n>] [--reps <n>] [--warmup <n>]\n"
+              << "                         [--filter <substring>] [--json <file>]\n"
+              << "       agile-pasta-bench compare <baseline.json> <current.json>\n"
+              << "                         [--threshold <fraction>] [--alpha <p>]\n"
+              << "\n"
+              << "  --scale <n>      Data size: n x " << kRowsPerScale << " employee rows (default 1, fractions allowed)\n"
+              << "  --reps <n>       Timed repetitions per case (default 10)\n"
+              << "  --warmup <n>     Untimed repetitions before timing (default 2)\n"
+              << "  --filter <text>  Only run cases whose name contains text\n"
+              << "  --json <file>    Write results (median, p95, samples) as JSON\n"
+              << "\n"
+              << "compare exits with status 1 when a case's median throughput drops by more than\n"
+              << "--threshold (default 0.05) and a one-sided Mann-Whitney test on the repetitions\n"
+              << "gives p < --alpha (default 0.05). Use at least 4 repetitions per run.\n";
+}
+
+int run_compare(int argc, char* argv[]) {
+    if (argc < 4) {
+        print_usage();
+        return 2;
+    }
+
+    CompareOptions options;
+    try {
+        for (int i = 4; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threshold" && i + 1 < argc) {
+                options.threshold = std::stod(argv[++i]);
+            } else if (arg == "--alpha" && i + 1 < argc) {
+                options.alpha = std::stod(argv[++i]);
+            } else {
+                print_usage();
+                return 2;
+            }
+        }
+    } catch (const std::exception&) {
+        print_usage();
+        return 2;
+    }
+
+    BenchmarkReport baseline;
+    BenchmarkReport current;
+    std::string error;
+    if (!BenchmarkComparator::load_report(argv[2], baseline, error) ||
+        !BenchmarkComparator::load_report(argv[3], current, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 2;
+    }
+    if (baseline.scale != current.scale) {
+        std::cerr << "Error: baseline scale " << baseline.scale << " does not match current scale "
+                  << current.scale << std::endl;
+        return 2;
+    }
+
+    auto comparisons = BenchmarkComparator::compare(baseline, current, options);
+    size_t regressions = 0;
+
+    std::printf("%-28s %14s %14s %9s %9s  %s\n", "case", "baseline", "current", "change", "p", "verdict");
+    for (const auto& comparison : comparisons) {
+        if (comparison.verdict == CaseComparison::Verdict::MISSING) {
+            std::printf("%-28s %11.3f ms %14s %9s %9s  %s\n", comparison.name.c_str(),
+                        comparison.baseline_median_ns / 1e6, "-", "-", "-",
+                        BenchmarkComparator::verdict_name(comparison.verdict));
+            continue;
+        }
+        double p_value = comparison.throughput_change < 0.0 ? comparison.p_slower : comparison.p_faster;
+        std::printf("%-28s %11.3f ms %11.3f ms %+8.1f%% %9.4f  %s\n", comparison.name.c_str(),
+                    comparison.baseline_median_ns / 1e6, comparison.current_median_ns / 1e6,
+                    comparison.throughput_change * 100.0, p_value,
+                    BenchmarkComparator::verdict_name(comparison.verdict));
+        if (comparison.verdict == CaseComparison::Verdict::REGRESSED) {
+            regressions++;
+        }
+    }
+
+    if (regressions > 0) {
+        std::cout << regressions << " case(s) regressed by more than " << options.threshold * 100.0
+                  << "% throughput" << std::endl;
+        return 1;
+    }
+    std::cout << "No throughput regressions" << std::endl;
+    return 0;
+}
+
+void run_benchmarks(BenchmarkRunner& runner, size_t rows, const std::filesystem::path& work_dir) {
+    auto employees = make_employees("employees", rows, 42);
+
+    // Parser
+    std::vector<std::string> lines;
+    uint64_t line_bytes = 0;
+    lines.reserve(rows);
+    for (const auto& record : employees->records) {
+        lines.push_back(join_fields(record.fields));
+        line_bytes += lines.back().size() + 1;
+    }
+
+    runner.run("psv/split_psv_line", lines.size(), line_bytes, [&]() {
+        uint64_t fields = 0;
+        for (const auto& line : lines) {
+            fields += PsvParser::split_psv_line(line).size();
+        }
+        benchmark_consume(fields);
+    });
+
+    if (runner.selected("psv/parse_data")) {
+        auto data_path = work_dir / "employees.psv";
+        std::string content;
+        content.reserve(line_bytes);
+        for (const auto& line : lines) {
+            content.append(line).push_back('\n');
+        }
+        write_text_file(data_path, content);
+
+        runner.run("psv/parse_data", lines.size(), content.size(), [&]() {
+            size_t total_records = 0;
+            benchmark_consume(PsvParser::parse_data(data_path, total_records).size());
+        });
+    }
+
+    // CSV output
+    uint64_t field_count = 0;
+    uint64_t field_bytes = 0;
+    for (const auto& record : employees->records) {
+        field_count += record.fields.size();
+        for (const auto& field : record.fields) field_bytes += field.size();
+    }
+
+    runner.run("csv/escape_csv_field", field_count, field_bytes, [&]() {
+        uint64_t escaped_bytes = 0;
+        for (const auto& record : employees->records) {
+            for (const auto& field : record.fields) {
+                escaped_bytes += CsvWriter::escape_csv_field(field).size();
+            }
+        }
+        benchmark_consume(escaped_bytes);
+    });
+
+    // String compression of loaded tables
+    runner.run("strings/compress_table", rows, field_bytes, [&]() {
+        benchmark_consume(CompressedTable::compress(*employees)->bytes());
+    });
+
+    if (runner.selected("strings/decompress_table")) {
+        auto compressed = CompressedTable::compress(*employees);
+        runner.run("strings/decompress_table", rows, field_bytes, [&]() {
+            benchmark_consume(compressed->decompress()->records.size());
+        });
+    }
+
+    // Change capture: load the last run's fingerprints and classify every row
+    if (runner.selected("diff/classify_rows")) {
+        auto fingerprints = work_dir / "bench_Fingerprints.apfp";
+        {
+            ChangeCapture previous(fingerprints, employees->headers, {"emp_id"});
+            for (const auto& record : employees->records) {
+                previous.classify(record.fields);
+            }
+            previous.save();
+        }
+        std::vector<std::vector<std::string>> result_rows;
+        for (const auto& record : employees->records) {
+            result_rows.push_back(record.fields);
+        }
+        runner.run("diff/classify_rows", rows, field_bytes, [&]() {
+            ChangeCapture capture(fingerprints, employees->headers, {"emp_id"});
+            std::string operations;
+            capture.classify(result_rows, operations);
+            benchmark_consume(capture.deleted_rows().size() + capture.counts().unchanged);
+        });
+    }
+
+    // Query engine
+    Database database;
+    database.load_table(make_employees("employees", rows, 42));
+    database.load_table(make_employees("contractors", rows / 2, 7));
+    database.load_table(make_employees("employees_sample", std::max<size_t>(1, rows / 10), 42));
+    database.load_table(make_departments());
+    QueryEngine query_engine(database);
+
+    runner.run("query/select_where", rows, 0, [&]() {
+        benchmark_consume(query_engine.select_where("employees", {"emp_id", "name", "salary"},
+                                                    "salary >= '75000'")->rows.size());
+    });
+
+    // Hash join: sample of employees against every department
+    runner.run("query/join", std::max<size_t>(1, rows / 10), 0, [&]() {
+        benchmark_consume(query_engine.join("employees_sample", "departments", "dept_id = dept_id")->rows.size());
+    });
+
+    // The same join with its hash table over budget, partitioned to disk
+    if (runner.selected("query/join_spilled")) {
+        QueryEngine spilling_engine(database);
+        spilling_engine.set_join_memory_budget(HashJoin::hash_table_bytes(kDepartmentCount) / 4, work_dir);
+        runner.run("query/join_spilled", std::max<size_t>(1, rows / 10), 0, [&]() {
+            benchmark_consume(spilling_engine.join("employees_sample", "departments", "dept_id = dept_id")->rows.size());
+        });
+    }
+
+    runner.run("query/union_tables", rows + rows / 2, 0, [&]() {
+        benchmark_consume(query_engine.union_tables({"employees", "contractors"})->rows.size());
+    });
+
+    // End-to-end transformation of one configuration
+    if (runner.selected("transform/transform_data")) {
+        auto headers_path = work_dir / "bench_report_Headers.psv";
+        auto rules_path = work_dir / "bench_report_Rules.psv";
+        write_text_file(headers_path, "employee_name|annual_salary|department_name|position\n");
+        write_text_file(rules_path,
+                        "GLOBAL|salary >= '75000'|High earners only\n"
+                        "FIELD|employee_name|UPPER(name)|Uppercase names\n"
+                        "FIELD|annual_salary|salary|Copy salary\n"
+                        "FIELD|department_name|LOWER(department)|Lowercase department\n");
+
+        Database transform_database;
+        transform_database.load_table(make_employees("employees", rows, 42));
+        QueryEngine transform_query(transform_database);
+        TransformationEngine engine(transform_database, transform_query);
+        engine.load_output_headers(headers_path);
+        engine.load_rules(rules_path);
+
+        runner.run("transform/transform_data", rows, 0, [&]() {
+            benchmark_consume(engine.transform_data()->rows.size());
+        });
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "compare") {
+        return run_compare(argc, argv);
+    }
+
+    BenchmarkOptions options;
+    double scale = 1.0;
+    std::string json_path;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                print_usage();
+                return 0;
+            } else if (arg == "--scale" && i + 1 < argc) {
+                scale = std::stod(argv[++i]);
+            } else if (arg == "--reps" && i + 1 < argc) {
+                options.repetitions = std::stoul(argv[++i]);
+            } else if (arg == "--warmup" && i + 1 < argc) {
+                options.warmup = std::stoul(argv[++i]);
+            } else if (arg == "--filter" && i + 1 < argc) {
+                options.filter = argv[++i];
+            } else if (arg == "--json" && i + 1 < argc) {
+                json_path = argv[++i];
+            } else {
+                print_usage();
+                return 1;
+            }
+        }
+    } catch (const std::exception&) {
+        print_usage();
+        return 1;
+    }
+
+    if (scale <= 0.0) {
+        std::cerr << "Error: --scale must be positive" << std::endl;
+        return 1;
+    }
+
+    size_t rows = std::max<size_t>(1, static_cast<size_t>(scale * kRowsPerScale));
+    std::filesystem::path work_dir;
+    try {
+        work_dir = make_work_dir();
+    } catch (const std::exception& e) {
+        std::cerr << "Cannot create benchmark directory: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "agile-pasta-bench: " << rows << " employee rows, "
+              << options.repetitions << " repetitions after " << options.warmup << " warmup" << std::endl;
+
+    BenchmarkRunner runner(options);
+    try {
+        run_benchmarks(runner, rows, work_dir);
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        std::filesystem::remove_all(work_dir);
+        return 1;
+    }
+    std::filesystem::remove_all(work_dir);
+
+    if (!json_path.empty()) {
+        std::ofstream file(json_path, std::ios::binary);
+        file << runner.to_json(scale);
+        if (!file.good()) {
+            std::cerr << "Failed to write benchmark results: " << json_path << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to: " << json_path << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+std::atomic<uint64_t> g_sink{0};
+
+void append_number(std::string& out, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.1f", value);
+    out.append(buffer);
+}
+
+std::string format_duration(double ns) {
+    char buffer[32];
+    if (ns >= 1e9) {
+        std::snprintf(buffer, sizeof(buffer), "%.3f s", ns / 1e9);
+    } else if (ns >= 1e6) {
+        std::snprintf(buffer, sizeof(buffer), "%.3f ms", ns / 1e6);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.3f us", ns / 1e3);
+    }
+    return buffer;
+}
+
+} // namespace
+
+void benchmark_consume(uint64_t value) {
+    g_sink.fetch_add(value, std::memory_order_relaxed);
+}
+
+double BenchmarkResult::median_ns() const {
+    return BenchmarkRunner::quantile(samples_ns, 0.5);
+}
+
+double BenchmarkResult::p95_ns() const {
+    return BenchmarkRunner::quantile(samples_ns, 0.95);
+}
+
+double BenchmarkResult::mean_ns() const {
+    if (samples_ns.empty()) return 0.0;
+    return std::accumulate(samples_ns.begin(), samples_ns.end(), 0.0) / samples_ns.size();
+}
+
+double BenchmarkResult::min_ns() const {
+    if (samples_ns.empty()) return 0.0;
+    return *std::min_element(samples_ns.begin(), samples_ns.end());
+}
+
+double BenchmarkResult::items_per_second() const {
+    double median = median_ns();
+    return median > 0.0 ? static_cast<double>(items) * 1e9 / median : 0.0;
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options) : options_(options) {
+    options_.repetitions = std::max<size_t>(1, options_.repetitions);
+}
+
+bool BenchmarkRunner::selected(const std::string& name) const {
+    return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+}
+
+const BenchmarkResult* BenchmarkRunner::run(const std::string& name, uint64_t items, uint64_t bytes,
+                                            const std::function<void()>& body) {
+    if (!selected(name)) {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < options_.warmup; ++i) {
+        body();
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.items = items;
+    result.bytes = bytes;
+    result.samples_ns.reserve(options_.repetitions);
+
+    for (size_t i = 0; i < options_.repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        result.samples_ns.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    char throughput[64];
+    std::snprintf(throughput, sizeof(throughput), "%.0f items/s", result.items_per_second());
+    std::cout << "  " << name << ": median " << format_duration(result.median_ns())
+              << ", p95 " << format_duration(result.p95_ns())
+              << ", " << throughput << std::endl;
+
+    results_.push_back(std::move(result));
+    return &results_.back();
+}
+
+std::string BenchmarkRunner::to_json(double scale) const {
+    char scale_text[32];
+    std::snprintf(scale_text, sizeof(scale_text), "%g", scale);
+    std::string out = "{\n  \"version\": 1,\n  \"scale\": ";
+    out.append(scale_text);
+    out.append(",\n  \"warmup\": ").append(std::to_string(options_.warmup));
+    out.append(",\n  \"repetitions\": ").append(std::to_string(options_.repetitions));
+    out.append(",\n  \"results\": [");
+
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const BenchmarkResult& result = results_[i];
+        out.append(i == 0 ? "\n    " : ",\n    ");
+        out.append("{\"name\": \"").append(result.name).append("\"");
+        out.append(", \"items\": ").append(std::to_string(result.items));
+        out.append(", \"bytes\": ").append(std::to_string(result.bytes));
+        out.append(", \"median_ns\": ");
+        append_number(out, result.median_ns());
+        out.append(", \"p95_ns\": ");
+        append_number(out, result.p95_ns());
+        out.append(", \"mean_ns\": ");
+        append_number(out, result.mean_ns());
+        out.append(", \"min_ns\": ");
+        append_number(out, result.min_ns());
+        out.append(", \"items_per_second\": ");
+        append_number(out, result.items_per_second());
+        out.append(", \"samples_ns\": [");
+        for (size_t s = 0; s < result.samples_ns.size(); ++s) {
+            if (s > 0) out.append(", ");
+            append_number(out, result.samples_ns[s]);
+        }
+        out.append("]}");
+    }
+
+    out.append(results_.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    return out;
+}
+
+double BenchmarkRunner::quantile(std::vector<double> samples, double q) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    if (q == 0.5 && samples.size() % 2 == 0) {
+        size_t upper = samples.size() / 2;
+        return (samples[upper - 1] + samples[upper]) / 2.0;
+    }
+
+    // Nearest rank: smallest sample with at least q of the samples at or below it
+    size_t rank = static_cast<size_t>(std::ceil(q * static_cast<double>(samples.size())));
+    rank = std::min(std::max<size_t>(rank, 1), samples.size());
+    return samples[rank - 1];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Timings of one benchmark case
+struct BenchmarkResult {
+    std::string name;
+    uint64_t items = 0;                 // Rows, fields or lines processed per repetition
+    uint64_t bytes = 0;                 // Input bytes per repetition, 0 if not meaningful
+    std::vector<double> samples_ns;     // One wall time per measured repetition
+
+    double median_ns() const;
+    double p95_ns() const;
+    double mean_ns() const;
+    double min_ns() const;
+
+    // Throughput at the median repetition
+    double items_per_second() const;
+};
+
+struct BenchmarkOptions {
+    size_t warmup = 2;          // Untimed repetitions before measuring
+    size_t repetitions = 10;    // Timed repetitions
+    std::string filter;         // Only run cases whose name contains this
+};
+
+// Self-contained timing harness for agile-pasta-bench
+class BenchmarkRunner {
+public:
+    explicit BenchmarkRunner(const BenchmarkOptions& options);
+
+    // Whether a case passes the name filter; lets callers skip expensive setup
+    bool selected(const std::string& name) const;
+
+    // Run body options.warmup times untimed, then options.repetitions times timed,
+    // and print a summary line. Returns the recorded result, or null when filtered out.
+    const BenchmarkResult* run(const std::string& name, uint64_t items, uint64_t bytes,
+                               const std::function<void()>& body);
+
+    const std::vector<BenchmarkResult>& results() const { return results_; }
+
+    // Results as JSON; scale is recorded so runs of different sizes are not compared
+    std::string to_json(double scale) const;
+
+    // Value at quantile q (0..1) of unsorted samples, nearest-rank
+    static double quantile(std::vector<double> samples, double q);
+
+private:
+    BenchmarkOptions options_;
+    std::vector<BenchmarkResult> results_;
+};
+
+// Keep the optimizer from discarding a benchmark's work
+void benchmark_consume(uint64_t value);
@@ -0,0 +1,373 @@
+#include "benchmark_compare.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+// Just enough JSON for result files: objects, arrays, strings, numbers, literals
+struct JsonValue {
+    enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = Type::NUL;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue* find(const std::string& key) const {
+        for (const auto& member : members) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+};
+
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : text_(text) {}
+
+    bool parse(JsonValue& value, std::string& error) {
+        if (!parse_value(value, 0)) {
+            error = error_ + " at offset " + std::to_string(pos_);
+            return false;
+        }
+        skip_whitespace();
+        if (pos_ != text_.size()) {
+            error = "Unexpected trailing data at offset " + std::to_string(pos_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    void skip_whitespace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            pos_++;
+        }
+    }
+
+    bool fail(const char* message) {
+        error_ = message;
+        return false;
+    }
+
+    bool parse_value(JsonValue& value, int depth) {
+        if (depth > kMaxDepth) return fail("Nesting too deep");
+        skip_whitespace();
+        if (pos_ >= text_.size()) return fail("Unexpected end of input");
+
+        char c = text_[pos_];
+        if (c == '{') return parse_object(value, depth);
+        if (c == '[') return parse_array(value, depth);
+        if (c == '"') {
+            value.type = JsonValue::Type::STRING;
+            return parse_string(value.text);
+        }
+        if (text_.compare(pos_, 4, "true") == 0 || text_.compare(pos_, 5, "false") == 0) {
+            value.type = JsonValue::Type::BOOLEAN;
+            value.number = c == 't' ? 1.0 : 0.0;
+            pos_ += c == 't' ? 4 : 5;
+            return true;
+        }
+        if (text_.compare(pos_, 4, "null") == 0) {
+            value.type = JsonValue::Type::NUL;
+            pos_ += 4;
+            return true;
+        }
+
+        const char* start = text_.c_str() + pos_;
+        char* end = nullptr;
+        value.number = std::strtod(start, &end);
+        if (end == start) return fail("Expected a value");
+        value.type = JsonValue::Type::NUMBER;
+        pos_ += static_cast<size_t>(end - start);
+        return true;
+    }
+
+    bool parse_string(std::string& out) {
+        pos_++;     // Opening quote
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size()) break;
+            char escape = text_[pos_++];
+            switch (escape) {
+                case 'n': out.push_back('\n'); break;
+                case 't': out.push_back('\t'); break;
+                case 'r': out.push_back('\r'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'u':
+                    // Case names are ASCII; keep escaped code points verbatim
+                    if (pos_ + 4 > text_.size()) return fail("Truncated escape");
+                    out.append("\\u").append(text_, pos_, 4);
+                    pos_ += 4;
+                    break;
+                default: out.push_back(escape); break;
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    bool parse_array(JsonValue& value, int depth) {
+        value.type = JsonValue::Type::ARRAY;
+        pos_++;
+        skip_whitespace();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+            pos_++;
+            return true;
+        }
+        for (;;) {
+            JsonValue item;
+            if (!parse_value(item, depth + 1)) return false;
+            value.items.push_back(std::move(item));
+            skip_whitespace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                pos_++;
+            } else if (pos_ < text_.size() && text_[pos_] == ']') {
+                pos_++;
+                return true;
+            } else {
+                return fail("Expected ',' or ']'");
+            }
+        }
+    }
+
+    bool parse_object(JsonValue& value, int depth) {
+        value.type = JsonValue::Type::OBJECT;
+        pos_++;
+        skip_whitespace();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            pos_++;
+            return true;
+        }
+        for (;;) {
+            skip_whitespace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') return fail("Expected a key");
+            std::string key;
+            if (!parse_string(key)) return false;
+            skip_whitespace();
+            if (pos_ >= text_.size() || text_[pos_] != ':') return fail("Expected ':'");
+            pos_++;
+            JsonValue member;
+            if (!parse_value(member, depth + 1)) return false;
+            value.members.emplace_back(std::move(key), std::move(member));
+            skip_whitespace();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                pos_++;
+            } else if (pos_ < text_.size() && text_[pos_] == '}') {
+                pos_++;
+                return true;
+            } else {
+                return fail("Expected ',' or '}'");
+            }
+        }
+    }
+
+    const std::string& text_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+// Number of orderings of m values of a and n values of b with exactly u
+// (a, b) pairs where a is larger, for every u in [0, m * n]
+std::vector<double> u_distribution(size_t m, size_t n) {
+    // counts[j][u] for the current i, built up one a-sample at a time
+    std::vector<std::vector<double>> previous(n + 1, std::vector<double>(1, 1.0));
+    for (size_t i = 1; i <= m; ++i) {
+        std::vector<std::vector<double>> current(n + 1);
+        current[0] = std::vector<double>(1, 1.0);
+        for (size_t j = 1; j <= n; ++j) {
+            // Largest value is an a (beats all j b-values) or a b (beats nothing)
+            std::vector<double> counts(i * j + 1, 0.0);
+            const auto& a_last = previous[j];
+            const auto& b_last = current[j - 1];
+            for (size_t u = 0; u < a_last.size(); ++u) counts[u + j] += a_last[u];
+            for (size_t u = 0; u < b_last.size(); ++u) counts[u] += b_last[u];
+            current[j] = std::move(counts);
+        }
+        previous = std::move(current);
+    }
+    return previous[n];
+}
+
+} // namespace
+
+bool BenchmarkComparator::parse_report(const std::string& json, BenchmarkReport& report, std::string& error) {
+    JsonValue root;
+    JsonReader reader(json);
+    if (!reader.parse(root, error)) {
+        return false;
+    }
+    if (root.type != JsonValue::Type::OBJECT) {
+        error = "Result file is not a JSON object";
+        return false;
+    }
+
+    const JsonValue* scale = root.find("scale");
+    const JsonValue* results = root.find("results");
+    if (!results || results->type != JsonValue::Type::ARRAY) {
+        error = "Result file has no results array";
+        return false;
+    }
+
+    report.scale = scale && scale->type == JsonValue::Type::NUMBER ? scale->number : 0.0;
+    report.results.clear();
+
+    for (const auto& item : results->items) {
+        const JsonValue* name = item.find("name");
+        const JsonValue* samples = item.find("samples_ns");
+        if (!name || name->type != JsonValue::Type::STRING ||
+            !samples || samples->type != JsonValue::Type::ARRAY) {
+            error = "Result entry without name or samples_ns";
+            return false;
+        }
+
+        BenchmarkResult result;
+        result.name = name->text;
+        if (const JsonValue* items = item.find("items")) result.items = static_cast<uint64_t>(items->number);
+        if (const JsonValue* bytes = item.find("bytes")) result.bytes = static_cast<uint64_t>(bytes->number);
+        for (const auto& sample : samples->items) {
+            if (sample.type != JsonValue::Type::NUMBER) {
+                error = "Non-numeric sample in " + result.name;
+                return false;
+            }
+            result.samples_ns.push_back(sample.number);
+        }
+        report.results.push_back(std::move(result));
+    }
+    return true;
+}
+
+bool BenchmarkComparator::load_report(const std::string& path, BenchmarkReport& report, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    if (!parse_report(buffer.str(), report, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+double BenchmarkComparator::mann_whitney_greater(const std::vector<double>& a, const std::vector<double>& b) {
+    size_t m = a.size();
+    size_t n = b.size();
+    if (m == 0 || n == 0) {
+        return 1.0;
+    }
+
+    // U = pairs where a wins, ties count half
+    double u = 0.0;
+    bool has_ties = false;
+    for (double x : a) {
+        for (double y : b) {
+            if (x > y) {
+                u += 1.0;
+            } else if (x == y) {
+                u += 0.5;
+                has_ties = true;
+            }
+        }
+    }
+
+    if (!has_ties && m * n <= 2500) {
+        std::vector<double> counts = u_distribution(m, n);
+        double total = 0.0;
+        double at_least = 0.0;
+        size_t observed = static_cast<size_t>(u);
+        for (size_t k = 0; k < counts.size(); ++k) {
+            total += counts[k];
+            if (k >= observed) at_least += counts[k];
+        }
+        return at_least / total;
+    }
+
+    // Normal approximation with tie correction and continuity correction
+    std::vector<double> pooled(a);
+    pooled.insert(pooled.end(), b.begin(), b.end());
+    std::sort(pooled.begin(), pooled.end());
+    double tie_term = 0.0;
+    for (size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j] == pooled[i]) j++;
+        double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    double total = static_cast<double>(m + n);
+    double mean = static_cast<double>(m * n) / 2.0;
+    double variance = static_cast<double>(m * n) / 12.0 * ((total + 1.0) - tie_term / (total * (total - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;     // Every sample identical
+    }
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+std::vector<CaseComparison> BenchmarkComparator::compare(const BenchmarkReport& baseline,
+                                                         const BenchmarkReport& current,
+                                                         const CompareOptions& options) {
+    std::map<std::string, const BenchmarkResult*> current_by_name;
+    for (const auto& result : current.results) {
+        current_by_name[result.name] = &result;
+    }
+
+    std::vector<CaseComparison> comparisons;
+    for (const auto& base : baseline.results) {
+        CaseComparison comparison;
+        comparison.name = base.name;
+        comparison.baseline_median_ns = base.median_ns();
+
+        auto it = current_by_name.find(base.name);
+        if (it == current_by_name.end()) {
+            comparison.verdict = CaseComparison::Verdict::MISSING;
+            comparisons.push_back(comparison);
+            continue;
+        }
+
+        const BenchmarkResult& now = *it->second;
+        comparison.current_median_ns = now.median_ns();
+        if (comparison.current_median_ns > 0.0) {
+            comparison.throughput_change = comparison.baseline_median_ns / comparison.current_median_ns - 1.0;
+        }
+
+        // Larger times mean lower throughput
+        comparison.p_slower = mann_whitney_greater(now.samples_ns, base.samples_ns);
+        comparison.p_faster = mann_whitney_greater(base.samples_ns, now.samples_ns);
+
+        if (comparison.throughput_change < -options.threshold && comparison.p_slower < options.alpha) {
+            comparison.verdict = CaseComparison::Verdict::REGRESSED;
+        } else if (comparison.throughput_change > options.threshold && comparison.p_faster < options.alpha) {
+            comparison.verdict = CaseComparison::Verdict::IMPROVED;
+        }
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+const char* BenchmarkComparator::verdict_name(CaseComparison::Verdict verdict) {
+    switch (verdict) {
+        case CaseComparison::Verdict::IMPROVED: return "improved";
+        case CaseComparison::Verdict::REGRESSED: return "REGRESSED";
+        case CaseComparison::Verdict::MISSING: return "missing";
+        case CaseComparison::Verdict::UNCHANGED:
+        default: return "ok";
+    }
+}
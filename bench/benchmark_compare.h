@@ -0,0 +1,52 @@
+#pragma once
+
+#include "benchmark.h"
+#include <string>
+#include <vector>
+
+struct CompareOptions {
+    double threshold = 0.05;    // Tolerated median throughput loss (0.05 = 5%)
+    double alpha = 0.05;        // Significance level for the Mann-Whitney test
+};
+
+// One case present in the baseline, compared with the current run
+struct CaseComparison {
+    enum class Verdict {
+        UNCHANGED,      // Within threshold or not significant
+        IMPROVED,       // Significantly faster by more than the threshold
+        REGRESSED,      // Significantly slower by more than the threshold
+        MISSING         // No longer present in the current run
+    };
+
+    std::string name;
+    double baseline_median_ns = 0.0;
+    double current_median_ns = 0.0;
+    double throughput_change = 0.0;     // current / baseline median throughput - 1
+    double p_slower = 1.0;              // One-sided p-value that current is slower
+    double p_faster = 1.0;              // One-sided p-value that current is faster
+    Verdict verdict = Verdict::UNCHANGED;
+};
+
+// Benchmark result files loaded back from BenchmarkRunner::to_json output
+struct BenchmarkReport {
+    double scale = 0.0;
+    std::vector<BenchmarkResult> results;
+};
+
+class BenchmarkComparator {
+public:
+    // Parse a result file; returns false and sets error on malformed input
+    static bool parse_report(const std::string& json, BenchmarkReport& report, std::string& error);
+    static bool load_report(const std::string& path, BenchmarkReport& report, std::string& error);
+
+    // Compare every baseline case with the same-named current case
+    static std::vector<CaseComparison> compare(const BenchmarkReport& baseline,
+                                               const BenchmarkReport& current,
+                                               const CompareOptions& options);
+
+    // One-sided Mann-Whitney U test: p-value that samples of a tend to be larger
+    // than samples of b. Exact for small tie-free samples, normal approximation otherwise.
+    static double mann_whitney_greater(const std::vector<double>& a, const std::vector<double>& b);
+
+    static const char* verdict_name(CaseComparison::Verdict verdict);
+};
@@ -0,0 +1,20 @@
+# Run agile-pasta-bench, then compare its results with a baseline.
+# Invoked by the BenchmarkRegression CTest test; fails on a throughput regression.
+
+separate_arguments(bench_args UNIX_COMMAND "${BENCH_ARGS}")
+
+execute_process(
+    COMMAND ${BENCH} ${bench_args} --json ${CURRENT}
+    RESULT_VARIABLE bench_result
+)
+if(NOT bench_result EQUAL 0)
+    message(FATAL_ERROR "agile-pasta-bench failed (${bench_result})")
+endif()
+
+execute_process(
+    COMMAND ${BENCH} compare ${BASELINE} ${CURRENT} --threshold ${THRESHOLD}
+    RESULT_VARIABLE compare_result
+)
+if(NOT compare_result EQUAL 0)
+    message(FATAL_ERROR "Benchmark comparison against ${BASELINE} failed (${compare_result})")
+endif()
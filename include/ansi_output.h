@@ -44,6 +44,7 @@ public:
     
     // Check if output is to a terminal (for conditional ANSI usage)
     static bool is_terminal_output();
+    static bool is_terminal_input();
 
 private:
     // Helper method to output with formatting
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Rows of one run classified against the previous run
+struct ChangeCounts {
+    size_t inserted = 0;
+    size_t updated = 0;
+    size_t deleted = 0;
+    size_t unchanged = 0;
+};
+
+// Change-data-capture for a config's output. Each row is reduced to two 64-bit
+// hashes: one of its key columns (the whole row when no key is declared) and
+// one of the whole row. The previous run's hashes are read from a fingerprint
+// file sorted by key hash, with a directory over the top bits of the key hash,
+// so each lookup touches one or two cache lines. Rows whose key is new are
+// inserts, rows whose key exists with a different row hash are updates, and
+// previous keys no row matched are deletes. With declared key columns their
+// values are stored too, so a deleted row can be written with its key columns
+// filled. Without them only the hashes are stored, since the key values would
+// be the whole output again, and a deleted row carries no values.
+//
+// File layout (little-endian): magic "APFP", u32 version, u64 schema hash
+// (headers and key columns), u64 entries, u64 key bytes, the entries as
+// (u64 key hash, u64 row hash, u64 key offset) sorted by key hash then row
+// hash, then the key values as u32 length + bytes per key column (none, and
+// every key offset 0, without declared key columns).
+class ChangeCapture {
+public:
+    static constexpr const char* kOperationColumn = "_op";
+    static constexpr char kInsert = 'I';
+    static constexpr char kUpdate = 'U';
+    static constexpr char kDelete = 'D';
+
+    // Reads the previous fingerprints of a config with these output headers.
+    // A missing file, one made for other headers or key columns, or one that
+    // cannot be read or is corrupt counts as an empty previous run (every row
+    // is an insert), and save() replaces it. Throws std::invalid_argument when
+    // a key column is not an output header.
+    ChangeCapture(std::filesystem::path fingerprint_path,
+                  const std::vector<std::string>& headers,
+                  const std::vector<std::string>& key_columns);
+
+    // Classify the next output row: kInsert, kUpdate, or 0 when unchanged.
+    // Rows with the same key are matched to previous rows in order.
+    char classify(const std::vector<std::string>& row);
+
+    // Classify rows in order, operations[i] for rows[i]. The lookups of a
+    // batch of rows overlap their cache misses, so this is the faster way.
+    void classify(const std::vector<std::vector<std::string>>& rows, std::string& operations);
+
+    // Previous rows no classified row matched, with the key columns filled and
+    // the other columns empty (every column empty without declared key
+    // columns). Call once after the last classify().
+    std::vector<std::vector<std::string>> deleted_rows();
+
+    // Replace the fingerprint file with this run's rows (via a temporary file
+    // and rename). Returns false when it cannot be written.
+    bool save();
+
+    // Whether the fingerprint file existed and matched these headers
+    bool has_previous() const { return has_previous_; }
+
+    // Whether a fingerprint file existed but could not be read or was corrupt
+    bool previous_damaged() const { return previous_damaged_; }
+
+    const ChangeCounts& counts() const { return counts_; }
+
+    // "<output stem>_Fingerprints.apfp" next to a config's output file
+    static std::filesystem::path fingerprint_path_for(const std::filesystem::path& output_path);
+
+    // Stable 64-bit hash of the given columns of a row (missing fields are empty)
+    static uint64_t hash_columns(const std::vector<std::string>& row, const std::vector<size_t>& columns);
+
+    // Bytes a fingerprint takes in memory and on disk, excluding key values
+    static constexpr uint64_t kEntryBytes = 3 * sizeof(uint64_t);
+
+    // Bytes a stored key value takes besides its characters
+    static constexpr uint64_t kKeyLengthBytes = sizeof(uint32_t);
+
+private:
+    struct Entry {
+        uint64_t key_hash;
+        uint64_t row_hash;
+        uint64_t key_offset;
+    };
+
+    std::filesystem::path path_;
+    std::vector<std::string> headers_;
+    std::vector<size_t> key_columns_;
+    std::vector<size_t> all_columns_;
+    bool stores_keys_ = true;       // False when the key is the whole row
+    uint64_t schema_hash_ = 0;
+    bool has_previous_ = false;
+    bool previous_damaged_ = false;
+    ChangeCounts counts_;
+
+    // Previous run, with a directory of the first entry of each key-hash bucket
+    std::vector<Entry> previous_;
+    std::string previous_keys_;
+    std::vector<uint64_t> directory_;
+    int directory_shift_ = 64;
+
+    // This run
+    std::vector<Entry> current_;
+    std::string current_keys_;
+
+    static constexpr size_t kBatchRows = 64;
+
+    void load();
+    bool keys_fit() const;
+    void append_key(const std::vector<std::string>& row);
+    const Entry& add_current(const std::vector<std::string>& row);
+    size_t bucket_start(uint64_t key_hash) const;
+    char resolve(const Entry& row, size_t begin);
+};
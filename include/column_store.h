@@ -0,0 +1,67 @@
+#pragma once
+
+#include "file_scanner.h"
+#include "psv_parser.h"
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Parsed input tables kept on disk in the columnar format (.apcol): one column
+// file per input file, and a catalog (_Catalog.psv) naming the input each was
+// made from with that input's size and modification time. Later runs map a
+// stored table instead of parsing its PSV file, and the table reads its fields
+// from the mapping (PsvTable::columns), so processes on one machine using the
+// same store share one copy of it in the page cache. Columns are stored as
+// strings so they can be read in place. A stored table is used only while its
+// input is unchanged, otherwise the input is parsed and stored again.
+class ColumnStore {
+public:
+    static constexpr const char* kCatalogName = "_Catalog.psv";
+
+    struct Stats {
+        uint64_t hits = 0;           // Tables mapped from the store
+        uint64_t misses = 0;         // Tables parsed because they were not stored or had changed
+        uint64_t write_errors = 0;   // Parsed tables that could not be stored (they still load)
+    };
+
+    // Opens the store, creating its directory if needed. Throws std::runtime_error if that fails.
+    explicit ColumnStore(std::filesystem::path directory);
+
+    ColumnStore(const ColumnStore&) = delete;
+    ColumnStore& operator=(const ColumnStore&) = delete;
+
+    // The table of an input file as TableLoader::parse_input gives it: a view
+    // over the stored copy when it is current and intact, else parsed and
+    // stored. Throws the parse error.
+    std::unique_ptr<PsvTable> load(const FileInfo& file);
+
+    // True when the input's stored copy is current
+    bool contains(const FileInfo& file) const;
+
+    Stats stats() const;
+
+    const std::filesystem::path& directory() const { return directory_; }
+
+    // Sizes and modification times of the input's files, and its partition values
+    static std::string signature(const FileInfo& file);
+
+private:
+    struct Entry {
+        std::string file;            // Column file name inside the store
+        std::string signature;
+    };
+
+    std::filesystem::path directory_;
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry> catalog_;  // By absolute input data file path
+    Stats stats_;
+
+    std::unique_ptr<PsvTable> map_table(const FileInfo& file, const Entry& entry) const;
+    bool save(const FileInfo& file, PsvTable& table, const std::string& signature);
+
+    static std::map<std::string, Entry> read_catalog(const std::filesystem::path& path);
+    static bool write_catalog(const std::filesystem::path& path, const std::map<std::string, Entry>& catalog);
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "query_engine.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+// Agile Pasta columnar format (.apcol)
+//
+// A self-describing binary layout for analytics consumers. All multi-byte
+// values are little-endian and every section starts on an 8-byte boundary so
+// readers can mmap the file and use the arrays in place.
+//
+//   [header 32 bytes]  magic "APCOL\0\0\1", version, column count, row count, footer offset
+//   [column blocks]    one block per column, written in column order
+//   [footer]           one descriptor per column (type, encoding, block location, stats)
+//
+// Column block layouts:
+//   INT64 / DOUBLE, PLAIN   values[row_count] (8 bytes each), null bitmap (1 bit per row, 1 = null)
+//   STRING, PLAIN           offsets[row_count + 1] (u64), value bytes
+//   STRING, DICTIONARY      offsets[dictionary_size + 1] (u64), dictionary bytes, codes[row_count] (u32)
+
+enum class ColumnType : uint32_t {
+    INT64 = 1,
+    DOUBLE = 2,
+    STRING = 3
+};
+
+enum class ColumnEncoding : uint32_t {
+    PLAIN = 1,
+    DICTIONARY = 2
+};
+
+struct ColumnDescriptor {
+    std::string name;
+    ColumnType type = ColumnType::STRING;
+    ColumnEncoding encoding = ColumnEncoding::PLAIN;
+    uint64_t offset = 0;            // Block start, from beginning of file
+    uint64_t length = 0;            // Block length in bytes
+    uint64_t dictionary_size = 0;   // Distinct values for DICTIONARY encoding
+    uint64_t null_count = 0;        // Empty values in numeric columns
+
+    // Column statistics; numeric bounds use the slot matching the type
+    int64_t min_int = 0;
+    int64_t max_int = 0;
+    double min_double = 0.0;
+    double max_double = 0.0;
+    std::string min_string;
+    std::string max_string;
+};
+
+class ColumnarWriter {
+public:
+    static constexpr char kMagic[8] = {'A', 'P', 'C', 'O', 'L', '\0', '\0', '\1'};
+    static constexpr uint32_t kVersion = 1;
+
+    // Write query result as a columnar file, encoding columns in parallel.
+    // Without infer_types every column is stored as STRING, so the file can be
+    // read in place through a ColumnarView.
+    static bool write_columnar(const QueryResult& result,
+                              const std::filesystem::path& output_path,
+                              bool infer_types = true);
+
+    // Write only the selected rows (by index into result.rows), used for partitioned output
+    static bool write_columnar_rows(const QueryResult& result,
+                                   const std::vector<size_t>& row_indices,
+                                   const std::filesystem::path& output_path);
+
+    // Infer the narrowest type that round-trips every non-empty value: a
+    // numeric type only when each value decodes to exactly its text
+    static ColumnType infer_type(const std::vector<const std::string*>& values);
+
+private:
+    static bool write_impl(const QueryResult& result,
+                          const std::vector<size_t>* row_indices,
+                          const std::filesystem::path& output_path,
+                          bool infer_types);
+};
+
+class ColumnarReader {
+public:
+    // Decode a columnar file image (a file read into memory or an mmap'd region)
+    // back into rows; numeric values are formatted canonically. Throws
+    // std::runtime_error when the image is not a columnar file or is damaged.
+    static std::unique_ptr<QueryResult> decode(const char* data, size_t size,
+                                               std::vector<ColumnDescriptor>* descriptors = nullptr);
+
+    // Read and decode a columnar file from disk
+    static std::unique_ptr<QueryResult> read_file(const std::filesystem::path& path,
+                                                  std::vector<ColumnDescriptor>* descriptors = nullptr);
+};
+
+// The values of a columnar file image read in place, without decoding it into
+// rows: each value points into the image (an mmap'd file, whose pages every
+// process mapping it shares). Only files whose columns are all STRING can be
+// viewed, as ColumnarWriter writes them without infer_types. The whole layout
+// is checked when the view is made, so reading a value checks nothing.
+class ColumnarView {
+public:
+    // The image must outlive the view. Throws std::runtime_error when the
+    // image is damaged or has a numeric column.
+    ColumnarView(const char* data, size_t size);
+
+    const std::vector<std::string>& headers() const { return headers_; }
+    size_t row_count() const { return row_count_; }
+
+    std::string_view value(size_t row, size_t column) const {
+        const Column& block = columns_[column];
+        uint64_t index = row;
+        if (block.codes) {
+            uint32_t code;
+            std::memcpy(&code, block.codes + row * 4, sizeof(code));
+            index = code;
+        }
+        uint64_t bounds[2];
+        std::memcpy(bounds, block.offsets + index * 8, sizeof(bounds));
+        return std::string_view(block.bytes + bounds[0], static_cast<size_t>(bounds[1] - bounds[0]));
+    }
+
+private:
+    struct Column {
+        const char* offsets = nullptr;  // Of each value (PLAIN) or dictionary entry
+        const char* bytes = nullptr;
+        const char* codes = nullptr;    // Dictionary code per row, null for PLAIN
+    };
+
+    std::vector<std::string> headers_;
+    std::vector<Column> columns_;
+    size_t row_count_ = 0;
+};
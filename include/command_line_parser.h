@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -8,6 +9,10 @@ struct CommandLineArgs {
         HELP,
         TRANSFORM,
         SANITY_CHECK,
+        GENERATE,
+        EXPLAIN,
+        SERVE,
+        QUERY,
         INVALID
     };
     
@@ -16,6 +21,40 @@ struct CommandLineArgs {
     std::string output_path;
     std::string sanity_check_path;  // For sanity check command
     bool show_help = false;
+    
+    // Output format and partitioning for the transform command
+    std::string output_format = "csv";
+    size_t max_rows_per_file = 0;   // 0 = no row cap
+    std::string partition_column;   // Empty = no split by column value
+    bool diff = false;              // Write only rows changed since the last run
+    std::vector<std::string> diff_key;  // Key columns for diff, empty = the whole row
+    
+    // Optional JSON run report for the transform command
+    std::string metrics_path;       // Empty = no metrics file
+    std::string trace_path;         // Empty = no Chrome trace file
+    bool perf_counters = false;     // Hardware counters per phase and config
+    bool verbose = false;           // Explain planner decisions
+    bool explain_analyze = false;   // explain: run each config and report actual rows and times
+    std::string store_path;         // Column store for parsed inputs (transform, query), empty = none
+    bool resume = false;            // transform: continue from the checkpoint of an interrupted run
+    
+    // Ad-hoc statement for the query command; empty = read statements from stdin
+    std::string query_sql;
+    
+    // Long-running job server for the serve command
+    std::string socket_path;
+    size_t serve_workers = 0;       // Concurrent jobs, 0 = hardware threads
+    uint64_t serve_cache_mb = 0;    // Table cache budget, 0 = derived from available memory
+    bool serve_compress_cache = false;  // Keep cached tables compressed between jobs
+    
+    // Synthetic data options for the gen command (written under output_path)
+    double gen_scale = 1.0;
+    uint64_t gen_seed = 42;
+    double gen_skew = 0.0;
+    double gen_sortedness = 1.0;
+    uint64_t gen_departments = 0;   // 0 = derived from scale
+    uint64_t gen_locations = 0;
+    uint64_t gen_cost_centers = 0;
 };
 
 class CommandLineParser {
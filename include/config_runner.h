@@ -0,0 +1,54 @@
+#pragma once
+
+#include "change_capture.h"
+#include "database.h"
+#include "execution_planner.h"
+#include "file_scanner.h"
+#include "output_writer.h"
+#include "run_checkpoint.h"
+#include "transformation_engine.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Output headers and rules of one config, parsed once and reusable across runs
+struct ConfigRules {
+    std::vector<std::string> headers;
+    std::vector<TransformationRule> rules;
+};
+
+// What running one config produced
+struct ConfigRunResult {
+    bool success = false;
+    std::string error;                          // Why it failed, empty on success
+    size_t rows_in = 0;                         // Source rows examined
+    size_t rows_out = 0;
+    uint64_t bytes_written = 0;
+    std::vector<std::filesystem::path> files;   // Output files, one per partition
+    ChangeCounts changes;                       // Rows by operation with OutputOptions::diff
+};
+
+// Runs one output config against loaded tables: a pure projection is copied
+// straight from the records, streaming configs write rows as they come, and the
+// rest materialize a result for the chosen output format. In diff mode only the
+// rows changed since the last diff run are written, with an operation column.
+class ConfigRunner {
+public:
+    // Parse a config's headers and rules files. Throws if either cannot be read.
+    static ConfigRules load_rules(const OutputFileInfo& config);
+
+    // Transform into the output file next to the config's headers file. With
+    // `console` the steps and outcome are reported the way the transform command
+    // shows them; otherwise the run is silent. The config reads a snapshot of
+    // `database`, so tables may keep loading into it meanwhile. Transform errors
+    // and corrupt fingerprint files are thrown. A checkpoint applies to
+    // streamed CSV outputs, which it continues and syncs in chunks.
+    static ConfigRunResult run(const OutputFileInfo& config, const ConfigRules& rules,
+                               const ConfigPlan& plan, const Database& database,
+                               const OutputOptions& options, bool console = true,
+                               const StreamCheckpoint* checkpoint = nullptr);
+
+    // Combined size of the files a config produced
+    static uint64_t total_file_size(const std::vector<std::filesystem::path>& files);
+};
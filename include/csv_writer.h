@@ -1,23 +1,91 @@
 #pragma once
 
 #include "query_engine.h"
+#include "output_buffer.h"
+#include "run_checkpoint.h"
 #include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
 #include <filesystem>
+#include <fstream>
+#include <memory>
 
 class CsvWriter {
 public:
     // Write query result to CSV file (Excel compatible)
-    static bool write_csv(const QueryResult& result, 
+    static bool write_csv(const QueryResult& result,
                          const std::filesystem::path& output_path);
-    
+
     // Write with progress reporting
-    static bool write_csv_with_progress(const QueryResult& result, 
+    static bool write_csv_with_progress(const QueryResult& result,
                                        const std::filesystem::path& output_path);
 
-private:
-    // Escape CSV field if needed
+    // Write only the selected rows (by index into result.rows), used for partitioned output
+    static bool write_csv_rows(const QueryResult& result,
+                              const std::vector<size_t>& row_indices,
+                              const std::filesystem::path& output_path);
+
+    // Stream selected columns of a loaded table straight into a CSV file, skipping
+    // rows rejected by row_filter (if set, given the row index). Used for pure
+    // projection configs so no intermediate QueryResult is built; fields of a
+    // mapped table go from the mapping to the file. With a checkpoint the file
+    // is continued and synced as CsvStreamWriter does it.
+    static bool write_projection(const std::vector<std::string>& headers,
+                                const PsvTable& table,
+                                const std::vector<size_t>& column_indices,
+                                const std::function<bool(size_t row)>& row_filter,
+                                const std::filesystem::path& output_path,
+                                size_t& rows_written,
+                                const StreamCheckpoint* checkpoint = nullptr);
+
+    // Escape CSV field if needed (public for benchmarks)
     static std::string escape_csv_field(const std::string& field);
-    
+
+private:
+    friend class CsvStreamWriter;
+
     // Check if field needs quoting
-    static bool needs_quoting(const std::string& field);
-};
\ No newline at end of file
+    static bool needs_quoting(std::string_view field);
+
+    // Append a field or a whole row to the output buffer, escaping as needed
+    static void append_csv_field(std::string& out, std::string_view field);
+    static void append_csv_row(OutputBuffer& buffer, const std::vector<std::string>& row);
+};
+
+// Incremental CSV output for streaming execution: rows are appended as they
+// are produced, so the result is never held in memory as a whole
+class CsvStreamWriter {
+public:
+    // Create the file and write the header row. A checkpoint with resume_bytes
+    // instead cuts the existing file back to that size and appends to it; the
+    // first resume_rows rows written are then taken to be in the file already
+    // and dropped. Every chunk_bytes the file is synced to disk and on_chunk
+    // gets the rows and bytes now durable. Returns false if the file cannot be
+    // opened or is shorter than resume_bytes.
+    bool open(const std::filesystem::path& output_path, const std::vector<std::string>& headers,
+              const StreamCheckpoint* checkpoint = nullptr);
+
+    void write_row(const std::vector<std::string>& row);
+
+    // Write the given columns of a table row (missing fields are empty)
+    void write_fields(const PsvTable& table, size_t row, const std::vector<size_t>& columns);
+
+    // Flush and close, returns false if any write failed
+    bool close();
+
+    // Rows in the file, counting those kept from a resumed file
+    size_t rows_written() const { return rows_written_; }
+
+private:
+    std::filesystem::path path_;
+    std::ofstream file_;
+    std::unique_ptr<OutputBuffer> buffer_;
+    size_t rows_written_ = 0;
+    size_t rows_to_skip_ = 0;
+    const StreamCheckpoint* checkpoint_ = nullptr;
+    uint64_t next_chunk_ = 0;       // Buffered bytes at which to sync next
+
+    // Count a written row and sync at chunk boundaries
+    void row_written();
+};
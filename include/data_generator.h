@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct GeneratorOptions {
+    double scale = 1.0;             // Scale factor; 1 is about 1 GB of employees
+    uint64_t seed = 42;             // Same seed and options always give the same bytes
+    double skew = 0.0;              // Zipf exponent for foreign keys, 0 = uniform
+    double sortedness = 1.0;        // 1 = employees in emp_id order, 0 = fully shuffled
+    uint64_t departments = 0;       // Table cardinalities, 0 = derived from scale
+    uint64_t locations = 0;
+    uint64_t cost_centers = 0;
+    size_t threads = 0;             // Worker threads, 0 = hardware concurrency
+    size_t chunk_rows = 65536;      // Rows generated per task
+};
+
+struct GeneratedTable {
+    std::string name;
+    std::filesystem::path path;
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+};
+
+// TPC-style synthetic data: employees -> departments -> cost_centers -> locations.
+// Every row is derived from (seed, table, row index) alone, so output does not
+// depend on thread count or chunk size.
+class DataGenerator {
+public:
+    static constexpr uint64_t kEmployeesPerScale = 16000000;
+
+    explicit DataGenerator(const GeneratorOptions& options);
+
+    uint64_t employee_rows() const { return employees_; }
+    uint64_t department_rows() const { return departments_; }
+    uint64_t cost_center_rows() const { return cost_centers_; }
+    uint64_t location_rows() const { return locations_; }
+
+    // Write <root>/input (tables and _Headers.psv) and <root>/output (sample rules)
+    std::vector<GeneratedTable> generate(const std::filesystem::path& root) const;
+
+    // One data line (without newline); index is the 0-based row number in the file
+    void append_employee(std::string& out, uint64_t index) const;
+    void append_department(std::string& out, uint64_t index) const;
+    void append_cost_center(std::string& out, uint64_t index) const;
+    void append_location(std::string& out, uint64_t index) const;
+
+    // emp_id written at row index; a bijection onto [1, employee_rows]
+    uint64_t employee_key(uint64_t index) const;
+
+    // yyyy-mm-dd for a day count since 1970-01-01
+    static std::string format_date(int64_t days);
+
+private:
+    // Zipf(skew) rank in [1, n] for a uniform u in [0, 1)
+    static uint64_t skewed_key(const std::vector<double>& cdf, uint64_t n, double u);
+
+    std::string department_name(uint64_t dept_id) const;
+
+    bool write_table(const std::filesystem::path& path, uint64_t rows,
+                     void (DataGenerator::*append_row)(std::string&, uint64_t) const,
+                     uint64_t& bytes_written) const;
+
+    GeneratorOptions options_;
+    uint64_t employees_;
+    uint64_t departments_;
+    uint64_t cost_centers_;
+    uint64_t locations_;
+    uint64_t shuffle_window_;           // Employees are permuted within blocks of this size
+    uint64_t window_multiplier_;        // Affine permutation multipliers for full and last blocks
+    uint64_t tail_multiplier_;
+    std::vector<double> department_cdf_;    // Empty when skew is 0
+    std::vector<double> cost_center_cdf_;
+    std::vector<double> location_cdf_;
+};
@@ -1,27 +1,62 @@
 #pragma once
 
 #include "psv_parser.h"
+#include "memory_accounting.h"
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <string>
 
+// Tables may be loaded while configs read others (see TableLoader). Each change
+// publishes a new immutable version of the catalog, so readers never lock and
+// never see a change half made. A pointer from get_table stays valid until its
+// table is dropped or replaced; readers that must not be affected by later
+// changes work on a snapshot.
 class Database {
 public:
+    Database();
+
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    // The tables as they are now. Later loads, replacements and drops here do
+    // not change the snapshot, and the tables it holds stay in memory until it
+    // is gone. Taking one copies a pointer.
+    Database snapshot() const;
+
     // Load all tables from parsed data
     void load_table(std::unique_ptr<PsvTable> table);
-    
+
+    // Add a table another owner keeps loaded (e.g. the serve table cache). Its
+    // memory stays accounted to that owner.
+    void share_table(std::shared_ptr<const PsvTable> table);
+
     // Get table by name
     const PsvTable* get_table(const std::string& name) const;
-    
+
     // Get all table names
     std::vector<std::string> get_table_names() const;
-    
+
     // Get total record count across all tables
     size_t get_total_records() const;
-    
+
+    // Unload one table, e.g. once no remaining config reads it
+    void drop_table(const std::string& name);
+
     // Clear all data
     void clear();
 
 private:
-    std::unordered_map<std::string, std::unique_ptr<PsvTable>> tables_;
-};
\ No newline at end of file
+    // One version of the catalog; never changed once published
+    using Catalog = std::unordered_map<std::string, std::shared_ptr<const PsvTable>>;
+
+    std::mutex write_mutex_;                    // Orders writers; readers do not take it
+    std::shared_ptr<const Catalog> catalog_;    // Read and replaced atomically
+
+    explicit Database(std::shared_ptr<const Catalog> catalog);
+
+    std::shared_ptr<const Catalog> current() const;
+    // Copy the current version, apply `change` and publish the result
+    template <typename Change>
+    void publish(Change change);
+};
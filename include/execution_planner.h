@@ -0,0 +1,134 @@
+#pragma once
+
+#include "database.h"
+#include "file_scanner.h"
+#include "output_writer.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class ExecutionMode {
+    IN_MEMORY,  // Tables loaded up front, result materialized, then written
+    STREAMING,  // Tables loaded up front, rows written as they are produced
+    SPILLING    // Over the memory budget: inputs stay on disk and each config
+                // loads only its own tables, releasing them afterwards
+};
+
+// Rule shape of a config, decided from its rules and the input headers
+enum class ConfigShape {
+    STATIC,     // No input column referenced: one row of constants
+    PROJECTION, // Bare columns of one table, written straight from the records
+    SELECT,     // One table with filters and expressions
+    JOIN,
+    UNION
+};
+
+// Size of one input table, extrapolated from a sample of its first rows
+struct InputEstimate {
+    std::string table;
+    size_t files = 1;                   // Partition files added up (see plan)
+    uint64_t file_bytes = 0;
+    uint64_t sampled_rows = 0;
+    size_t columns = 0;
+    double bytes_per_row = 0.0;         // Average line length in the file
+    double memory_per_row = 0.0;        // Estimated in-memory footprint of a loaded row
+    uint64_t estimated_rows = 0;
+    uint64_t memory_bytes = 0;          // Estimated footprint of the loaded table
+};
+
+// The first rows of an input, cut at a line boundary
+struct InputSample {
+    std::unique_ptr<PsvTable> table;    // Named after the input, with its headers
+    uint64_t bytes = 0;                 // Bytes of the file the sampled records came from
+    bool whole_file = false;
+};
+
+// What the planner needs to know about one output config
+struct ConfigDescription {
+    std::string name;
+    ConfigShape shape = ConfigShape::STATIC;
+    std::vector<std::string> tables;    // Inputs the config reads
+    size_t global_filters = 0;
+    std::vector<std::string> global_conditions;     // Conditions of its GLOBAL filters
+    size_t output_columns = 0;
+};
+
+struct ConfigPlan {
+    std::string name;
+    ConfigShape shape = ConfigShape::STATIC;
+    ExecutionMode mode = ExecutionMode::IN_MEMORY;
+    bool stream_rows = false;           // Rows go straight to a streaming writer
+    std::vector<std::string> tables;
+    uint64_t estimated_rows = 0;        // Source rows before filtering (upper bound of output)
+    uint64_t tables_bytes = 0;          // Loaded size of the tables it reads
+    uint64_t working_bytes = 0;         // Intermediate results on top of the tables
+    uint64_t join_memory_bytes = 0;     // Hash table size above which a join spills to disk, 0 = never
+    std::string reason;
+};
+
+struct ExecutionPlan {
+    std::vector<InputEstimate> inputs;
+    std::vector<ConfigPlan> configs;    // In execution order
+    uint64_t available_memory = 0;      // 0 = unknown
+    uint64_t memory_budget = 0;         // 0 = unlimited
+    uint64_t tables_bytes = 0;          // All tables some config reads
+    size_t hardware_threads = 1;
+    size_t load_threads = 1;            // Concurrent table loads
+    bool load_up_front = true;          // False once any config spills
+    size_t pruned_partitions = 0;       // Partition files no config reads (see prune_partitions)
+
+    // Tables no config reads; they are never loaded
+    std::vector<std::string> unused_tables;
+
+    const InputEstimate* find_input(const std::string& table) const;
+
+    // Human-readable decisions, one line each (shown with --verbose)
+    std::vector<std::string> explain() const;
+};
+
+// Chooses, before any data is loaded, how each config runs and how many
+// threads load the inputs. Estimates come from file sizes, a sample of each
+// input's first rows and the shape of each config's rules.
+class ExecutionPlanner {
+public:
+    static constexpr size_t kSampleBytes = 64 * 1024;
+    static constexpr double kBudgetFraction = 0.8;    // Share of available memory the plan may use
+    static constexpr uint64_t kMinJoinMemory = 64ull * 1024 * 1024;  // Hash table room a join always gets
+
+    // Parse the records in the first max_bytes of an input
+    static InputSample sample_input(const FileInfo& file, size_t max_bytes = kSampleBytes);
+
+    // Sample the start of an input file and extrapolate its row count and loaded size
+    static InputEstimate estimate_input(const FileInfo& file);
+
+    // Header-only tables for every input, enough to resolve which tables a config reads
+    static void load_schemas(const std::vector<FileInfo>& inputs, Database& schema);
+
+    // Drop partition files every config reading their table rejects outright: a
+    // single-table config whose GLOBAL filter on a partition column fails for the
+    // file's value. The files are never opened, and outputs stay the same.
+    static std::vector<FileInfo> prune_partitions(const std::vector<FileInfo>& inputs,
+                                                  const std::vector<ConfigDescription>& configs,
+                                                  const Database& schema);
+
+    // Classify a config from its rules against the input schemas (see load_schemas)
+    static ConfigDescription describe_config(const OutputFileInfo& config, const Database& schema);
+
+    // Decide modes and threads. Estimates of one table's partitions are added up.
+    // available_memory = 0 means unknown (never spill).
+    static ExecutionPlan plan(const std::vector<InputEstimate>& inputs,
+                              const std::vector<ConfigDescription>& configs,
+                              const OutputOptions& output_options,
+                              uint64_t available_memory,
+                              size_t hardware_threads);
+
+    // Memory this process may still use: available RAM, capped by a cgroup limit. 0 if unknown.
+    static uint64_t available_memory_bytes();
+
+    // Size for plan output, e.g. "12.3 MB"
+    static std::string format_bytes(uint64_t bytes);
+
+    static const char* mode_name(ExecutionMode mode);
+    static const char* shape_name(ConfigShape shape);
+};
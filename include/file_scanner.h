@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 #include <filesystem>
 
@@ -9,6 +11,17 @@ struct FileInfo {
     std::filesystem::path headers_path;
     size_t size_bytes;
     std::string name_prefix;
+    
+    // Partitions of a directory table (<table>/_Headers.psv): the directory's
+    // name, and the key=value directories between it and the file, one entry
+    // per partition column of the table (empty value where the file has none)
+    std::string table_name;
+    std::vector<std::pair<std::string, std::string>> partition_values;
+    
+    bool is_partition() const { return !table_name.empty(); }
+    
+    // Table the file loads into: the directory table, else the file's stem
+    std::string table() const { return is_partition() ? table_name : path.stem().string(); }
 };
 
 struct OutputFileInfo {
@@ -17,13 +30,27 @@ struct OutputFileInfo {
     std::string name_prefix;
 };
 
+// A .psv file found while listing a tree
+struct ScannedFile {
+    std::filesystem::path path;
+    uintmax_t size_bytes = 0;       // Only read for data files (not *_Headers.psv)
+};
+
 class FileScanner {
 public:
-    // Scan for input PSV files and their headers
-    static std::vector<FileInfo> scan_input_files(const std::string& root_path);
+    // Scan for input PSV files and their headers, sorted by path. A directory
+    // holding _Headers.psv is one table: every data file under it is a partition.
+    // threads = 0 picks a count suited to slow (network) file systems.
+    static std::vector<FileInfo> scan_input_files(const std::string& root_path, size_t threads = 0);
+    
+    // Scan for output rule files, sorted by path
+    static std::vector<OutputFileInfo> scan_output_files(const std::string& root_path, size_t threads = 0);
     
-    // Scan for output rule files
-    static std::vector<OutputFileInfo> scan_output_files(const std::string& root_path);
+    // Every .psv file under root. Directories are listed in parallel, one
+    // directory per task; the only stat is the size of each data file.
+    static std::vector<ScannedFile> list_psv_files(const std::filesystem::path& root,
+                                                   bool read_data_sizes,
+                                                   size_t threads = 0);
     
     // Display found files with sizes
     static void display_file_structure(const std::vector<FileInfo>& files);
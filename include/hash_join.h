@@ -0,0 +1,44 @@
+#pragma once
+
+#include "psv_parser.h"
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+// How one join ran
+struct JoinStats {
+    bool spilled = false;           // Keys were partitioned to disk
+    size_t partitions = 0;          // Partition pairs joined, counting repartitioned ones
+    size_t depth = 0;               // Deepest repartitioning of a skewed partition
+    uint64_t spilled_bytes = 0;     // Written to partition files
+};
+
+// Equi-join of two loaded tables on one column each. The right side's keys go
+// into a hash table and the left side probes it. When that table would exceed
+// the memory budget, it becomes a Grace hash join: the key and row number of
+// every row of both sides are hash-partitioned into files, and partition pairs
+// are joined one at a time with the smaller side as the hash table. A partition
+// still over the budget is partitioned again with another hash, up to kMaxDepth
+// levels; past that (one key repeated too often) it is joined as it is.
+class HashJoin {
+public:
+    static constexpr size_t kFanout = 16;
+    static constexpr size_t kMaxDepth = 4;
+
+    // Row numbers (left, right) of the rows whose keys are equal and not empty,
+    // in the order a nested loop over left, then right, finds them. Missing
+    // fields of short rows are empty. memory_budget 0 = never spill. Partition
+    // files go to a new directory under spill_dir (the system temp directory
+    // when empty) that is removed afterwards. Throws std::runtime_error when a
+    // partition file cannot be written or read.
+    static std::vector<std::pair<size_t, size_t>> match(const PsvTable& left, size_t left_column,
+                                                        const PsvTable& right, size_t right_column,
+                                                        uint64_t memory_budget,
+                                                        const std::filesystem::path& spill_dir = {},
+                                                        JoinStats* stats = nullptr);
+
+    // Estimated memory of a hash table over `rows` keys taking `key_bytes`
+    // (0 when the keys stay in the loaded table)
+    static uint64_t hash_table_bytes(uint64_t rows, uint64_t key_bytes = 0);
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "config_runner.h"
+#include "output_writer.h"
+#include "table_cache.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One transform job: the input and output trees of a transform run
+struct JobRequest {
+    std::string input_path;
+    std::string output_path;
+    OutputOptions options;
+};
+
+struct JobResult {
+    bool success = false;
+    std::string error;
+    double seconds = 0.0;
+    std::vector<std::pair<std::string, ConfigRunResult>> configs;  // By config name, in run order
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string content_type = "text/plain; charset=utf-8";
+    std::string body;
+};
+
+// Throughput and latency of finished jobs, rendered in the Prometheus text format
+class ServerMetrics {
+public:
+    // Upper bounds of the job duration histogram buckets, in seconds
+    static const std::vector<double>& duration_buckets();
+
+    void job_started();
+    void job_finished(const JobResult& result);
+
+    std::string to_prometheus(const TableCache::Stats& cache) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point started_ = std::chrono::steady_clock::now();
+    uint64_t jobs_ok_ = 0;
+    uint64_t jobs_failed_ = 0;
+    uint64_t jobs_in_flight_ = 0;
+    uint64_t rows_read_ = 0;
+    uint64_t rows_written_ = 0;
+    uint64_t bytes_written_ = 0;
+    std::vector<uint64_t> bucket_counts_ = std::vector<uint64_t>(duration_buckets().size(), 0);
+    double duration_sum_ = 0.0;
+};
+
+// Long-running transform service on a Unix domain socket. It speaks plain
+// HTTP/1.0, one request per connection, so curl --unix-socket works as a client:
+//
+//   POST /transform?in=<dir>&out=<dir>[&format=..&max_rows_per_file=..&partition_by=..]
+//   GET  /metrics     Prometheus text format
+//   GET  /health
+//   POST /shutdown    Stop accepting, finish running jobs and exit
+//
+// Parsed tables and rules stay in a TableCache between jobs, so repeated jobs
+// over the same inputs skip parsing. Connections are served by a pool of
+// workers, so jobs run concurrently.
+class JobServer {
+public:
+    // workers: concurrent connections (0 = hardware threads); cache_budget_bytes:
+    // size the table cache is trimmed to after each job (0 = unlimited);
+    // compress_cache: keep cached tables compressed between jobs
+    JobServer(size_t workers, uint64_t cache_budget_bytes, bool compress_cache = false);
+
+    JobServer(const JobServer&) = delete;
+    JobServer& operator=(const JobServer&) = delete;
+
+    // Run one job against the warm cache. Safe to call from several threads.
+    JobResult run_job(const JobRequest& request);
+
+    // Answer one request; target is the path with its query string
+    HttpResponse handle(const std::string& method, const std::string& target, const std::string& body);
+
+    // Listen on socket_path until stop(), POST /shutdown, SIGINT or SIGTERM.
+    // Returns false if the socket cannot be opened. Not available on Windows.
+    bool serve(const std::string& socket_path);
+
+    // Ask serve() to return once running jobs finish
+    void stop();
+
+    std::string metrics_text() const;
+
+    // Decode application/x-www-form-urlencoded pairs (a query string or form body)
+    static std::map<std::string, std::string> parse_form(const std::string& text);
+
+    // JSON body of a job response
+    static std::string result_json(const JobResult& result);
+
+private:
+    size_t workers_;
+    TableCache cache_;
+    ServerMetrics metrics_;
+    std::atomic<bool> stopping_{false};
+
+    HttpResponse handle_transform(const std::map<std::string, std::string>& params);
+    void serve_connection(int client);
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "query_engine.h"
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Writes results as JSON Lines (one JSON object per row, keys in header order,
+// all values as JSON strings)
+class JsonLinesWriter {
+public:
+    static constexpr size_t kDefaultChunkRows = 65536;
+
+    // Streaming mode: serialize rows in order through a single output buffer
+    static bool write_jsonl(const QueryResult& result,
+                           const std::filesystem::path& output_path);
+
+    // Parallel mode: serialize chunks of rows on worker threads, then write them in order
+    static bool write_jsonl_parallel(const QueryResult& result,
+                                    const std::filesystem::path& output_path,
+                                    size_t chunk_rows = kDefaultChunkRows);
+
+    // Write only the selected rows (by index into result.rows), used for partitioned output
+    static bool write_jsonl_rows(const QueryResult& result,
+                                const std::vector<size_t>& row_indices,
+                                const std::filesystem::path& output_path);
+
+    // Append value to out as the body of a JSON string (without surrounding quotes)
+    static void append_escaped(std::string& out, const std::string& value);
+
+private:
+    // Escaped key bytes for each header, computed once per file:
+    // {"first": for the first column and ,"next": for the others
+    static std::vector<std::string> build_key_prefixes(const std::vector<std::string>& headers);
+
+    static void append_row(std::string& out,
+                          const std::vector<std::string>& key_prefixes,
+                          const std::vector<std::string>& row);
+};
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PsvTable;
+struct QueryResult;
+
+enum class MemoryCategory {
+    TABLE,          // Loaded PsvTable records
+    RESULT,         // Materialized QueryResult rows
+    HASH_TABLE,     // Dictionaries and partition maps
+    BUFFER          // Output and serialization buffers
+};
+
+// Current and high-water bytes of one component, category or the whole process
+struct ComponentMemory {
+    std::string name;
+    MemoryCategory category = MemoryCategory::TABLE;
+    uint64_t current_bytes = 0;
+    uint64_t peak_bytes = 0;
+};
+
+// Explicit accounting of the bytes held by the large data structures. Owners
+// report estimated sizes (see the *_bytes helpers) through MemoryCharge; peaks
+// are tracked per component, per category and in total.
+class MemoryAccounting {
+public:
+    static void acquire(MemoryCategory category, const std::string& name, uint64_t bytes);
+    static void release(MemoryCategory category, const std::string& name, uint64_t bytes);
+
+    // Every component seen since the last reset, largest peak first
+    static std::vector<ComponentMemory> components();
+
+    // Current and peak of the sum over one category (not the sum of peaks)
+    static ComponentMemory category_total(MemoryCategory category);
+    static ComponentMemory total();
+
+    static void reset();
+
+    // Start a new high-water window: every peak drops to its current value
+    static void reset_peaks();
+
+    static const char* category_name(MemoryCategory category);
+
+    // Estimated heap footprint, including container and string overhead
+    static uint64_t string_bytes(const std::string& value);
+    static uint64_t table_bytes(const PsvTable& table);
+    static uint64_t result_bytes(const QueryResult& result);
+    static uint64_t rows_bytes(const std::vector<std::vector<std::string>>& rows);
+
+    // Node-based hash map: bucket array plus one node (value and next pointer) per entry
+    template <typename Map>
+    static uint64_t hash_table_bytes(const Map& map) {
+        return sizeof(Map) + map.bucket_count() * sizeof(void*) +
+               map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*));
+    }
+};
+
+// RAII charge against one component, released on destruction
+class MemoryCharge {
+public:
+    MemoryCharge() = default;
+    MemoryCharge(MemoryCategory category, std::string name, uint64_t bytes = 0);
+    ~MemoryCharge();
+
+    MemoryCharge(MemoryCharge&& other) noexcept;
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+    // Change the charged size, e.g. once a structure has been filled
+    void update(uint64_t bytes);
+    void release();
+
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    MemoryCategory category_ = MemoryCategory::TABLE;
+    std::string name_;
+    uint64_t bytes_ = 0;
+    bool active_ = false;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "memory_accounting.h"
+#include <string>
+#include <fstream>
+#include <cstddef>
+
+// Accumulates serialized output in memory and hands it to the file in large
+// blocks instead of issuing one stream write per field
+class OutputBuffer {
+public:
+    static constexpr size_t kDefaultCapacity = 1 << 20; // 1 MB
+
+    explicit OutputBuffer(std::ofstream& file, size_t capacity = kDefaultCapacity);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(const char* data, size_t length);
+    void append(const std::string& data);
+    void push_back(char c);
+
+    // Direct access for serializers that want to write into the buffer themselves
+    std::string& data() { return buffer_; }
+
+    // Flush if the buffer has grown past its capacity
+    void maybe_flush();
+
+    // Write buffered bytes to the file, returns false on stream failure
+    bool flush();
+
+    // Total bytes handed to the file so far
+    size_t bytes_written() const { return bytes_written_; }
+
+private:
+    std::ofstream& file_;
+    std::string buffer_;
+    size_t capacity_;
+    size_t bytes_written_ = 0;
+    MemoryCharge charge_;
+};
\ No newline at end of file
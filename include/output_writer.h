@@ -0,0 +1,64 @@
+#pragma once
+
+#include "query_engine.h"
+#include <string>
+#include <vector>
+#include <filesystem>
+
+enum class OutputFormat {
+    CSV,        // Excel-compatible CSV (default)
+    COLUMNAR,   // Typed columnar binary (.apcol), see columnar_writer.h
+    JSON_LINES, // One JSON object per row (.jsonl)
+    XLSX        // Excel workbook with typed cells (.xlsx), see xlsx_writer.h
+};
+
+// Options controlling the format of a config's result and how it is split into files
+struct OutputOptions {
+    OutputFormat format = OutputFormat::CSV;
+    size_t max_rows_per_file = 0;      // 0 = no row cap
+    std::string partition_column;      // Empty = no split by column value
+    bool diff = false;                 // Write only rows changed since the last run (see change_capture.h)
+    std::vector<std::string> diff_key; // Columns identifying a row for diff, empty = the whole row
+};
+
+// One file produced for a config's result
+struct OutputPartition {
+    std::filesystem::path path;
+    std::vector<size_t> row_indices;   // Rows of the result routed to this file
+};
+
+class OutputWriter {
+public:
+    // Write result to output_path, or to several files derived from it when
+    // partitioning is requested. Returns false if any file could not be written.
+    static bool write(const QueryResult& result,
+                      const std::filesystem::path& output_path,
+                      const OutputOptions& options,
+                      std::vector<std::filesystem::path>& written_files);
+
+    // File extension (with dot) used for a format
+    static std::string extension_for(OutputFormat format);
+
+    // Parse a --format value, returns false for unknown names
+    static bool parse_format(const std::string& name, OutputFormat& format);
+
+    // Route every row of the result to its partition in a single pass
+    static std::vector<OutputPartition> plan_partitions(const QueryResult& result,
+                                                        const std::filesystem::path& output_path,
+                                                        const OutputOptions& options);
+
+private:
+    // Write one partition (or the whole result when row_indices is null) in the requested format
+    static bool write_file(const QueryResult& result,
+                           const std::vector<size_t>* row_indices,
+                           const std::filesystem::path& path,
+                           OutputFormat format);
+
+    // Turn a column value into something safe to use in a file name
+    static std::string sanitize_partition_value(const std::string& value);
+
+    // Build "<stem>[_<value>][_partNNNN]<ext>" next to output_path
+    static std::filesystem::path partition_path(const std::filesystem::path& output_path,
+                                                const std::string& value_suffix,
+                                                size_t part_number);
+};
\ No newline at end of file
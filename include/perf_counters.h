@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Hardware counter values, or the difference between two readings
+struct PerfSample {
+    enum Counter : unsigned {
+        CYCLES = 1u << 0,
+        INSTRUCTIONS = 1u << 1,
+        CACHE_MISSES = 1u << 2,
+        BRANCH_MISSES = 1u << 3
+    };
+
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+    unsigned valid = 0;         // Counter bits that were actually measured
+
+    bool has(Counter counter) const { return (valid & counter) != 0; }
+
+    // Instructions per cycle, 0 unless both counters were measured
+    double ipc() const;
+
+    // Counts from `start` to this sample, for counters valid in both
+    PerfSample since(const PerfSample& start) const;
+};
+
+// Process-wide hardware performance counters for --perf-counters, opened with
+// Linux perf_event_open. Counters are inherited by threads created after
+// enable(); a worker's counts are folded into the totals when it exits.
+// Values are scaled up when the kernel multiplexes counters.
+//
+// Counters that cannot be opened (no PMU in a VM or container, a restrictive
+// perf_event_paranoid, other platforms) are simply left out of each sample;
+// reason() says why.
+class PerfCounters {
+public:
+    // Open the counters; returns false when none could be opened
+    static bool enable();
+    static void disable();
+    static bool enabled();
+
+    // Current totals since enable(); an empty sample while disabled
+    static PerfSample read();
+
+    // Which counters are open, or why none are
+    static std::string reason();
+};
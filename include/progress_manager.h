@@ -21,4 +21,7 @@ public:
     // Update progress bar
     static void update_progress(CustomProgressBar& bar, size_t current);
     static void complete_progress(CustomProgressBar& bar);
+    
+    // Turn all bars on or off for the process; serve mode runs jobs without them
+    static void set_enabled(bool enabled);
 };
\ No newline at end of file
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 #include <memory>
 #include <map>
 
+class ColumnarView;
+
 struct PsvRecord {
     std::vector<std::string> fields;
 };
@@ -16,11 +19,42 @@ struct PsvTable {
     std::vector<PsvRecord> records;
     std::filesystem::path source_file;
     
+    // Set when the table is a view over a mapped column store file (see
+    // ColumnStore): rows are then read from the mapping and records is empty
+    std::shared_ptr<const ColumnarView> columns;
+    
     // Index for fast lookups
     std::map<std::string, size_t> header_index;
     
     void build_header_index();
     std::string get_field(size_t record_idx, const std::string& header) const;
+    
+    // Rows, whether held in records or mapped
+    size_t row_count() const { return columns ? mapped_row_count() : records.size(); }
+    
+    // A field of a row, empty past the end of a short row. Mapped fields
+    // point into the mapping and stay valid while the table does.
+    std::string_view field(size_t row, size_t column) const {
+        if (columns) {
+            return mapped_field(row, column);
+        }
+        const auto& fields = records[row].fields;
+        return column < fields.size() ? std::string_view(fields[column]) : std::string_view();
+    }
+    
+    // The fields of a row: the record itself, or a mapped row copied into scratch
+    const std::vector<std::string>& row_fields(size_t row, std::vector<std::string>& scratch) const {
+        if (!columns) {
+            return records[row].fields;
+        }
+        copy_mapped_row(row, scratch);
+        return scratch;
+    }
+
+private:
+    size_t mapped_row_count() const;
+    std::string_view mapped_field(size_t row, size_t column) const;
+    void copy_mapped_row(size_t row, std::vector<std::string>& out) const;
 };
 
 class PsvParser {
@@ -35,8 +69,10 @@ public:
     // Parse data file with progress reporting
     static std::vector<PsvRecord> parse_data(const std::filesystem::path& data_path, 
                                             size_t& total_records);
+    
+    // Split one data line on '|' and trim each field (public for benchmarks)
+    static std::vector<std::string> split_psv_line(const std::string& line);
 
 private:
-    static std::vector<std::string> split_psv_line(const std::string& line);
     static std::string trim(const std::string& str);
 };
\ No newline at end of file
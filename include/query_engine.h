@@ -1,7 +1,11 @@
 #pragma once
 
 #include "database.h"
+#include "hash_join.h"
 #include "psv_parser.h"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
@@ -31,7 +35,17 @@ public:
                                              const std::vector<std::string>& columns,
                                              const std::string& where_clause);
     
-    // Execute JOIN query
+    // SELECT of the rows `matches` accepts (given the table and a row index),
+    // copying only the given columns
+    std::unique_ptr<QueryResult> select_matching(const std::string& table_name,
+                                                const std::vector<std::string>& columns,
+                                                const std::function<bool(const PsvTable&, size_t row)>& matches);
+    
+    // Memory a join's hash table may use before the join spills to disk (0 =
+    // unlimited), and where its partition files go (empty = system temp directory)
+    void set_join_memory_budget(uint64_t bytes, std::filesystem::path spill_dir = {});
+    
+    // Execute JOIN query as a hash join (see HashJoin)
     std::unique_ptr<QueryResult> join(const std::string& left_table,
                                      const std::string& right_table,
                                      const std::string& join_condition,
@@ -40,12 +54,18 @@ public:
     // Execute UNION query
     std::unique_ptr<QueryResult> union_tables(const std::vector<std::string>& table_names);
     
+    // How the last join ran
+    const JoinStats& last_join_stats() const { return last_join_; }
+    
 private:
     const Database& database_;
+    uint64_t join_memory_budget_ = 0;
+    std::filesystem::path spill_dir_;
+    JoinStats last_join_;
     
     // Helper methods
-    bool evaluate_condition(const PsvRecord& record, 
-                          const PsvTable& table,
+    bool evaluate_condition(const PsvTable& table,
+                          size_t record,
                           const std::string& condition);
     
     std::vector<std::string> parse_join_condition(const std::string& condition);
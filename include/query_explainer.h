@@ -0,0 +1,57 @@
+#pragma once
+
+#include "database.h"
+#include "execution_planner.h"
+#include "file_scanner.h"
+#include "output_writer.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// One operator of a config's plan: what it does, how many rows it is expected
+// to produce and, once analyzed, what it actually did
+struct PlanOperator {
+    std::string name;                   // Scan, Values, Join, Union, Filter, Project or Write
+    std::string detail;
+    double estimated_rows = 0.0;
+    double selectivity = -1.0;          // Filters: estimated share of rows kept; <0 otherwise
+    bool analyzed = false;
+    uint64_t actual_rows = 0;
+    double seconds = 0.0;
+    uint64_t memory_bytes = 0;          // Bytes the operator held at its peak
+    std::vector<PlanOperator> inputs;
+};
+
+// EXPLAIN and EXPLAIN ANALYZE for output configs. build() lays out the operators
+// a config runs as, with row estimates from the planner's input sizes and from
+// running the config over the input samples (filter selectivity, join key
+// distinct counts). analyze() then runs it on the real inputs.
+class QueryExplainer {
+public:
+    // Sampled table of every input, named like the loaded tables
+    static void load_samples(const std::vector<FileInfo>& inputs, Database& samples);
+
+    static PlanOperator build(const OutputFileInfo& config,
+                              const ConfigPlan& config_plan,
+                              const ExecutionPlan& plan,
+                              const Database& samples,
+                              const OutputOptions& output_options);
+
+    // Load the config's tables, execute it the way transform would and record
+    // actual rows, time and memory on every operator. Output goes to scratch_dir
+    // instead of next to the config. Returns false if the output could not be written.
+    static bool analyze(PlanOperator& root,
+                        const OutputFileInfo& config,
+                        const ConfigPlan& config_plan,
+                        const std::vector<FileInfo>& inputs,
+                        const OutputOptions& output_options,
+                        const std::filesystem::path& scratch_dir);
+
+    // Indented operator tree, root first
+    static std::vector<std::string> render(const PlanOperator& root);
+
+    // Estimated rows of an equi-join from both sides' sizes and key distinct counts
+    static double join_rows(double left_rows, double left_distinct,
+                            double right_rows, double right_distinct);
+};
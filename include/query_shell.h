@@ -0,0 +1,91 @@
+#pragma once
+
+#include "database.h"
+#include "query_engine.h"
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One ad-hoc statement of the query command:
+//   SELECT <columns> FROM <table> [JOIN <table> ON <a.col> = <b.col>]
+//   [WHERE <col> <op> <value> [AND ...]] [GROUP BY <cols>]
+//   [ORDER BY <col> [ASC|DESC]] [LIMIT <n>]
+// Columns are * or a list of column names and COUNT/SUM/AVG/MIN/MAX(column),
+// each with an optional AS label.
+struct QueryStatement {
+    struct Column {
+        std::string aggregate;      // Empty for a plain column, else COUNT, SUM, AVG, MIN or MAX
+        std::string name;           // Column name, or * for COUNT(*)
+        std::string label;          // Output header
+    };
+
+    struct Condition {
+        std::string column;
+        std::string op;             // =, !=, <, <=, > or >=
+        std::string value;
+    };
+
+    std::vector<Column> columns;    // Empty = *
+    std::string table;
+    std::string join_table;         // Empty = no join
+    std::string join_condition;
+    std::vector<Condition> where;   // All must hold
+    std::vector<std::string> group_by;
+    std::string order_by;
+    bool descending = false;
+    size_t limit = 0;               // 0 = no limit
+};
+
+// Per-column statistics of a loaded table, shown by .stats
+struct ColumnStats {
+    std::string name;
+    size_t distinct = 0;
+    size_t empty = 0;
+    std::string min;
+    std::string max;
+    bool numeric = true;            // Every non-empty value parses as a number
+};
+
+// Interactive SQL-like queries over loaded tables, for debugging outputs without
+// writing a throwaway rules file. Joins go through QueryEngine; their results
+// and column statistics are kept for the session, so follow-up statements over
+// the same tables reuse them.
+class QueryShell {
+public:
+    static constexpr size_t kDisplayRows = 100;     // Rows printed before "... more"
+
+    explicit QueryShell(const Database& database);
+
+    // Parse one statement. Throws std::runtime_error naming the problem.
+    static QueryStatement parse(const std::string& sql);
+
+    // Run a parsed statement. Throws std::runtime_error for unknown tables or columns.
+    std::unique_ptr<QueryResult> execute(const QueryStatement& statement);
+
+    // Run one statement or dot command (.tables, .schema, .stats, .help) and
+    // print its result. Returns false for .quit.
+    bool run_command(const std::string& command, std::ostream& out);
+
+    // Read statements (ended by ';') and dot commands until end of input or .quit
+    void run(std::istream& in, std::ostream& out, bool interactive);
+
+    // Column statistics of a table, computed on first request
+    const std::vector<ColumnStats>& column_stats(const std::string& table);
+
+    // Aligned text table of the first max_rows rows
+    static std::vector<std::string> format_table(const QueryResult& result, size_t max_rows = kDisplayRows);
+
+    // Compare like GLOBAL rules do: numerically when both sides are numbers
+    static bool compare(const std::string& value, const std::string& op, const std::string& literal);
+
+private:
+    const Database& database_;
+    QueryEngine engine_;
+    std::map<std::string, std::shared_ptr<const QueryResult>> joins_;  // By tables and condition
+    std::map<std::string, std::vector<ColumnStats>> stats_;
+
+    std::shared_ptr<const QueryResult> join(const QueryStatement& statement);
+};
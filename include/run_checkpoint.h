@@ -0,0 +1,78 @@
+#pragma once
+
+#include "file_scanner.h"
+#include "output_writer.h"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Progress of one config recorded in a run checkpoint
+struct ConfigCheckpoint {
+    bool done = false;                  // Output complete, else a partly streamed CSV file
+    size_t rows = 0;                    // Rows written (the durable ones of a partial output)
+    uint64_t bytes = 0;                 // Size of the output files (the durable prefix of a partial one)
+    std::string signature;              // Inputs, rules and output options the output was made from
+    std::vector<std::string> files;     // Output file names, next to the config's headers file
+};
+
+// Where a streamed CSV output continues from, and how often it is made durable
+struct StreamCheckpoint {
+    size_t resume_rows = 0;             // Rows already in the file; the same rows emitted again are skipped
+    uint64_t resume_bytes = 0;          // Durable size of the file to continue, 0 = write a new file
+    uint64_t chunk_bytes = 0;           // Sync the file and report every this many bytes, 0 = never
+    std::function<void(size_t rows, uint64_t bytes)> on_chunk;
+};
+
+// Progress of a transform run, kept in _Checkpoint.psv at the root of the
+// output tree so a run that dies can be resumed. A config is recorded once its
+// output is complete, and a streamed CSV output also after each chunk made
+// durable on disk. A resumed run skips completed configs and continues a
+// partial output from its last checkpoint, but only while the config's inputs,
+// rules and output options are unchanged and its files are intact. The file is
+// replaced by rename on every update and removed once a run completes.
+class RunCheckpoint {
+public:
+    static constexpr const char* kFileName = "_Checkpoint.psv";
+    static constexpr uint64_t kChunkBytes = 64ull * 1024 * 1024;
+
+    // Checkpoint of a run writing under output_root. With resume the entries
+    // of an interrupted run are kept, otherwise any old checkpoint is removed.
+    RunCheckpoint(std::filesystem::path output_root, bool resume);
+
+    // Entry name of a config: its headers file path below the output root, without the suffix
+    std::string key(const OutputFileInfo& config) const;
+
+    // A config's progress if it was made with this signature and its files
+    // still hold what was recorded (complete files of the recorded total size,
+    // or a partial file at least as long as its durable prefix); else null
+    const ConfigCheckpoint* find(const OutputFileInfo& config, const std::string& signature) const;
+
+    // Record a config's progress and persist the checkpoint. Returns false
+    // when the file cannot be written.
+    bool record(const OutputFileInfo& config, const ConfigCheckpoint& progress);
+
+    // Remove the checkpoint after a complete run
+    void finish();
+
+    size_t size() const { return entries_.size(); }
+    const std::filesystem::path& path() const { return path_; }
+
+    // Hash of what a config's output depends on: its headers and rules files,
+    // every input file of the tables it reads (sizes and modification times,
+    // see ColumnStore::signature) and the output options
+    static std::string signature(const OutputFileInfo& config, const std::vector<FileInfo>& inputs,
+                                 const std::vector<std::string>& tables, const OutputOptions& options);
+
+    // Force a written file's data to disk. Returns false when that fails.
+    static bool sync_file(const std::filesystem::path& path);
+
+private:
+    std::filesystem::path root_;
+    std::filesystem::path path_;
+    std::map<std::string, ConfigCheckpoint> entries_;
+
+    bool save() const;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "perf_counters.h"
+
+// Process-wide heap allocation counters, fed by the replacement operator new
+// in run_metrics.cpp. Counts are striped per thread to keep allocation cheap
+// (threads beyond the 32 stripes share them). Counting is off until enable(),
+// and while off an allocation costs one relaxed atomic load.
+class AllocationCounter {
+public:
+    static void enable();
+    static void disable();
+    static bool enabled();
+
+    // Allocations counted while enabled
+    static uint64_t allocations();
+    static uint64_t allocated_bytes();
+};
+
+// Point-in-time process resource usage
+struct ResourceSample {
+    std::chrono::steady_clock::time_point wall;
+    double cpu_seconds = 0.0;       // User + system time of the whole process
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    PerfSample perf;                // Empty unless --perf-counters is active
+
+    static ResourceSample now();
+};
+
+// Counters for one pipeline phase or one output config
+struct StageMetrics {
+    std::string name;
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint64_t rows_in = 0;
+    uint64_t rows_out = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t peak_rss_bytes = 0;    // Process high-water mark when the stage ended
+    PerfSample perf;                // Hardware counters over the stage (--perf-counters)
+
+    // Input rows (or output rows for stages without input) per wall second
+    double rows_per_second() const;
+
+    // Bytes read plus written, in MB (10^6 bytes) per wall second
+    double mb_per_second() const;
+
+    // A count divided by input rows (or output rows), e.g. cache misses per row
+    double per_row(uint64_t count) const;
+};
+
+// Collects StageMetrics for a run and writes them as JSON (--metrics)
+class RunMetrics {
+public:
+    enum class Category {
+        PHASE,      // Pipeline step: scan, load, transform, ...
+        CONFIG      // One output configuration
+    };
+
+    // Measures a stage from construction until finish() (or destruction).
+    // Row and byte counts are filled in by the caller through counters().
+    class Stage {
+    public:
+        Stage(RunMetrics& owner, Category category, const std::string& name);
+        ~Stage();
+
+        Stage(const Stage&) = delete;
+        Stage& operator=(const Stage&) = delete;
+
+        StageMetrics& counters() { return metrics_; }
+
+        void finish();
+
+    private:
+        RunMetrics& owner_;
+        Category category_;
+        StageMetrics metrics_;
+        ResourceSample start_;
+        uint64_t trace_start_ns_ = 0;   // Stages double as --trace spans
+        bool finished_ = false;
+    };
+
+    RunMetrics();
+
+    // Record a finished stage; safe to call from several threads
+    void record(Category category, const StageMetrics& metrics);
+
+    std::vector<StageMetrics> phases() const;
+    std::vector<StageMetrics> configs() const;
+
+    // Whole run so far: wall/CPU/allocations since construction, rows and bytes summed over phases
+    StageMetrics totals() const;
+
+    // Adds a perf_counters section saying which counters were measured
+    void set_perf_status(const std::string& status);
+
+    std::string to_json() const;
+    bool write_json(const std::filesystem::path& path) const;
+
+    // Process high-water mark of resident memory, 0 where unsupported
+    static uint64_t peak_rss_bytes();
+
+private:
+    mutable std::mutex mutex_;
+    ResourceSample start_;
+    std::vector<StageMetrics> phases_;
+    std::vector<StageMetrics> configs_;
+    std::string perf_status_;
+};
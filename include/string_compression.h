@@ -0,0 +1,110 @@
+#pragma once
+
+#include "psv_parser.h"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Lightweight compression of text columns in the style of FSST (Fast Static
+// Symbol Table): up to 255 symbols of 1 to 8 bytes, learned from a sample of
+// the column, each replaced by a one-byte code. Bytes no symbol covers are
+// written as an escape code followed by the byte. Every value is encoded on its
+// own, so any single value decodes without its neighbours, and equal values
+// always have equal codes.
+class SymbolTable {
+public:
+    static constexpr size_t kMaxSymbols = 255;
+    static constexpr size_t kMaxSymbolLength = 8;
+    static constexpr uint8_t kEscape = 255;
+
+    // A table without symbols stores values unchanged
+    SymbolTable() = default;
+
+    // Learn the symbols that shorten `sample` the most
+    static SymbolTable train(const std::vector<std::string_view>& sample);
+
+    // Append the code of `value` / the value of `code` to `out`
+    void encode(std::string_view value, std::string& out) const;
+    void decode(std::string_view code, std::string& out) const;
+
+    size_t size() const { return symbols_.size(); }
+    const std::string& symbol(uint8_t code) const { return symbols_[code]; }
+
+    // Estimated heap footprint
+    uint64_t bytes() const;
+
+private:
+    std::vector<std::string> symbols_;                  // By code
+    std::array<uint64_t, kMaxSymbols> words_{};         // Symbol bytes packed for decoding
+    std::array<uint8_t, kMaxSymbols> lengths_{};
+    std::array<std::vector<uint8_t>, 256> by_first_;    // Codes by first byte, longest symbol first
+
+    explicit SymbolTable(std::vector<std::string> symbols);
+
+    // Longest symbol at the start of `text`; 0 when none matches
+    size_t match(std::string_view text, uint8_t& code) const;
+};
+
+// One column's values, each compressed with the column's symbol table
+class CompressedColumn {
+public:
+    // Column `column` of `table`; missing fields of short rows are empty. Keeps
+    // the values unchanged when the learned symbols would not shorten them.
+    static CompressedColumn compress(const PsvTable& table, size_t column);
+
+    size_t size() const { return offsets_.size() - 1; }
+
+    std::string value(size_t row) const;
+    void append_value(size_t row, std::string& out) const;
+
+    // Compressed form of a value, to compare with equals() without decoding rows
+    std::string encode(std::string_view value) const;
+    bool equals(size_t row, const std::string& encoded) const { return code(row) == encoded; }
+
+    std::string_view code(size_t row) const {
+        return std::string_view(data_).substr(offsets_[row], offsets_[row + 1] - offsets_[row]);
+    }
+
+    const SymbolTable& symbols() const { return symbols_; }
+
+    // Estimated heap footprint
+    uint64_t bytes() const;
+
+private:
+    SymbolTable symbols_;
+    std::string data_;                  // Codes of every value, in row order
+    std::vector<uint64_t> offsets_{0};  // Start of each value's code, plus the end
+};
+
+// A PsvTable held as compressed columns, typically 2-3x smaller than its
+// records. Individual fields decode on demand; decompress() rebuilds the table
+// with one field per header in every record.
+class CompressedTable {
+public:
+    // Compresses columns in parallel
+    static std::unique_ptr<CompressedTable> compress(const PsvTable& table);
+
+    std::unique_ptr<PsvTable> decompress() const;
+
+    // Like PsvTable::get_field: empty for an unknown header or row
+    std::string get_field(size_t row, const std::string& header) const;
+
+    const std::string& name() const { return name_; }
+    const std::vector<std::string>& headers() const { return headers_; }
+    size_t row_count() const { return rows_; }
+    const CompressedColumn& column(size_t index) const { return columns_[index]; }
+
+    // Estimated heap footprint, comparable with MemoryAccounting::table_bytes
+    uint64_t bytes() const;
+
+private:
+    std::string name_;
+    std::vector<std::string> headers_;
+    std::filesystem::path source_file_;
+    size_t rows_ = 0;
+    std::vector<CompressedColumn> columns_;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "config_runner.h"
+#include "file_scanner.h"
+#include "memory_accounting.h"
+#include "psv_parser.h"
+#include "string_compression.h"
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Parsed tables and config rules kept warm between serve jobs. An entry is
+// reused while its files keep the size and modification time it was read with,
+// and read again once they change. Jobs asking for a table another job is
+// loading wait for that load instead of parsing the file twice. With
+// compression, tables are kept as CompressedTables and expanded for the jobs
+// reading them; jobs running at the same time share one expanded copy.
+class TableCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t tables = 0;
+        uint64_t bytes = 0;          // Accounted size of the cached tables
+    };
+
+    // budget_bytes: size trim() shrinks the cache to, 0 = unlimited
+    explicit TableCache(uint64_t budget_bytes = 0, bool compress = false);
+
+    TableCache(const TableCache&) = delete;
+    TableCache& operator=(const TableCache&) = delete;
+
+    // The table of an input file, parsed on first use or after the file changed.
+    // Throws the parse error; a failed load is not cached.
+    std::shared_ptr<const PsvTable> get_table(const FileInfo& file);
+
+    // A directory table from these partitions (in path order), cached as one
+    // entry per set of files: jobs pruning differently get their own entry
+    std::shared_ptr<const PsvTable> get_table(const std::vector<FileInfo>& files);
+
+    // A config's headers and rules, parsed again when either file changed
+    std::shared_ptr<const ConfigRules> get_rules(const OutputFileInfo& config);
+
+    // Drop least recently used tables no job holds until the cache fits its budget
+    void trim();
+
+    Stats stats() const;
+
+private:
+    // A cached table in one of its two forms
+    struct CachedTable {
+        std::shared_ptr<const PsvTable> table;
+        std::shared_ptr<const CompressedTable> compressed;
+    };
+
+    struct TableEntry {
+        std::string signature;       // Sizes and times of the data and headers files
+        std::shared_future<CachedTable> table;
+        std::weak_ptr<const PsvTable> expanded;    // Of a compressed table, while jobs read it
+        uint64_t load_id = 0;
+        uint64_t bytes = 0;
+        uint64_t last_used = 0;
+        MemoryCharge charge;
+    };
+
+    struct RulesEntry {
+        std::string signature;
+        std::shared_ptr<const ConfigRules> rules;
+    };
+
+    // Size and modification time of each file, empty parts for missing ones
+    static std::string signature(const std::filesystem::path& first, const std::filesystem::path& second);
+
+    // The expanded copy of a compressed entry, shared with jobs already reading it
+    std::shared_ptr<const PsvTable> expand(const std::string& key,
+                                           const std::shared_ptr<const CompressedTable>& compressed);
+
+    uint64_t budget_bytes_;
+    bool compress_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, TableEntry> tables_;    // By data file paths
+    std::unordered_map<std::string, RulesEntry> rules_;     // By rules file path
+    uint64_t bytes_ = 0;
+    uint64_t clock_ = 0;             // Use counter for least recently used eviction
+    uint64_t next_load_id_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "database.h"
+#include "file_scanner.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class ColumnStore;
+
+// Parses input files into a Database on a pool of background threads, smallest
+// file first. Callers wait only for the tables they need, so a config reading a
+// small table can run while a large one is still loading. Partitions of a
+// directory table load in parallel and become one table once all are parsed.
+class TableLoader {
+public:
+    // Starts loading right away. on_finished runs once every file has loaded,
+    // on the worker thread that loaded the last one. With a store, files are
+    // read through it (see ColumnStore::load) instead of parsed directly.
+    TableLoader(Database& database, std::vector<FileInfo> files, size_t threads,
+                std::function<void()> on_finished = nullptr, ColumnStore* store = nullptr);
+
+    // Waits for loads in progress; files not yet started are skipped
+    ~TableLoader();
+
+    TableLoader(const TableLoader&) = delete;
+    TableLoader& operator=(const TableLoader&) = delete;
+
+    // True when none of `tables` is still waiting to load. Tables this loader
+    // was not given count as ready.
+    bool ready(const std::vector<std::string>& tables) const;
+
+    // Block until `tables` are ready. Rethrows the first load error.
+    void wait_for(const std::vector<std::string>& tables);
+
+    // Block until one of the candidate table sets is ready and return its
+    // index; the earliest ready candidate wins. Rethrows the first load error.
+    size_t wait_for_any(const std::vector<std::vector<std::string>>& candidates);
+
+    void wait_all();
+
+    // Parse one input file. A partition is named after its table, with its
+    // partition values appended to every row as extra columns.
+    static std::unique_ptr<PsvTable> parse_input(const FileInfo& file);
+
+    // One table of partitions parsed by parse_input, rows in the order given
+    static std::unique_ptr<PsvTable> merge_partitions(std::vector<std::unique_ptr<PsvTable>> parts);
+
+private:
+    // Parsed partitions of a directory table, in path order, until the last arrives
+    struct PartitionSet {
+        std::vector<std::unique_ptr<PsvTable>> parts;
+        size_t remaining = 0;
+    };
+
+    Database& database_;
+    std::vector<FileInfo> files_;
+    std::function<void()> on_finished_;
+    ColumnStore* store_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable table_loaded_;
+    // Files still to load per table name; a name shared by several files
+    // (the last to finish replaces the others) is ready once all have loaded
+    std::unordered_map<std::string, size_t> pending_;
+    std::unordered_map<std::string, PartitionSet> partitions_;
+    std::vector<size_t> partition_slot_;    // Per file: its place in its table's PartitionSet
+    std::exception_ptr failure_;
+    std::atomic<size_t> next_file_{0};
+    std::atomic<bool> stopping_{false};
+    std::vector<std::thread> workers_;
+
+    void run_worker();
+    bool ready_locked(const std::vector<std::string>& tables) const;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <filesystem>
+
+// One completed span; names are copied inline so recording never allocates
+struct TraceEvent {
+    static constexpr size_t kNameSize = 56;
+
+    char name[kNameSize];
+    const char* category;   // String literal
+    uint64_t start_ns;      // Since Tracer::enable()
+    uint64_t duration_ns;
+};
+
+// Span recorder for --trace, exported in the Chrome Trace Event format
+// (loadable in chrome://tracing and Perfetto).
+//
+// Each thread records into its own fixed-size ring buffer, so recording takes
+// no locks: a thread only touches the registry (under a mutex) the first time
+// it records and when it exits. An exiting thread hands its ring to the next
+// new one, so threads started per chunk of output reuse a few rings. When a
+// ring is full the oldest events are overwritten and counted as dropped.
+// While tracing is disabled a span costs one relaxed atomic load.
+class Tracer {
+public:
+    static constexpr size_t kDefaultEventsPerThread = 16384;
+
+    // Start a new trace, discarding buffers from any previous one.
+    // Must not be called while spans are open on other threads.
+    static void enable(size_t events_per_thread = kDefaultEventsPerThread);
+    static void disable();
+    static bool enabled();
+
+    // Nanoseconds since enable()
+    static uint64_t now_ns();
+
+    static void record(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns);
+
+    // Chrome Trace Event JSON of everything recorded; call once worker threads are done
+    static std::string to_json();
+    static bool write_json(const std::filesystem::path& path);
+
+    // Ring buffers of the current trace, at most one per thread alive at once
+    static size_t thread_buffers();
+
+    // Events overwritten because a thread's ring buffer was full
+    static uint64_t dropped_events();
+};
+
+// Records the enclosing scope as a span when tracing is enabled
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name);
+    TraceSpan(const char* category, const std::string& name);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* category_;
+    char name_[TraceEvent::kNameSize];
+    uint64_t start_ns_;
+    bool active_;
+};
@@ -2,6 +2,7 @@
 
 #include "database.h"
 #include "query_engine.h"
+#include <functional>
 #include <string>
 #include <vector>
 #include <filesystem>
@@ -27,6 +28,23 @@ struct TransformationRule {
     std::vector<std::string> union_tables; // For UNION operations
 };
 
+// A config whose every output column is a bare column of one source table,
+// which can be written straight from the loaded records (see plan_projection)
+struct ProjectionPlan {
+    const PsvTable* source = nullptr;
+    std::vector<size_t> column_indices; // Source column for each output header
+};
+
+// Rows and time of each step of the last transform_rows() call (explain --analyze)
+struct TransformStats {
+    size_t source_rows = 0;         // Rows out of the JOIN, UNION or select (before filters)
+    uint64_t source_bytes = 0;      // Estimated size of that intermediate result
+    double source_seconds = 0.0;
+    size_t filtered_rows = 0;       // Rows passing the GLOBAL filters
+    double filter_seconds = 0.0;    // Per-row times, only measured with set_timed(true)
+    double project_seconds = 0.0;
+};
+
 class TransformationEngine {
 public:
     explicit TransformationEngine(const Database& db, QueryEngine& query_engine);
@@ -37,17 +55,69 @@ public:
     // Load output headers
     void load_output_headers(const std::filesystem::path& headers_path);
     
+    // Use rules and headers parsed earlier (e.g. kept warm by the serve mode)
+    void set_rules(std::vector<TransformationRule> rules);
+    void set_output_headers(std::vector<std::string> headers);
+    
     // Transform data according to rules
     std::unique_ptr<QueryResult> transform_data();
     
+    // Same transformation, handing each output row to emit instead of collecting
+    // them, so streaming writers never hold the whole result. Returns rows emitted.
+    size_t transform_rows(const std::function<void(std::vector<std::string>&&)>& emit);
+    
     // Get output headers
     const std::vector<std::string>& get_output_headers() const;
+    
+    // Source rows (after JOIN/UNION) examined by the last transform_data() call
+    size_t get_rows_scanned() const;
+    
+    // Steps of the last transform_data()/transform_rows() call
+    const TransformStats& get_stats() const;
+    
+    // Time filtering and projection of every row separately (costs two clock reads per row)
+    void set_timed(bool timed);
+    
+    // Show the processing progress bar (on by default)
+    void set_progress(bool show_progress);
+    
+    // Parsed rules, in file order
+    const std::vector<TransformationRule>& get_rules() const;
+    
+    // Table a config without JOIN/UNION reads, empty if its rules are all static
+    std::string get_source_table() const;
+    
+    // Detect a pure projection: no JOIN/UNION and every output column is a direct
+    // source column reference. GLOBAL filters are allowed and checked per row.
+    bool plan_projection(ProjectionPlan& plan) const;
+    
+    // Check a source row against all GLOBAL filter rules
+    bool passes_global_filters(const std::vector<std::string>& row,
+                               const std::vector<std::string>& headers);
+    
+    // Evaluate one GLOBAL rule condition against a row
+    static bool evaluate_rule_condition(const std::string& condition,
+                                        const std::vector<std::string>& row,
+                                        const std::vector<std::string>& headers);
+    
+    // The one column a GLOBAL condition tests (field op 'value', optionally
+    // wrapped in ? ACCEPT : REJECT), empty when it has another form
+    static std::string condition_field(const std::string& condition);
 
 private:
     const Database& database_;
     QueryEngine& query_engine_;
     std::vector<TransformationRule> rules_;
     std::vector<std::string> output_headers_;
+    TransformStats stats_;
+    bool timed_ = false;
+    bool show_progress_ = true;
+    
+    // Pick the source table for configs without JOIN/UNION, empty if rules are all static
+    std::string find_source_table(const std::vector<std::string>& table_names) const;
+    
+    // Whole-word match of a field name inside an expression
+    static bool references_field(const std::string& expression, const std::string& field);
     
     // Parse rule from text line
     TransformationRule parse_rule(const std::string& rule_text);
@@ -57,13 +127,8 @@ private:
                           const std::vector<std::string>& input_row,
                           const std::vector<std::string>& input_headers);
     
-    // Evaluate rule condition
-    bool evaluate_rule_condition(const std::string& condition,
-                               const std::vector<std::string>& row,
-                               const std::vector<std::string>& headers);
-    
     // Evaluate simple condition (helper for if-else logic)
-    bool evaluate_simple_condition(const std::string& condition,
-                                 const std::vector<std::string>& row,
-                                 const std::vector<std::string>& headers);
+    static bool evaluate_simple_condition(const std::string& condition,
+                                          const std::vector<std::string>& row,
+                                          const std::vector<std::string>& headers);
 };
\ No newline at end of file
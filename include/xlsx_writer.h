@@ -0,0 +1,46 @@
+#pragma once
+
+#include "query_engine.h"
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Writes results as an Excel workbook (.xlsx) through the streaming ZipWriter.
+//
+// Column types are inferred once up front: integer and decimal columns become
+// numeric cells, everything else (including IDs with leading zeros and dates)
+// stays text so Excel cannot reinterpret it. Repetitive text columns go through
+// the shared-strings table, other text is written as inline strings. Sheet XML
+// is generated in row chunks on worker threads and streamed into the archive in
+// order, so only one wave of chunks is held in memory at a time. Results larger
+// than one sheet continue on Sheet2, Sheet3, ...
+class XlsxWriter {
+public:
+    // Excel's sheet limit is 1,048,576 rows, one of which holds the headers
+    static constexpr size_t kMaxRowsPerSheet = 1048575;
+    static constexpr size_t kMaxColumns = 16384;
+    static constexpr size_t kDefaultChunkRows = 16384;
+
+    static bool write_xlsx(const QueryResult& result,
+                           const std::filesystem::path& output_path,
+                           size_t rows_per_sheet = kMaxRowsPerSheet,
+                           size_t chunk_rows = kDefaultChunkRows);
+
+    // Write only the selected rows (by index into result.rows), used for partitioned output
+    static bool write_xlsx_rows(const QueryResult& result,
+                                const std::vector<size_t>& row_indices,
+                                const std::filesystem::path& output_path);
+
+    // Spreadsheet column name for a zero-based index: 0 -> A, 26 -> AA
+    static std::string column_name(size_t index);
+
+    // Append value to out as XML character data; characters XML 1.0 cannot carry are dropped
+    static void append_xml_escaped(std::string& out, const std::string& value);
+
+private:
+    static bool write_impl(const QueryResult& result,
+                           const std::vector<size_t>* row_indices,
+                           const std::filesystem::path& output_path,
+                           size_t rows_per_sheet,
+                           size_t chunk_rows);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+// Minimal streaming ZIP container writer.
+//
+// Entries are stored uncompressed and written one at a time: the local header
+// is emitted with placeholder CRC and sizes, the entry data is streamed straight
+// to the file, and the header is patched in place once the entry ends. Only the
+// central directory (a few dozen bytes per entry) is kept in memory. Archives
+// are limited to 4 GB since ZIP64 records are not written.
+class ZipWriter {
+public:
+    explicit ZipWriter(const std::filesystem::path& path);
+
+    bool is_open() const;
+
+    // Start a new entry; the previous entry must have been ended
+    bool begin_entry(const std::string& name);
+
+    // Append data to the current entry
+    bool write(const char* data, size_t length);
+    bool write(const std::string& data);
+
+    // Patch the local header of the current entry with its CRC and size
+    bool end_entry();
+
+    // Write the central directory; no entries can be added afterwards
+    bool finish();
+
+    // Update a running CRC-32 (IEEE) with data; start from 0
+    static uint32_t crc32(uint32_t crc, const char* data, size_t length);
+
+private:
+    struct Entry {
+        std::string name;
+        uint32_t crc = 0;
+        uint64_t size = 0;
+        uint64_t header_offset = 0;
+    };
+
+    std::ofstream file_;
+    std::vector<Entry> entries_;
+    bool in_entry_ = false;
+    bool finished_ = false;
+    bool ok_ = true;
+};
@@ -85,6 +85,14 @@ std::string AnsiOutput::get_reset_code() {
     return "\033[0m";
 }
 
+bool AnsiOutput::is_terminal_input() {
+#if defined(_WIN32) || defined(_WIN64)
+    return _isatty(_fileno(stdin));
+#else
+    return isatty(STDIN_FILENO);
+#endif
+}
+
 bool AnsiOutput::is_terminal_output() {
 #if defined(_WIN32) || defined(_WIN64)
     return _isatty(_fileno(stdout));
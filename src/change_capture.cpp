@@ -0,0 +1,361 @@
+#include "change_capture.h"
+#include "run_checkpoint.h"
+#include "tracer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'P', 'F', 'P'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kHeaderBytes = sizeof(kMagic) + sizeof(uint32_t) + 3 * sizeof(uint64_t);
+
+// Set in a previous entry's key offset once a row matched it, so the flag
+// shares the entry's cache line
+constexpr uint64_t kMatched = uint64_t(1) << 63;
+
+// Previous entries per directory bucket, on average
+constexpr uint64_t kEntriesPerBucket = 4;
+
+constexpr uint64_t kMultiplier = 0xc6a4a7935bd1e995ull;
+
+// MurmurHash64A over one field, 8 bytes at a time
+uint64_t hash_bytes(std::string_view data, uint64_t seed) {
+    const int r = 47;
+    uint64_t h = seed ^ (data.size() * kMultiplier);
+    size_t words = data.size() / 8;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t k;
+        std::memcpy(&k, data.data() + i * 8, sizeof(k));
+        k *= kMultiplier;
+        k ^= k >> r;
+        k *= kMultiplier;
+        h ^= k;
+        h *= kMultiplier;
+    }
+    size_t tail = data.size() & 7;
+    if (tail) {
+        uint64_t k = 0;
+        std::memcpy(&k, data.data() + words * 8, tail);
+        h ^= k;
+        h *= kMultiplier;
+    }
+    h ^= h >> r;
+    h *= kMultiplier;
+    h ^= h >> r;
+    return h;
+}
+
+std::string_view field_at(const std::vector<std::string>& row, size_t column) {
+    return column < row.size() ? std::string_view(row[column]) : std::string_view();
+}
+
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(_MSC_VER)
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+template <typename T>
+void write_value(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T read_value(std::istream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+} // namespace
+
+static_assert(sizeof(uint64_t) * 3 == ChangeCapture::kEntryBytes, "entries are written as they are in memory");
+
+ChangeCapture::ChangeCapture(std::filesystem::path fingerprint_path,
+                             const std::vector<std::string>& headers,
+                             const std::vector<std::string>& key_columns)
+    : path_(std::move(fingerprint_path)), headers_(headers) {
+    for (size_t column = 0; column < headers_.size(); ++column) {
+        all_columns_.push_back(column);
+    }
+    for (const auto& key : key_columns) {
+        auto it = std::find(headers_.begin(), headers_.end(), key);
+        if (it == headers_.end()) {
+            throw std::invalid_argument("Diff key column is not an output header: " + key);
+        }
+        key_columns_.push_back(static_cast<size_t>(it - headers_.begin()));
+    }
+    if (key_columns_.empty()) {
+        key_columns_ = all_columns_;
+    }
+    stores_keys_ = key_columns_ != all_columns_;
+
+    std::vector<std::string> key_names;
+    for (size_t column : key_columns_) {
+        key_names.push_back(headers_[column]);
+    }
+    schema_hash_ = hash_columns(headers_, all_columns_) ^ (hash_columns(key_names, all_columns_) * 31);
+    load();
+}
+
+uint64_t ChangeCapture::hash_columns(const std::vector<std::string>& row, const std::vector<size_t>& columns) {
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (size_t column : columns) {
+        h = hash_bytes(field_at(row, column), h);
+    }
+    return h;
+}
+
+std::filesystem::path ChangeCapture::fingerprint_path_for(const std::filesystem::path& output_path) {
+    return output_path.parent_path() / (output_path.stem().string() + "_Fingerprints.apfp");
+}
+
+void ChangeCapture::load() {
+    std::error_code ec;
+    if (!std::filesystem::exists(path_, ec)) {
+        return;
+    }
+    TraceSpan span("diff", "load " + path_.filename().string());
+    std::ifstream in(path_, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    in.read(magic, sizeof(magic));
+    uint32_t version = read_value<uint32_t>(in);
+    uint64_t schema = read_value<uint64_t>(in);
+    uint64_t count = read_value<uint64_t>(in);
+    uint64_t key_bytes = read_value<uint64_t>(in);
+    uint64_t file_bytes = std::filesystem::file_size(path_, ec);
+    if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion || ec ||
+        count > file_bytes / kEntryBytes || file_bytes != kHeaderBytes + count * kEntryBytes + key_bytes) {
+        // Diff against no previous run rather than fail it; save() writes a good file
+        previous_damaged_ = true;
+        return;
+    }
+    if (schema != schema_hash_) {
+        // Other columns or keys; the old hashes cannot be compared
+        return;
+    }
+
+    previous_.resize(static_cast<size_t>(count));
+    in.read(reinterpret_cast<char*>(previous_.data()), static_cast<std::streamsize>(count * kEntryBytes));
+    if (stores_keys_) {
+        previous_keys_.resize(static_cast<size_t>(key_bytes));
+        in.read(&previous_keys_[0], static_cast<std::streamsize>(key_bytes));
+    } else {
+        // Only the hashes are used; files from before whole-row keys were
+        // dropped still point into key values
+        for (auto& entry : previous_) {
+            entry.key_offset = 0;
+        }
+    }
+    if (!in || !keys_fit()) {
+        previous_.clear();
+        previous_keys_.clear();
+        previous_damaged_ = true;
+        return;
+    }
+    has_previous_ = true;
+
+    // Entries are sorted by key hash, so the top bits of the hash split them
+    // into contiguous buckets; the directory holds where each bucket starts
+    int bits = 0;
+    while (bits < 32 && (uint64_t(1) << bits) * kEntriesPerBucket < count) {
+        bits++;
+    }
+    directory_shift_ = 64 - bits;
+    size_t buckets = size_t(1) << bits;
+    directory_.assign(buckets, 0);
+    size_t entry = 0;
+    for (size_t bucket = 0; bucket < buckets; ++bucket) {
+        directory_[bucket] = entry;
+        while (entry < previous_.size() &&
+               (bits == 0 || (previous_[entry].key_hash >> directory_shift_) == bucket)) {
+            entry++;
+        }
+    }
+}
+
+bool ChangeCapture::keys_fit() const {
+    // Every entry's key values must lie inside the stored key bytes, so
+    // deleted_rows() can read them unchecked
+    if (!stores_keys_) {
+        return true;
+    }
+    for (const auto& entry : previous_) {
+        uint64_t offset = entry.key_offset;
+        for (size_t i = 0; i < key_columns_.size(); ++i) {
+            uint32_t length = 0;
+            if (offset > previous_keys_.size() || previous_keys_.size() - offset < sizeof(length)) {
+                return false;
+            }
+            std::memcpy(&length, previous_keys_.data() + offset, sizeof(length));
+            offset += sizeof(length);
+            if (previous_keys_.size() - offset < length) {
+                return false;
+            }
+            offset += length;
+        }
+    }
+    return true;
+}
+
+void ChangeCapture::append_key(const std::vector<std::string>& row) {
+    if (!stores_keys_) {
+        return;
+    }
+    for (size_t column : key_columns_) {
+        std::string_view value = field_at(row, column);
+        uint32_t length = static_cast<uint32_t>(value.size());
+        current_keys_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        current_keys_.append(value);
+    }
+}
+
+const ChangeCapture::Entry& ChangeCapture::add_current(const std::vector<std::string>& row) {
+    uint64_t key_hash = hash_columns(row, key_columns_);
+    // Without a declared key the key is the whole row
+    uint64_t row_hash = stores_keys_ ? hash_columns(row, all_columns_) : key_hash;
+    current_.push_back({key_hash, row_hash, current_keys_.size()});
+    append_key(row);
+    return current_.back();
+}
+
+size_t ChangeCapture::bucket_start(uint64_t key_hash) const {
+    size_t bucket = directory_shift_ == 64 ? 0 : static_cast<size_t>(key_hash >> directory_shift_);
+    return static_cast<size_t>(directory_[bucket]);
+}
+
+char ChangeCapture::resolve(const Entry& row, size_t begin) {
+    char operation = kInsert;
+    if (has_previous_) {
+        // Buckets are contiguous, so the bucket ends where the hashes pass this key
+        while (begin < previous_.size() && previous_[begin].key_hash < row.key_hash) {
+            begin++;
+        }
+        size_t same_key = previous_.size();
+        for (size_t entry = begin; entry < previous_.size() && previous_[entry].key_hash == row.key_hash; ++entry) {
+            if (previous_[entry].key_offset & kMatched) {
+                continue;
+            }
+            if (previous_[entry].row_hash == row.row_hash) {
+                previous_[entry].key_offset |= kMatched;
+                counts_.unchanged++;
+                return 0;
+            }
+            same_key = std::min(same_key, entry);
+        }
+        if (same_key != previous_.size()) {
+            previous_[same_key].key_offset |= kMatched;
+            operation = kUpdate;
+        }
+    }
+    if (operation == kInsert) {
+        counts_.inserted++;
+    } else {
+        counts_.updated++;
+    }
+    return operation;
+}
+
+char ChangeCapture::classify(const std::vector<std::string>& row) {
+    const Entry& entry = add_current(row);
+    return resolve(entry, has_previous_ ? bucket_start(entry.key_hash) : 0);
+}
+
+void ChangeCapture::classify(const std::vector<std::vector<std::string>>& rows, std::string& operations) {
+    operations.resize(rows.size());
+    size_t begins[kBatchRows];
+    for (size_t start = 0; start < rows.size(); start += kBatchRows) {
+        size_t count = std::min(kBatchRows, rows.size() - start);
+        size_t first = current_.size();
+        for (size_t i = 0; i < count; ++i) {
+            add_current(rows[start + i]);
+        }
+        if (has_previous_) {
+            // Look up the whole batch's buckets, then fetch their entries, so
+            // the cache misses of a batch overlap instead of following each other
+            for (size_t i = 0; i < count; ++i) {
+                begins[i] = bucket_start(current_[first + i].key_hash);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (begins[i] < previous_.size()) {
+                    prefetch(&previous_[begins[i]]);
+                }
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            operations[start + i] = resolve(current_[first + i], has_previous_ ? begins[i] : 0);
+        }
+    }
+}
+
+std::vector<std::vector<std::string>> ChangeCapture::deleted_rows() {
+    std::vector<std::vector<std::string>> rows;
+    for (size_t entry = 0; entry < previous_.size(); ++entry) {
+        if (previous_[entry].key_offset & kMatched) {
+            continue;
+        }
+        std::vector<std::string> row(headers_.size());
+        // Without declared keys only the hashes were kept, so the row stays empty
+        if (stores_keys_) {
+            size_t offset = static_cast<size_t>(previous_[entry].key_offset & ~kMatched);
+            for (size_t column : key_columns_) {
+                uint32_t length = 0;
+                std::memcpy(&length, previous_keys_.data() + offset, sizeof(length));
+                offset += sizeof(length);
+                row[column].assign(previous_keys_.data() + offset, length);
+                offset += length;
+            }
+        }
+        rows.push_back(std::move(row));
+        previous_[entry].key_offset |= kMatched;
+    }
+    counts_.deleted += rows.size();
+    return rows;
+}
+
+bool ChangeCapture::save() {
+    TraceSpan span("diff", "save " + path_.filename().string());
+    std::sort(current_.begin(), current_.end(), [](const Entry& a, const Entry& b) {
+        return a.key_hash != b.key_hash ? a.key_hash < b.key_hash : a.row_hash < b.row_hash;
+    });
+
+    auto temporary = path_.string() + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(kMagic, sizeof(kMagic));
+        write_value(out, kVersion);
+        write_value(out, schema_hash_);
+        write_value(out, static_cast<uint64_t>(current_.size()));
+        write_value(out, static_cast<uint64_t>(current_keys_.size()));
+        out.write(reinterpret_cast<const char*>(current_.data()),
+                  static_cast<std::streamsize>(current_.size() * kEntryBytes));
+        out.write(current_keys_.data(), static_cast<std::streamsize>(current_keys_.size()));
+        // Closing flushes the buffer, which is where a full disk shows
+        out.close();
+        // A short file would replace good fingerprints and make every row an insert
+        if (!out || !RunCheckpoint::sync_file(temporary)) {
+            std::error_code ec;
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path_, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
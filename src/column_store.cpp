@@ -0,0 +1,300 @@
+#include "column_store.h"
+#include "columnar_writer.h"
+#include "table_loader.h"
+#include "tracer.h"
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Read-only mapping of a whole file. Its pages come from the page cache, so
+// every process mapping the same file shares one copy.
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32) || defined(_WIN64)
+        file_ = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size;
+        if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+            close();
+            throw std::runtime_error("Cannot map column file: " + path.string());
+        }
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            close();
+            throw std::runtime_error("Cannot map column file: " + path.string());
+        }
+        data_ = static_cast<const char*>(view);
+        size_ = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (fd < 0 || fstat(fd, &status) != 0 || status.st_size == 0) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            throw std::runtime_error("Cannot map column file: " + path.string());
+        }
+        size_ = static_cast<size_t>(status.st_size);
+        void* view = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping keeps the file open
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            throw std::runtime_error("Cannot map column file: " + path.string());
+        }
+        data_ = static_cast<const char*>(view);
+#endif
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+
+    void close() {
+#if defined(_WIN32) || defined(_WIN64)
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_) {
+            CloseHandle(mapping_);
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+        }
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+    }
+};
+
+// A mapped column file and the view over it, kept alive by the tables reading it
+struct StoredColumns {
+    MappedFile file;
+    ColumnarView view;
+
+    explicit StoredColumns(const std::filesystem::path& path) : file(path), view(file.data(), file.size()) {}
+};
+
+// Suffix for files being written, unique per thread and moment so concurrent
+// writers (threads or processes) never share one
+std::string temporary_suffix() {
+    std::ostringstream suffix;
+    suffix << ".tmp" << std::hex << std::hash<std::thread::id>{}(std::this_thread::get_id())
+           << std::chrono::steady_clock::now().time_since_epoch().count();
+    return suffix.str();
+}
+
+// Catalog key of an input: its absolute path, so runs from other directories agree
+std::string source_key(const FileInfo& file) {
+    std::error_code ec;
+    auto absolute = std::filesystem::absolute(file.path, ec);
+    return (ec ? file.path : absolute.lexically_normal()).string();
+}
+
+} // namespace
+
+ColumnStore::ColumnStore(std::filesystem::path directory) : directory_(std::move(directory)) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (!std::filesystem::is_directory(directory_)) {
+        throw std::runtime_error("Cannot create column store directory: " + directory_.string());
+    }
+    catalog_ = read_catalog(directory_ / kCatalogName);
+}
+
+std::string ColumnStore::signature(const FileInfo& file) {
+    std::ostringstream out;
+    for (const auto* path : {&file.path, &file.headers_path}) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(*path, ec);
+        if (!ec) {
+            out << size;
+        }
+        out << ':';
+        auto modified = std::filesystem::last_write_time(*path, ec);
+        if (!ec) {
+            out << modified.time_since_epoch().count();
+        }
+        out << ';';
+    }
+    // A table gaining a partition key adds a column to all of its partitions
+    for (const auto& value : file.partition_values) {
+        out << value.first << '=' << value.second << ';';
+    }
+    return out.str();
+}
+
+bool ColumnStore::contains(const FileInfo& file) const {
+    std::string current = signature(file);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = catalog_.find(source_key(file));
+    return it != catalog_.end() && it->second.signature == current &&
+           std::filesystem::exists(directory_ / it->second.file);
+}
+
+std::unique_ptr<PsvTable> ColumnStore::load(const FileInfo& file) {
+    std::string current = signature(file);
+    Entry entry;
+    bool stored = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = catalog_.find(source_key(file));
+        if (it != catalog_.end() && it->second.signature == current) {
+            entry = it->second;
+            stored = true;
+        }
+    }
+
+    if (stored) {
+        try {
+            auto table = map_table(file, entry);
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.hits++;
+            return table;
+        } catch (const std::exception&) {
+            // Column file removed, damaged or from an older layout: parse the input and store it again
+        }
+    }
+
+    auto table = TableLoader::parse_input(file);
+    bool saved = save(file, *table, current);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.misses++;
+    if (!saved) {
+        stats_.write_errors++;
+    }
+    return table;
+}
+
+ColumnStore::Stats ColumnStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::unique_ptr<PsvTable> ColumnStore::map_table(const FileInfo& file, const Entry& entry) const {
+    TraceSpan span("parse", "map " + entry.file);
+    auto stored = std::make_shared<const StoredColumns>(directory_ / entry.file);
+
+    // The table reads its fields from the mapping; nothing is copied to the heap
+    auto table = std::make_unique<PsvTable>();
+    table->name = file.table();
+    table->source_file = file.is_partition() ? file.headers_path.parent_path() : file.path;
+    table->headers = stored->view.headers();
+    table->columns = std::shared_ptr<const ColumnarView>(stored, &stored->view);
+    table->build_header_index();
+    return table;
+}
+
+bool ColumnStore::save(const FileInfo& file, PsvTable& table, const std::string& signature) {
+    // Named after the table, and unique per input path
+    std::ostringstream name;
+    name << table.name << '-' << std::hex << std::setw(16) << std::setfill('0')
+         << static_cast<uint64_t>(std::hash<std::string>{}(source_key(file))) << ".apcol";
+    Entry entry{name.str(), signature};
+    auto temporary = directory_ / (entry.file + temporary_suffix());
+
+    // Lend the records' fields to the writer rather than copying them
+    QueryResult image;
+    image.headers = table.headers;
+    image.rows.reserve(table.records.size());
+    for (auto& record : table.records) {
+        image.rows.push_back(std::move(record.fields));
+    }
+    // String columns only, so later runs can read the file in place
+    bool written = ColumnarWriter::write_columnar(image, temporary, false);
+    for (size_t row = 0; row < table.records.size(); ++row) {
+        table.records[row].fields = std::move(image.rows[row]);
+    }
+
+    // Readers see the old column file or the new one, never a partial one
+    std::error_code ec;
+    if (written) {
+        std::filesystem::rename(temporary, directory_ / entry.file, ec);
+    }
+    if (!written || ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+
+    // Start from the catalog on disk, which other processes may have added to
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto catalog = read_catalog(directory_ / kCatalogName);
+    catalog[source_key(file)] = entry;
+    if (!write_catalog(directory_ / kCatalogName, catalog)) {
+        return false;
+    }
+    catalog_ = std::move(catalog);
+    return true;
+}
+
+std::map<std::string, ColumnStore::Entry> ColumnStore::read_catalog(const std::filesystem::path& path) {
+    std::map<std::string, Entry> catalog;
+    std::ifstream file(path);
+    std::string line;
+    // The first line names the columns
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        auto fields = PsvParser::split_psv_line(line);
+        if (fields.size() == 3) {
+            catalog[fields[0]] = Entry{fields[1], fields[2]};
+        }
+    }
+    return catalog;
+}
+
+bool ColumnStore::write_catalog(const std::filesystem::path& path, const std::map<std::string, Entry>& catalog) {
+    auto temporary = path.string() + temporary_suffix();
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << "source|file|signature\n";
+        for (const auto& entry : catalog) {
+            file << entry.first << '|' << entry.second.file << '|' << entry.second.signature << '\n';
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,569 @@
+#include "columnar_writer.h"
+#include "memory_accounting.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+constexpr char ColumnarWriter::kMagic[8];
+
+namespace {
+
+constexpr size_t kHeaderSize = 32;
+
+// Rows of a result, optionally restricted to a subset of indices
+struct RowSelection {
+    const QueryResult& result;
+    const std::vector<size_t>* indices;
+
+    size_t size() const { return indices ? indices->size() : result.rows.size(); }
+
+    const std::string& value(size_t row, size_t column) const {
+        static const std::string kEmpty;
+        const auto& fields = result.rows[indices ? (*indices)[row] : row];
+        return column < fields.size() ? fields[column] : kEmpty;
+    }
+};
+
+// The format is little-endian; every platform we build for is too, so plain copies suffice
+template <typename T>
+void append_pod(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T read_pod(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+void pad_to_8(std::string& out) {
+    out.append((8 - out.size() % 8) % 8, '\0');
+}
+
+size_t padded_8(size_t length) {
+    return (length + 7) & ~static_cast<size_t>(7);
+}
+
+bool parse_int64(const std::string& text, int64_t& value) {
+    size_t pos = 0;
+    bool negative = false;
+    if (!text.empty() && text[0] == '-') {
+        negative = true;
+        pos = 1;
+    }
+
+    size_t digits = text.size() - pos;
+    // Reject leading zeros so IDs like "007" stay strings and round-trip exactly
+    if (digits == 0 || digits > 19 || (text[pos] == '0' && (digits > 1 || negative))) {
+        return false;
+    }
+
+    uint64_t magnitude = 0;
+    for (size_t i = pos; i < text.size(); ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        magnitude = magnitude * 10 + static_cast<uint64_t>(text[i] - '0');
+    }
+
+    uint64_t limit = negative ? static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1
+                              : static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    if (magnitude > limit) {
+        return false;
+    }
+
+    value = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+    return true;
+}
+
+std::string format_double(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    if (std::strtod(buffer, nullptr) != value) {
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    return buffer;
+}
+
+bool parse_plain_double(const std::string& text, double& value) {
+    // Accept only plain decimal notation: -?(0|[1-9][0-9]*)(\.[0-9]+)?
+    size_t pos = 0;
+    if (pos < text.size() && text[pos] == '-') pos++;
+
+    size_t int_start = pos;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') pos++;
+    size_t int_digits = pos - int_start;
+    if (int_digits == 0 || (int_digits > 1 && text[int_start] == '0')) {
+        return false;
+    }
+
+    if (pos < text.size()) {
+        if (text[pos] != '.') return false;
+        pos++;
+        size_t frac_start = pos;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') pos++;
+        if (pos == frac_start || pos != text.size()) return false;
+    }
+
+    value = std::strtod(text.c_str(), nullptr);
+    // Like leading zeros for integers: "19.90" or "1.0" would decode as
+    // "19.9" and "1", so only values printed back as written are doubles
+    return format_double(value) == text;
+}
+
+void encode_numeric(const RowSelection& rows, size_t column, ColumnDescriptor& desc, std::string& block) {
+    size_t row_count = rows.size();
+    std::string bitmap((row_count + 7) / 8, '\0');
+    bool have_value = false;
+
+    block.reserve(row_count * 8 + bitmap.size() + 8);
+    for (size_t row = 0; row < row_count; ++row) {
+        const std::string& text = rows.value(row, column);
+        if (text.empty()) {
+            bitmap[row / 8] |= static_cast<char>(1 << (row % 8));
+            desc.null_count++;
+            append_pod<int64_t>(block, 0);
+            continue;
+        }
+
+        if (desc.type == ColumnType::INT64) {
+            int64_t value = 0;
+            parse_int64(text, value);
+            append_pod(block, value);
+            desc.min_int = have_value ? std::min(desc.min_int, value) : value;
+            desc.max_int = have_value ? std::max(desc.max_int, value) : value;
+        } else {
+            double value = 0.0;
+            parse_plain_double(text, value);
+            append_pod(block, value);
+            desc.min_double = have_value ? std::min(desc.min_double, value) : value;
+            desc.max_double = have_value ? std::max(desc.max_double, value) : value;
+        }
+        have_value = true;
+    }
+
+    block.append(bitmap);
+    pad_to_8(block);
+}
+
+void encode_string(const RowSelection& rows, size_t column, ColumnDescriptor& desc, std::string& block) {
+    size_t row_count = rows.size();
+
+    // Dictionary-encode when values repeat at least twice on average
+    std::unordered_map<std::string_view, uint32_t> dictionary;
+    std::vector<std::string_view> dictionary_values;
+    std::vector<uint32_t> codes;
+    codes.reserve(row_count);
+
+    bool use_dictionary = row_count > 0;
+    for (size_t row = 0; row < row_count && use_dictionary; ++row) {
+        std::string_view value = rows.value(row, column);
+        auto it = dictionary.find(value);
+        if (it == dictionary.end()) {
+            it = dictionary.emplace(value, static_cast<uint32_t>(dictionary_values.size())).first;
+            dictionary_values.push_back(value);
+            if (dictionary_values.size() * 2 > row_count) {
+                use_dictionary = false;
+            }
+        }
+        codes.push_back(it->second);
+    }
+
+    MemoryCharge dictionary_charge(MemoryCategory::HASH_TABLE, "columnar dictionary",
+                                   MemoryAccounting::hash_table_bytes(dictionary) +
+                                   dictionary_values.capacity() * sizeof(std::string_view) +
+                                   codes.capacity() * sizeof(uint32_t));
+
+    // Statistics are computed over distinct values when a dictionary exists
+    auto update_bounds = [&desc](std::string_view value, bool first) {
+        if (first || value < desc.min_string) desc.min_string = std::string(value);
+        if (first || value > desc.max_string) desc.max_string = std::string(value);
+    };
+
+    if (use_dictionary) {
+        desc.encoding = ColumnEncoding::DICTIONARY;
+        desc.dictionary_size = dictionary_values.size();
+
+        uint64_t offset = 0;
+        append_pod(block, offset);
+        for (size_t i = 0; i < dictionary_values.size(); ++i) {
+            offset += dictionary_values[i].size();
+            append_pod(block, offset);
+            update_bounds(dictionary_values[i], i == 0);
+        }
+        for (const auto& value : dictionary_values) {
+            block.append(value.data(), value.size());
+        }
+        pad_to_8(block);
+
+        for (uint32_t code : codes) {
+            append_pod(block, code);
+        }
+        pad_to_8(block);
+        return;
+    }
+
+    desc.encoding = ColumnEncoding::PLAIN;
+    uint64_t offset = 0;
+    append_pod(block, offset);
+    for (size_t row = 0; row < row_count; ++row) {
+        const std::string& value = rows.value(row, column);
+        offset += value.size();
+        append_pod(block, offset);
+        update_bounds(value, row == 0);
+    }
+    for (size_t row = 0; row < row_count; ++row) {
+        block.append(rows.value(row, column));
+    }
+    pad_to_8(block);
+}
+
+void append_descriptor(std::string& footer, const ColumnDescriptor& desc) {
+    append_pod(footer, static_cast<uint32_t>(desc.type));
+    append_pod(footer, static_cast<uint32_t>(desc.encoding));
+    append_pod(footer, desc.offset);
+    append_pod(footer, desc.length);
+    append_pod(footer, desc.dictionary_size);
+    append_pod(footer, desc.null_count);
+    if (desc.type == ColumnType::DOUBLE) {
+        append_pod(footer, desc.min_double);
+        append_pod(footer, desc.max_double);
+    } else {
+        append_pod(footer, desc.min_int);
+        append_pod(footer, desc.max_int);
+    }
+    append_pod(footer, static_cast<uint32_t>(desc.name.size()));
+    append_pod(footer, static_cast<uint32_t>(desc.min_string.size()));
+    append_pod(footer, static_cast<uint32_t>(desc.max_string.size()));
+    append_pod<uint32_t>(footer, 0); // Reserved
+    footer.append(desc.name);
+    footer.append(desc.min_string);
+    footer.append(desc.max_string);
+    pad_to_8(footer);
+}
+
+} // namespace
+
+bool ColumnarWriter::write_columnar(const QueryResult& result,
+                                   const std::filesystem::path& output_path,
+                                   bool infer_types) {
+    return write_impl(result, nullptr, output_path, infer_types);
+}
+
+bool ColumnarWriter::write_columnar_rows(const QueryResult& result,
+                                        const std::vector<size_t>& row_indices,
+                                        const std::filesystem::path& output_path) {
+    return write_impl(result, &row_indices, output_path, true);
+}
+
+ColumnType ColumnarWriter::infer_type(const std::vector<const std::string*>& values) {
+    bool all_int = true;
+    bool all_double = true;
+    bool any_value = false;
+
+    for (const std::string* text : values) {
+        if (text->empty()) continue;
+        any_value = true;
+
+        int64_t int_value;
+        double double_value;
+        if (all_int && !parse_int64(*text, int_value)) all_int = false;
+        if (all_double && !parse_plain_double(*text, double_value)) all_double = false;
+        if (!all_int && !all_double) break;
+    }
+
+    if (!any_value) return ColumnType::STRING;
+    if (all_int) return ColumnType::INT64;
+    if (all_double) return ColumnType::DOUBLE;
+    return ColumnType::STRING;
+}
+
+bool ColumnarWriter::write_impl(const QueryResult& result,
+                               const std::vector<size_t>* row_indices,
+                               const std::filesystem::path& output_path,
+                               bool infer_types) {
+    std::ofstream file(output_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    RowSelection rows{result, row_indices};
+    size_t column_count = result.headers.size();
+    std::vector<ColumnDescriptor> descriptors(column_count);
+    std::vector<std::string> blocks(column_count);
+
+    // Encode each column independently on a small pool of threads
+    std::atomic<size_t> next_column{0};
+    size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t worker_count = std::min(column_count, hardware_threads);
+    std::vector<std::future<void>> workers;
+
+    for (size_t w = 0; w < worker_count; ++w) {
+        workers.push_back(std::async(std::launch::async, [&]() {
+            size_t column;
+            while ((column = next_column.fetch_add(1)) < column_count) {
+                ColumnDescriptor& desc = descriptors[column];
+                desc.name = result.headers[column];
+
+                if (infer_types) {
+                    std::vector<const std::string*> values;
+                    values.reserve(rows.size());
+                    for (size_t row = 0; row < rows.size(); ++row) {
+                        values.push_back(&rows.value(row, column));
+                    }
+                    desc.type = infer_type(values);
+                }
+
+                if (desc.type == ColumnType::STRING) {
+                    encode_string(rows, column, desc, blocks[column]);
+                } else {
+                    encode_numeric(rows, column, desc, blocks[column]);
+                }
+                desc.length = blocks[column].size();
+            }
+        }));
+    }
+
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    // Lay out blocks after the header, then the footer
+    uint64_t offset = kHeaderSize;
+    for (size_t column = 0; column < column_count; ++column) {
+        descriptors[column].offset = offset;
+        offset += descriptors[column].length;
+    }
+
+    std::string header;
+    header.append(kMagic, sizeof(kMagic));
+    append_pod(header, kVersion);
+    append_pod(header, static_cast<uint32_t>(column_count));
+    append_pod(header, static_cast<uint64_t>(rows.size()));
+    append_pod(header, offset); // Footer offset
+
+    std::string footer;
+    for (const auto& desc : descriptors) {
+        append_descriptor(footer, desc);
+    }
+
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    for (const auto& block : blocks) {
+        file.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+    file.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+
+    return file.good();
+}
+
+namespace {
+
+// Header and footer of a columnar file image, every block checked to lie
+// inside the image and every array, offset and code inside its block
+struct ColumnarLayout {
+    uint64_t row_count = 0;
+    std::vector<ColumnDescriptor> descriptors;
+};
+
+ColumnarLayout read_layout(const char* data, size_t size) {
+    if (size < kHeaderSize || std::memcmp(data, ColumnarWriter::kMagic, sizeof(ColumnarWriter::kMagic)) != 0) {
+        throw std::runtime_error("Not an agile-pasta columnar file");
+    }
+
+    uint32_t version = read_pod<uint32_t>(data + 8);
+    if (version != ColumnarWriter::kVersion) {
+        throw std::runtime_error("Unsupported columnar file version: " + std::to_string(version));
+    }
+
+    uint32_t column_count = read_pod<uint32_t>(data + 12);
+    uint64_t row_count = read_pod<uint64_t>(data + 16);
+    uint64_t footer_offset = read_pod<uint64_t>(data + 24);
+
+    auto truncated = []() {
+        return std::runtime_error("Truncated columnar file");
+    };
+    auto require = [size, &truncated](uint64_t offset, uint64_t length) {
+        if (offset > size || length > size - offset) {
+            throw truncated();
+        }
+    };
+    // Arrays inside a column block must also lie within the block itself
+    auto require_in_block = [&truncated](const ColumnDescriptor& desc, uint64_t offset, uint64_t length) {
+        if (offset > desc.length || length > desc.length - offset) {
+            throw truncated();
+        }
+    };
+
+    // Every row takes at least 4 bytes per column (a dictionary code), and every
+    // descriptor at least 72 bytes, so larger counts cannot fit in this file
+    require(0, static_cast<uint64_t>(column_count) * 72);
+    if (column_count > 0 && row_count > size / (4 * static_cast<uint64_t>(column_count))) {
+        throw truncated();
+    }
+
+    ColumnarLayout layout;
+    layout.row_count = row_count;
+    layout.descriptors.resize(column_count);
+    uint64_t pos = footer_offset;
+    for (auto& desc : layout.descriptors) {
+        require(pos, 72);
+        desc.type = static_cast<ColumnType>(read_pod<uint32_t>(data + pos));
+        desc.encoding = static_cast<ColumnEncoding>(read_pod<uint32_t>(data + pos + 4));
+        desc.offset = read_pod<uint64_t>(data + pos + 8);
+        desc.length = read_pod<uint64_t>(data + pos + 16);
+        desc.dictionary_size = read_pod<uint64_t>(data + pos + 24);
+        desc.null_count = read_pod<uint64_t>(data + pos + 32);
+        if (desc.type == ColumnType::DOUBLE) {
+            desc.min_double = read_pod<double>(data + pos + 40);
+            desc.max_double = read_pod<double>(data + pos + 48);
+        } else {
+            desc.min_int = read_pod<int64_t>(data + pos + 40);
+            desc.max_int = read_pod<int64_t>(data + pos + 48);
+        }
+        uint32_t name_len = read_pod<uint32_t>(data + pos + 56);
+        uint32_t min_len = read_pod<uint32_t>(data + pos + 60);
+        uint32_t max_len = read_pod<uint32_t>(data + pos + 64);
+        pos += 72;
+
+        require(pos, static_cast<uint64_t>(name_len) + min_len + max_len);
+        desc.name.assign(data + pos, name_len);
+        desc.min_string.assign(data + pos + name_len, min_len);
+        desc.max_string.assign(data + pos + name_len + min_len, max_len);
+        pos = padded_8(pos + name_len + min_len + max_len);
+
+        require(desc.offset, desc.length);
+        const char* block = data + desc.offset;
+        if (desc.type == ColumnType::INT64 || desc.type == ColumnType::DOUBLE) {
+            require_in_block(desc, 0, row_count * 8 + (row_count + 7) / 8);
+        } else if (desc.encoding == ColumnEncoding::DICTIONARY) {
+            if (desc.dictionary_size >= desc.length / 8) {
+                throw truncated();
+            }
+            uint64_t offsets_len = (desc.dictionary_size + 1) * 8;
+            uint64_t bytes_len = read_pod<uint64_t>(block + desc.dictionary_size * 8);
+            require_in_block(desc, offsets_len, bytes_len);
+            uint64_t codes_offset = offsets_len + padded_8(bytes_len);
+            require_in_block(desc, codes_offset, row_count * 4);
+            for (uint64_t code = 0; code < desc.dictionary_size; ++code) {
+                uint64_t start = read_pod<uint64_t>(block + code * 8);
+                uint64_t end = read_pod<uint64_t>(block + (code + 1) * 8);
+                if (start > end || end > bytes_len) {
+                    throw truncated();
+                }
+            }
+            for (uint64_t row = 0; row < row_count; ++row) {
+                if (read_pod<uint32_t>(block + codes_offset + row * 4) >= desc.dictionary_size) {
+                    throw truncated();
+                }
+            }
+        } else {
+            uint64_t offsets_len = (row_count + 1) * 8;
+            require_in_block(desc, 0, offsets_len);
+            uint64_t bytes_len = desc.length - offsets_len;
+            for (uint64_t row = 0; row < row_count; ++row) {
+                uint64_t start = read_pod<uint64_t>(block + row * 8);
+                uint64_t end = read_pod<uint64_t>(block + (row + 1) * 8);
+                if (start > end || end > bytes_len) {
+                    throw truncated();
+                }
+            }
+        }
+    }
+    return layout;
+}
+
+} // namespace
+
+std::unique_ptr<QueryResult> ColumnarReader::decode(const char* data, size_t size,
+                                                    std::vector<ColumnDescriptor>* descriptors_out) {
+    ColumnarLayout layout = read_layout(data, size);
+    const std::vector<ColumnDescriptor>& descriptors = layout.descriptors;
+    uint64_t row_count = layout.row_count;
+    size_t column_count = descriptors.size();
+
+    auto result = std::make_unique<QueryResult>();
+    result->rows.assign(row_count, std::vector<std::string>(column_count));
+
+    for (size_t column = 0; column < column_count; ++column) {
+        const ColumnDescriptor& desc = descriptors[column];
+        const char* block = data + desc.offset;
+        result->headers.push_back(desc.name);
+
+        if (desc.type == ColumnType::INT64 || desc.type == ColumnType::DOUBLE) {
+            const char* bitmap = block + row_count * 8;
+            for (uint64_t row = 0; row < row_count; ++row) {
+                if (bitmap[row / 8] & (1 << (row % 8))) continue;
+                result->rows[row][column] = desc.type == ColumnType::INT64
+                    ? std::to_string(read_pod<int64_t>(block + row * 8))
+                    : format_double(read_pod<double>(block + row * 8));
+            }
+        } else if (desc.encoding == ColumnEncoding::DICTIONARY) {
+            const char* offsets = block;
+            const char* bytes = block + (desc.dictionary_size + 1) * 8;
+            uint64_t bytes_len = read_pod<uint64_t>(offsets + desc.dictionary_size * 8);
+            const char* codes = bytes + padded_8(bytes_len);
+            for (uint64_t row = 0; row < row_count; ++row) {
+                uint64_t code = read_pod<uint32_t>(codes + row * 4);
+                uint64_t start = read_pod<uint64_t>(offsets + code * 8);
+                uint64_t end = read_pod<uint64_t>(offsets + (code + 1) * 8);
+                result->rows[row][column].assign(bytes + start, end - start);
+            }
+        } else {
+            const char* offsets = block;
+            const char* bytes = block + (row_count + 1) * 8;
+            for (uint64_t row = 0; row < row_count; ++row) {
+                uint64_t start = read_pod<uint64_t>(offsets + row * 8);
+                uint64_t end = read_pod<uint64_t>(offsets + (row + 1) * 8);
+                result->rows[row][column].assign(bytes + start, end - start);
+            }
+        }
+    }
+
+    if (descriptors_out) {
+        *descriptors_out = std::move(layout.descriptors);
+    }
+    return result;
+}
+
+std::unique_ptr<QueryResult> ColumnarReader::read_file(const std::filesystem::path& path,
+                                                       std::vector<ColumnDescriptor>* descriptors) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open columnar file: " + path.string());
+    }
+
+    std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decode(image.data(), image.size(), descriptors);
+}
+
+ColumnarView::ColumnarView(const char* data, size_t size) {
+    ColumnarLayout layout = read_layout(data, size);
+    row_count_ = static_cast<size_t>(layout.row_count);
+    for (const auto& desc : layout.descriptors) {
+        if (desc.type != ColumnType::STRING) {
+            throw std::runtime_error("Columnar file has a numeric column and cannot be viewed: " + desc.name);
+        }
+        headers_.push_back(desc.name);
+        Column column;
+        column.offsets = data + desc.offset;
+        if (desc.encoding == ColumnEncoding::DICTIONARY) {
+            column.bytes = column.offsets + (desc.dictionary_size + 1) * 8;
+            column.codes = column.bytes + padded_8(read_pod<uint64_t>(column.offsets + desc.dictionary_size * 8));
+        } else {
+            column.bytes = column.offsets + (layout.row_count + 1) * 8;
+        }
+        columns_.push_back(column);
+    }
+}
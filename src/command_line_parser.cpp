@@ -2,6 +2,25 @@
 #include "ansi_output.h"
 #include <iostream>
 #include <string>
+#include <stdexcept>
+#include <sstream>
+
+namespace {
+
+// Split "a,b,c"; false when any name is empty
+bool parse_column_list(const std::string& value, std::vector<std::string>& columns) {
+    std::istringstream stream(value);
+    std::string column;
+    while (std::getline(stream, column, ',')) {
+        if (column.empty()) {
+            return false;
+        }
+        columns.push_back(column);
+    }
+    return !columns.empty() && value.back() != ',';
+}
+
+} // namespace
 
 CommandLineArgs CommandLineParser::parse(int argc, char* argv[]) {
     CommandLineArgs args;
@@ -30,6 +49,109 @@ CommandLineArgs CommandLineParser::parse(int argc, char* argv[]) {
                 args.input_path = argv[++i];
             } else if (arg == "--out" && i + 1 < argc) {
                 args.output_path = argv[++i];
+            } else if (arg == "--max-rows-per-file" && i + 1 < argc) {
+                try {
+                    long long value = std::stoll(argv[++i]);
+                    if (value <= 0) {
+                        throw std::invalid_argument("non-positive row cap");
+                    }
+                    args.max_rows_per_file = static_cast<size_t>(value);
+                } catch (const std::exception&) {
+                    args.command = CommandLineArgs::Command::INVALID;
+                    return args;
+                }
+            } else if (arg == "--partition-by" && i + 1 < argc) {
+                args.partition_column = argv[++i];
+            } else if (arg == "--diff") {
+                args.diff = true;
+            } else if (arg == "--diff-key" && i + 1 < argc) {
+                args.diff = true;
+                if (!parse_column_list(argv[++i], args.diff_key)) {
+                    args.command = CommandLineArgs::Command::INVALID;
+                    return args;
+                }
+            } else if (arg == "--format" && i + 1 < argc) {
+                args.output_format = argv[++i];
+            } else if (arg == "--metrics" && i + 1 < argc) {
+                args.metrics_path = argv[++i];
+            } else if (arg == "--trace" && i + 1 < argc) {
+                args.trace_path = argv[++i];
+            } else if (arg == "--perf-counters") {
+                args.perf_counters = true;
+            } else if (arg == "--verbose" || arg == "-v") {
+                args.verbose = true;
+            } else if (arg == "--resume") {
+                args.resume = true;
+            } else if (arg == "--store" && i + 1 < argc) {
+                args.store_path = argv[++i];
+            } else {
+                // Unknown parameter
+                args.command = CommandLineArgs::Command::INVALID;
+                return args;
+            }
+        }
+        
+        return args;
+    }
+    
+    if (command == "explain") {
+        args.command = CommandLineArgs::Command::EXPLAIN;
+        
+        // Same inputs and output options as transform, since they shape the plan
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            
+            if (arg == "--in" && i + 1 < argc) {
+                args.input_path = argv[++i];
+            } else if (arg == "--out" && i + 1 < argc) {
+                args.output_path = argv[++i];
+            } else if (arg == "--analyze") {
+                args.explain_analyze = true;
+            } else if (arg == "--max-rows-per-file" && i + 1 < argc) {
+                try {
+                    long long value = std::stoll(argv[++i]);
+                    if (value <= 0) {
+                        throw std::invalid_argument("non-positive row cap");
+                    }
+                    args.max_rows_per_file = static_cast<size_t>(value);
+                } catch (const std::exception&) {
+                    args.command = CommandLineArgs::Command::INVALID;
+                    return args;
+                }
+            } else if (arg == "--partition-by" && i + 1 < argc) {
+                args.partition_column = argv[++i];
+            } else if (arg == "--diff") {
+                args.diff = true;
+            } else if (arg == "--diff-key" && i + 1 < argc) {
+                args.diff = true;
+                if (!parse_column_list(argv[++i], args.diff_key)) {
+                    args.command = CommandLineArgs::Command::INVALID;
+                    return args;
+                }
+            } else if (arg == "--format" && i + 1 < argc) {
+                args.output_format = argv[++i];
+            } else {
+                // Unknown parameter
+                args.command = CommandLineArgs::Command::INVALID;
+                return args;
+            }
+        }
+        
+        return args;
+    }
+    
+    if (command == "query") {
+        args.command = CommandLineArgs::Command::QUERY;
+        
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            
+            if (arg == "--in" && i + 1 < argc) {
+                args.input_path = argv[++i];
+            } else if ((arg == "--execute" || arg == "-e") && i + 1 < argc) {
+                args.query_sql = argv[++i];
+            } else if (arg == "--store" && i + 1 < argc) {
+                args.store_path = argv[++i];
             } else {
                 // Unknown parameter
                 args.command = CommandLineArgs::Command::INVALID;
@@ -40,6 +162,85 @@ CommandLineArgs CommandLineParser::parse(int argc, char* argv[]) {
         return args;
     }
     
+    if (command == "serve") {
+        args.command = CommandLineArgs::Command::SERVE;
+        
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            
+            try {
+                if (arg == "--socket" && i + 1 < argc) {
+                    args.socket_path = argv[++i];
+                } else if (arg == "--workers" && i + 1 < argc) {
+                    long long value = std::stoll(argv[++i]);
+                    if (value <= 0) {
+                        throw std::invalid_argument("non-positive worker count");
+                    }
+                    args.serve_workers = static_cast<size_t>(value);
+                } else if (arg == "--cache-mb" && i + 1 < argc) {
+                    args.serve_cache_mb = std::stoull(argv[++i]);
+                } else if (arg == "--compress-cache") {
+                    args.serve_compress_cache = true;
+                } else {
+                    // Unknown parameter
+                    args.command = CommandLineArgs::Command::INVALID;
+                    return args;
+                }
+            } catch (const std::exception&) {
+                args.command = CommandLineArgs::Command::INVALID;
+                return args;
+            }
+        }
+        
+        return args;
+    }
+    
+    if (command == "gen" || command == "generate") {
+        args.command = CommandLineArgs::Command::GENERATE;
+        
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            
+            try {
+                if (arg == "--out" && i + 1 < argc) {
+                    args.output_path = argv[++i];
+                } else if (arg == "--scale" && i + 1 < argc) {
+                    args.gen_scale = std::stod(argv[++i]);
+                    if (!(args.gen_scale > 0.0)) {
+                        throw std::invalid_argument("non-positive scale");
+                    }
+                } else if (arg == "--seed" && i + 1 < argc) {
+                    args.gen_seed = std::stoull(argv[++i]);
+                } else if (arg == "--skew" && i + 1 < argc) {
+                    args.gen_skew = std::stod(argv[++i]);
+                    if (args.gen_skew < 0.0) {
+                        throw std::invalid_argument("negative skew");
+                    }
+                } else if (arg == "--sortedness" && i + 1 < argc) {
+                    args.gen_sortedness = std::stod(argv[++i]);
+                    if (args.gen_sortedness < 0.0 || args.gen_sortedness > 1.0) {
+                        throw std::invalid_argument("sortedness out of range");
+                    }
+                } else if (arg == "--departments" && i + 1 < argc) {
+                    args.gen_departments = std::stoull(argv[++i]);
+                } else if (arg == "--locations" && i + 1 < argc) {
+                    args.gen_locations = std::stoull(argv[++i]);
+                } else if (arg == "--cost-centers" && i + 1 < argc) {
+                    args.gen_cost_centers = std::stoull(argv[++i]);
+                } else {
+                    // Unknown parameter
+                    args.command = CommandLineArgs::Command::INVALID;
+                    return args;
+                }
+            } catch (const std::exception&) {
+                args.command = CommandLineArgs::Command::INVALID;
+                return args;
+            }
+        }
+        
+        return args;
+    }
+    
     if (command == "check" || command == "sanity-check") {
         args.command = CommandLineArgs::Command::SANITY_CHECK;
         
@@ -73,16 +274,33 @@ void CommandLineParser::print_help() {
     AnsiOutput::plain("");
     AnsiOutput::styled("SYNOPSIS", AnsiOutput::Color::yellow, AnsiOutput::Style::bold);
     AnsiOutput::plain("    agile-pasta help");
-    AnsiOutput::plain("    agile-pasta transform --in <input_path> --out <output_path>");
+    AnsiOutput::plain("    agile-pasta transform --in <input_path> --out <output_path> [options]");
+    AnsiOutput::plain("    agile-pasta explain --in <input_path> --out <output_path> [--analyze] [options]");
+    AnsiOutput::plain("    agile-pasta query --in <input_path> [--execute <statement>] [--store <dir>]");
+    AnsiOutput::plain("    agile-pasta serve --socket <path> [--workers <n>] [--cache-mb <n>] [--compress-cache]");
     AnsiOutput::plain("    agile-pasta check --out <output_path>");
+    AnsiOutput::plain("    agile-pasta gen --out <dir> [--scale <n>] [generator options]");
     AnsiOutput::plain("");
     AnsiOutput::styled("COMMANDS", AnsiOutput::Color::yellow, AnsiOutput::Style::bold);
     AnsiOutput::styled("    help", AnsiOutput::Color::cyan);
     AnsiOutput::plain("                    Show this help message and usage examples");
     AnsiOutput::styled("    transform", AnsiOutput::Color::cyan);
     AnsiOutput::plain("               Transform PSV data files to CSV format");
+    AnsiOutput::styled("    explain", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                 Show the operators each configuration runs as (scan, join,");
+    AnsiOutput::plain("                          filter, project, write) with row estimates; writes nothing");
+    AnsiOutput::styled("    query", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                   Load the input tables once, then answer SELECT statements");
+    AnsiOutput::plain("                          (WHERE, JOIN, GROUP BY, ORDER BY, LIMIT) typed on stdin");
+    AnsiOutput::styled("    serve", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                   Run as a daemon taking transform jobs over a Unix domain");
+    AnsiOutput::plain("                          socket (HTTP), keeping parsed tables and rules warm");
+    AnsiOutput::plain("                          between jobs; GET /metrics gives Prometheus metrics");
     AnsiOutput::styled("    check", AnsiOutput::Color::cyan);
     AnsiOutput::plain("                   Run sanity checks on output configuration files");
+    AnsiOutput::styled("    gen", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                     Generate synthetic employees, departments, cost centers and");
+    AnsiOutput::plain("                          locations with sample rules (<dir>/input, <dir>/output)");
     AnsiOutput::plain("");
     AnsiOutput::styled("OPTIONS", AnsiOutput::Color::yellow, AnsiOutput::Style::bold);
     AnsiOutput::styled("    --in <path>", AnsiOutput::Color::cyan);
@@ -90,6 +308,72 @@ void CommandLineParser::print_help() {
     AnsiOutput::styled("    --out <path>", AnsiOutput::Color::cyan);
     AnsiOutput::plain("           Output directory path (searches recursively for rule files)");
     AnsiOutput::plain("                          For 'check' command: path to validate configuration files");
+    AnsiOutput::styled("    --format <name>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Output format: csv (default), columnar (typed binary .apcol),");
+    AnsiOutput::plain("                          jsonl (JSON Lines, one object per row) or xlsx (Excel workbook)");
+    AnsiOutput::styled("    --max-rows-per-file <n>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Split each output into files of at most n rows");
+    AnsiOutput::plain("                          (name_part0001.csv, name_part0002.csv, ...)");
+    AnsiOutput::styled("    --partition-by <column>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Write one output file per distinct value of an output column");
+    AnsiOutput::plain("                          (name_<value>.csv); combines with --max-rows-per-file");
+    AnsiOutput::styled("    --diff", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Write only rows inserted, updated or deleted since the last");
+    AnsiOutput::plain("                          --diff run, with an _op column (I, U, D); row hashes are kept");
+    AnsiOutput::plain("                          in name_Fingerprints.apfp next to each output");
+    AnsiOutput::styled("    --diff-key <col[,col]>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Output columns identifying a row for --diff; configs without");
+    AnsiOutput::plain("                          them, and --diff alone, compare whole rows (a change shows as");
+    AnsiOutput::plain("                          a delete plus an insert)");
+    AnsiOutput::styled("    --metrics <file.json>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Write a JSON report of time, CPU, rows, bytes, peak memory");
+    AnsiOutput::plain("                          and allocations for each phase and each configuration");
+    AnsiOutput::styled("    --trace <file.json>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Record a Chrome/Perfetto trace of loads, parses, joins,");
+    AnsiOutput::plain("                          filters, transforms and writes on every thread");
+    AnsiOutput::styled("    --perf-counters", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Measure CPU cycles, instructions, cache and branch misses");
+    AnsiOutput::plain("                          per phase and configuration (Linux perf_event_open)");
+    AnsiOutput::styled("    --verbose, -v", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Explain the execution plan: estimated input sizes, memory");
+    AnsiOutput::plain("                          budget, load threads and each config's in-memory, streaming");
+    AnsiOutput::plain("                          or spilling mode");
+    AnsiOutput::styled("    --analyze", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          For 'explain': also run each configuration (output goes to a");
+    AnsiOutput::plain("                          temporary directory) and show actual rows, time and memory");
+    AnsiOutput::styled("    --store <dir>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          For 'transform' and 'query': keep parsed inputs as column");
+    AnsiOutput::plain("                          files in dir and map them on later runs while unchanged");
+    AnsiOutput::styled("    --resume", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          For 'transform': continue an interrupted run from the");
+    AnsiOutput::plain("                          _Checkpoint.psv it left in --out, skipping completed configs");
+    AnsiOutput::plain("                          and continuing partly written CSV outputs");
+    AnsiOutput::styled("    --execute, -e <statement>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          For 'query': run one statement and exit instead of reading stdin");
+    AnsiOutput::plain("");
+    AnsiOutput::styled("SERVE OPTIONS", AnsiOutput::Color::yellow, AnsiOutput::Style::bold);
+    AnsiOutput::styled("    --socket <path>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Unix domain socket to listen on (replaced if stale)");
+    AnsiOutput::styled("    --workers <n>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Jobs served at once (default: hardware threads)");
+    AnsiOutput::styled("    --cache-mb <n>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Memory the table cache is trimmed to after each job");
+    AnsiOutput::plain("                          (default: the planner's share of available memory)");
+    AnsiOutput::styled("    --compress-cache", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Keep cached tables compressed between jobs, 2-3x smaller;");
+    AnsiOutput::plain("                          each job expands the tables it reads");
+    AnsiOutput::plain("");
+    AnsiOutput::styled("GENERATOR OPTIONS", AnsiOutput::Color::yellow, AnsiOutput::Style::bold);
+    AnsiOutput::styled("    --scale <n>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Scale factor: n x 16,000,000 employees, about n GB (default 1)");
+    AnsiOutput::styled("    --seed <n>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Random seed; the same seed and options give identical files");
+    AnsiOutput::styled("    --skew <s>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Zipf exponent for foreign keys (0 = uniform, 1 = classic Zipf)");
+    AnsiOutput::styled("    --sortedness <f>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          1 = employees in emp_id order (default), 0 = fully shuffled");
+    AnsiOutput::styled("    --departments <n>  --locations <n>  --cost-centers <n>", AnsiOutput::Color::cyan);
+    AnsiOutput::plain("                          Override table cardinalities derived from the scale");
     AnsiOutput::plain("");
     AnsiOutput::styled("DESCRIPTION", AnsiOutput::Color::yellow, AnsiOutput::Style::bold);
     AnsiOutput::plain("    The transform command processes PSV data files and applies transformation rules");
@@ -166,9 +450,29 @@ void CommandLineParser::print_help() {
     AnsiOutput::plain("    # Transform data files");
     AnsiOutput::styled("    agile-pasta transform --in /data/input --out /data/output", AnsiOutput::Color::green);
     AnsiOutput::plain("");
+    AnsiOutput::plain("    # One file per department, capped at Excel's row limit");
+    AnsiOutput::styled("    agile-pasta transform --in /data/input --out /data/output --partition-by department_name --max-rows-per-file 1048575", AnsiOutput::Color::green);
+    AnsiOutput::plain("");
+    AnsiOutput::plain("    # Keep parsed inputs in a column store shared by later runs");
+    AnsiOutput::styled("    agile-pasta transform --in /data/input --out /data/output --store /var/cache/agile-pasta", AnsiOutput::Color::green);
+    AnsiOutput::plain("");
+    AnsiOutput::plain("    # Compare estimated and actual rows of every operator");
+    AnsiOutput::styled("    agile-pasta explain --in /data/input --out /data/output --analyze", AnsiOutput::Color::green);
+    AnsiOutput::plain("");
+    AnsiOutput::plain("    # Check a join and a filter without writing a rules file");
+    AnsiOutput::styled("    agile-pasta query --in /data/input -e \"SELECT dept_name, COUNT(*) FROM employees JOIN departments ON employees.dept_id = departments.dept_id GROUP BY dept_name\"", AnsiOutput::Color::green);
+    AnsiOutput::plain("");
+    AnsiOutput::plain("    # Serve jobs on a socket, then submit one and scrape the metrics");
+    AnsiOutput::styled("    agile-pasta serve --socket /run/agile-pasta.sock", AnsiOutput::Color::green);
+    AnsiOutput::styled("    curl --unix-socket /run/agile-pasta.sock -X POST 'http://localhost/transform?in=/data/input&out=/data/output'", AnsiOutput::Color::green);
+    AnsiOutput::styled("    curl --unix-socket /run/agile-pasta.sock http://localhost/metrics", AnsiOutput::Color::green);
+    AnsiOutput::plain("");
     AnsiOutput::plain("    # Run sanity checks on output configuration");
     AnsiOutput::styled("    agile-pasta check --out /data/output", AnsiOutput::Color::green);
     AnsiOutput::plain("");
+    AnsiOutput::plain("    # Generate about 10 GB of skewed, half-shuffled test data");
+    AnsiOutput::styled("    agile-pasta gen --out /data/bench --scale 10 --skew 1.1 --sortedness 0.5", AnsiOutput::Color::green);
+    AnsiOutput::plain("");
     AnsiOutput::plain("    # Windows example");
     AnsiOutput::styled("    agile-pasta transform --in C:\\Data\\Input --out C:\\Data\\Output", AnsiOutput::Color::green);
     AnsiOutput::plain("");
@@ -196,7 +500,11 @@ void CommandLineParser::print_help() {
 
 void CommandLineParser::print_usage() {
     AnsiOutput::plain("Usage: agile-pasta help");
-    AnsiOutput::plain("       agile-pasta transform --in <input_path> --out <output_path>");
+    AnsiOutput::plain("       agile-pasta transform --in <input_path> --out <output_path> [options]");
+    AnsiOutput::plain("       agile-pasta explain --in <input_path> --out <output_path> [--analyze] [options]");
+    AnsiOutput::plain("       agile-pasta query --in <input_path> [--execute <statement>] [--store <dir>]");
+    AnsiOutput::plain("       agile-pasta serve --socket <path> [--workers <n>] [--cache-mb <n>] [--compress-cache]");
     AnsiOutput::plain("       agile-pasta check --out <output_path>");
+    AnsiOutput::plain("       agile-pasta gen --out <dir> [--scale <n>] [generator options]");
     AnsiOutput::info("Try 'agile-pasta help' for more information.");
 }
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "config_runner.h"
+#include "ansi_output.h"
+#include "csv_writer.h"
+#include "memory_accounting.h"
+#include "query_engine.h"
+#include "tracer.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+// Streamed rows are diffed in batches of this many
+constexpr size_t kDiffBatchRows = 1024;
+
+// Keep only the rows that changed, marked in a leading operation column, then
+// the deleted ones
+void keep_changes(QueryResult& result, ChangeCapture& capture) {
+    std::string operations;
+    capture.classify(result.rows, operations);
+    std::vector<std::vector<std::string>> changed;
+    for (size_t row = 0; row < result.rows.size(); ++row) {
+        if (operations[row]) {
+            result.rows[row].insert(result.rows[row].begin(), std::string(1, operations[row]));
+            changed.push_back(std::move(result.rows[row]));
+        }
+    }
+    for (auto& row : capture.deleted_rows()) {
+        row.insert(row.begin(), std::string(1, ChangeCapture::kDelete));
+        changed.push_back(std::move(row));
+    }
+    result.headers.insert(result.headers.begin(), ChangeCapture::kOperationColumn);
+    result.rows = std::move(changed);
+}
+
+} // namespace
+
+ConfigRules ConfigRunner::load_rules(const OutputFileInfo& config) {
+    Database empty;
+    QueryEngine query_engine(empty);
+    TransformationEngine engine(empty, query_engine);
+    engine.load_output_headers(config.headers_path);
+    engine.load_rules(config.rules_path);
+
+    ConfigRules parsed;
+    parsed.headers = engine.get_output_headers();
+    parsed.rules = engine.get_rules();
+    return parsed;
+}
+
+ConfigRunResult ConfigRunner::run(const OutputFileInfo& config, const ConfigRules& rules,
+                                  const ConfigPlan& plan, const Database& database,
+                                  const OutputOptions& options, bool console,
+                                  const StreamCheckpoint* checkpoint) {
+    ConfigRunResult result;
+    // Tables loaded, replaced or dropped while this config runs do not affect it
+    Database tables = database.snapshot();
+    QueryEngine query_engine(tables);
+    query_engine.set_join_memory_budget(plan.join_memory_bytes);
+    TransformationEngine transform_engine(tables, query_engine);
+    transform_engine.set_output_headers(rules.headers);
+    transform_engine.set_rules(rules.rules);
+    transform_engine.set_progress(console);
+
+    auto output_path = config.headers_path.parent_path() /
+                       (config.name_prefix + OutputWriter::extension_for(options.format));
+
+    auto failed = [&]() {
+        result.error = "Failed to write output file: " + output_path.string();
+        if (console) {
+            std::cerr << "Failed to write output file: " << output_path << std::endl;
+        }
+    };
+
+    // Diff mode compares every row with the fingerprints of the last run
+    std::unique_ptr<ChangeCapture> capture;
+    if (options.diff) {
+        // One key serves every config; a config without all its columns diffs whole rows
+        const auto& headers = transform_engine.get_output_headers();
+        std::vector<std::string> key = options.diff_key;
+        for (const auto& column : key) {
+            if (std::find(headers.begin(), headers.end(), column) == headers.end()) {
+                if (console) {
+                    AnsiOutput::warning("No output column " + column + " in " + config.name_prefix +
+                                        ", diffing whole rows");
+                }
+                key.clear();
+                break;
+            }
+        }
+        capture = std::make_unique<ChangeCapture>(ChangeCapture::fingerprint_path_for(output_path), headers, key);
+        if (console && capture->previous_damaged()) {
+            AnsiOutput::warning("Cannot read fingerprint file " +
+                                ChangeCapture::fingerprint_path_for(output_path).string() +
+                                ", diffing against no previous run");
+        }
+    }
+
+    // Pure column projections skip the intermediate result and copy fields straight to CSV
+    ProjectionPlan projection;
+
+    if (plan.stream_rows && !capture && transform_engine.plan_projection(projection)) {
+        if (console) {
+            AnsiOutput::info("Pure column projection of " + projection.source->name +
+                             ", streaming records to: " + output_path.string());
+        }
+
+        const PsvTable& source = *projection.source;
+        size_t rows_written = 0;
+        TraceSpan write_span("write", "write " + output_path.filename().string());
+        // Mapped rows are copied out only when a GLOBAL filter has to read them
+        const auto& rules = transform_engine.get_rules();
+        bool filtered = std::any_of(rules.begin(), rules.end(), [](const TransformationRule& rule) {
+            return rule.type == TransformationRule::RuleType::GLOBAL;
+        });
+        std::vector<std::string> scratch;
+        std::function<bool(size_t)> row_filter;
+        if (filtered) {
+            row_filter = [&](size_t row) {
+                return transform_engine.passes_global_filters(source.row_fields(row, scratch), source.headers);
+            };
+        }
+        bool written = CsvWriter::write_projection(
+            transform_engine.get_output_headers(), source, projection.column_indices,
+            row_filter, output_path, rows_written, checkpoint);
+
+        if (written) {
+            if (console) {
+                AnsiOutput::success("Successfully wrote " + std::to_string(rows_written) +
+                                    " records to " + output_path.string());
+            }
+            result.success = true;
+            result.rows_in = source.row_count();
+            result.rows_out = rows_written;
+            result.files = {output_path};
+        } else {
+            failed();
+        }
+    } else if (plan.stream_rows) {
+        // Rows go to the CSV file as they are produced; no result is materialized
+        if (console) {
+            AnsiOutput::info("Streaming output: " + output_path.string());
+        }
+
+        CsvStreamWriter writer;
+        auto headers = transform_engine.get_output_headers();
+        if (capture) {
+            headers.insert(headers.begin(), ChangeCapture::kOperationColumn);
+        }
+        if (writer.open(output_path, headers, checkpoint)) {
+            TraceSpan write_span("write", "write " + output_path.filename().string());
+            std::vector<std::vector<std::string>> pending;
+            std::string operations;
+            auto write_changes = [&]() {
+                capture->classify(pending, operations);
+                for (size_t i = 0; i < pending.size(); ++i) {
+                    if (operations[i]) {
+                        pending[i].insert(pending[i].begin(), std::string(1, operations[i]));
+                        writer.write_row(pending[i]);
+                    }
+                }
+                pending.clear();
+            };
+            transform_engine.transform_rows([&](std::vector<std::string>&& row) {
+                if (capture) {
+                    pending.push_back(std::move(row));
+                    if (pending.size() == kDiffBatchRows) {
+                        write_changes();
+                    }
+                } else {
+                    writer.write_row(row);
+                }
+            });
+            if (capture) {
+                write_changes();
+                for (auto& row : capture->deleted_rows()) {
+                    row.insert(row.begin(), std::string(1, ChangeCapture::kDelete));
+                    writer.write_row(row);
+                }
+            }
+            result.rows_in = transform_engine.get_rows_scanned();
+            result.rows_out = writer.rows_written();
+            result.files = {output_path};
+
+            if (writer.close()) {
+                if (console) {
+                    AnsiOutput::success("Successfully wrote " + std::to_string(writer.rows_written()) +
+                                        " records to " + output_path.string());
+                }
+                result.success = true;
+            } else {
+                failed();
+            }
+        } else {
+            failed();
+        }
+    } else {
+        auto transformed_data = transform_engine.transform_data();
+        result.rows_in = transform_engine.get_rows_scanned();
+        MemoryCharge result_charge(MemoryCategory::RESULT, "result " + config.name_prefix,
+                                   transformed_data ? MemoryAccounting::result_bytes(*transformed_data) : 0);
+
+        if (!transformed_data) {
+            // No output headers: nothing to write
+            result.success = true;
+            return result;
+        }
+        if (capture) {
+            TraceSpan diff_span("diff", "diff " + config.name_prefix);
+            keep_changes(*transformed_data, *capture);
+        }
+        if (console) {
+            AnsiOutput::info("Writing output: " + output_path.string());
+        }
+        result.rows_out = transformed_data->rows.size();
+
+        if (OutputWriter::write(*transformed_data, output_path, options, result.files)) {
+            if (console) {
+                if (result.files.size() == 1) {
+                    AnsiOutput::success("Successfully wrote " + std::to_string(result.rows_out) +
+                                        " records to " + result.files.front().string());
+                } else {
+                    AnsiOutput::success("Successfully wrote " + std::to_string(result.rows_out) +
+                                        " records to " + std::to_string(result.files.size()) + " partition files");
+                }
+            }
+            result.success = true;
+        } else {
+            failed();
+        }
+    }
+
+    // The fingerprints move on only once the changes are written, so a failed
+    // run is diffed again against the same previous run
+    if (capture && result.success) {
+        result.changes = capture->counts();
+        if (console) {
+            const ChangeCounts& changes = result.changes;
+            AnsiOutput::info("Changes: " + std::to_string(changes.inserted) + " inserted, " +
+                             std::to_string(changes.updated) + " updated, " +
+                             std::to_string(changes.deleted) + " deleted, " +
+                             std::to_string(changes.unchanged) + " unchanged" +
+                             (capture->has_previous() ? "" : " (no previous fingerprints)"));
+        }
+        if (!capture->save()) {
+            result.success = false;
+            result.error = "Failed to write fingerprint file: " +
+                           ChangeCapture::fingerprint_path_for(output_path).string();
+            if (console) {
+                std::cerr << result.error << std::endl;
+            }
+        }
+    }
+
+    result.bytes_written = total_file_size(result.files);
+    return result;
+}
+
+uint64_t ConfigRunner::total_file_size(const std::vector<std::filesystem::path>& files) {
+    uint64_t total = 0;
+    for (const auto& file : files) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(file, ec);
+        if (!ec) {
+            total += size;
+        }
+    }
+    return total;
+}
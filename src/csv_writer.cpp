@@ -3,70 +3,129 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <array>
+
+namespace {
+
+// Byte classes used to decide quoting in one pass over a field
+struct QuoteClassifier {
+    std::array<bool, 256> special{}; // Forces quoting anywhere in the field
+    std::array<bool, 256> space{};   // Forces quoting at either end of the field
+
+    QuoteClassifier() {
+        for (unsigned char c : {',', '"', '\n', '\r'}) special[c] = true;
+        for (unsigned char c : {' ', '\t', '\n', '\v', '\f', '\r'}) space[c] = true;
+    }
+};
+
+const QuoteClassifier kQuoteClassifier;
+
+} // namespace
 
 bool CsvWriter::write_csv(const QueryResult& result, const std::filesystem::path& output_path) {
     std::ofstream file(output_path);
     if (!file.is_open()) {
         return false;
     }
-    
+
+    OutputBuffer buffer(file);
+
     // Write headers
-    for (size_t i = 0; i < result.headers.size(); ++i) {
-        if (i > 0) file << ",";
-        file << escape_csv_field(result.headers[i]);
-    }
-    file << "\n";
-    
+    append_csv_row(buffer, result.headers);
+
     // Write data rows
     for (const auto& row : result.rows) {
-        for (size_t i = 0; i < row.size(); ++i) {
-            if (i > 0) file << ",";
-            file << escape_csv_field(row[i]);
-        }
-        file << "\n";
+        append_csv_row(buffer, row);
     }
-    
-    return file.good();
+
+    return buffer.flush();
 }
 
-bool CsvWriter::write_csv_with_progress(const QueryResult& result, 
+bool CsvWriter::write_csv_with_progress(const QueryResult& result,
                                        const std::filesystem::path& output_path) {
     std::ofstream file(output_path);
     if (!file.is_open()) {
         return false;
     }
-    
+
+    OutputBuffer buffer(file);
+
     // Create progress bar
     auto progress = ProgressManager::create_processing_progress(
         "Writing " + output_path.filename().string(), result.rows.size() + 1);
-    
+
     // Write headers
-    for (size_t i = 0; i < result.headers.size(); ++i) {
-        if (i > 0) file << ",";
-        file << escape_csv_field(result.headers[i]);
-    }
-    file << "\n";
-    
+    append_csv_row(buffer, result.headers);
+
     ProgressManager::update_progress(*progress, 1);
-    
+
     // Write data rows
     for (size_t row_idx = 0; row_idx < result.rows.size(); ++row_idx) {
-        const auto& row = result.rows[row_idx];
-        
-        for (size_t i = 0; i < row.size(); ++i) {
-            if (i > 0) file << ",";
-            file << escape_csv_field(row[i]);
-        }
-        file << "\n";
-        
+        append_csv_row(buffer, result.rows[row_idx]);
+
         // Update progress periodically
         if (row_idx % 100 == 0 || row_idx == result.rows.size() - 1) {
             ProgressManager::update_progress(*progress, row_idx + 2);
         }
     }
+
+    bool ok = buffer.flush();
+    ProgressManager::complete_progress(*progress);
+    return ok;
+}
+
+bool CsvWriter::write_csv_rows(const QueryResult& result,
+                              const std::vector<size_t>& row_indices,
+                              const std::filesystem::path& output_path) {
+    std::ofstream file(output_path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    OutputBuffer buffer(file);
+    append_csv_row(buffer, result.headers);
+
+    for (size_t row_idx : row_indices) {
+        if (row_idx < result.rows.size()) {
+            append_csv_row(buffer, result.rows[row_idx]);
+        }
+    }
+
+    return buffer.flush();
+}
+
+bool CsvWriter::write_projection(const std::vector<std::string>& headers,
+                                const PsvTable& table,
+                                const std::vector<size_t>& column_indices,
+                                const std::function<bool(size_t row)>& row_filter,
+                                const std::filesystem::path& output_path,
+                                size_t& rows_written,
+                                const StreamCheckpoint* checkpoint) {
+    rows_written = 0;
+    
+    CsvStreamWriter writer;
+    if (!writer.open(output_path, headers, checkpoint)) {
+        return false;
+    }
     
+    auto progress = ProgressManager::create_processing_progress(
+        "Writing " + output_path.filename().string(), table.row_count() + 1);
+    
+    size_t row_count = table.row_count();
+    for (size_t record_idx = 0; record_idx < row_count; ++record_idx) {
+        if (!row_filter || row_filter(record_idx)) {
+            writer.write_fields(table, record_idx, column_indices);
+        }
+        
+        if (record_idx % 1000 == 0 || record_idx == row_count - 1) {
+            ProgressManager::update_progress(*progress, record_idx + 2);
+        }
+    }
+    
+    rows_written = writer.rows_written();
+    bool ok = writer.close();
     ProgressManager::complete_progress(*progress);
-    return file.good();
+    return ok;
 }
 
 std::string CsvWriter::escape_csv_field(const std::string& field) {
@@ -85,11 +144,132 @@ std::string CsvWriter::escape_csv_field(const std::string& field) {
     return field;
 }
 
-bool CsvWriter::needs_quoting(const std::string& field) {
+bool CsvWriter::needs_quoting(std::string_view field) {
     // Quote if contains comma, quote, newline, or starts/ends with whitespace
-    return field.find(',') != std::string::npos ||
-           field.find('"') != std::string::npos ||
-           field.find('\n') != std::string::npos ||
-           field.find('\r') != std::string::npos ||
-           (!field.empty() && (std::isspace(field.front()) || std::isspace(field.back())));
-}
\ No newline at end of file
+    if (field.empty()) {
+        return false;
+    }
+    
+    const auto* bytes = reinterpret_cast<const unsigned char*>(field.data());
+    if (kQuoteClassifier.space[bytes[0]] || kQuoteClassifier.space[bytes[field.size() - 1]]) {
+        return true;
+    }
+    
+    for (size_t i = 0; i < field.size(); ++i) {
+        if (kQuoteClassifier.special[bytes[i]]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CsvWriter::append_csv_field(std::string& out, std::string_view field) {
+    if (!needs_quoting(field)) {
+        out.append(field);
+        return;
+    }
+
+    out.push_back('"');
+    for (char c : field) {
+        if (c == '"') {
+            out.push_back('"'); // Escape quotes by doubling them
+        }
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+void CsvWriter::append_csv_row(OutputBuffer& buffer, const std::vector<std::string>& row) {
+    std::string& out = buffer.data();
+    for (size_t i = 0; i < row.size(); ++i) {
+        if (i > 0) out.push_back(',');
+        append_csv_field(out, row[i]);
+    }
+    out.push_back('\n');
+    buffer.maybe_flush();
+}
+
+bool CsvStreamWriter::open(const std::filesystem::path& output_path, const std::vector<std::string>& headers,
+                           const StreamCheckpoint* checkpoint) {
+    path_ = output_path;
+    checkpoint_ = checkpoint;
+    rows_written_ = 0;
+    rows_to_skip_ = 0;
+    bool resuming = checkpoint && checkpoint->resume_bytes > 0;
+    if (resuming) {
+        // Drop whatever was written after the last durable checkpoint
+        std::error_code ec;
+        auto size = std::filesystem::file_size(output_path, ec);
+        if (ec || size < checkpoint->resume_bytes) {
+            return false;
+        }
+        std::filesystem::resize_file(output_path, checkpoint->resume_bytes, ec);
+        if (ec) {
+            return false;
+        }
+        file_.open(output_path, std::ios::app);
+        rows_written_ = checkpoint->resume_rows;
+        rows_to_skip_ = checkpoint->resume_rows;
+    } else {
+        file_.open(output_path);
+    }
+    if (!file_.is_open()) {
+        return false;
+    }
+    buffer_ = std::make_unique<OutputBuffer>(file_);
+    if (!resuming) {
+        CsvWriter::append_csv_row(*buffer_, headers);
+    }
+    next_chunk_ = checkpoint && checkpoint->chunk_bytes > 0 ? checkpoint->chunk_bytes : 0;
+    return true;
+}
+
+void CsvStreamWriter::write_row(const std::vector<std::string>& row) {
+    if (rows_to_skip_ > 0) {
+        rows_to_skip_--;
+        return;
+    }
+    CsvWriter::append_csv_row(*buffer_, row);
+    row_written();
+}
+
+void CsvStreamWriter::write_fields(const PsvTable& table, size_t row, const std::vector<size_t>& columns) {
+    if (rows_to_skip_ > 0) {
+        rows_to_skip_--;
+        return;
+    }
+    // Copy each selected field's bytes directly, escaping only when classified as needed
+    std::string& out = buffer_->data();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (i > 0) out.push_back(',');
+        CsvWriter::append_csv_field(out, table.field(row, columns[i]));
+    }
+    out.push_back('\n');
+    buffer_->maybe_flush();
+    row_written();
+}
+
+void CsvStreamWriter::row_written() {
+    rows_written_++;
+    if (next_chunk_ == 0 || buffer_->bytes_written() + buffer_->data().size() < next_chunk_) {
+        return;
+    }
+    next_chunk_ += checkpoint_->chunk_bytes;
+    if (!buffer_->flush()) {
+        return;
+    }
+    file_.flush();
+    if (file_.good() && RunCheckpoint::sync_file(path_) && checkpoint_->on_chunk) {
+        checkpoint_->on_chunk(rows_written_, static_cast<uint64_t>(file_.tellp()));
+    }
+}
+
+bool CsvStreamWriter::close() {
+    if (!buffer_) {
+        return false;
+    }
+    bool ok = buffer_->flush();
+    buffer_.reset();
+    file_.close();
+    return ok && !file_.fail();
+}
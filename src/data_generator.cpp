@@ -0,0 +1,450 @@
+#include "data_generator.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const char* const kFirstNames[] = {
+    "John", "Jane", "Bob", "Alice", "Charlie", "Diana", "Frank", "Grace", "Henry", "Ivy",
+    "Jack", "Karen", "Liam", "Mary", "Nathan", "Olivia", "Paul", "Quinn", "Rachel", "Sam",
+    "Tom", "Uma", "Victor", "Wendy", "Xander", "Yara", "Zoe", "Adam", "Beth", "Carl",
+    "David", "Emma", "Felix", "Gina", "Harry", "Iris", "Jake", "Kate", "Leo", "Mia",
+    "Nick", "Opa", "Pete", "Quin", "Ruby", "Steve", "Tina", "Ulrich", "Vera", "Will"
+};
+
+const char* const kLastNames[] = {
+    "Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller", "Davis", "Rodriguez", "Martinez",
+    "Hernandez", "Lopez", "Gonzalez", "Wilson", "Anderson", "Thomas", "Taylor", "Moore", "Jackson", "Martin",
+    "Lee", "Perez", "Thompson", "White", "Harris", "Sanchez", "Clark", "Ramirez", "Lewis", "Robinson",
+    "Walker", "Young", "Allen", "King", "Wright", "Scott", "Torres", "Nguyen", "Hill", "Flores",
+    "Green", "Adams", "Nelson", "Baker", "Hall", "Rivera", "Campbell", "Mitchell", "Carter", "Roberts"
+};
+
+const char* const kPositions[] = {
+    "Software Engineer", "Data Analyst", "Project Manager", "Quality Assurance", "UX Designer",
+    "DevOps Engineer", "Business Analyst", "Senior Developer", "Marketing Manager", "Product Manager",
+    "System Administrator", "Database Administrator", "Technical Writer", "Sales Representative",
+    "Customer Support", "Security Analyst", "Network Engineer", "Frontend Developer", "Backend Developer",
+    "Full Stack Developer", "Data Scientist", "Machine Learning Engineer", "Cloud Architect"
+};
+
+const char* const kDepartmentNames[] = {
+    "Engineering", "Analytics", "Management", "QA", "Design", "Marketing", "Sales", "Support",
+    "Operations", "Security", "Finance", "HR", "Legal", "Research", "IT"
+};
+
+struct City {
+    const char* name;
+    const char* region;
+    const char* country;
+};
+
+const City kCities[] = {
+    {"New York", "Americas", "USA"}, {"Chicago", "Americas", "USA"}, {"Austin", "Americas", "USA"},
+    {"Toronto", "Americas", "Canada"}, {"Mexico City", "Americas", "Mexico"}, {"Sao Paulo", "Americas", "Brazil"},
+    {"London", "EMEA", "UK"}, {"Dublin", "EMEA", "Ireland"}, {"Berlin", "EMEA", "Germany"},
+    {"Paris", "EMEA", "France"}, {"Madrid", "EMEA", "Spain"}, {"Stockholm", "EMEA", "Sweden"},
+    {"Cape Town", "EMEA", "South Africa"}, {"Dubai", "EMEA", "UAE"}, {"Tokyo", "APAC", "Japan"},
+    {"Singapore", "APAC", "Singapore"}, {"Sydney", "APAC", "Australia"}, {"Bangalore", "APAC", "India"},
+    {"Seoul", "APAC", "South Korea"}, {"Shanghai", "APAC", "China"}
+};
+
+constexpr size_t kFirstNameCount = sizeof(kFirstNames) / sizeof(kFirstNames[0]);
+constexpr size_t kLastNameCount = sizeof(kLastNames) / sizeof(kLastNames[0]);
+constexpr size_t kPositionCount = sizeof(kPositions) / sizeof(kPositions[0]);
+constexpr size_t kDepartmentNameCount = sizeof(kDepartmentNames) / sizeof(kDepartmentNames[0]);
+constexpr size_t kCityCount = sizeof(kCities) / sizeof(kCities[0]);
+
+// Per-table salts keep the row streams of different tables independent
+constexpr uint64_t kEmployeeSalt = 0x656d706c6f796565ULL;
+constexpr uint64_t kDepartmentSalt = 0x6465706172746d74ULL;
+constexpr uint64_t kCostCenterSalt = 0x636f737463656e74ULL;
+constexpr uint64_t kShuffleSalt = 0x73687566666c6521ULL;
+
+constexpr int64_t kFirstHireDay = 16436;    // 2015-01-01
+constexpr int64_t kHireDaySpan = 3653;      // Ten years
+
+uint64_t mix64(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+// splitmix64 stream seeded from (seed, table, row)
+class RowRandom {
+public:
+    RowRandom(uint64_t seed, uint64_t salt, uint64_t row)
+        : state_(mix64(seed ^ mix64(salt ^ mix64(row)))) {}
+
+    uint64_t next() {
+        state_ += 0x9e3779b97f4a7c15ULL;
+        return mix64(state_);
+    }
+
+    uint64_t below(uint64_t bound) { return next() % bound; }
+
+    // Uniform in [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t state_;
+};
+
+void append_uint(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void append_padded(std::string& out, uint64_t value, size_t width) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    size_t digits = static_cast<size_t>(result.ptr - buffer);
+    if (digits < width) {
+        out.append(width - digits, '0');
+    }
+    out.append(buffer, result.ptr);
+}
+
+// (a * b) % m without 64-bit overflow
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t m) {
+    if (a < (1ULL << 32) && b < (1ULL << 32)) {
+        return (a * b) % m;
+    }
+    uint64_t result = 0;
+    a %= m;
+    while (b > 0) {
+        if (b & 1) {
+            result = result >= m - a ? result - (m - a) : result + a;
+        }
+        a = a >= m - a ? a - (m - a) : a + a;
+        b >>= 1;
+    }
+    return result;
+}
+
+// Multiplier coprime with m near the golden ratio of m, for an affine permutation of [0, m)
+uint64_t coprime_multiplier(uint64_t m) {
+    uint64_t a = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(m) * 0.6180339887));
+    while (std::gcd(a, m) != 1) {
+        a++;
+    }
+    return a;
+}
+
+std::vector<double> zipf_cdf(uint64_t n, double skew) {
+    std::vector<double> cdf;
+    if (skew <= 0.0 || n == 0) {
+        return cdf;
+    }
+    cdf.resize(n);
+    double total = 0.0;
+    for (uint64_t rank = 1; rank <= n; ++rank) {
+        total += 1.0 / std::pow(static_cast<double>(rank), skew);
+        cdf[rank - 1] = total;
+    }
+    for (double& value : cdf) {
+        value /= total;
+    }
+    return cdf;
+}
+
+uint64_t scaled_count(double scale, double per_scale, uint64_t minimum) {
+    return std::max<uint64_t>(minimum, static_cast<uint64_t>(std::llround(scale * per_scale)));
+}
+
+bool write_text_file(const std::filesystem::path& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+    return file.good();
+}
+
+} // namespace
+
+DataGenerator::DataGenerator(const GeneratorOptions& options) : options_(options) {
+    if (!(options_.scale > 0.0)) {
+        throw std::invalid_argument("Scale must be positive");
+    }
+    if (options_.skew < 0.0) {
+        throw std::invalid_argument("Skew must not be negative");
+    }
+    if (options_.sortedness < 0.0 || options_.sortedness > 1.0) {
+        throw std::invalid_argument("Sortedness must be between 0 and 1");
+    }
+    options_.chunk_rows = std::max<size_t>(1, options_.chunk_rows);
+
+    employees_ = scaled_count(options_.scale, static_cast<double>(kEmployeesPerScale), 1);
+    departments_ = options_.departments > 0 ? options_.departments
+                                            : scaled_count(options_.scale, 1000.0, kDepartmentNameCount);
+    cost_centers_ = options_.cost_centers > 0 ? options_.cost_centers
+                                              : std::max<uint64_t>(5, departments_ / 10);
+    locations_ = options_.locations > 0 ? options_.locations : scaled_count(options_.scale, 100.0, kCityCount);
+
+    // Window of n^(1 - sortedness): 1 keeps emp_id order, n shuffles the whole file
+    double window = std::pow(static_cast<double>(employees_), 1.0 - options_.sortedness);
+    shuffle_window_ = std::min(employees_, std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(window))));
+    window_multiplier_ = coprime_multiplier(shuffle_window_);
+    uint64_t tail_size = employees_ % shuffle_window_;
+    tail_multiplier_ = tail_size > 0 ? coprime_multiplier(tail_size) : 1;
+
+    department_cdf_ = zipf_cdf(departments_, options_.skew);
+    cost_center_cdf_ = zipf_cdf(cost_centers_, options_.skew);
+    location_cdf_ = zipf_cdf(locations_, options_.skew);
+}
+
+uint64_t DataGenerator::skewed_key(const std::vector<double>& cdf, uint64_t n, double u) {
+    if (cdf.empty()) {
+        return 1 + std::min(n - 1, static_cast<uint64_t>(u * static_cast<double>(n)));
+    }
+    auto it = std::upper_bound(cdf.begin(), cdf.end(), u);
+    return 1 + std::min<uint64_t>(n - 1, static_cast<uint64_t>(it - cdf.begin()));
+}
+
+uint64_t DataGenerator::employee_key(uint64_t index) const {
+    if (shuffle_window_ <= 1) {
+        return index + 1;
+    }
+    // Affine permutation inside each block, with a per-block offset
+    uint64_t block = index / shuffle_window_;
+    uint64_t block_start = block * shuffle_window_;
+    uint64_t block_size = std::min(shuffle_window_, employees_ - block_start);
+    uint64_t offset = mix64(options_.seed ^ kShuffleSalt ^ mix64(block)) % block_size;
+    uint64_t multiplier = block_size == shuffle_window_ ? window_multiplier_ : tail_multiplier_;
+    uint64_t position = (mul_mod(multiplier, index - block_start, block_size) + offset) % block_size;
+    return block_start + position + 1;
+}
+
+std::string DataGenerator::department_name(uint64_t dept_id) const {
+    std::string name = kDepartmentNames[(dept_id - 1) % kDepartmentNameCount];
+    uint64_t group = (dept_id - 1) / kDepartmentNameCount;
+    if (group > 0) {
+        name.push_back(' ');
+        append_uint(name, group + 1);
+    }
+    return name;
+}
+
+std::string DataGenerator::format_date(int64_t days) {
+    // Civil date from days since 1970-01-01 (proleptic Gregorian)
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t day_of_era = days - era * 146097;
+    int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int64_t mp = (5 * day_of_year + 2) / 153;
+    int64_t day = day_of_year - (153 * mp + 2) / 5 + 1;
+    int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    int64_t year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+
+    std::string out;
+    append_padded(out, static_cast<uint64_t>(year), 4);
+    out.push_back('-');
+    append_padded(out, static_cast<uint64_t>(month), 2);
+    out.push_back('-');
+    append_padded(out, static_cast<uint64_t>(day), 2);
+    return out;
+}
+
+void DataGenerator::append_employee(std::string& out, uint64_t index) const {
+    // Attributes follow the key, so an employee is identical at any sortedness
+    uint64_t emp_id = employee_key(index);
+    RowRandom random(options_.seed, kEmployeeSalt, emp_id);
+
+    uint64_t salary = random.uniform() < 0.6 ? 75000 + random.below(75001) : 45000 + random.below(30000);
+    uint64_t dept_id = skewed_key(department_cdf_, departments_, random.uniform());
+
+    append_uint(out, emp_id);
+    out.push_back('|');
+    out.append(kFirstNames[random.below(kFirstNameCount)]);
+    out.push_back(' ');
+    out.append(kLastNames[random.below(kLastNameCount)]);
+    out.push_back('|');
+    out.append(kPositions[random.below(kPositionCount)]);
+    out.push_back('|');
+    out.append(format_date(kFirstHireDay + static_cast<int64_t>(random.below(kHireDaySpan))));
+    out.push_back('|');
+    append_uint(out, salary);
+    out.push_back('|');
+    out.append(department_name(dept_id));
+    out.push_back('|');
+    append_uint(out, dept_id);
+}
+
+void DataGenerator::append_department(std::string& out, uint64_t index) const {
+    uint64_t dept_id = index + 1;
+    RowRandom random(options_.seed, kDepartmentSalt, dept_id);
+
+    append_uint(out, dept_id);
+    out.push_back('|');
+    out.append(department_name(dept_id));
+    out.push_back('|');
+    append_uint(out, skewed_key(cost_center_cdf_, cost_centers_, random.uniform()));
+    out.push_back('|');
+    append_uint(out, skewed_key(location_cdf_, locations_, random.uniform()));
+    out.push_back('|');
+    append_uint(out, 100000 + random.below(49) * 100000);
+    out.push_back('|');
+    append_uint(out, 1 + random.below(employees_));
+}
+
+void DataGenerator::append_cost_center(std::string& out, uint64_t index) const {
+    uint64_t cost_center_id = index + 1;
+    RowRandom random(options_.seed, kCostCenterSalt, cost_center_id);
+
+    append_uint(out, cost_center_id);
+    out.append("|CC-");
+    append_padded(out, cost_center_id, 5);
+    out.push_back('|');
+    append_uint(out, skewed_key(location_cdf_, locations_, random.uniform()));
+    out.push_back('|');
+    append_uint(out, 1000000 + random.below(99) * 1000000);
+}
+
+void DataGenerator::append_location(std::string& out, uint64_t index) const {
+    uint64_t location_id = index + 1;
+    const City& city = kCities[index % kCityCount];
+
+    append_uint(out, location_id);
+    out.push_back('|');
+    out.append(city.name);
+    if (index >= kCityCount) {
+        out.append(" Office ");
+        append_uint(out, index / kCityCount + 1);
+    }
+    out.push_back('|');
+    out.append(city.region);
+    out.push_back('|');
+    out.append(city.country);
+}
+
+bool DataGenerator::write_table(const std::filesystem::path& path, uint64_t rows,
+                                void (DataGenerator::*append_row)(std::string&, uint64_t) const,
+                                uint64_t& bytes_written) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    size_t workers = options_.threads > 0 ? options_.threads
+                                          : std::max(1u, std::thread::hardware_concurrency());
+    uint64_t chunk_rows = options_.chunk_rows;
+    uint64_t chunk_count = (rows + chunk_rows - 1) / chunk_rows;
+
+    // Keep up to two chunks per worker in flight so generation overlaps the
+    // in-order writes, with memory bounded by the window rather than the table
+    std::deque<std::future<std::string>> in_flight;
+    uint64_t next_chunk = 0;
+    bytes_written = 0;
+
+    auto launch = [&](uint64_t chunk) {
+        return std::async(std::launch::async, [this, append_row, rows, chunk_rows, chunk]() {
+            uint64_t begin = chunk * chunk_rows;
+            uint64_t end = std::min(rows, begin + chunk_rows);
+            std::string out;
+            out.reserve(static_cast<size_t>(end - begin) * 96);
+            for (uint64_t row = begin; row < end; ++row) {
+                (this->*append_row)(out, row);
+                out.push_back('\n');
+            }
+            return out;
+        });
+    };
+
+    while (next_chunk < chunk_count || !in_flight.empty()) {
+        while (next_chunk < chunk_count && in_flight.size() < workers * 2) {
+            in_flight.push_back(launch(next_chunk++));
+        }
+        std::string bytes = in_flight.front().get();
+        in_flight.pop_front();
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        bytes_written += bytes.size();
+    }
+
+    return file.good();
+}
+
+std::vector<GeneratedTable> DataGenerator::generate(const std::filesystem::path& root) const {
+    auto input_dir = root / "input";
+    auto output_dir = root / "output";
+    std::filesystem::create_directories(input_dir);
+    std::filesystem::create_directories(output_dir);
+
+    struct TableSpec {
+        const char* name;
+        const char* headers;
+        uint64_t rows;
+        void (DataGenerator::*append_row)(std::string&, uint64_t) const;
+    };
+
+    // Dimension tables first so a partial run still has its lookups
+    const TableSpec specs[] = {
+        {"locations", "location_id|city|region|country", locations_, &DataGenerator::append_location},
+        {"cost_centers", "cost_center_id|cost_center_name|location_id|annual_budget",
+         cost_centers_, &DataGenerator::append_cost_center},
+        {"departments", "dept_id|department_name|cost_center_id|location_id|budget|manager_id",
+         departments_, &DataGenerator::append_department},
+        {"employees", "emp_id|name|position|hire_date|salary|department|dept_id",
+         employees_, &DataGenerator::append_employee},
+    };
+
+    std::vector<GeneratedTable> tables;
+    for (const auto& spec : specs) {
+        GeneratedTable table;
+        table.name = spec.name;
+        table.path = input_dir / (table.name + ".psv");
+        table.rows = spec.rows;
+
+        auto headers_path = input_dir / (table.name + "_Headers.psv");
+        if (!write_text_file(headers_path, std::string(spec.headers) + "\n")) {
+            throw std::runtime_error("Cannot write headers file: " + headers_path.string());
+        }
+        if (!write_table(table.path, spec.rows, spec.append_row, table.bytes)) {
+            throw std::runtime_error("Cannot write data file: " + table.path.string());
+        }
+        tables.push_back(table);
+    }
+
+    // Sample configurations; the employee-department join is left out because
+    // its materialized result would copy every employee row at these sizes
+    const std::pair<const char*, const char*> samples[][2] = {
+        {{"gen_employee_summary_Headers.psv", "employee_name|department_name|position|annual_salary\n"},
+         {"gen_employee_summary_Rules.psv",
+          "GLOBAL|salary >= '75000'|Only employees with salary >= 75000\n"
+          "FIELD|employee_name|UPPER(name)|Convert name to uppercase\n"
+          "FIELD|department_name|department|Copy department name\n"
+          "FIELD|position|position|Copy position\n"
+          "FIELD|annual_salary|salary|Copy salary\n"}},
+        {{"gen_department_locations_Headers.psv", "department_name|city|region|budget\n"},
+         {"gen_department_locations_Rules.psv",
+          "GLOBAL|Join departments.location_id = locations.location_id|Departments with their locations\n"
+          "FIELD|department_name|departments.department_name|Copy department name\n"
+          "FIELD|city|locations.city|Copy city\n"
+          "FIELD|region|locations.region|Copy region\n"
+          "FIELD|budget|departments.budget|Copy department budget\n"}},
+        {{"gen_cost_center_budget_Headers.psv", "cost_center|annual_budget\n"},
+         {"gen_cost_center_budget_Rules.psv",
+          "GLOBAL|annual_budget >= '50000000'|Only large cost centers\n"
+          "FIELD|cost_center|cost_center_name|Copy cost center name\n"
+          "FIELD|annual_budget|annual_budget|Copy annual budget\n"}},
+    };
+
+    for (const auto& sample : samples) {
+        for (const auto& file : sample) {
+            if (!write_text_file(output_dir / file.first, file.second)) {
+                throw std::runtime_error("Cannot write sample configuration: " + (output_dir / file.first).string());
+            }
+        }
+    }
+
+    return tables;
+}
@@ -1,37 +1,89 @@
 #include "database.h"
 #include <algorithm>
+#include <atomic>
+
+namespace {
+
+// A loaded table together with its memory charge, so the charge lasts exactly
+// as long as the last catalog version or snapshot holding the table
+struct ChargedTable {
+    std::unique_ptr<PsvTable> table;
+    MemoryCharge charge;
+};
+
+} // namespace
+
+Database::Database() : catalog_(std::make_shared<const Catalog>()) {}
+
+Database::Database(std::shared_ptr<const Catalog> catalog) : catalog_(std::move(catalog)) {}
+
+Database Database::snapshot() const {
+    return Database(current());
+}
+
+std::shared_ptr<const Database::Catalog> Database::current() const {
+    return std::atomic_load(&catalog_);
+}
+
+template <typename Change>
+void Database::publish(Change change) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto next = std::make_shared<Catalog>(*current());
+    change(*next);
+    std::atomic_store(&catalog_, std::shared_ptr<const Catalog>(std::move(next)));
+}
 
 void Database::load_table(std::unique_ptr<PsvTable> table) {
     if (table && !table->name.empty()) {
-        tables_[table->name] = std::move(table);
+        std::string name = table->name;
+        auto charged = std::make_shared<ChargedTable>();
+        charged->charge = MemoryCharge(MemoryCategory::TABLE, "table " + name,
+                                       MemoryAccounting::table_bytes(*table));
+        charged->table = std::move(table);
+        std::shared_ptr<const PsvTable> loaded(charged, charged->table.get());
+        publish([&](Catalog& catalog) { catalog[name] = std::move(loaded); });
+    }
+}
+
+void Database::share_table(std::shared_ptr<const PsvTable> table) {
+    if (table && !table->name.empty()) {
+        std::string name = table->name;
+        publish([&](Catalog& catalog) { catalog[name] = std::move(table); });
     }
 }
 
 const PsvTable* Database::get_table(const std::string& name) const {
-    auto it = tables_.find(name);
-    return (it != tables_.end()) ? it->second.get() : nullptr;
+    auto catalog = current();
+    auto it = catalog->find(name);
+    return (it != catalog->end()) ? it->second.get() : nullptr;
 }
 
 std::vector<std::string> Database::get_table_names() const {
+    auto catalog = current();
     std::vector<std::string> names;
-    names.reserve(tables_.size());
-    
-    for (const auto& pair : tables_) {
+    names.reserve(catalog->size());
+
+    for (const auto& pair : *catalog) {
         names.push_back(pair.first);
     }
-    
+
     std::sort(names.begin(), names.end());
     return names;
 }
 
 size_t Database::get_total_records() const {
+    auto catalog = current();
     size_t total = 0;
-    for (const auto& pair : tables_) {
-        total += pair.second->records.size();
+    for (const auto& pair : *catalog) {
+        total += pair.second->row_count();
     }
     return total;
 }
 
+void Database::drop_table(const std::string& name) {
+    publish([&](Catalog& catalog) { catalog.erase(name); });
+}
+
 void Database::clear() {
-    tables_.clear();
-}
\ No newline at end of file
+    publish([](Catalog& catalog) { catalog.clear(); });
+}
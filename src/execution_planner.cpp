@@ -0,0 +1,559 @@
+#include "execution_planner.h"
+#include "change_capture.h"
+#include "memory_accounting.h"
+#include "psv_parser.h"
+#include "transformation_engine.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#endif
+
+namespace {
+
+std::string format_bytes(uint64_t bytes) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    if (bytes >= 1024ull * 1024 * 1024) {
+        text << bytes / (1024.0 * 1024.0 * 1024.0) << " GB";
+    } else if (bytes >= 1024 * 1024) {
+        text << bytes / (1024.0 * 1024.0) << " MB";
+    } else {
+        text << bytes / 1024.0 << " KB";
+    }
+    return text.str();
+}
+
+// First number in a file such as /proc/meminfo fields or cgroup limits; 0 if absent
+uint64_t read_limit(const char* path) {
+    std::ifstream file(path);
+    uint64_t value = 0;
+    if (file >> value) {
+        return value;
+    }
+    return 0;
+}
+
+// Inputs smaller than this load on one thread; thread start-up would dominate
+constexpr uint64_t kSmallInputBytes = 1024 * 1024;
+
+// One estimate per table: the partitions of a directory table are sampled one
+// file at a time, and their sizes and rows add up
+std::vector<InputEstimate> combine_partitions(const std::vector<InputEstimate>& inputs) {
+    std::vector<InputEstimate> tables;
+    std::map<std::string, size_t> positions;
+    for (const auto& input : inputs) {
+        auto position = positions.find(input.table);
+        if (position == positions.end()) {
+            positions[input.table] = tables.size();
+            tables.push_back(input);
+            continue;
+        }
+        InputEstimate& table = tables[position->second];
+        double rows = static_cast<double>(table.estimated_rows + input.estimated_rows);
+        if (rows > 0) {
+            table.bytes_per_row = (table.bytes_per_row * table.estimated_rows +
+                                   input.bytes_per_row * input.estimated_rows) / rows;
+            table.memory_per_row = (table.memory_per_row * table.estimated_rows +
+                                    input.memory_per_row * input.estimated_rows) / rows;
+        }
+        table.files += input.files;
+        table.file_bytes += input.file_bytes;
+        table.sampled_rows += input.sampled_rows;
+        table.estimated_rows += input.estimated_rows;
+        table.memory_bytes += input.memory_bytes;
+        table.columns = std::max(table.columns, input.columns);
+    }
+    return tables;
+}
+
+// Header-only copy of an input's table, partition columns included
+std::unique_ptr<PsvTable> schema_table(const FileInfo& input) {
+    auto table = std::make_unique<PsvTable>();
+    table->name = input.table();
+    table->source_file = input.path;
+    try {
+        table->headers = PsvParser::parse_headers(input.headers_path);
+    } catch (const std::exception&) {
+        // Unreadable headers: the table can still be named by JOIN/UNION rules
+    }
+    for (const auto& value : input.partition_values) {
+        table->headers.push_back(value.first);
+    }
+    table->build_header_index();
+    return table;
+}
+
+// Whether a config could keep any row of a partition. Only a single-table
+// config's GLOBAL filters on partition columns are decided per file; the
+// column must not also be a data column, which the filter would test instead.
+bool config_reads_partition(const ConfigDescription& config, const FileInfo& input, const PsvTable* schema) {
+    if (config.shape != ConfigShape::SELECT && config.shape != ConfigShape::PROJECTION) {
+        return true;
+    }
+    std::vector<std::string> headers;
+    std::vector<std::string> row;
+    for (const auto& value : input.partition_values) {
+        headers.push_back(value.first);
+        row.push_back(value.second);
+    }
+    for (const auto& condition : config.global_conditions) {
+        std::string field = TransformationEngine::condition_field(condition);
+        if (field.empty() || std::find(headers.begin(), headers.end(), field) == headers.end()) {
+            continue;
+        }
+        if (schema && std::count(schema->headers.begin(), schema->headers.end(), field) > 1) {
+            continue;
+        }
+        if (!TransformationEngine::evaluate_rule_condition(condition, row, headers)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const InputEstimate* ExecutionPlan::find_input(const std::string& table) const {
+    for (const auto& input : inputs) {
+        if (input.table == table) {
+            return &input;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> ExecutionPlan::explain() const {
+    std::vector<std::string> lines;
+
+    std::ostringstream memory;
+    memory << "Memory: ";
+    if (memory_budget == 0) {
+        memory << "available unknown, no budget";
+    } else {
+        memory << format_bytes(available_memory) << " available, budget " << format_bytes(memory_budget);
+    }
+    memory << "; tables need ~" << format_bytes(tables_bytes);
+    lines.push_back(memory.str());
+
+    for (const auto& input : inputs) {
+        std::ostringstream line;
+        line << "Input " << input.table << ": " << format_bytes(input.file_bytes) << " on disk, ~"
+             << input.estimated_rows << " rows (" << input.sampled_rows << " sampled, "
+             << std::fixed << std::setprecision(0) << input.bytes_per_row << " B/row), ~"
+             << format_bytes(input.memory_bytes) << " loaded";
+        lines.push_back(line.str());
+    }
+    if (pruned_partitions > 0) {
+        lines.push_back("Partitions: " + std::to_string(pruned_partitions) +
+                        " files skipped, GLOBAL filters on partition columns reject them");
+    }
+    if (!unused_tables.empty()) {
+        std::string line = "Not loaded (no config reads them):";
+        for (const auto& table : unused_tables) {
+            line += " " + table;
+        }
+        lines.push_back(line);
+    }
+
+    lines.push_back(load_up_front
+        ? "Load: all tables up front on " + std::to_string(load_threads) + " of " +
+              std::to_string(hardware_threads) + " threads"
+        : "Load: per config on up to " + std::to_string(load_threads) +
+              " threads, releasing tables no later config needs");
+
+    for (const auto& config : configs) {
+        std::ostringstream line;
+        line << "Config " << config.name << ": " << ExecutionPlanner::mode_name(config.mode);
+        if (config.mode == ExecutionMode::SPILLING && config.stream_rows) {
+            line << " + streaming";
+        }
+        line << " (" << ExecutionPlanner::shape_name(config.shape);
+        for (size_t i = 0; i < config.tables.size(); ++i) {
+            line << (i == 0 ? " of " : ", ") << config.tables[i];
+        }
+        line << "; ~" << config.estimated_rows << " rows, working set ~"
+             << format_bytes(config.working_bytes) << ") - " << config.reason;
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+InputSample ExecutionPlanner::sample_input(const FileInfo& file, size_t max_bytes) {
+    InputSample sample;
+    sample.table = std::make_unique<PsvTable>();
+    sample.table->name = file.table();
+    sample.table->source_file = file.path;
+    try {
+        sample.table->headers = PsvParser::parse_headers(file.headers_path);
+    } catch (const std::exception&) {
+        // Sampled without headers; the load itself will report the problem
+    }
+    size_t data_columns = sample.table->headers.size();
+    for (const auto& value : file.partition_values) {
+        sample.table->headers.push_back(value.first);
+    }
+    sample.table->build_header_index();
+
+    std::ifstream data(file.path, std::ios::binary);
+    if (!data.is_open()) {
+        return sample;
+    }
+    std::string text(max_bytes, '\0');
+    data.read(&text[0], static_cast<std::streamsize>(text.size()));
+    text.resize(static_cast<size_t>(data.gcount()));
+
+    // Drop a line cut off by the sample boundary
+    sample.whole_file = text.size() >= file.size_bytes;
+    if (!sample.whole_file) {
+        size_t last_newline = text.rfind('\n');
+        text.resize(last_newline == std::string::npos ? 0 : last_newline + 1);
+    }
+    sample.bytes = text.size();
+
+    std::istringstream lines(text);
+    std::string line;
+    size_t line_count = std::count(text.begin(), text.end(), '\n') + 1;
+    sample.table->records.reserve(line_count);
+    while (std::getline(lines, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        PsvRecord record;
+        record.fields = PsvParser::split_psv_line(line);
+        if (file.is_partition()) {
+            // Same layout as TableLoader::parse_input
+            record.fields.resize(data_columns);
+            for (const auto& value : file.partition_values) {
+                record.fields.push_back(value.second);
+            }
+        }
+        sample.table->records.push_back(std::move(record));
+    }
+    sample.table->records.shrink_to_fit();
+    return sample;
+}
+
+InputEstimate ExecutionPlanner::estimate_input(const FileInfo& file) {
+    InputEstimate estimate;
+    estimate.table = file.table();
+    estimate.file_bytes = file.size_bytes;
+
+    InputSample sample = sample_input(file);
+    const PsvTable& table = *sample.table;
+    PsvTable empty;
+    empty.headers = table.headers;
+    empty.build_header_index();
+    uint64_t empty_bytes = MemoryAccounting::table_bytes(empty);
+
+    estimate.columns = table.headers.size();
+    estimate.sampled_rows = table.records.size();
+    if (estimate.sampled_rows == 0) {
+        return estimate;
+    }
+
+    estimate.bytes_per_row = static_cast<double>(sample.bytes) / estimate.sampled_rows;
+    estimate.memory_per_row = static_cast<double>(MemoryAccounting::table_bytes(table) - empty_bytes) /
+                              estimate.sampled_rows;
+    estimate.estimated_rows = sample.whole_file
+        ? estimate.sampled_rows
+        : static_cast<uint64_t>(static_cast<double>(file.size_bytes) / estimate.bytes_per_row);
+    estimate.memory_bytes = empty_bytes +
+                            static_cast<uint64_t>(estimate.memory_per_row * estimate.estimated_rows);
+    return estimate;
+}
+
+void ExecutionPlanner::load_schemas(const std::vector<FileInfo>& inputs, Database& schema) {
+    for (const auto& input : inputs) {
+        // Partitions of a table share one headers file
+        if (input.is_partition() && schema.get_table(input.table_name)) {
+            continue;
+        }
+        schema.load_table(schema_table(input));
+    }
+}
+
+std::vector<FileInfo> ExecutionPlanner::prune_partitions(const std::vector<FileInfo>& inputs,
+                                                         const std::vector<ConfigDescription>& configs,
+                                                         const Database& schema) {
+    std::vector<FileInfo> kept;
+    for (const auto& input : inputs) {
+        if (!input.is_partition()) {
+            kept.push_back(input);
+            continue;
+        }
+        // Tables no config reads are kept for the planner to report as unused
+        const PsvTable* table = schema.get_table(input.table_name);
+        bool referenced = false;
+        bool read = false;
+        for (const auto& config : configs) {
+            if (std::find(config.tables.begin(), config.tables.end(), input.table_name) == config.tables.end()) {
+                continue;
+            }
+            referenced = true;
+            if (config_reads_partition(config, input, table)) {
+                read = true;
+                break;
+            }
+        }
+        if (read || !referenced) {
+            kept.push_back(input);
+        }
+    }
+    return kept;
+}
+
+ConfigDescription ExecutionPlanner::describe_config(const OutputFileInfo& config, const Database& schema) {
+    QueryEngine query_engine(schema);
+    TransformationEngine engine(schema, query_engine);
+    engine.load_output_headers(config.headers_path);
+    engine.load_rules(config.rules_path);
+
+    ConfigDescription description;
+    description.name = config.name_prefix;
+    description.output_columns = engine.get_output_headers().size();
+
+    // The first JOIN or UNION rule is the one transform_data() executes
+    for (const auto& rule : engine.get_rules()) {
+        if (rule.type == TransformationRule::RuleType::GLOBAL) {
+            description.global_filters++;
+            description.global_conditions.push_back(rule.condition);
+        } else if (description.tables.empty() && rule.type == TransformationRule::RuleType::GLOBAL_JOIN) {
+            description.shape = ConfigShape::JOIN;
+            description.tables = {rule.left_table, rule.right_table};
+        } else if (description.tables.empty() && rule.type == TransformationRule::RuleType::GLOBAL_UNION) {
+            description.shape = ConfigShape::UNION;
+            description.tables = rule.union_tables;
+        }
+    }
+    if (!description.tables.empty()) {
+        return description;
+    }
+
+    ProjectionPlan projection;
+    if (engine.plan_projection(projection)) {
+        description.shape = ConfigShape::PROJECTION;
+        description.tables = {projection.source->name};
+    } else {
+        std::string source = engine.get_source_table();
+        if (!source.empty()) {
+            description.shape = ConfigShape::SELECT;
+            description.tables = {source};
+        }
+    }
+    return description;
+}
+
+ExecutionPlan ExecutionPlanner::plan(const std::vector<InputEstimate>& inputs,
+                                     const std::vector<ConfigDescription>& configs,
+                                     const OutputOptions& output_options,
+                                     uint64_t available_memory,
+                                     size_t hardware_threads) {
+    ExecutionPlan plan;
+    plan.inputs = combine_partitions(inputs);
+    plan.available_memory = available_memory;
+    plan.memory_budget = static_cast<uint64_t>(static_cast<double>(available_memory) * kBudgetFraction);
+    plan.hardware_threads = std::max<size_t>(1, hardware_threads);
+
+    // Only a single unsplit CSV file can be written row by row
+    bool can_stream = output_options.format == OutputFormat::CSV &&
+                      output_options.max_rows_per_file == 0 &&
+                      output_options.partition_column.empty();
+
+    std::set<std::string> used_tables;
+    uint64_t largest_working_set = 0;
+    for (const auto& config : configs) {
+        ConfigPlan config_plan;
+        config_plan.name = config.name;
+        config_plan.shape = config.shape;
+        config_plan.tables = config.tables;
+        config_plan.stream_rows = can_stream;
+
+        double source_row_bytes = 0.0;
+        double output_field_bytes = sizeof(std::string);
+        for (const auto& table : config.tables) {
+            used_tables.insert(table);
+            const InputEstimate* input = plan.find_input(table);
+            if (!input) {
+                continue;
+            }
+            config_plan.tables_bytes += input->memory_bytes;
+            if (input->columns > 0) {
+                output_field_bytes = std::max(output_field_bytes, input->memory_per_row / input->columns);
+            }
+            switch (config.shape) {
+                case ConfigShape::JOIN:
+                    // Assume a key / foreign-key join: one output row per row of the larger side
+                    config_plan.estimated_rows = std::max(config_plan.estimated_rows, input->estimated_rows);
+                    source_row_bytes += input->memory_per_row;
+                    break;
+                case ConfigShape::UNION:
+                    config_plan.estimated_rows += input->estimated_rows;
+                    source_row_bytes = std::max(source_row_bytes, input->memory_per_row);
+                    break;
+                default:
+                    config_plan.estimated_rows = input->estimated_rows;
+                    source_row_bytes = input->memory_per_row;
+                    break;
+            }
+        }
+        if (config.shape == ConfigShape::STATIC) {
+            config_plan.estimated_rows = 1;
+        }
+
+        // The source result is a copy of the input rows (joined or appended),
+        // except for projections streamed straight from the loaded records
+        if (!(config.shape == ConfigShape::PROJECTION && can_stream && !output_options.diff)) {
+            config_plan.working_bytes += static_cast<uint64_t>(source_row_bytes * config_plan.estimated_rows);
+        }
+        // Diffing holds the last run's fingerprints and this run's, with the
+        // values of declared key columns
+        if (output_options.diff) {
+            double key_bytes = static_cast<double>(output_options.diff_key.size()) *
+                               (ChangeCapture::kKeyLengthBytes + output_field_bytes);
+            config_plan.working_bytes += static_cast<uint64_t>(
+                2 * (ChangeCapture::kEntryBytes + key_bytes) * config_plan.estimated_rows);
+        }
+        if (!can_stream) {
+            double output_row_bytes = sizeof(std::vector<std::string>) + config.output_columns * output_field_bytes;
+            config_plan.working_bytes += static_cast<uint64_t>(output_row_bytes * config_plan.estimated_rows);
+        }
+        largest_working_set = std::max(largest_working_set, config_plan.working_bytes);
+        plan.configs.push_back(std::move(config_plan));
+    }
+
+    uint64_t used_file_bytes = 0;
+    size_t used_files = 0;
+    for (const auto& input : plan.inputs) {
+        if (used_tables.count(input.table)) {
+            plan.tables_bytes += input.memory_bytes;
+            used_file_bytes += input.file_bytes;
+            used_files += input.files;
+        } else {
+            plan.unused_tables.push_back(input.table);
+        }
+    }
+
+    plan.load_up_front = plan.memory_budget == 0 ||
+                         plan.tables_bytes + largest_working_set <= plan.memory_budget;
+
+    for (auto& config : plan.configs) {
+        uint64_t needed = config.tables_bytes + config.working_bytes;
+        if (plan.load_up_front) {
+            config.mode = can_stream ? ExecutionMode::STREAMING : ExecutionMode::IN_MEMORY;
+            if (can_stream) {
+                config.reason = config.shape == ConfigShape::PROJECTION && !output_options.diff
+                    ? "records copied straight to CSV"
+                    : "single CSV output, rows written as produced";
+            } else {
+                config.reason = "output format or splitting needs the whole result";
+            }
+            if (plan.memory_budget > 0) {
+                config.reason += "; all tables plus working set fit the budget";
+            }
+        } else {
+            config.mode = ExecutionMode::SPILLING;
+            config.reason = "all tables plus working sets exceed the budget, loading only this config's tables";
+            if (needed > plan.memory_budget) {
+                config.reason += "; needs ~" + format_bytes(needed) + " even alone";
+            }
+        }
+
+        // A join's hash table gets what the budget leaves besides the loaded
+        // tables and the working set; a larger one is partitioned to disk
+        if (config.shape == ConfigShape::JOIN && plan.memory_budget > 0) {
+            uint64_t used = (plan.load_up_front ? plan.tables_bytes : config.tables_bytes) + config.working_bytes;
+            config.join_memory_bytes = std::max(kMinJoinMemory,
+                                                plan.memory_budget > used ? plan.memory_budget - used : 0);
+            config.reason += "; hash join spills to disk above ~" + format_bytes(config.join_memory_bytes);
+        }
+        if (output_options.diff) {
+            config.reason += "; only rows changed since the last run are written";
+        }
+    }
+
+    // Files load in parallel, partitions of one table included
+    size_t files_to_load = plan.load_up_front ? used_files : 0;
+    if (!plan.load_up_front) {
+        for (const auto& config : plan.configs) {
+            size_t config_files = 0;
+            for (const auto& table : config.tables) {
+                const InputEstimate* input = plan.find_input(table);
+                config_files += input ? input->files : 1;
+            }
+            files_to_load = std::max(files_to_load, config_files);
+        }
+    }
+    plan.load_threads = used_file_bytes < kSmallInputBytes
+        ? 1
+        : std::max<size_t>(1, std::min(files_to_load, plan.hardware_threads));
+    return plan;
+}
+
+uint64_t ExecutionPlanner::available_memory_bytes() {
+#if defined(_WIN32) || defined(_WIN64)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        return static_cast<uint64_t>(status.ullAvailPhys);
+    }
+    return 0;
+#elif defined(__linux__)
+    uint64_t available = 0;
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t value = 0;
+    std::string unit;
+    while (meminfo >> key >> value >> unit) {
+        if (key == "MemAvailable:") {
+            available = value * 1024;
+            break;
+        }
+    }
+
+    // Containers: the cgroup limit (v2, then v1) minus what is already charged
+    uint64_t limit = read_limit("/sys/fs/cgroup/memory.max");
+    uint64_t usage = read_limit("/sys/fs/cgroup/memory.current");
+    if (limit == 0) {
+        limit = read_limit("/sys/fs/cgroup/memory/memory.limit_in_bytes");
+        usage = read_limit("/sys/fs/cgroup/memory/memory.usage_in_bytes");
+    }
+    // v1 reports "no limit" as a huge page-aligned number
+    if (limit > 0 && limit < (1ull << 60)) {
+        uint64_t headroom = limit > usage ? limit - usage : 0;
+        available = available == 0 ? headroom : std::min(available, headroom);
+    }
+    return available;
+#else
+    return 0;
+#endif
+}
+
+std::string ExecutionPlanner::format_bytes(uint64_t bytes) {
+    return ::format_bytes(bytes);
+}
+
+const char* ExecutionPlanner::mode_name(ExecutionMode mode) {
+    switch (mode) {
+        case ExecutionMode::STREAMING: return "streaming";
+        case ExecutionMode::SPILLING: return "spilling";
+        case ExecutionMode::IN_MEMORY:
+        default: return "in-memory";
+    }
+}
+
+const char* ExecutionPlanner::shape_name(ConfigShape shape) {
+    switch (shape) {
+        case ConfigShape::PROJECTION: return "projection";
+        case ConfigShape::SELECT: return "select";
+        case ConfigShape::JOIN: return "join";
+        case ConfigShape::UNION: return "union";
+        case ConfigShape::STATIC:
+        default: return "static";
+    }
+}
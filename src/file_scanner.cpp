@@ -4,8 +4,167 @@
 #include <iomanip>
 #include <sstream>
 #include <regex>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
-std::vector<FileInfo> FileScanner::scan_input_files(const std::string& root_path) {
+namespace {
+
+const std::string kPsvSuffix = ".psv";
+const std::string kHeadersSuffix = "_Headers.psv";
+const std::string kRulesSuffix = "_Rules.psv";
+const std::string kTableHeaders = "_Headers.psv";    // Marks a directory table
+
+bool ends_with(const std::string& value, const std::string& suffix) {
+    return value.length() >= suffix.length() &&
+           value.compare(value.length() - suffix.length(), suffix.length(), suffix) == 0;
+}
+
+// Listing is bound by file system latency rather than CPU (on NFS most of the
+// time is spent waiting for the server), so use more tasks than cores
+size_t scan_thread_count(size_t requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::min<size_t>(std::max<size_t>(cores * 2, 4), 32);
+}
+
+// Key that pairs files of one prefix within one directory
+std::string pair_key(const std::filesystem::path& file, size_t suffix_length) {
+    std::string name = file.filename().string();
+    return (file.parent_path() / name.substr(0, name.length() - suffix_length)).string();
+}
+
+// Nearest directory above a file that holds a table's _Headers.psv, or nullptr
+const ScannedFile* find_table_headers(const std::filesystem::path& file,
+                                      const std::unordered_map<std::string, const ScannedFile*>& table_headers) {
+    for (auto directory = file.parent_path(); !directory.empty(); directory = directory.parent_path()) {
+        auto it = table_headers.find(directory.string());
+        if (it != table_headers.end()) {
+            return it->second;
+        }
+        if (directory == directory.parent_path()) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+// key=value directories between a table's directory and one of its partitions
+std::vector<std::pair<std::string, std::string>> partition_segments(const std::filesystem::path& file,
+                                                                    const std::filesystem::path& table_dir) {
+    std::vector<std::pair<std::string, std::string>> segments;
+    for (const auto& part : file.parent_path().lexically_relative(table_dir)) {
+        std::string name = part.string();
+        size_t equals = name.find('=');
+        if (equals != std::string::npos && equals > 0) {
+            segments.emplace_back(name.substr(0, equals), name.substr(equals + 1));
+        }
+    }
+    return segments;
+}
+
+} // namespace
+
+std::vector<ScannedFile> FileScanner::list_psv_files(const std::filesystem::path& root,
+                                                     bool read_data_sizes,
+                                                     size_t threads) {
+    size_t worker_count = scan_thread_count(threads);
+    
+    // Directories still to list; a worker takes one, lists it and queues its
+    // subdirectories. The scan is done when nothing is queued or being listed.
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::vector<std::filesystem::path> pending{root};
+    size_t listing = 0;
+    std::exception_ptr failure;
+    std::vector<std::vector<ScannedFile>> found(worker_count);
+    
+    auto worker = [&](size_t worker_index) {
+        std::vector<ScannedFile>& files = found[worker_index];
+        for (;;) {
+            std::filesystem::path directory;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_ready.wait(lock, [&] { return !pending.empty() || listing == 0 || failure; });
+                if (pending.empty() || failure) {
+                    return;
+                }
+                directory = std::move(pending.back());
+                pending.pop_back();
+                listing++;
+            }
+            
+            std::vector<std::filesystem::path> subdirectories;
+            try {
+                for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+                    // Types come from the listing itself. Like recursive_directory_iterator,
+                    // symlinks are followed to files but not into directories.
+                    if (entry.is_symlink()) {
+                        if (!entry.is_regular_file()) continue;
+                    } else if (entry.is_directory()) {
+                        subdirectories.push_back(entry.path());
+                        continue;
+                    } else if (!entry.is_regular_file()) {
+                        continue;
+                    }
+                    
+                    std::string filename = entry.path().filename().string();
+                    if (!ends_with(filename, kPsvSuffix)) continue;
+                    
+                    ScannedFile file;
+                    file.path = entry.path();
+                    if (read_data_sizes && !ends_with(filename, kHeadersSuffix)) {
+                        file.size_bytes = entry.file_size();
+                    }
+                    files.push_back(std::move(file));
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+                listing--;
+                work_ready.notify_all();
+                return;
+            }
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            listing--;
+            for (auto& subdirectory : subdirectories) {
+                pending.push_back(std::move(subdirectory));
+            }
+            work_ready.notify_all();
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (size_t w = 1; w < worker_count; ++w) {
+        workers.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    
+    std::vector<ScannedFile> files;
+    for (auto& worker_files : found) {
+        files.insert(files.end(), std::make_move_iterator(worker_files.begin()),
+                     std::make_move_iterator(worker_files.end()));
+    }
+    return files;
+}
+
+std::vector<FileInfo> FileScanner::scan_input_files(const std::string& root_path, size_t threads) {
     std::vector<FileInfo> files;
     
     try {
@@ -15,41 +174,100 @@ std::vector<FileInfo> FileScanner::scan_input_files(const std::string& root_path
             throw std::runtime_error("Input path does not exist or is not a directory: " + root_path);
         }
         
-        // Use recursive iterator to find all .psv files
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
-            if (!entry.is_regular_file()) continue;
-            
-            std::string filename = entry.path().filename().string();
-            
-            // Look for data files (not header files)
-            if (filename.length() >= 4 && filename.substr(filename.length() - 4) == ".psv" && 
-                !(filename.length() >= 12 && filename.substr(filename.length() - 12) == "_Headers.psv")) {
-                // Extract prefix (everything before .psv)
-                std::string prefix = filename.substr(0, filename.length() - 4);
-                
-                // Look for corresponding header file
-                std::filesystem::path headers_path = entry.path().parent_path() / (prefix + "_Headers.psv");
-                
-                if (std::filesystem::exists(headers_path)) {
-                    FileInfo info;
-                    info.path = entry.path();
-                    info.headers_path = headers_path;
-                    info.size_bytes = std::filesystem::file_size(entry.path());
-                    info.name_prefix = prefix;
-                    
-                    files.push_back(info);
+        auto listing = list_psv_files(root, true, threads);
+        
+        // A directory holding _Headers.psv is a table; data files below it are its partitions
+        std::unordered_map<std::string, const ScannedFile*> table_headers;
+        for (const auto& file : listing) {
+            if (file.path.filename() == kTableHeaders) {
+                table_headers[file.path.parent_path().string()] = &file;
+            }
+        }
+        
+        // Pair each other data file (<prefix>.psv) with <prefix>_Headers.psv in the same directory
+        struct InputPair {
+            const ScannedFile* data = nullptr;
+            const ScannedFile* headers = nullptr;
+        };
+        std::unordered_map<std::string, InputPair> pairs;
+        pairs.reserve(listing.size());
+        for (const auto& file : listing) {
+            std::string filename = file.path.filename().string();
+            if (ends_with(filename, kHeadersSuffix)) {
+                if (filename != kTableHeaders) {
+                    pairs[pair_key(file.path, kHeadersSuffix.length())].headers = &file;
                 }
+                continue;
+            }
+            const ScannedFile* headers = table_headers.empty() ? nullptr
+                                                               : find_table_headers(file.path, table_headers);
+            if (headers) {
+                std::filesystem::path table_dir = headers->path.parent_path();
+                FileInfo info;
+                info.path = file.path;
+                info.headers_path = headers->path;
+                info.size_bytes = static_cast<size_t>(file.size_bytes);
+                info.name_prefix = file.path.stem().string();
+                info.table_name = table_dir.filename().string();
+                info.partition_values = partition_segments(file.path, table_dir);
+                files.push_back(std::move(info));
+            } else {
+                pairs[pair_key(file.path, kPsvSuffix.length())].data = &file;
             }
         }
         
+        for (const auto& entry : pairs) {
+            const InputPair& pair = entry.second;
+            if (!pair.data || !pair.headers) continue;
+            
+            FileInfo info;
+            info.path = pair.data->path;
+            info.headers_path = pair.headers->path;
+            info.size_bytes = static_cast<size_t>(pair.data->size_bytes);
+            info.name_prefix = pair.data->path.stem().string();
+            files.push_back(std::move(info));
+        }
+        
     } catch (const std::filesystem::filesystem_error& e) {
         throw std::runtime_error("Filesystem error while scanning input files: " + std::string(e.what()));
     }
     
+    // Hash order is arbitrary; keep runs reproducible
+    std::sort(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b) {
+        return a.path < b.path;
+    });
+    
+    // All partitions of a table get the same columns: every key found under
+    // it, in the order keys first appear
+    std::map<std::filesystem::path, std::vector<std::string>> table_keys;
+    for (const auto& file : files) {
+        if (!file.is_partition()) continue;
+        auto& keys = table_keys[file.headers_path];
+        for (const auto& segment : file.partition_values) {
+            if (std::find(keys.begin(), keys.end(), segment.first) == keys.end()) {
+                keys.push_back(segment.first);
+            }
+        }
+    }
+    for (auto& file : files) {
+        if (!file.is_partition()) continue;
+        std::vector<std::pair<std::string, std::string>> values;
+        for (const auto& key : table_keys[file.headers_path]) {
+            std::string value;
+            // The segment nearest the file wins when a key repeats
+            for (const auto& segment : file.partition_values) {
+                if (segment.first == key) {
+                    value = segment.second;
+                }
+            }
+            values.emplace_back(key, value);
+        }
+        file.partition_values = std::move(values);
+    }
     return files;
 }
 
-std::vector<OutputFileInfo> FileScanner::scan_output_files(const std::string& root_path) {
+std::vector<OutputFileInfo> FileScanner::scan_output_files(const std::string& root_path, size_t threads) {
     std::vector<OutputFileInfo> files;
     
     try {
@@ -59,35 +277,43 @@ std::vector<OutputFileInfo> FileScanner::scan_output_files(const std::string& ro
             throw std::runtime_error("Output path does not exist or is not a directory: " + root_path);
         }
         
-        // Use recursive iterator to find header files
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
-            if (!entry.is_regular_file()) continue;
-            
-            std::string filename = entry.path().filename().string();
-            
-            // Look for header files
-            if (filename.length() >= 12 && filename.substr(filename.length() - 12) == "_Headers.psv") {
-                // Extract prefix (everything before _Headers.psv)
-                std::string prefix = filename.substr(0, filename.length() - 12);
-                
-                // Look for corresponding rule file
-                std::filesystem::path rules_path = entry.path().parent_path() / (prefix + "_Rules.psv");
-                
-                if (std::filesystem::exists(rules_path)) {
-                    OutputFileInfo info;
-                    info.headers_path = entry.path();
-                    info.rules_path = rules_path;
-                    info.name_prefix = prefix;
-                    
-                    files.push_back(info);
-                }
+        auto listing = list_psv_files(root, false, threads);
+        
+        // Pair <prefix>_Headers.psv with <prefix>_Rules.psv in the same directory
+        struct OutputPair {
+            const ScannedFile* headers = nullptr;
+            const ScannedFile* rules = nullptr;
+        };
+        std::unordered_map<std::string, OutputPair> pairs;
+        pairs.reserve(listing.size());
+        for (const auto& file : listing) {
+            std::string filename = file.path.filename().string();
+            if (ends_with(filename, kHeadersSuffix)) {
+                pairs[pair_key(file.path, kHeadersSuffix.length())].headers = &file;
+            } else if (ends_with(filename, kRulesSuffix)) {
+                pairs[pair_key(file.path, kRulesSuffix.length())].rules = &file;
             }
         }
         
+        for (const auto& entry : pairs) {
+            const OutputPair& pair = entry.second;
+            if (!pair.headers || !pair.rules) continue;
+            
+            std::string filename = pair.headers->path.filename().string();
+            OutputFileInfo info;
+            info.headers_path = pair.headers->path;
+            info.rules_path = pair.rules->path;
+            info.name_prefix = filename.substr(0, filename.length() - kHeadersSuffix.length());
+            files.push_back(std::move(info));
+        }
+        
     } catch (const std::filesystem::filesystem_error& e) {
         throw std::runtime_error("Filesystem error while scanning output files: " + std::string(e.what()));
     }
     
+    std::sort(files.begin(), files.end(), [](const OutputFileInfo& a, const OutputFileInfo& b) {
+        return a.headers_path < b.headers_path;
+    });
     return files;
 }
 
@@ -99,6 +325,14 @@ void FileScanner::display_file_structure(const std::vector<FileInfo>& files) {
         AnsiOutput::info("Data file:   " + file.path.string() + " (" + format_file_size(file.size_bytes) + ")");
         AnsiOutput::plain("Header file: " + file.headers_path.string());
         AnsiOutput::plain("Prefix:      " + file.name_prefix);
+        if (file.is_partition()) {
+            std::string partition = "Table:       " + file.table_name;
+            for (size_t i = 0; i < file.partition_values.size(); ++i) {
+                partition += (i == 0 ? " (" : ", ") + file.partition_values[i].first + "=" +
+                             file.partition_values[i].second;
+            }
+            AnsiOutput::plain(file.partition_values.empty() ? partition : partition + ")");
+        }
         AnsiOutput::plain("");
     }
 }
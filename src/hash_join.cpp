@@ -0,0 +1,352 @@
+#include "hash_join.h"
+#include "tracer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+using Pairs = std::vector<std::pair<size_t, size_t>>;
+
+constexpr size_t kNoRow = std::numeric_limits<size_t>::max();
+constexpr size_t kWriteBufferBytes = 64 * 1024;
+
+std::string_view key_of(const PsvTable& table, size_t row, size_t column) {
+    return table.field(row, column);
+}
+
+// Partition of a key for one level of partitioning; each level mixes the hash
+// differently, so a partition split again spreads over all new partitions
+size_t partition_of(std::string_view key, size_t depth) {
+    uint64_t h = std::hash<std::string_view>{}(key) + depth * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return static_cast<size_t>(h % HashJoin::kFanout);
+}
+
+// A file of (row number, key) records: u64 row, u32 key length, key bytes
+struct Partition {
+    std::filesystem::path file;
+    uint64_t rows = 0;
+    uint64_t key_bytes = 0;
+};
+
+class PartitionWriter {
+public:
+    explicit PartitionWriter(std::filesystem::path file) : out_(file, std::ios::binary | std::ios::trunc) {
+        partition_.file = std::move(file);
+        if (!out_) {
+            throw std::runtime_error("Cannot create join partition file: " + partition_.file.string());
+        }
+    }
+
+    void add(uint64_t row, std::string_view key) {
+        uint32_t length = static_cast<uint32_t>(key.size());
+        buffer_.append(reinterpret_cast<const char*>(&row), sizeof(row));
+        buffer_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        buffer_.append(key);
+        partition_.rows++;
+        partition_.key_bytes += key.size();
+        if (buffer_.size() >= kWriteBufferBytes) {
+            flush();
+        }
+    }
+
+    // Returns the bytes written
+    uint64_t close() {
+        flush();
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("Cannot write join partition file: " + partition_.file.string());
+        }
+        return written_;
+    }
+
+    const Partition& partition() const { return partition_; }
+
+private:
+    Partition partition_;
+    std::ofstream out_;
+    std::string buffer_;
+    uint64_t written_ = 0;
+
+    void flush() {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        written_ += buffer_.size();
+        buffer_.clear();
+    }
+};
+
+template <typename Visit>
+void read_partition(const Partition& partition, Visit visit) {
+    std::ifstream in(partition.file, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot read join partition file: " + partition.file.string());
+    }
+    std::string key;
+    for (uint64_t i = 0; i < partition.rows; ++i) {
+        uint64_t row = 0;
+        uint32_t length = 0;
+        in.read(reinterpret_cast<char*>(&row), sizeof(row));
+        in.read(reinterpret_cast<char*>(&length), sizeof(length));
+        key.resize(length);
+        in.read(&key[0], length);
+        if (!in) {
+            throw std::runtime_error("Truncated join partition file: " + partition.file.string());
+        }
+        visit(static_cast<size_t>(row), std::string_view(key));
+    }
+}
+
+// Directory for one join's partition files, removed with everything in it
+class SpillDirectory {
+public:
+    explicit SpillDirectory(const std::filesystem::path& parent) {
+        static std::atomic<uint64_t> joins{0};
+        std::ostringstream name;
+        name << "agile-pasta-join-" << std::hex << std::chrono::steady_clock::now().time_since_epoch().count()
+             << '-' << joins.fetch_add(1);
+        path_ = (parent.empty() ? std::filesystem::temp_directory_path() : parent) / name.str();
+        std::error_code ec;
+        std::filesystem::create_directories(path_, ec);
+        if (ec) {
+            throw std::runtime_error("Cannot create join spill directory: " + path_.string());
+        }
+    }
+
+    ~SpillDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    SpillDirectory(const SpillDirectory&) = delete;
+    SpillDirectory& operator=(const SpillDirectory&) = delete;
+
+    const std::filesystem::path& path() const { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+class GraceJoin {
+public:
+    GraceJoin(uint64_t budget, const std::filesystem::path& directory, JoinStats& stats)
+        : budget_(budget), directory_(directory), stats_(stats) {}
+
+    Pairs run(const PsvTable& left, size_t left_column, const PsvTable& right, size_t right_column) {
+        std::vector<Partition> left_parts;
+        std::vector<Partition> right_parts;
+        {
+            TraceSpan span("join", "partition " + left.name + " x " + right.name);
+            left_parts = partition_table(left, left_column, "left");
+            right_parts = partition_table(right, right_column, "right");
+        }
+        Pairs pairs;
+        for (size_t i = 0; i < HashJoin::kFanout; ++i) {
+            join(left_parts[i], right_parts[i], 0, pairs);
+        }
+        // Partitions come back in hash order; restore the nested-loop order
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+
+private:
+    uint64_t budget_;
+    std::filesystem::path directory_;
+    JoinStats& stats_;
+    size_t next_file_ = 0;
+
+    std::vector<PartitionWriter> open_writers(const std::string& side) {
+        std::vector<PartitionWriter> writers;
+        writers.reserve(HashJoin::kFanout);
+        for (size_t i = 0; i < HashJoin::kFanout; ++i) {
+            writers.emplace_back(directory_ / (side + "-" + std::to_string(next_file_++) + ".bin"));
+        }
+        return writers;
+    }
+
+    std::vector<Partition> close_writers(std::vector<PartitionWriter>& writers) {
+        std::vector<Partition> partitions;
+        for (auto& writer : writers) {
+            stats_.spilled_bytes += writer.close();
+            partitions.push_back(writer.partition());
+        }
+        return partitions;
+    }
+
+    std::vector<Partition> partition_table(const PsvTable& table, size_t column, const std::string& side) {
+        auto writers = open_writers(side);
+        for (size_t row = 0; row < table.row_count(); ++row) {
+            std::string_view key = key_of(table, row, column);
+            if (!key.empty()) {
+                writers[partition_of(key, 0)].add(row, key);
+            }
+        }
+        return close_writers(writers);
+    }
+
+    std::vector<Partition> partition_file(const Partition& input, size_t depth, const std::string& side) {
+        auto writers = open_writers(side);
+        read_partition(input, [&](size_t row, std::string_view key) {
+            writers[partition_of(key, depth)].add(row, key);
+        });
+        std::error_code ec;
+        std::filesystem::remove(input.file, ec);
+        return close_writers(writers);
+    }
+
+    void join(const Partition& left, const Partition& right, size_t depth, Pairs& pairs) {
+        if (left.rows == 0 || right.rows == 0) {
+            return;
+        }
+        const Partition& build = right.rows <= left.rows ? right : left;
+        if (depth >= HashJoin::kMaxDepth ||
+            HashJoin::hash_table_bytes(build.rows, build.key_bytes) <= budget_) {
+            join_in_memory(left, right, pairs);
+            return;
+        }
+
+        TraceSpan span("join", "repartition at depth " + std::to_string(depth + 1));
+        stats_.depth = std::max(stats_.depth, depth + 1);
+        auto left_parts = partition_file(left, depth + 1, "left");
+        auto right_parts = partition_file(right, depth + 1, "right");
+        uint64_t build_rows = build.rows;
+        bool build_is_right = &build == &right;
+        for (size_t i = 0; i < HashJoin::kFanout; ++i) {
+            // A build side that did not split is one key repeated; splitting
+            // again cannot help
+            uint64_t rows = build_is_right ? right_parts[i].rows : left_parts[i].rows;
+            if (rows == build_rows) {
+                join_in_memory(left_parts[i], right_parts[i], pairs);
+            } else {
+                join(left_parts[i], right_parts[i], depth + 1, pairs);
+            }
+        }
+    }
+
+    // Hash the smaller side of one partition pair and stream the other past it
+    void join_in_memory(const Partition& left, const Partition& right, Pairs& pairs) {
+        if (left.rows == 0 || right.rows == 0) {
+            return;
+        }
+        stats_.partitions++;
+        bool build_is_right = right.rows <= left.rows;
+        const Partition& build = build_is_right ? right : left;
+        const Partition& probe = build_is_right ? left : right;
+
+        // Keys live in one buffer sized up front, so views into it stay valid
+        std::string keys;
+        keys.reserve(static_cast<size_t>(build.key_bytes));
+        std::vector<size_t> rows;
+        std::vector<std::pair<size_t, size_t>> spans;
+        rows.reserve(static_cast<size_t>(build.rows));
+        spans.reserve(static_cast<size_t>(build.rows));
+        read_partition(build, [&](size_t row, std::string_view key) {
+            rows.push_back(row);
+            spans.emplace_back(keys.size(), key.size());
+            keys.append(key);
+        });
+
+        std::unordered_map<std::string_view, size_t> first;
+        first.reserve(rows.size());
+        std::vector<size_t> next(rows.size(), kNoRow);
+        for (size_t entry = rows.size(); entry-- > 0;) {
+            std::string_view key(keys.data() + spans[entry].first, spans[entry].second);
+            auto inserted = first.try_emplace(key, entry);
+            if (!inserted.second) {
+                next[entry] = inserted.first->second;
+                inserted.first->second = entry;
+            }
+        }
+
+        read_partition(probe, [&](size_t row, std::string_view key) {
+            auto it = first.find(key);
+            if (it == first.end()) {
+                return;
+            }
+            for (size_t entry = it->second; entry != kNoRow; entry = next[entry]) {
+                if (build_is_right) {
+                    pairs.emplace_back(row, rows[entry]);
+                } else {
+                    pairs.emplace_back(rows[entry], row);
+                }
+            }
+        });
+        std::error_code ec;
+        std::filesystem::remove(left.file, ec);
+        std::filesystem::remove(right.file, ec);
+    }
+};
+
+} // namespace
+
+uint64_t HashJoin::hash_table_bytes(uint64_t rows, uint64_t key_bytes) {
+    // Per row: a map node (view, entry, next pointer, cached hash), a bucket,
+    // the chain link, and for partitions the row number and key position
+    uint64_t per_row = sizeof(std::string_view) + 3 * sizeof(size_t) + sizeof(void*) + sizeof(size_t);
+    if (key_bytes > 0) {
+        per_row += 3 * sizeof(size_t);
+    }
+    return rows * per_row + key_bytes;
+}
+
+std::vector<std::pair<size_t, size_t>> HashJoin::match(const PsvTable& left, size_t left_column,
+                                                       const PsvTable& right, size_t right_column,
+                                                       uint64_t memory_budget,
+                                                       const std::filesystem::path& spill_dir,
+                                                       JoinStats* stats) {
+    JoinStats local;
+    JoinStats& result_stats = stats ? *stats : local;
+    result_stats = JoinStats();
+
+    if (memory_budget > 0 && hash_table_bytes(right.row_count()) > memory_budget) {
+        result_stats.spilled = true;
+        SpillDirectory directory(spill_dir);
+        return GraceJoin(memory_budget, directory.path(), result_stats).run(left, left_column, right, right_column);
+    }
+
+    // Right rows by key, chained in row order, so probing in left order gives
+    // the pairs already sorted
+    std::unordered_map<std::string_view, size_t> first;
+    first.reserve(right.row_count());
+    std::vector<size_t> next(right.row_count(), kNoRow);
+    for (size_t row = right.row_count(); row-- > 0;) {
+        std::string_view key = key_of(right, row, right_column);
+        if (key.empty()) {
+            continue;
+        }
+        auto inserted = first.try_emplace(key, row);
+        if (!inserted.second) {
+            next[row] = inserted.first->second;
+            inserted.first->second = row;
+        }
+    }
+
+    Pairs pairs;
+    for (size_t row = 0; row < left.row_count(); ++row) {
+        std::string_view key = key_of(left, row, left_column);
+        if (key.empty()) {
+            continue;
+        }
+        auto it = first.find(key);
+        if (it == first.end()) {
+            continue;
+        }
+        for (size_t match = it->second; match != kNoRow; match = next[match]) {
+            pairs.emplace_back(row, match);
+        }
+    }
+    result_stats.partitions = 1;
+    return pairs;
+}
@@ -0,0 +1,593 @@
+#include "job_server.h"
+#include "ansi_output.h"
+#include "execution_planner.h"
+#include "file_scanner.h"
+#include "json_lines_writer.h"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t kMaxHeaderBytes = 64 * 1024;
+constexpr size_t kMaxBodyBytes = 1024 * 1024;
+constexpr int kReadTimeoutSeconds = 30;
+constexpr int kPollMilliseconds = 200;
+
+// Set from SIGINT/SIGTERM while serve() runs
+volatile std::sig_atomic_t signalled = 0;
+
+void on_signal(int) {
+    signalled = 1;
+}
+
+std::string json_string(const std::string& value) {
+    std::string out = "\"";
+    JsonLinesWriter::append_escaped(out, value);
+    out += '"';
+    return out;
+}
+
+HttpResponse json_error(int status, const std::string& message) {
+    HttpResponse response;
+    response.status = status;
+    response.content_type = "application/json";
+    response.body = "{\"status\":\"error\",\"error\":" + json_string(message) + "}\n";
+    return response;
+}
+
+const char* status_text(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        default:  return "Error";
+    }
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string url_decode(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '+') {
+            out += ' ';
+        } else if (text[i] == '%' && i + 2 < text.size() &&
+                   hex_value(text[i + 1]) >= 0 && hex_value(text[i + 2]) >= 0) {
+            out += static_cast<char>(hex_value(text[i + 1]) * 16 + hex_value(text[i + 2]));
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+const std::vector<double>& ServerMetrics::duration_buckets() {
+    static const std::vector<double> buckets = {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+                                                1.0, 2.5, 5.0, 10.0, 30.0, 60.0, 300.0};
+    return buckets;
+}
+
+void ServerMetrics::job_started() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_in_flight_++;
+}
+
+void ServerMetrics::job_finished(const JobResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_in_flight_--;
+    (result.success ? jobs_ok_ : jobs_failed_)++;
+    for (const auto& config : result.configs) {
+        rows_read_ += config.second.rows_in;
+        rows_written_ += config.second.rows_out;
+        bytes_written_ += config.second.bytes_written;
+    }
+    const auto& buckets = duration_buckets();
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (result.seconds <= buckets[i]) {
+            bucket_counts_[i]++;
+        }
+    }
+    duration_sum_ += result.seconds;
+}
+
+std::string ServerMetrics::to_prometheus(const TableCache::Stats& cache) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    auto metric = [&out](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+    };
+
+    metric("agile_pasta_jobs_total", "counter", "Transform jobs finished, by outcome");
+    out << "agile_pasta_jobs_total{status=\"ok\"} " << jobs_ok_ << '\n';
+    out << "agile_pasta_jobs_total{status=\"error\"} " << jobs_failed_ << '\n';
+
+    metric("agile_pasta_jobs_in_flight", "gauge", "Transform jobs running now");
+    out << "agile_pasta_jobs_in_flight " << jobs_in_flight_ << '\n';
+
+    metric("agile_pasta_job_duration_seconds", "histogram", "Wall time of transform jobs");
+    const auto& buckets = duration_buckets();
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        out << "agile_pasta_job_duration_seconds_bucket{le=\"" << buckets[i] << "\"} " << bucket_counts_[i] << '\n';
+    }
+    uint64_t jobs = jobs_ok_ + jobs_failed_;
+    out << "agile_pasta_job_duration_seconds_bucket{le=\"+Inf\"} " << jobs << '\n';
+    out << "agile_pasta_job_duration_seconds_sum " << duration_sum_ << '\n';
+    out << "agile_pasta_job_duration_seconds_count " << jobs << '\n';
+
+    metric("agile_pasta_rows_read_total", "counter", "Source rows examined by transform jobs");
+    out << "agile_pasta_rows_read_total " << rows_read_ << '\n';
+    metric("agile_pasta_rows_written_total", "counter", "Rows written by transform jobs");
+    out << "agile_pasta_rows_written_total " << rows_written_ << '\n';
+    metric("agile_pasta_bytes_written_total", "counter", "Output bytes written by transform jobs");
+    out << "agile_pasta_bytes_written_total " << bytes_written_ << '\n';
+
+    metric("agile_pasta_table_cache_hits_total", "counter", "Tables served from the cache");
+    out << "agile_pasta_table_cache_hits_total " << cache.hits << '\n';
+    metric("agile_pasta_table_cache_misses_total", "counter", "Tables parsed because they were not cached or had changed");
+    out << "agile_pasta_table_cache_misses_total " << cache.misses << '\n';
+    metric("agile_pasta_table_cache_tables", "gauge", "Tables held in the cache");
+    out << "agile_pasta_table_cache_tables " << cache.tables << '\n';
+    metric("agile_pasta_table_cache_bytes", "gauge", "Estimated memory of the cached tables");
+    out << "agile_pasta_table_cache_bytes " << cache.bytes << '\n';
+
+    metric("agile_pasta_uptime_seconds", "gauge", "Seconds since the server started");
+    out << "agile_pasta_uptime_seconds "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count() << '\n';
+    return out.str();
+}
+
+JobServer::JobServer(size_t workers, uint64_t cache_budget_bytes, bool compress_cache)
+    : workers_(workers > 0 ? workers : std::max(1u, std::thread::hardware_concurrency())),
+      cache_(cache_budget_bytes, compress_cache) {
+}
+
+JobResult JobServer::run_job(const JobRequest& request) {
+    auto started = std::chrono::steady_clock::now();
+    metrics_.job_started();
+
+    JobResult result;
+    try {
+        auto inputs = FileScanner::scan_input_files(request.input_path);
+        if (inputs.empty()) {
+            throw std::runtime_error("No input PSV files found in: " + request.input_path);
+        }
+        auto outputs = FileScanner::scan_output_files(request.output_path);
+        if (outputs.empty()) {
+            throw std::runtime_error("No output rule files found in: " + request.output_path);
+        }
+
+        Database schema;
+        ExecutionPlanner::load_schemas(inputs, schema);
+        std::vector<ConfigDescription> descriptions;
+        for (const auto& output : outputs) {
+            descriptions.push_back(ExecutionPlanner::describe_config(output, schema));
+        }
+        inputs = ExecutionPlanner::prune_partitions(inputs, descriptions, schema);
+        std::vector<InputEstimate> estimates;
+        for (const auto& input : inputs) {
+            InputEstimate estimate;
+            estimate.table = input.table();
+            estimate.file_bytes = input.size_bytes;
+            estimates.push_back(estimate);
+        }
+        // Cached tables stay resident between jobs, so no config spills
+        ExecutionPlan plan = ExecutionPlanner::plan(estimates, descriptions, request.options, 0,
+                                                    std::thread::hardware_concurrency());
+
+        // One cache entry per table: a single file, or all kept partitions
+        std::map<std::string, std::vector<FileInfo>> table_files;
+        for (const auto& input : inputs) {
+            std::string table = input.table();
+            bool used = std::any_of(plan.configs.begin(), plan.configs.end(), [&table](const ConfigPlan& config) {
+                return std::find(config.tables.begin(), config.tables.end(), table) != config.tables.end();
+            });
+            if (used) {
+                table_files[table].push_back(input);
+            }
+        }
+        Database database;
+        for (const auto& entry : table_files) {
+            if (entry.second.front().is_partition()) {
+                database.share_table(cache_.get_table(entry.second));
+            } else {
+                // Like a normal run, the last file of a shared name wins
+                database.share_table(cache_.get_table(entry.second.back()));
+            }
+        }
+
+        result.success = true;
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            const ConfigPlan& config_plan = plan.configs[i];
+            bool static_config = config_plan.shape == ConfigShape::STATIC;
+            ConfigRunResult config_result = ConfigRunner::run(outputs[i], *cache_.get_rules(outputs[i]), config_plan,
+                                                              static_config ? schema : database,
+                                                              request.options, false);
+            if (!config_result.success) {
+                result.success = false;
+                if (result.error.empty()) {
+                    result.error = config_result.error;
+                }
+            }
+            result.configs.emplace_back(outputs[i].name_prefix, std::move(config_result));
+        }
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error = e.what();
+    }
+
+    cache_.trim();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    metrics_.job_finished(result);
+    return result;
+}
+
+std::string JobServer::metrics_text() const {
+    return metrics_.to_prometheus(cache_.stats());
+}
+
+std::map<std::string, std::string> JobServer::parse_form(const std::string& text) {
+    std::map<std::string, std::string> values;
+    std::stringstream pairs(text);
+    std::string pair;
+    while (std::getline(pairs, pair, '&')) {
+        if (pair.empty()) {
+            continue;
+        }
+        size_t equals = pair.find('=');
+        if (equals == std::string::npos) {
+            values[url_decode(pair)] = "";
+        } else {
+            values[url_decode(pair.substr(0, equals))] = url_decode(pair.substr(equals + 1));
+        }
+    }
+    return values;
+}
+
+std::string JobServer::result_json(const JobResult& result) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"status\":" << (result.success ? "\"ok\"" : "\"error\"");
+    if (!result.error.empty()) {
+        out << ",\"error\":" << json_string(result.error);
+    }
+    out << ",\"seconds\":" << result.seconds << ",\"configs\":[";
+    for (size_t i = 0; i < result.configs.size(); ++i) {
+        const auto& config = result.configs[i].second;
+        out << (i ? "," : "") << "{\"name\":" << json_string(result.configs[i].first)
+            << ",\"status\":" << (config.success ? "\"ok\"" : "\"error\"")
+            << ",\"rows_in\":" << config.rows_in << ",\"rows_out\":" << config.rows_out
+            << ",\"bytes_written\":" << config.bytes_written << ",\"files\":[";
+        for (size_t f = 0; f < config.files.size(); ++f) {
+            out << (f ? "," : "") << json_string(config.files[f].string());
+        }
+        out << "]}";
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+HttpResponse JobServer::handle_transform(const std::map<std::string, std::string>& params) {
+    JobRequest request;
+    auto in = params.find("in");
+    auto out = params.find("out");
+    if (in == params.end() || in->second.empty() || out == params.end() || out->second.empty()) {
+        return json_error(400, "Both in and out directories are required");
+    }
+    request.input_path = in->second;
+    request.output_path = out->second;
+
+    auto format = params.find("format");
+    if (format != params.end() && !OutputWriter::parse_format(format->second, request.options.format)) {
+        return json_error(400, "Unknown output format: " + format->second);
+    }
+    auto max_rows = params.find("max_rows_per_file");
+    if (max_rows != params.end()) {
+        const std::string& value = max_rows->second;
+        if (value.empty() || !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return json_error(400, "max_rows_per_file must be a number: " + value);
+        }
+        request.options.max_rows_per_file = std::stoull(value);
+    }
+    auto partition = params.find("partition_by");
+    if (partition != params.end()) {
+        request.options.partition_column = partition->second;
+    }
+
+    JobResult result = run_job(request);
+    HttpResponse response;
+    response.status = result.success ? 200 : 500;
+    response.content_type = "application/json";
+    response.body = result_json(result);
+    return response;
+}
+
+HttpResponse JobServer::handle(const std::string& method, const std::string& target, const std::string& body) {
+    size_t query_start = target.find('?');
+    std::string path = target.substr(0, query_start);
+    auto params = parse_form(query_start == std::string::npos ? "" : target.substr(query_start + 1));
+    for (const auto& value : parse_form(body)) {
+        params.insert(value);
+    }
+
+    auto wrong_method = [](const std::string& allowed) {
+        HttpResponse response;
+        response.status = 405;
+        response.body = "Use " + allowed + "\n";
+        return response;
+    };
+
+    HttpResponse response;
+    if (path == "/metrics") {
+        if (method != "GET") {
+            return wrong_method("GET");
+        }
+        response.content_type = "text/plain; version=0.0.4; charset=utf-8";
+        response.body = metrics_text();
+    } else if (path == "/health") {
+        response.body = "ok\n";
+    } else if (path == "/transform") {
+        if (method != "POST") {
+            return wrong_method("POST");
+        }
+        return handle_transform(params);
+    } else if (path == "/shutdown") {
+        if (method != "POST") {
+            return wrong_method("POST");
+        }
+        stop();
+        response.body = "stopping\n";
+    } else {
+        response.status = 404;
+        response.body = "Not found: " + path + "\n";
+    }
+    return response;
+}
+
+void JobServer::stop() {
+    stopping_ = true;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+bool JobServer::serve(const std::string& socket_path) {
+    std::cerr << "serve needs Unix domain sockets, which this build does not support: "
+              << socket_path << std::endl;
+    return false;
+}
+
+void JobServer::serve_connection(int) {
+}
+
+#else
+
+void JobServer::serve_connection(int client) {
+    timeval timeout{kReadTimeoutSeconds, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    auto started = std::chrono::steady_clock::now();
+    std::string request;
+    HttpResponse response;
+    std::string method;
+    std::string target;
+    char buffer[8192];
+
+    // Request line and headers
+    size_t header_end;
+    while ((header_end = request.find("\r\n\r\n")) == std::string::npos && request.size() < kMaxHeaderBytes) {
+        ssize_t got = recv(client, buffer, sizeof(buffer), 0);
+        if (got <= 0) {
+            close(client);
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(got));
+    }
+
+    std::istringstream head(request.substr(0, header_end == std::string::npos ? request.size() : header_end));
+    std::string line;
+    std::getline(head, line);
+    std::istringstream request_line(line);
+    request_line >> method >> target;
+
+    size_t content_length = 0;
+    while (std::getline(head, line)) {
+        std::string lower = line;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (lower.rfind("content-length:", 0) == 0) {
+            content_length = std::strtoull(line.c_str() + 15, nullptr, 10);
+        }
+    }
+
+    if (header_end == std::string::npos || method.empty() || target.empty()) {
+        response.status = 400;
+        response.body = "Malformed request\n";
+    } else if (content_length > kMaxBodyBytes) {
+        response.status = 413;
+        response.body = "Request body too large\n";
+    } else {
+        std::string body = request.substr(header_end + 4);
+        while (body.size() < content_length) {
+            ssize_t got = recv(client, buffer, sizeof(buffer), 0);
+            if (got <= 0) {
+                break;
+            }
+            body.append(buffer, static_cast<size_t>(got));
+        }
+        body.resize(std::min(body.size(), content_length));
+        try {
+            response = handle(method, target, body);
+        } catch (const std::exception& e) {
+            response = json_error(500, e.what());
+        }
+    }
+
+    std::ostringstream reply;
+    reply << "HTTP/1.0 " << response.status << ' ' << status_text(response.status) << "\r\n"
+          << "Content-Type: " << response.content_type << "\r\n"
+          << "Content-Length: " << response.body.size() << "\r\n"
+          << "Connection: close\r\n\r\n"
+          << response.body;
+    std::string bytes = reply.str();
+    for (size_t sent = 0; sent < bytes.size();) {
+        ssize_t wrote = send(client, bytes.data() + sent, bytes.size() - sent, 0);
+        if (wrote <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(wrote);
+    }
+    close(client);
+
+    std::ostringstream log;
+    log << method << ' ' << target.substr(0, target.find('?')) << " -> " << response.status << " ("
+        << std::fixed << std::setprecision(3)
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count() << " s)";
+    AnsiOutput::plain(log.str());
+}
+
+bool JobServer::serve(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path must be 1 to " << sizeof(address.sun_path) - 1
+                  << " characters: " << socket_path << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Cannot create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A socket file left by a server that is gone is replaced; a live one is not
+    struct stat existing;
+    if (lstat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << "Not a socket, refusing to replace: " << socket_path << std::endl;
+            close(listener);
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (live) {
+            std::cerr << "Another server is listening on: " << socket_path << std::endl;
+            close(listener);
+            return false;
+        }
+        unlink(socket_path.c_str());
+    }
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+
+    // Clients hanging up mid-response must not kill the server
+    struct sigaction ignore{};
+    struct sigaction stop_action{};
+    struct sigaction old_pipe{};
+    struct sigaction old_int{};
+    struct sigaction old_term{};
+    ignore.sa_handler = SIG_IGN;
+    stop_action.sa_handler = on_signal;
+    sigaction(SIGPIPE, &ignore, &old_pipe);
+    sigaction(SIGINT, &stop_action, &old_int);
+    sigaction(SIGTERM, &stop_action, &old_term);
+    signalled = 0;
+    stopping_ = false;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::deque<int> clients;
+    bool accepting = true;
+
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < workers_; ++w) {
+        workers.emplace_back([&]() {
+            for (;;) {
+                int client;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_ready.wait(lock, [&] { return !clients.empty() || !accepting; });
+                    if (clients.empty()) {
+                        return;
+                    }
+                    client = clients.front();
+                    clients.pop_front();
+                }
+                serve_connection(client);
+            }
+        });
+    }
+
+    AnsiOutput::success("Serving on " + socket_path + " with " + std::to_string(workers_) + " workers");
+    while (!stopping_ && !signalled) {
+        pollfd waiting{listener, POLLIN, 0};
+        if (poll(&waiting, 1, kPollMilliseconds) <= 0) {
+            continue;
+        }
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        clients.push_back(client);
+        queue_ready.notify_one();
+    }
+
+    // Queued connections are still answered before the workers exit
+    AnsiOutput::info("Stopping, waiting for running jobs...");
+    close(listener);
+    unlink(socket_path.c_str());
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        accepting = false;
+    }
+    queue_ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    sigaction(SIGPIPE, &old_pipe, nullptr);
+    sigaction(SIGINT, &old_int, nullptr);
+    sigaction(SIGTERM, &old_term, nullptr);
+    return true;
+}
+
+#endif
@@ -0,0 +1,193 @@
+#include "json_lines_writer.h"
+#include "output_buffer.h"
+#include "tracer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <thread>
+
+namespace {
+
+constexpr uint64_t kOnes = 0x0101010101010101ULL;
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// True if any byte of the word is zero
+inline uint64_t has_zero_byte(uint64_t word) {
+    return (word - kOnes) & ~word & kHighBits;
+}
+
+// True if any byte of the word needs escaping: '"', '\\' or a control character
+inline bool word_needs_escape(uint64_t word) {
+    uint64_t control = (word - kOnes * 0x20) & ~word & kHighBits;
+    uint64_t quote = has_zero_byte(word ^ (kOnes * '"'));
+    uint64_t backslash = has_zero_byte(word ^ (kOnes * '\\'));
+    return (control | quote | backslash) != 0;
+}
+
+void append_escaped_byte(std::string& out, unsigned char c) {
+    static const char kHex[] = "0123456789abcdef";
+    switch (c) {
+        case '"':  out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\b': out.append("\\b"); break;
+        case '\f': out.append("\\f"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            if (c < 0x20) {
+                char escape[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(escape, sizeof(escape));
+            } else {
+                out.push_back(static_cast<char>(c));
+            }
+    }
+}
+
+} // namespace
+
+bool JsonLinesWriter::write_jsonl(const QueryResult& result,
+                                 const std::filesystem::path& output_path) {
+    std::ofstream file(output_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    OutputBuffer buffer(file);
+    auto key_prefixes = build_key_prefixes(result.headers);
+
+    for (const auto& row : result.rows) {
+        append_row(buffer.data(), key_prefixes, row);
+        buffer.maybe_flush();
+    }
+
+    return buffer.flush();
+}
+
+bool JsonLinesWriter::write_jsonl_parallel(const QueryResult& result,
+                                          const std::filesystem::path& output_path,
+                                          size_t chunk_rows) {
+    chunk_rows = std::max<size_t>(1, chunk_rows);
+    size_t chunk_count = (result.rows.size() + chunk_rows - 1) / chunk_rows;
+    if (chunk_count <= 1) {
+        return write_jsonl(result, output_path);
+    }
+
+    std::ofstream file(output_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto key_prefixes = build_key_prefixes(result.headers);
+
+    // Each chunk is serialized into its own buffer, one wave of chunks per worker
+    // at a time so memory stays bounded, then written to the file in row order
+    size_t wave_size = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t wave_start = 0; wave_start < chunk_count; wave_start += wave_size) {
+        size_t wave_end = std::min(chunk_count, wave_start + wave_size);
+        std::vector<std::future<std::pair<std::string, MemoryCharge>>> chunks;
+
+        for (size_t chunk = wave_start; chunk < wave_end; ++chunk) {
+            chunks.push_back(std::async(std::launch::async, [&, chunk]() {
+                TraceSpan span("write", "serialize jsonl chunk");
+                size_t begin = chunk * chunk_rows;
+                size_t end = std::min(result.rows.size(), begin + chunk_rows);
+
+                std::string out;
+                out.reserve((end - begin) * key_prefixes.size() * 24);
+                for (size_t row = begin; row < end; ++row) {
+                    append_row(out, key_prefixes, result.rows[row]);
+                }
+                MemoryCharge charge(MemoryCategory::BUFFER, "jsonl chunks", out.capacity());
+                return std::make_pair(std::move(out), std::move(charge));
+            }));
+        }
+
+        for (auto& chunk : chunks) {
+            auto serialized = chunk.get();
+            file.write(serialized.first.data(), static_cast<std::streamsize>(serialized.first.size()));
+        }
+    }
+
+    return file.good();
+}
+
+bool JsonLinesWriter::write_jsonl_rows(const QueryResult& result,
+                                      const std::vector<size_t>& row_indices,
+                                      const std::filesystem::path& output_path) {
+    std::ofstream file(output_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    OutputBuffer buffer(file);
+    auto key_prefixes = build_key_prefixes(result.headers);
+
+    for (size_t row_idx : row_indices) {
+        if (row_idx < result.rows.size()) {
+            append_row(buffer.data(), key_prefixes, result.rows[row_idx]);
+            buffer.maybe_flush();
+        }
+    }
+
+    return buffer.flush();
+}
+
+void JsonLinesWriter::append_escaped(std::string& out, const std::string& value) {
+    const char* data = value.data();
+    size_t length = value.size();
+    size_t pos = 0;
+
+    // Scan eight bytes at a time and copy clean words wholesale
+    while (pos + 8 <= length) {
+        uint64_t word;
+        std::memcpy(&word, data + pos, 8);
+        if (!word_needs_escape(word)) {
+            out.append(data + pos, 8);
+            pos += 8;
+            continue;
+        }
+        for (size_t end = pos + 8; pos < end; ++pos) {
+            append_escaped_byte(out, static_cast<unsigned char>(data[pos]));
+        }
+    }
+
+    for (; pos < length; ++pos) {
+        append_escaped_byte(out, static_cast<unsigned char>(data[pos]));
+    }
+}
+
+std::vector<std::string> JsonLinesWriter::build_key_prefixes(const std::vector<std::string>& headers) {
+    std::vector<std::string> prefixes;
+    prefixes.reserve(headers.size());
+
+    for (size_t i = 0; i < headers.size(); ++i) {
+        std::string prefix = i == 0 ? "{\"" : ",\"";
+        append_escaped(prefix, headers[i]);
+        prefix.append("\":\"");
+        prefixes.push_back(std::move(prefix));
+    }
+    return prefixes;
+}
+
+void JsonLinesWriter::append_row(std::string& out,
+                                const std::vector<std::string>& key_prefixes,
+                                const std::vector<std::string>& row) {
+    if (key_prefixes.empty()) {
+        out.append("{}\n");
+        return;
+    }
+
+    // Every header gets a key; missing trailing fields are written as ""
+    for (size_t i = 0; i < key_prefixes.size(); ++i) {
+        out.append(key_prefixes[i]);
+        if (i < row.size()) {
+            append_escaped(out, row[i]);
+        }
+        out.push_back('"');
+    }
+    out.append("}\n");
+}
\ No newline at end of file
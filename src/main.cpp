@@ -4,49 +4,58 @@
 #include "database.h"
 #include "query_engine.h"
 #include "transformation_engine.h"
-#include "csv_writer.h"
+#include "output_writer.h"
 #include "progress_manager.h"
 #include "ansi_output.h"
+#include "run_metrics.h"
+#include "tracer.h"
+#include "data_generator.h"
+#include "memory_accounting.h"
+#include "perf_counters.h"
+#include "execution_planner.h"
+#include "query_explainer.h"
+#include "table_loader.h"
+#include "column_store.h"
+#include "config_runner.h"
+#include "run_checkpoint.h"
+#include "job_server.h"
+#include "query_shell.h"
 
 #include <iostream>
 #include <thread>
-#include <future>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <iomanip>
 
-void load_data_multithreaded(const std::vector<FileInfo>& files, Database& database) {
+void load_data_multithreaded(const std::vector<FileInfo>& files, Database& database, size_t threads,
+                             ColumnStore* store = nullptr) {
     AnsiOutput::info("\nLoading data files...");
     
-    std::vector<std::future<std::unique_ptr<PsvTable>>> futures;
-    
-    for (const auto& file : files) {
-        auto future = std::async(std::launch::async, [&file]() {
-            auto progress = ProgressManager::create_file_progress(
-                file.path.filename().string(), file.size_bytes);
-            
-            auto table = PsvParser::parse_file(file.path, file.headers_path);
-            
-            ProgressManager::complete_progress(*progress);
-            return table;
-        });
-        
-        futures.push_back(std::move(future));
-    }
-    
-    // Collect results
-    for (auto& future : futures) {
-        auto table = future.get();
-        if (table) {
-            database.load_table(std::move(table));
-        }
-    }
+    // A fixed set of workers pulls files, so the planner's thread count bounds
+    // how many tables are parsed at once; wait_all() rethrows a parse error
+    TableLoader loader(database, files, threads, nullptr, store);
+    loader.wait_all();
     
     AnsiOutput::success("Loaded " + std::to_string(database.get_total_records()) + 
                      " total records from " + std::to_string(files.size()) + " files.");
 }
 
+// Inputs whose tables are in `tables` and not yet in the database
+std::vector<FileInfo> files_to_load(const std::vector<FileInfo>& inputs,
+                                    const std::vector<std::string>& tables,
+                                    const Database& database) {
+    std::vector<FileInfo> files;
+    for (const auto& input : inputs) {
+        std::string table = input.table();
+        if (std::find(tables.begin(), tables.end(), table) != tables.end() && !database.get_table(table)) {
+            files.push_back(input);
+        }
+    }
+    return files;
+}
+
 void process_sanity_check(const std::string& output_path) {
     try {
         AnsiOutput::info("Running sanity checks on output directory: " + output_path);
@@ -243,11 +252,183 @@ void process_sanity_check(const std::string& output_path) {
     }
 }
 
-void process_transformation(const std::string& input_path, const std::string& output_path) {
+void process_generate(const CommandLineArgs& args) {
+    GeneratorOptions options;
+    options.scale = args.gen_scale;
+    options.seed = args.gen_seed;
+    options.skew = args.gen_skew;
+    options.sortedness = args.gen_sortedness;
+    options.departments = args.gen_departments;
+    options.locations = args.gen_locations;
+    options.cost_centers = args.gen_cost_centers;
+    
+    DataGenerator generator(options);
+    std::ostringstream heading;
+    heading << "Generating scale " << options.scale << " data in: " << args.output_path;
+    AnsiOutput::info(heading.str());
+    AnsiOutput::plain("  employees: " + std::to_string(generator.employee_rows()) +
+                      ", departments: " + std::to_string(generator.department_rows()) +
+                      ", cost_centers: " + std::to_string(generator.cost_center_rows()) +
+                      ", locations: " + std::to_string(generator.location_rows()));
+    
+    auto start = std::chrono::steady_clock::now();
+    auto tables = generator.generate(args.output_path);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    uint64_t total_bytes = 0;
+    for (const auto& table : tables) {
+        total_bytes += table.bytes;
+        std::ostringstream line;
+        line << "  " << table.path.string() << ": " << table.rows << " rows, "
+             << std::fixed << std::setprecision(1) << table.bytes / (1024.0 * 1024.0) << " MB";
+        AnsiOutput::plain(line.str());
+    }
+    
+    std::ostringstream summary;
+    summary << "Generated " << std::fixed << std::setprecision(1) << total_bytes / (1024.0 * 1024.0)
+            << " MB in " << std::setprecision(2) << seconds << " s";
+    AnsiOutput::success(summary.str());
+    AnsiOutput::info("Sample rules written to: " + (std::filesystem::path(args.output_path) / "output").string());
+}
+
+// Peak accounted memory per category and the largest components
+void print_store_summary(const ColumnStore& store) {
+    auto stats = store.stats();
+    AnsiOutput::info("Column store " + store.directory().string() + ": " + std::to_string(stats.hits) +
+                     " files mapped, " + std::to_string(stats.misses) + " parsed and stored");
+    if (stats.write_errors > 0) {
+        AnsiOutput::warning("  " + std::to_string(stats.write_errors) +
+                            " files could not be stored; they are parsed again next run");
+    }
+}
+
+void print_memory_summary() {
+    auto format_size = [](uint64_t bytes) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(1);
+        if (bytes < 1024 * 1024) {
+            text << bytes / 1024.0 << " KB";
+        } else {
+            text << bytes / (1024.0 * 1024.0) << " MB";
+        }
+        return text.str();
+    };
+    
+    ComponentMemory total = MemoryAccounting::total();
+    AnsiOutput::info("\nMemory (accounted peak " + format_size(total.peak_bytes) + "):");
+    for (MemoryCategory category : {MemoryCategory::TABLE, MemoryCategory::RESULT,
+                                    MemoryCategory::HASH_TABLE, MemoryCategory::BUFFER}) {
+        ComponentMemory usage = MemoryAccounting::category_total(category);
+        AnsiOutput::plain("  " + usage.name + ": peak " + format_size(usage.peak_bytes) +
+                          ", current " + format_size(usage.current_bytes));
+    }
+    
+    auto components = MemoryAccounting::components();
+    size_t shown = std::min<size_t>(components.size(), 5);
+    if (shown > 0) {
+        AnsiOutput::plain("  Largest components:");
+    }
+    for (size_t i = 0; i < shown; ++i) {
+        AnsiOutput::plain("    " + components[i].name + ": peak " + format_size(components[i].peak_bytes));
+    }
+    AnsiOutput::plain("  Process peak RSS: " + format_size(RunMetrics::peak_rss_bytes()));
+}
+
+// IPC and misses per row for each phase and config (--perf-counters)
+void print_perf_summary(const RunMetrics& metrics) {
+    auto print_stage = [](const StageMetrics& stage) {
+        const PerfSample& perf = stage.perf;
+        std::ostringstream line;
+        line << "  " << std::left << std::setw(28) << stage.name << std::right << std::fixed;
+        if (perf.has(PerfSample::CYCLES) && perf.has(PerfSample::INSTRUCTIONS)) {
+            line << "  IPC " << std::setprecision(2) << perf.ipc();
+        }
+        if (perf.has(PerfSample::CACHE_MISSES)) {
+            line << "  cache misses/row " << std::setprecision(2) << stage.per_row(perf.cache_misses);
+        }
+        if (perf.has(PerfSample::BRANCH_MISSES)) {
+            line << "  branch misses/row " << std::setprecision(2) << stage.per_row(perf.branch_misses);
+        }
+        AnsiOutput::plain(line.str());
+    };
+    
+    AnsiOutput::info("\nHardware counters (" + PerfCounters::reason() + "):");
+    for (const auto& phase : metrics.phases()) {
+        print_stage(phase);
+    }
+    for (const auto& config : metrics.configs()) {
+        print_stage(config);
+    }
+}
+
+// Roll a config's row and byte counts up into the transform phase
+void add_config_totals(StageMetrics& phase, const StageMetrics& config) {
+    phase.rows_in += config.rows_in;
+    phase.rows_out += config.rows_out;
+    phase.bytes_written += config.bytes_written;
+}
+
+// Classify configs against the schemas, drop partitions no config reads,
+// estimate the remaining inputs and choose how each config runs
+ExecutionPlan plan_execution(std::vector<FileInfo>& input_files,
+                             const std::vector<OutputFileInfo>& output_files,
+                             const OutputOptions& output_options,
+                             Database& schema) {
+    ExecutionPlanner::load_schemas(input_files, schema);
+    std::vector<ConfigDescription> descriptions;
+    for (const auto& output_file : output_files) {
+        descriptions.push_back(ExecutionPlanner::describe_config(output_file, schema));
+    }
+    size_t scanned_files = input_files.size();
+    input_files = ExecutionPlanner::prune_partitions(input_files, descriptions, schema);
+    std::vector<InputEstimate> estimates;
+    for (const auto& file : input_files) {
+        estimates.push_back(ExecutionPlanner::estimate_input(file));
+    }
+    ExecutionPlan plan = ExecutionPlanner::plan(estimates, descriptions, output_options,
+                                                ExecutionPlanner::available_memory_bytes(),
+                                                std::thread::hardware_concurrency());
+    plan.pruned_partitions = scanned_files - input_files.size();
+    return plan;
+}
+
+void process_transformation(const CommandLineArgs& args) {
+    const std::string& input_path = args.input_path;
+    const std::string& output_path = args.output_path;
+    
+    OutputOptions output_options;
+    output_options.max_rows_per_file = args.max_rows_per_file;
+    output_options.partition_column = args.partition_column;
+    output_options.diff = args.diff;
+    output_options.diff_key = args.diff_key;
+    if (!OutputWriter::parse_format(args.output_format, output_options.format)) {
+        std::cerr << "Unknown output format: " << args.output_format << std::endl;
+        return;
+    }
+    
+    // Counters must be open before the run's first sample is taken
+    if (args.perf_counters && !PerfCounters::enable()) {
+        AnsiOutput::warning("Hardware counters unavailable, continuing without them: " + PerfCounters::reason());
+    }
+    
+    // Only the metrics report shows allocations, so other runs skip counting them
+    if (!args.metrics_path.empty()) {
+        AllocationCounter::enable();
+    }
+    RunMetrics metrics;
+    if (args.perf_counters) {
+        metrics.set_perf_status(PerfCounters::reason());
+    }
+    if (!args.trace_path.empty()) {
+        Tracer::enable();
+    }
+    
     try {
         // Step 1: Scan input files
+        RunMetrics::Stage scan_input_stage(metrics, RunMetrics::Category::PHASE, "scan_input");
         AnsiOutput::info("Scanning input directory: " + input_path);
         auto input_files = FileScanner::scan_input_files(input_path);
+        scan_input_stage.finish();
         
         if (input_files.empty()) {
             std::cerr << "No input PSV files found in: " << input_path << std::endl;
@@ -256,13 +437,11 @@ void process_transformation(const std::string& input_path, const std::string& ou
         
         FileScanner::display_file_structure(input_files);
         
-        // Step 2: Load data into database
-        Database database;
-        load_data_multithreaded(input_files, database);
-        
-        // Step 3: Scan output files for transformation rules
+        // Step 2: Scan output files for transformation rules
+        RunMetrics::Stage scan_output_stage(metrics, RunMetrics::Category::PHASE, "scan_output");
         AnsiOutput::info("\nScanning output directory: " + output_path);
         auto output_files = FileScanner::scan_output_files(output_path);
+        scan_output_stage.finish();
         
         if (output_files.empty()) {
             std::cerr << "No output rule files found in: " << output_path << std::endl;
@@ -271,42 +450,330 @@ void process_transformation(const std::string& input_path, const std::string& ou
         
         FileScanner::display_output_structure(output_files);
         
-        // Step 4: Process transformations for each output file
-        QueryEngine query_engine(database);
+        // Step 3: Plan execution from input sizes, rule shapes and available memory
+        RunMetrics::Stage plan_stage(metrics, RunMetrics::Category::PHASE, "plan");
+        Database schema;
+        ExecutionPlan plan = plan_execution(input_files, output_files, output_options, schema);
+        plan_stage.finish();
         
-        for (const auto& output_file : output_files) {
+        if (args.verbose) {
+            AnsiOutput::info("\nExecution plan:");
+            for (const auto& line : plan.explain()) {
+                AnsiOutput::plain("  " + line);
+            }
+        } else if (!plan.load_up_front) {
+            AnsiOutput::warning("\nInputs exceed the memory budget; loading tables per configuration "
+                                "(--verbose shows the plan)");
+        }
+        
+        // Configs an interrupted run completed are skipped with --resume, as
+        // long as their inputs, rules and output options are unchanged
+        RunCheckpoint checkpoint(output_path, args.resume);
+        std::vector<std::string> signatures;
+        std::vector<const ConfigCheckpoint*> resumed;
+        for (size_t i = 0; i < output_files.size(); ++i) {
+            signatures.push_back(RunCheckpoint::signature(output_files[i], input_files,
+                                                          plan.configs[i].tables, output_options));
+            resumed.push_back(checkpoint.find(output_files[i], signatures.back()));
+        }
+        if (args.resume && checkpoint.size() == 0) {
+            AnsiOutput::warning("\nNo checkpoint in " + output_path + ", running every configuration");
+        }
+        auto completed = [&resumed](size_t index) {
+            return resumed[index] && resumed[index]->done;
+        };
+        
+        // Step 4: Load the tables some config reads in the background, smallest
+        // first. Each config starts as soon as its own tables are in.
+        std::unique_ptr<ColumnStore> store;
+        if (!args.store_path.empty()) {
+            store = std::make_unique<ColumnStore>(args.store_path);
+        }
+        Database database;
+        std::unique_ptr<RunMetrics::Stage> load_stage;
+        std::unique_ptr<TableLoader> loader;
+        if (plan.load_up_front) {
+            load_stage = std::make_unique<RunMetrics::Stage>(metrics, RunMetrics::Category::PHASE, "load");
+            std::vector<std::string> used_tables;
+            for (size_t i = 0; i < plan.configs.size(); ++i) {
+                if (!completed(i)) {
+                    used_tables.insert(used_tables.end(), plan.configs[i].tables.begin(), plan.configs[i].tables.end());
+                }
+            }
+            auto files = files_to_load(input_files, used_tables, database);
+            for (const auto& file : files) {
+                load_stage->counters().bytes_read += file.size_bytes;
+            }
+            
+            AnsiOutput::info("\nLoading " + std::to_string(files.size()) + " data files...");
+            size_t file_count = files.size();
+            loader = std::make_unique<TableLoader>(database, std::move(files), plan.load_threads,
+                [&database, &load_stage, file_count]() {
+                    load_stage->counters().rows_in = database.get_total_records();
+                    load_stage->counters().rows_out = database.get_total_records();
+                    load_stage->finish();
+                    AnsiOutput::success("Loaded " + std::to_string(database.get_total_records()) + 
+                                        " total records from " + std::to_string(file_count) + " files.");
+                }, store.get());
+        }
+        
+        // Step 5: Process transformations for each output file, each once its tables are loaded
+        RunMetrics::Stage transform_stage(metrics, RunMetrics::Category::PHASE, "transform");
+        
+        std::vector<size_t> waiting_configs;
+        for (size_t i = 0; i < output_files.size(); ++i) {
+            if (completed(i)) {
+                AnsiOutput::info("\nSkipping " + output_files[i].name_prefix + ": completed by the interrupted run (" +
+                                 std::to_string(resumed[i]->rows) + " records)");
+            } else {
+                waiting_configs.push_back(i);
+            }
+        }
+        size_t failed_configs = 0;
+        while (!waiting_configs.empty()) {
+            // In file order among the configs whose tables are ready
+            size_t next = 0;
+            if (loader) {
+                std::vector<std::vector<std::string>> waiting_tables;
+                for (size_t index : waiting_configs) {
+                    waiting_tables.push_back(plan.configs[index].tables);
+                }
+                next = loader->wait_for_any(waiting_tables);
+            }
+            size_t config_index = waiting_configs[next];
+            waiting_configs.erase(waiting_configs.begin() + next);
+            
+            const auto& output_file = output_files[config_index];
+            const ConfigPlan& config_plan = plan.configs[config_index];
             AnsiOutput::header("\nProcessing transformation: " + output_file.name_prefix);
             
-            TransformationEngine transform_engine(database, query_engine);
+            RunMetrics::Stage config_stage(metrics, RunMetrics::Category::CONFIG, output_file.name_prefix);
+            StageMetrics& config_counters = config_stage.counters();
+            
+            if (!plan.load_up_front) {
+                // Spilling: bring in this config's tables, release those no later config reads
+                auto files = files_to_load(input_files, config_plan.tables, database);
+                if (!files.empty()) {
+                    load_data_multithreaded(files, database, plan.load_threads, store.get());
+                    for (const auto& file : files) {
+                        config_counters.bytes_read += file.size_bytes;
+                    }
+                }
+            }
             
-            // Load transformation rules and headers
-            transform_engine.load_output_headers(output_file.headers_path);
-            transform_engine.load_rules(output_file.rules_path);
+            // Streamed CSV outputs are synced and checkpointed in chunks; a
+            // partial one the interrupted run left is continued
+            const std::string& signature = signatures[config_index];
+            std::string output_name = output_file.name_prefix + OutputWriter::extension_for(output_options.format);
+            StreamCheckpoint stream;
+            stream.chunk_bytes = RunCheckpoint::kChunkBytes;
+            stream.on_chunk = [&](size_t rows, uint64_t bytes) {
+                checkpoint.record(output_file, ConfigCheckpoint{false, rows, bytes, signature, {output_name}});
+            };
+            if (resumed[config_index] && config_plan.stream_rows) {
+                stream.resume_rows = resumed[config_index]->rows;
+                stream.resume_bytes = resumed[config_index]->bytes;
+                AnsiOutput::info("Continuing the interrupted run's output after " +
+                                 std::to_string(stream.resume_rows) + " records");
+            }
             
-            // Transform data
-            auto transformed_data = transform_engine.transform_data();
+            // Static configs read no table; the schema is enough even when nothing is loaded
+            bool static_config = config_plan.shape == ConfigShape::STATIC;
+            ConfigRunResult result = ConfigRunner::run(output_file, ConfigRunner::load_rules(output_file),
+                                                       config_plan, static_config ? schema : database,
+                                                       output_options, true, &stream);
+            config_counters.rows_in = result.rows_in;
+            config_counters.rows_out = result.rows_out;
+            config_counters.bytes_written = result.bytes_written;
             
-            if (transformed_data) {
-                // Write CSV output
-                auto output_csv_path = output_file.headers_path.parent_path() / 
-                                     (output_file.name_prefix + ".csv");
-                
-                AnsiOutput::info("Writing output: " + output_csv_path.string());
-                
-                if (CsvWriter::write_csv_with_progress(*transformed_data, output_csv_path)) {
-                    AnsiOutput::success("Successfully wrote " + std::to_string(transformed_data->rows.size()) + 
-                                       " records to " + output_csv_path.string());
-                } else {
-                    std::cerr << "Failed to write output file: " << output_csv_path << std::endl;
+            if (result.success) {
+                ConfigCheckpoint done{true, result.rows_out, result.bytes_written, signature, {}};
+                for (const auto& file : result.files) {
+                    done.files.push_back(file.filename().string());
+                }
+                if (!checkpoint.record(output_file, done)) {
+                    AnsiOutput::warning("Cannot write checkpoint file: " + checkpoint.path().string());
+                }
+            } else {
+                failed_configs++;
+            }
+            
+            if (!plan.load_up_front) {
+                // Keep a table while any config still waiting reads it, so it is loaded once
+                for (const auto& table : config_plan.tables) {
+                    bool needed_later = std::any_of(waiting_configs.begin(), waiting_configs.end(), [&](size_t waiting) {
+                        const auto& tables = plan.configs[waiting].tables;
+                        return std::find(tables.begin(), tables.end(), table) != tables.end();
+                    });
+                    if (!needed_later) {
+                        database.drop_table(table);
+                    }
                 }
             }
+            add_config_totals(transform_stage.counters(), config_counters);
         }
         
-        AnsiOutput::success("\nTransformation complete!");
+        transform_stage.finish();
+        if (failed_configs == 0) {
+            checkpoint.finish();
+            AnsiOutput::success("\nTransformation complete!");
+        } else {
+            AnsiOutput::warning("\n" + std::to_string(failed_configs) + " configuration(s) failed; " +
+                                "run again with --resume to redo only those");
+        }
+        if (store) {
+            print_store_summary(*store);
+        }
+        print_memory_summary();
+        if (PerfCounters::enabled()) {
+            print_perf_summary(metrics);
+        }
         
     } catch (const std::exception& e) {
         std::cerr << "Error during transformation: " << e.what() << std::endl;
     }
+    
+    if (!args.metrics_path.empty()) {
+        if (metrics.write_json(args.metrics_path)) {
+            AnsiOutput::info("Run metrics written to: " + args.metrics_path);
+        } else {
+            std::cerr << "Failed to write metrics file: " << args.metrics_path << std::endl;
+        }
+    }
+    
+    PerfCounters::disable();
+    
+    if (!args.trace_path.empty()) {
+        Tracer::disable();
+        if (Tracer::write_json(args.trace_path)) {
+            AnsiOutput::info("Trace written to: " + args.trace_path);
+        } else {
+            std::cerr << "Failed to write trace file: " << args.trace_path << std::endl;
+        }
+    }
+}
+
+void process_explain(const CommandLineArgs& args) {
+    OutputOptions output_options;
+    output_options.max_rows_per_file = args.max_rows_per_file;
+    output_options.partition_column = args.partition_column;
+    output_options.diff = args.diff;
+    output_options.diff_key = args.diff_key;
+    if (!OutputWriter::parse_format(args.output_format, output_options.format)) {
+        std::cerr << "Unknown output format: " << args.output_format << std::endl;
+        return;
+    }
+    
+    std::filesystem::path scratch_dir;
+    try {
+        auto input_files = FileScanner::scan_input_files(args.input_path);
+        if (input_files.empty()) {
+            std::cerr << "No input PSV files found in: " << args.input_path << std::endl;
+            return;
+        }
+        auto output_files = FileScanner::scan_output_files(args.output_path);
+        if (output_files.empty()) {
+            std::cerr << "No output rule files found in: " << args.output_path << std::endl;
+            return;
+        }
+        
+        Database schema;
+        ExecutionPlan plan = plan_execution(input_files, output_files, output_options, schema);
+        Database samples;
+        QueryExplainer::load_samples(input_files, samples);
+        
+        AnsiOutput::info("Execution plan:");
+        for (const auto& line : plan.explain()) {
+            AnsiOutput::plain("  " + line);
+        }
+        
+        if (args.explain_analyze) {
+            // Analyzed outputs are measured, then thrown away
+            scratch_dir = std::filesystem::temp_directory_path() /
+                          ("agile-pasta-explain-" +
+                           std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+            std::filesystem::create_directories(scratch_dir);
+        }
+        
+        for (size_t config_index = 0; config_index < output_files.size(); ++config_index) {
+            const auto& output_file = output_files[config_index];
+            const ConfigPlan& config_plan = plan.configs[config_index];
+            AnsiOutput::header("\n" + output_file.name_prefix + ": " +
+                               ExecutionPlanner::mode_name(config_plan.mode) + " " +
+                               ExecutionPlanner::shape_name(config_plan.shape));
+            
+            PlanOperator root = QueryExplainer::build(output_file, config_plan, plan, samples, output_options);
+            if (args.explain_analyze &&
+                !QueryExplainer::analyze(root, output_file, config_plan, input_files, output_options, scratch_dir)) {
+                std::cerr << "Failed to write output while analyzing: " << output_file.name_prefix << std::endl;
+            }
+            for (const auto& line : QueryExplainer::render(root)) {
+                AnsiOutput::plain("  " + line);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error during explain: " << e.what() << std::endl;
+    }
+    
+    if (!scratch_dir.empty()) {
+        std::error_code error;
+        std::filesystem::remove_all(scratch_dir, error);
+    }
+}
+
+void process_query(const CommandLineArgs& args) {
+    try {
+        auto input_files = FileScanner::scan_input_files(args.input_path);
+        if (input_files.empty()) {
+            std::cerr << "No input PSV files found in: " << args.input_path << std::endl;
+            return;
+        }
+        
+        // A single statement's output may be piped; keep it free of progress bars
+        bool interactive = args.query_sql.empty() && AnsiOutput::is_terminal_input();
+        if (!args.query_sql.empty()) {
+            ProgressManager::set_enabled(false);
+        }
+        std::unique_ptr<ColumnStore> store;
+        if (!args.store_path.empty()) {
+            store = std::make_unique<ColumnStore>(args.store_path);
+        }
+        Database database;
+        load_data_multithreaded(input_files, database, std::max(1u, std::thread::hardware_concurrency()),
+                                store.get());
+        if (store && interactive) {
+            print_store_summary(*store);
+        }
+        
+        QueryShell shell(database);
+        if (!args.query_sql.empty()) {
+            shell.run_command(args.query_sql, std::cout);
+            return;
+        }
+        if (interactive) {
+            AnsiOutput::info("Statements end with ';'. Type .help for the syntax, .quit to leave.");
+        }
+        shell.run(std::cin, std::cout, interactive);
+    } catch (const std::exception& e) {
+        std::cerr << "Error during query: " << e.what() << std::endl;
+    }
+}
+
+int process_serve(const CommandLineArgs& args) {
+    uint64_t cache_budget = args.serve_cache_mb * 1024 * 1024;
+    if (cache_budget == 0) {
+        cache_budget = static_cast<uint64_t>(static_cast<double>(ExecutionPlanner::available_memory_bytes()) *
+                                              ExecutionPlanner::kBudgetFraction);
+    }
+    
+    // Jobs run side by side; their progress bars would only garble the log
+    ProgressManager::set_enabled(false);
+    JobServer server(args.serve_workers, cache_budget, args.serve_compress_cache);
+    if (cache_budget > 0) {
+        AnsiOutput::info("Table cache budget: " + ExecutionPlanner::format_bytes(cache_budget) +
+                         (args.serve_compress_cache ? ", tables kept compressed" : ""));
+    }
+    return server.serve(args.socket_path) ? 0 : 1;
 }
 
 int main(int argc, char* argv[]) {
@@ -324,9 +791,35 @@ int main(int argc, char* argv[]) {
                     CommandLineParser::print_usage();
                     return 1;
                 }
-                process_transformation(args.input_path, args.output_path);
+                process_transformation(args);
                 return 0;
                 
+            case CommandLineArgs::Command::EXPLAIN:
+                if (args.input_path.empty() || args.output_path.empty()) {
+                    std::cerr << "Error: Both --in and --out paths are required for explain command." << std::endl;
+                    CommandLineParser::print_usage();
+                    return 1;
+                }
+                process_explain(args);
+                return 0;
+                
+            case CommandLineArgs::Command::QUERY:
+                if (args.input_path.empty()) {
+                    std::cerr << "Error: --in path is required for query command." << std::endl;
+                    CommandLineParser::print_usage();
+                    return 1;
+                }
+                process_query(args);
+                return 0;
+                
+            case CommandLineArgs::Command::SERVE:
+                if (args.socket_path.empty()) {
+                    std::cerr << "Error: --socket path is required for serve command." << std::endl;
+                    CommandLineParser::print_usage();
+                    return 1;
+                }
+                return process_serve(args);
+                
             case CommandLineArgs::Command::SANITY_CHECK:
                 if (args.sanity_check_path.empty()) {
                     std::cerr << "Error: --out path is required for check command." << std::endl;
@@ -336,6 +829,15 @@ int main(int argc, char* argv[]) {
                 process_sanity_check(args.sanity_check_path);
                 return 0;
                 
+            case CommandLineArgs::Command::GENERATE:
+                if (args.output_path.empty()) {
+                    std::cerr << "Error: --out directory is required for gen command." << std::endl;
+                    CommandLineParser::print_usage();
+                    return 1;
+                }
+                process_generate(args);
+                return 0;
+                
             case CommandLineArgs::Command::INVALID:
             default:
                 std::cerr << "Error: Invalid command or arguments." << std::endl;
@@ -0,0 +1,220 @@
+#include "memory_accounting.h"
+#include "psv_parser.h"
+#include "query_engine.h"
+#include <algorithm>
+#include <array>
+#include <map>
+#include <mutex>
+
+namespace {
+
+constexpr size_t kCategoryCount = 4;
+
+struct Usage {
+    uint64_t current = 0;
+    uint64_t peak = 0;
+
+    void add(uint64_t bytes) {
+        current += bytes;
+        peak = std::max(peak, current);
+    }
+
+    void subtract(uint64_t bytes) {
+        current -= std::min(current, bytes);
+    }
+};
+
+struct AccountingState {
+    std::mutex mutex;
+    std::map<std::pair<MemoryCategory, std::string>, Usage> components;
+    std::array<Usage, kCategoryCount> categories;
+    Usage total;
+};
+
+AccountingState& state() {
+    static AccountingState instance;
+    return instance;
+}
+
+// Bytes a string keeps outside its own object (nothing while it fits the small buffer)
+uint64_t heap_string_bytes(const std::string& value) {
+    static const size_t kInlineCapacity = std::string().capacity();
+    return value.capacity() > kInlineCapacity ? value.capacity() + 1 : 0;
+}
+
+uint64_t fields_bytes(const std::vector<std::string>& fields) {
+    uint64_t bytes = sizeof(fields) + fields.capacity() * sizeof(std::string);
+    for (const auto& field : fields) {
+        bytes += heap_string_bytes(field);
+    }
+    return bytes;
+}
+
+} // namespace
+
+void MemoryAccounting::acquire(MemoryCategory category, const std::string& name, uint64_t bytes) {
+    AccountingState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.components[{category, name}].add(bytes);
+    s.categories[static_cast<size_t>(category)].add(bytes);
+    s.total.add(bytes);
+}
+
+void MemoryAccounting::release(MemoryCategory category, const std::string& name, uint64_t bytes) {
+    AccountingState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.components[{category, name}].subtract(bytes);
+    s.categories[static_cast<size_t>(category)].subtract(bytes);
+    s.total.subtract(bytes);
+}
+
+std::vector<ComponentMemory> MemoryAccounting::components() {
+    AccountingState& s = state();
+    std::vector<ComponentMemory> result;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (const auto& entry : s.components) {
+            ComponentMemory component;
+            component.category = entry.first.first;
+            component.name = entry.first.second;
+            component.current_bytes = entry.second.current;
+            component.peak_bytes = entry.second.peak;
+            result.push_back(std::move(component));
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [](const ComponentMemory& a, const ComponentMemory& b) {
+        return a.peak_bytes > b.peak_bytes;
+    });
+    return result;
+}
+
+ComponentMemory MemoryAccounting::category_total(MemoryCategory category) {
+    AccountingState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const Usage& usage = s.categories[static_cast<size_t>(category)];
+
+    ComponentMemory total;
+    total.name = category_name(category);
+    total.category = category;
+    total.current_bytes = usage.current;
+    total.peak_bytes = usage.peak;
+    return total;
+}
+
+ComponentMemory MemoryAccounting::total() {
+    AccountingState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    ComponentMemory total;
+    total.name = "total";
+    total.current_bytes = s.total.current;
+    total.peak_bytes = s.total.peak;
+    return total;
+}
+
+void MemoryAccounting::reset() {
+    AccountingState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.components.clear();
+    s.categories.fill(Usage{});
+    s.total = Usage{};
+}
+
+void MemoryAccounting::reset_peaks() {
+    AccountingState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (auto& entry : s.components) {
+        entry.second.peak = entry.second.current;
+    }
+    for (auto& usage : s.categories) {
+        usage.peak = usage.current;
+    }
+    s.total.peak = s.total.current;
+}
+
+const char* MemoryAccounting::category_name(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::TABLE: return "tables";
+        case MemoryCategory::RESULT: return "results";
+        case MemoryCategory::HASH_TABLE: return "hash_tables";
+        case MemoryCategory::BUFFER: return "buffers";
+    }
+    return "unknown";
+}
+
+uint64_t MemoryAccounting::string_bytes(const std::string& value) {
+    return sizeof(std::string) + heap_string_bytes(value);
+}
+
+uint64_t MemoryAccounting::table_bytes(const PsvTable& table) {
+    // A mapped table's fields live in the shared page cache, not on this process's heap
+    uint64_t bytes = sizeof(PsvTable) + fields_bytes(table.headers);
+    bytes += table.records.capacity() * sizeof(PsvRecord);
+    for (const auto& record : table.records) {
+        bytes += fields_bytes(record.fields) - sizeof(record.fields);
+    }
+    // std::map node per header: key, value and three tree pointers plus color
+    bytes += table.header_index.size() * (sizeof(std::pair<const std::string, size_t>) + 4 * sizeof(void*));
+    return bytes;
+}
+
+uint64_t MemoryAccounting::result_bytes(const QueryResult& result) {
+    return sizeof(QueryResult) - sizeof(result.rows) + fields_bytes(result.headers) - sizeof(result.headers) +
+           rows_bytes(result.rows);
+}
+
+uint64_t MemoryAccounting::rows_bytes(const std::vector<std::vector<std::string>>& rows) {
+    uint64_t bytes = sizeof(rows) + rows.capacity() * sizeof(std::vector<std::string>);
+    for (const auto& row : rows) {
+        bytes += fields_bytes(row) - sizeof(row);
+    }
+    return bytes;
+}
+
+MemoryCharge::MemoryCharge(MemoryCategory category, std::string name, uint64_t bytes)
+    : category_(category), name_(std::move(name)), bytes_(bytes), active_(true) {
+    MemoryAccounting::acquire(category_, name_, bytes_);
+}
+
+MemoryCharge::~MemoryCharge() {
+    release();
+}
+
+MemoryCharge::MemoryCharge(MemoryCharge&& other) noexcept
+    : category_(other.category_), name_(std::move(other.name_)), bytes_(other.bytes_), active_(other.active_) {
+    other.active_ = false;
+    other.bytes_ = 0;
+}
+
+MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept {
+    if (this != &other) {
+        release();
+        category_ = other.category_;
+        name_ = std::move(other.name_);
+        bytes_ = other.bytes_;
+        active_ = other.active_;
+        other.active_ = false;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MemoryCharge::update(uint64_t bytes) {
+    if (!active_) {
+        return;
+    }
+    if (bytes > bytes_) {
+        MemoryAccounting::acquire(category_, name_, bytes - bytes_);
+    } else if (bytes < bytes_) {
+        MemoryAccounting::release(category_, name_, bytes_ - bytes);
+    }
+    bytes_ = bytes;
+}
+
+void MemoryCharge::release() {
+    if (active_) {
+        MemoryAccounting::release(category_, name_, bytes_);
+        active_ = false;
+        bytes_ = 0;
+    }
+}
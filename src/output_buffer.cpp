@@ -0,0 +1,40 @@
+#include "output_buffer.h"
+
+OutputBuffer::OutputBuffer(std::ofstream& file, size_t capacity)
+    : file_(file), capacity_(capacity) {
+    // Reserve a little headroom so a row crossing the threshold does not reallocate
+    buffer_.reserve(capacity_ + capacity_ / 8);
+    charge_ = MemoryCharge(MemoryCategory::BUFFER, "output buffer", buffer_.capacity());
+}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::append(const char* data, size_t length) {
+    buffer_.append(data, length);
+    maybe_flush();
+}
+
+void OutputBuffer::append(const std::string& data) {
+    append(data.data(), data.size());
+}
+
+void OutputBuffer::push_back(char c) {
+    buffer_.push_back(c);
+}
+
+void OutputBuffer::maybe_flush() {
+    if (buffer_.size() >= capacity_) {
+        flush();
+    }
+}
+
+bool OutputBuffer::flush() {
+    if (!buffer_.empty()) {
+        file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        bytes_written_ += buffer_.size();
+        buffer_.clear();
+    }
+    return file_.good();
+}
\ No newline at end of file
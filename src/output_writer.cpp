@@ -0,0 +1,252 @@
+#include "output_writer.h"
+#include "csv_writer.h"
+#include "columnar_writer.h"
+#include "json_lines_writer.h"
+#include "memory_accounting.h"
+#include "xlsx_writer.h"
+#include "tracer.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+bool OutputWriter::write(const QueryResult& result,
+                         const std::filesystem::path& output_path,
+                         const OutputOptions& options,
+                         std::vector<std::filesystem::path>& written_files) {
+    written_files.clear();
+
+    // Unpartitioned output keeps the single-file path with progress reporting
+    if (options.max_rows_per_file == 0 && options.partition_column.empty()) {
+        if (!write_file(result, nullptr, output_path, options.format)) {
+            return false;
+        }
+        written_files.push_back(output_path);
+        return true;
+    }
+
+    auto partitions = plan_partitions(result, output_path, options);
+
+    uint64_t row_list_bytes = partitions.capacity() * sizeof(OutputPartition);
+    for (const auto& partition : partitions) {
+        row_list_bytes += partition.row_indices.capacity() * sizeof(size_t);
+    }
+    MemoryCharge row_list_charge(MemoryCategory::BUFFER, "partition row lists", row_list_bytes);
+
+    // Each partition gets its own writer and buffer; a small pool of threads
+    // pulls partitions so hundreds of column values don't mean hundreds of threads
+    size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t worker_count = std::min(partitions.size(), hardware_threads);
+
+    std::atomic<size_t> next_partition{0};
+    std::atomic<bool> all_ok{true};
+    std::vector<std::future<void>> workers;
+
+    for (size_t w = 0; w < worker_count; ++w) {
+        workers.push_back(std::async(std::launch::async, [&]() {
+            size_t index;
+            while ((index = next_partition.fetch_add(1)) < partitions.size()) {
+                const auto& partition = partitions[index];
+                if (!write_file(result, &partition.row_indices, partition.path, options.format)) {
+                    all_ok = false;
+                }
+            }
+        }));
+    }
+
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    for (const auto& partition : partitions) {
+        written_files.push_back(partition.path);
+    }
+
+    return all_ok;
+}
+
+std::string OutputWriter::extension_for(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::COLUMNAR: return ".apcol";
+        case OutputFormat::JSON_LINES: return ".jsonl";
+        case OutputFormat::XLSX: return ".xlsx";
+        case OutputFormat::CSV:
+        default:                     return ".csv";
+    }
+}
+
+bool OutputWriter::parse_format(const std::string& name, OutputFormat& format) {
+    if (name == "csv") {
+        format = OutputFormat::CSV;
+    } else if (name == "columnar" || name == "apcol") {
+        format = OutputFormat::COLUMNAR;
+    } else if (name == "jsonl" || name == "ndjson") {
+        format = OutputFormat::JSON_LINES;
+    } else if (name == "xlsx") {
+        format = OutputFormat::XLSX;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool OutputWriter::write_file(const QueryResult& result,
+                              const std::vector<size_t>* row_indices,
+                              const std::filesystem::path& path,
+                              OutputFormat format) {
+    TraceSpan span("write", "write " + path.filename().string());
+    switch (format) {
+        case OutputFormat::COLUMNAR:
+            return row_indices ? ColumnarWriter::write_columnar_rows(result, *row_indices, path)
+                               : ColumnarWriter::write_columnar(result, path);
+        case OutputFormat::JSON_LINES:
+            // Whole results are serialized in parallel chunks, partitions stream
+            return row_indices ? JsonLinesWriter::write_jsonl_rows(result, *row_indices, path)
+                               : JsonLinesWriter::write_jsonl_parallel(result, path);
+        case OutputFormat::XLSX:
+            return row_indices ? XlsxWriter::write_xlsx_rows(result, *row_indices, path)
+                               : XlsxWriter::write_xlsx(result, path);
+        case OutputFormat::CSV:
+        default:
+            // The single-file CSV path keeps its progress bar
+            return row_indices ? CsvWriter::write_csv_rows(result, *row_indices, path)
+                               : CsvWriter::write_csv_with_progress(result, path);
+    }
+}
+
+std::vector<OutputPartition> OutputWriter::plan_partitions(const QueryResult& result,
+                                                           const std::filesystem::path& output_path,
+                                                           const OutputOptions& options) {
+    // Locate the partition column, if any
+    bool split_by_value = false;
+    size_t column_index = 0;
+    if (!options.partition_column.empty()) {
+        auto it = std::find(result.headers.begin(), result.headers.end(), options.partition_column);
+        if (it != result.headers.end()) {
+            split_by_value = true;
+            column_index = std::distance(result.headers.begin(), it);
+        } else {
+            std::cerr << "Warning: Partition column '" << options.partition_column
+                      << "' not found in output headers, writing without value partitions." << std::endl;
+        }
+    }
+
+    struct PartitionGroup {
+        std::string suffix;
+        size_t current_partition = 0;
+        size_t rows_in_current = 0;
+        size_t part_count = 0;
+    };
+
+    std::vector<OutputPartition> partitions;
+    std::vector<PartitionGroup> groups;
+    std::unordered_map<std::string, size_t> group_by_value;
+    std::unordered_set<std::string> used_suffixes;
+    std::unordered_map<std::string, size_t> next_number;    // Next "_N" to try per sanitized value
+
+    auto start_partition = [&](PartitionGroup& group) {
+        group.part_count++;
+        group.rows_in_current = 0;
+        group.current_partition = partitions.size();
+
+        OutputPartition partition;
+        partition.path = partition_path(output_path, group.suffix,
+                                        options.max_rows_per_file > 0 ? group.part_count : 0);
+        partitions.push_back(std::move(partition));
+    };
+
+    auto find_group = [&](const std::string& value) -> PartitionGroup& {
+        auto it = group_by_value.find(value);
+        if (it != group_by_value.end()) {
+            return groups[it->second];
+        }
+
+        PartitionGroup group;
+        if (split_by_value) {
+            // Distinct values may sanitize to the same name, keep the files apart.
+            // A numbered name may itself be a value's name ("a_b_2"), so count up
+            // until the name is free.
+            std::string suffix = sanitize_partition_value(value);
+            group.suffix = suffix;
+            if (used_suffixes.count(suffix)) {
+                size_t& number = next_number.emplace(suffix, 2).first->second;
+                do {
+                    group.suffix = suffix + "_" + std::to_string(number++);
+                } while (used_suffixes.count(group.suffix));
+            }
+            used_suffixes.insert(group.suffix);
+        }
+
+        group_by_value.emplace(value, groups.size());
+        groups.push_back(group);
+        start_partition(groups.back());
+        return groups.back();
+    };
+
+    static const std::string kNoValue;
+
+    // Single pass: route each row to its group, rolling over to a new part at the row cap
+    for (size_t row_idx = 0; row_idx < result.rows.size(); ++row_idx) {
+        const auto& row = result.rows[row_idx];
+        const std::string& value = !split_by_value ? kNoValue :
+                                   (column_index < row.size() ? row[column_index] : kNoValue);
+
+        PartitionGroup& group = find_group(value);
+        if (options.max_rows_per_file > 0 && group.rows_in_current >= options.max_rows_per_file) {
+            start_partition(group);
+        }
+
+        partitions[group.current_partition].row_indices.push_back(row_idx);
+        group.rows_in_current++;
+    }
+
+    MemoryCharge map_charge(MemoryCategory::HASH_TABLE, "partition map",
+                            MemoryAccounting::hash_table_bytes(group_by_value) +
+                            MemoryAccounting::hash_table_bytes(used_suffixes) +
+                            MemoryAccounting::hash_table_bytes(next_number));
+
+    // An empty result still produces one file with headers
+    if (partitions.empty()) {
+        PartitionGroup group;
+        start_partition(group);
+    }
+
+    return partitions;
+}
+
+std::string OutputWriter::sanitize_partition_value(const std::string& value) {
+    if (value.empty()) {
+        return "empty";
+    }
+
+    std::string sanitized;
+    sanitized.reserve(value.size());
+    for (unsigned char c : value) {
+        sanitized.push_back((std::isalnum(c) || c == '-' || c == '.') ? static_cast<char>(c) : '_');
+    }
+    return sanitized;
+}
+
+std::filesystem::path OutputWriter::partition_path(const std::filesystem::path& output_path,
+                                                   const std::string& value_suffix,
+                                                   size_t part_number) {
+    std::ostringstream name;
+    name << output_path.stem().string();
+
+    if (!value_suffix.empty()) {
+        name << "_" << value_suffix;
+    }
+
+    if (part_number > 0) {
+        name << "_part" << std::setw(4) << std::setfill('0') << part_number;
+    }
+
+    name << output_path.extension().string();
+    return output_path.parent_path() / name.str();
+}
\ No newline at end of file
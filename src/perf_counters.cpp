@@ -0,0 +1,185 @@
+#include "perf_counters.h"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct CounterSpec {
+    PerfSample::Counter counter;
+    const char* name;
+    uint32_t config;
+};
+
+#if defined(__linux__)
+const std::array<CounterSpec, 4> kCounters = {{
+    {PerfSample::CYCLES, "cycles", PERF_COUNT_HW_CPU_CYCLES},
+    {PerfSample::INSTRUCTIONS, "instructions", PERF_COUNT_HW_INSTRUCTIONS},
+    {PerfSample::CACHE_MISSES, "cache-misses", PERF_COUNT_HW_CACHE_MISSES},
+    {PerfSample::BRANCH_MISSES, "branch-misses", PERF_COUNT_HW_BRANCH_MISSES},
+}};
+#endif
+
+struct PerfState {
+    std::mutex mutex;
+    std::array<int, 4> fds{{-1, -1, -1, -1}};
+    bool enabled = false;
+    std::string reason = "not enabled";
+};
+
+PerfState& state() {
+    static PerfState instance;
+    return instance;
+}
+
+uint64_t* field(PerfSample& sample, PerfSample::Counter counter) {
+    switch (counter) {
+        case PerfSample::CYCLES: return &sample.cycles;
+        case PerfSample::INSTRUCTIONS: return &sample.instructions;
+        case PerfSample::CACHE_MISSES: return &sample.cache_misses;
+        case PerfSample::BRANCH_MISSES: return &sample.branch_misses;
+    }
+    return &sample.cycles;
+}
+
+uint64_t value_of(const PerfSample& sample, PerfSample::Counter counter) {
+    return *field(const_cast<PerfSample&>(sample), counter);
+}
+
+void close_all(PerfState& s) {
+#if defined(__linux__)
+    for (int& fd : s.fds) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+#endif
+}
+
+} // namespace
+
+double PerfSample::ipc() const {
+    if (!has(CYCLES) || !has(INSTRUCTIONS) || cycles == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(instructions) / static_cast<double>(cycles);
+}
+
+PerfSample PerfSample::since(const PerfSample& start) const {
+    PerfSample delta;
+    delta.valid = valid & start.valid;
+    for (Counter counter : {CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES}) {
+        if (delta.has(counter)) {
+            uint64_t end_value = value_of(*this, counter);
+            uint64_t start_value = value_of(start, counter);
+            *field(delta, counter) = end_value > start_value ? end_value - start_value : 0;
+        }
+    }
+    return delta;
+}
+
+bool PerfCounters::enable() {
+    PerfState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    close_all(s);
+    s.enabled = false;
+
+#if defined(__linux__)
+    std::string opened;
+    std::string failure;
+    for (size_t i = 0; i < kCounters.size(); ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = kCounters[i].config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;    // Allowed at perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+
+        // This process and its future threads, on any CPU
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd < 0) {
+            if (failure.empty()) {
+                failure = std::string(kCounters[i].name) + ": " + std::strerror(errno);
+            }
+            continue;
+        }
+        s.fds[i] = static_cast<int>(fd);
+        opened += opened.empty() ? kCounters[i].name : std::string(", ") + kCounters[i].name;
+    }
+
+    if (opened.empty()) {
+        s.reason = "perf_event_open failed (" + failure + ")";
+        return false;
+    }
+    s.enabled = true;
+    s.reason = "measuring " + opened;
+    if (!failure.empty()) {
+        s.reason += "; unavailable " + failure;
+    }
+    return true;
+#else
+    s.reason = "hardware counters are only supported on Linux";
+    return false;
+#endif
+}
+
+void PerfCounters::disable() {
+    PerfState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    close_all(s);
+    s.enabled = false;
+    s.reason = "not enabled";
+}
+
+bool PerfCounters::enabled() {
+    PerfState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.enabled;
+}
+
+PerfSample PerfCounters::read() {
+    PerfSample sample;
+    PerfState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.enabled) {
+        return sample;
+    }
+
+#if defined(__linux__)
+    for (size_t i = 0; i < kCounters.size(); ++i) {
+        if (s.fds[i] < 0) {
+            continue;
+        }
+        // value, time enabled, time running
+        uint64_t values[3] = {0, 0, 0};
+        if (::read(s.fds[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+            continue;
+        }
+        uint64_t value = values[0];
+        if (values[2] < values[1]) {
+            // Multiplexed: extrapolate to the whole enabled time
+            value = static_cast<uint64_t>(static_cast<double>(value) * values[1] / values[2]);
+        }
+        *field(sample, kCounters[i].counter) = value;
+        sample.valid |= kCounters[i].counter;
+    }
+#endif
+    return sample;
+}
+
+std::string PerfCounters::reason() {
+    PerfState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.reason;
+}
@@ -1,4 +1,9 @@
 #include "progress_manager.h"
+#include <atomic>
+
+namespace {
+std::atomic<bool> bars_enabled{true};
+}
 
 std::unique_ptr<CustomProgressBar> ProgressManager::create_file_progress(
     const std::string& filename, size_t total_size) {
@@ -57,11 +62,20 @@ std::unique_ptr<CustomBlockProgressBar> ProgressManager::create_overall_progress
 }
 
 void ProgressManager::update_progress(CustomProgressBar& bar, size_t current) {
+    if (!bars_enabled) {
+        return;
+    }
     // No platform-specific line erasing needed - the custom progress bar handles this internally
     bar.set_progress(current);
 }
 
 void ProgressManager::complete_progress(CustomProgressBar& bar) {
+    if (!bars_enabled) {
+        return;
+    }
     // No platform-specific line erasing needed - the custom progress bar handles this internally
     bar.mark_as_completed();
-}
\ No newline at end of file
+}
+void ProgressManager::set_enabled(bool enabled) {
+    bars_enabled = enabled;
+}
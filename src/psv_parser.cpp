@@ -1,5 +1,7 @@
 #include "psv_parser.h"
+#include "columnar_writer.h"
 #include "progress_manager.h"
+#include "tracer.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -13,7 +15,7 @@ void PsvTable::build_header_index() {
 }
 
 std::string PsvTable::get_field(size_t record_idx, const std::string& header) const {
-    if (record_idx >= records.size()) {
+    if (record_idx >= row_count()) {
         return "";
     }
     
@@ -22,12 +24,24 @@ std::string PsvTable::get_field(size_t record_idx, const std::string& header) co
         return "";
     }
     
-    size_t field_idx = it->second;
-    if (field_idx >= records[record_idx].fields.size()) {
-        return "";
+    return std::string(field(record_idx, it->second));
+}
+
+size_t PsvTable::mapped_row_count() const {
+    return columns->row_count();
+}
+
+std::string_view PsvTable::mapped_field(size_t row, size_t column) const {
+    return column < columns->headers().size() ? columns->value(row, column) : std::string_view();
+}
+
+void PsvTable::copy_mapped_row(size_t row, std::vector<std::string>& out) const {
+    size_t count = columns->headers().size();
+    out.resize(count);
+    for (size_t column = 0; column < count; ++column) {
+        std::string_view value = columns->value(row, column);
+        out[column].assign(value.data(), value.size());
     }
-    
-    return records[record_idx].fields[field_idx];
 }
 
 std::unique_ptr<PsvTable> PsvParser::parse_file(const std::filesystem::path& data_path, 
@@ -67,6 +81,7 @@ std::vector<std::string> PsvParser::parse_headers(const std::filesystem::path& h
 
 std::vector<PsvRecord> PsvParser::parse_data(const std::filesystem::path& data_path, 
                                             size_t& total_records) {
+    TraceSpan span("parse", "parse " + data_path.filename().string());
     std::ifstream file(data_path);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open data file: " + data_path.string());
@@ -1,5 +1,7 @@
 #include "query_engine.h"
+#include "tracer.h"
 #include <algorithm>
+#include <cstdint>
 #include <regex>
 #include <sstream>
 
@@ -23,13 +25,13 @@ std::unique_ptr<QueryResult> QueryEngine::select(const std::string& table_name,
     }
     
     // Copy data
-    for (const auto& record : table->records) {
+    for (size_t record = 0; record < table->row_count(); ++record) {
         std::vector<std::string> row;
         
         for (const auto& header : result->headers) {
             auto it = table->header_index.find(header);
-            if (it != table->header_index.end() && it->second < record.fields.size()) {
-                row.push_back(record.fields[it->second]);
+            if (it != table->header_index.end()) {
+                row.emplace_back(table->field(record, it->second));
             } else {
                 row.push_back("");
             }
@@ -59,14 +61,14 @@ std::unique_ptr<QueryResult> QueryEngine::select_where(const std::string& table_
     }
     
     // Filter and copy data
-    for (const auto& record : table->records) {
-        if (evaluate_condition(record, *table, where_clause)) {
+    for (size_t record = 0; record < table->row_count(); ++record) {
+        if (evaluate_condition(*table, record, where_clause)) {
             std::vector<std::string> row;
             
             for (const auto& header : result->headers) {
                 auto it = table->header_index.find(header);
-                if (it != table->header_index.end() && it->second < record.fields.size()) {
-                    row.push_back(record.fields[it->second]);
+                if (it != table->header_index.end()) {
+                    row.emplace_back(table->field(record, it->second));
                 } else {
                     row.push_back("");
                 }
@@ -79,10 +81,44 @@ std::unique_ptr<QueryResult> QueryEngine::select_where(const std::string& table_
     return result;
 }
 
+std::unique_ptr<QueryResult> QueryEngine::select_matching(const std::string& table_name,
+                                                         const std::vector<std::string>& columns,
+                                                         const std::function<bool(const PsvTable&, size_t row)>& matches) {
+    const PsvTable* table = database_.get_table(table_name);
+    if (!table) {
+        return nullptr;
+    }
+    
+    auto result = std::make_unique<QueryResult>();
+    result->headers = columns.empty() ? table->headers : columns;
+    
+    // Resolve column positions once instead of per record
+    std::vector<size_t> indices;
+    for (const auto& header : result->headers) {
+        auto it = table->header_index.find(header);
+        indices.push_back(it != table->header_index.end() ? it->second : SIZE_MAX);
+    }
+    
+    for (size_t record = 0; record < table->row_count(); ++record) {
+        if (!matches(*table, record)) {
+            continue;
+        }
+        std::vector<std::string> row;
+        row.reserve(indices.size());
+        for (size_t index : indices) {
+            row.emplace_back(index != SIZE_MAX ? table->field(record, index) : std::string_view());
+        }
+        result->rows.push_back(std::move(row));
+    }
+    
+    return result;
+}
+
 std::unique_ptr<QueryResult> QueryEngine::join(const std::string& left_table,
                                               const std::string& right_table,
                                               const std::string& join_condition,
                                               JoinType join_type) {
+    TraceSpan span("join", "join " + left_table + " x " + right_table);
     const PsvTable* left = database_.get_table(left_table);
     const PsvTable* right = database_.get_table(right_table);
     
@@ -109,43 +145,44 @@ std::unique_ptr<QueryResult> QueryEngine::join(const std::string& left_table,
         result->headers.push_back(right_table + "." + header);
     }
     
-    // Perform join (simplified implementation for INNER join)
-    if (join_type == JoinType::INNER) {
-        for (const auto& left_record : left->records) {
-            std::string left_value = left->get_field(
-                &left_record - &left->records[0], left_field);
-            
-            for (const auto& right_record : right->records) {
-                std::string right_value = right->get_field(
-                    &right_record - &right->records[0], right_field);
-                
-                if (left_value == right_value && !left_value.empty()) {
-                    std::vector<std::string> row;
-                    
-                    // Add left record fields
-                    for (const auto& field : left_record.fields) {
-                        row.push_back(field);
-                    }
-                    
-                    // Add right record fields
-                    for (const auto& field : right_record.fields) {
-                        row.push_back(field);
-                    }
-                    
-                    result->rows.push_back(row);
-                }
-            }
-        }
+    // Only INNER joins are implemented; a key column either table lacks matches nothing
+    auto left_column = left->header_index.find(left_field);
+    auto right_column = right->header_index.find(right_field);
+    last_join_ = JoinStats();
+    if (join_type != JoinType::INNER || left_column == left->header_index.end() ||
+        right_column == right->header_index.end()) {
+        return result;
+    }
+    
+    auto pairs = HashJoin::match(*left, left_column->second, *right, right_column->second,
+                                 join_memory_budget_, spill_dir_, &last_join_);
+    result->rows.reserve(pairs.size());
+    std::vector<std::string> left_scratch;
+    std::vector<std::string> right_scratch;
+    for (const auto& pair : pairs) {
+        const auto& left_fields = left->row_fields(pair.first, left_scratch);
+        const auto& right_fields = right->row_fields(pair.second, right_scratch);
+        std::vector<std::string> row;
+        row.reserve(left_fields.size() + right_fields.size());
+        row.insert(row.end(), left_fields.begin(), left_fields.end());
+        row.insert(row.end(), right_fields.begin(), right_fields.end());
+        result->rows.push_back(std::move(row));
     }
     
     return result;
 }
 
+void QueryEngine::set_join_memory_budget(uint64_t bytes, std::filesystem::path spill_dir) {
+    join_memory_budget_ = bytes;
+    spill_dir_ = std::move(spill_dir);
+}
+
 std::unique_ptr<QueryResult> QueryEngine::union_tables(const std::vector<std::string>& table_names) {
     if (table_names.empty()) {
         return nullptr;
     }
     
+    TraceSpan span("union", "union");
     auto result = std::make_unique<QueryResult>();
     
     // Use headers from first table
@@ -161,14 +198,14 @@ std::unique_ptr<QueryResult> QueryEngine::union_tables(const std::vector<std::st
         const PsvTable* table = database_.get_table(table_name);
         if (!table) continue;
         
-        for (const auto& record : table->records) {
+        for (size_t record = 0; record < table->row_count(); ++record) {
             std::vector<std::string> row;
             
             // Map fields to result headers
             for (const auto& header : result->headers) {
                 auto it = table->header_index.find(header);
-                if (it != table->header_index.end() && it->second < record.fields.size()) {
-                    row.push_back(record.fields[it->second]);
+                if (it != table->header_index.end()) {
+                    row.emplace_back(table->field(record, it->second));
                 } else {
                     row.push_back("");
                 }
@@ -181,13 +218,13 @@ std::unique_ptr<QueryResult> QueryEngine::union_tables(const std::vector<std::st
     return result;
 }
 
-bool QueryEngine::evaluate_condition(const PsvRecord& record, 
-                                    const PsvTable& table,
+bool QueryEngine::evaluate_condition(const PsvTable& table,
+                                    size_t record,
                                     const std::string& condition) {
     // Simplified condition evaluation
     // Support basic operations like: field = 'value', field > 'value', etc.
     
-    std::regex condition_regex(R"((\w+)\s*(=|!=|>|<|>=|<=)\s*'([^']*)')");
+    static const std::regex condition_regex(R"((\w+)\s*(=|!=|>|<|>=|<=)\s*'([^']*)')");
     std::smatch match;
     
     if (std::regex_match(condition, match, condition_regex)) {
@@ -196,11 +233,11 @@ bool QueryEngine::evaluate_condition(const PsvRecord& record,
         std::string value = match[3].str();
         
         auto it = table.header_index.find(field_name);
-        if (it == table.header_index.end() || it->second >= record.fields.size()) {
+        if (it == table.header_index.end() || (!table.columns && it->second >= table.records[record].fields.size())) {
             return false;
         }
         
-        std::string field_value = record.fields[it->second];
+        std::string field_value(table.field(record, it->second));
         
         if (operator_str == "=") {
             return field_value == value;
@@ -0,0 +1,448 @@
+#include "query_explainer.h"
+#include "csv_writer.h"
+#include "memory_accounting.h"
+#include "psv_parser.h"
+#include "query_engine.h"
+#include "table_loader.h"
+#include "transformation_engine.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+const char* format_name(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::CSV: return "csv";
+        case OutputFormat::COLUMNAR: return "columnar";
+        case OutputFormat::JSON_LINES: return "jsonl";
+        case OutputFormat::XLSX: return "xlsx";
+    }
+    return "csv";
+}
+
+// Join rules name fields either bare or as table.field
+std::string column_of(const std::string& field) {
+    size_t dot = field.rfind('.');
+    return dot == std::string::npos ? field : field.substr(dot + 1);
+}
+
+// Share of rows with a non-empty join key and the key's distinct count,
+// extrapolated from a sample. A key unique within the sample is taken to be
+// unique in the whole input; otherwise the sample has seen its domain.
+struct KeyStats {
+    double non_empty = 1.0;
+    double distinct = 0.0;
+};
+
+KeyStats key_stats(const PsvTable* sample, const std::string& field, const InputEstimate* estimate) {
+    KeyStats stats;
+    double rows = estimate ? static_cast<double>(estimate->estimated_rows) : 0.0;
+    stats.distinct = rows;
+    if (!sample || sample->records.empty()) {
+        return stats;
+    }
+    auto column = sample->header_index.find(column_of(field));
+    if (column == sample->header_index.end()) {
+        return stats;
+    }
+
+    std::unordered_set<std::string> values;
+    size_t non_empty = 0;
+    for (const auto& record : sample->records) {
+        if (column->second < record.fields.size() && !record.fields[column->second].empty()) {
+            values.insert(record.fields[column->second]);
+            non_empty++;
+        }
+    }
+    stats.non_empty = static_cast<double>(non_empty) / sample->records.size();
+
+    bool whole_file = !estimate || estimate->sampled_rows >= estimate->estimated_rows;
+    if (whole_file || values.size() < non_empty) {
+        stats.distinct = static_cast<double>(values.size());
+    } else {
+        stats.distinct = rows * stats.non_empty;
+    }
+    return stats;
+}
+
+PlanOperator make_operator(const std::string& name, const std::string& detail, double estimated_rows) {
+    PlanOperator op;
+    op.name = name;
+    op.detail = detail;
+    op.estimated_rows = estimated_rows;
+    return op;
+}
+
+PlanOperator scan_operator(const std::string& table, const ExecutionPlan& plan) {
+    const InputEstimate* estimate = plan.find_input(table);
+    return make_operator("Scan", table, estimate ? static_cast<double>(estimate->estimated_rows) : 0.0);
+}
+
+// First operator with this name (and detail, when given), depth first
+PlanOperator* find_operator(PlanOperator& root, const std::string& name, const std::string& detail = "") {
+    if (root.name == name && (detail.empty() || root.detail == detail)) {
+        return &root;
+    }
+    for (auto& input : root.inputs) {
+        if (PlanOperator* found = find_operator(input, name, detail)) {
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+void record(PlanOperator* op, uint64_t rows, double seconds, uint64_t memory_bytes) {
+    if (op) {
+        op->analyzed = true;
+        op->actual_rows = rows;
+        op->seconds = seconds;
+        op->memory_bytes = memory_bytes;
+    }
+}
+
+std::string format_rows(double rows) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(0) << rows;
+    return text.str();
+}
+
+std::string format_seconds(double seconds) {
+    std::ostringstream text;
+    text << std::fixed;
+    if (seconds >= 1.0) {
+        text << std::setprecision(2) << seconds << " s";
+    } else {
+        text << std::setprecision(3) << seconds * 1000.0 << " ms";
+    }
+    return text.str();
+}
+
+void render_operator(const PlanOperator& op, size_t depth, std::vector<std::string>& lines) {
+    std::ostringstream line;
+    line << std::string(depth * 3, ' ') << (depth == 0 ? "" : "-> ") << op.name;
+    if (!op.detail.empty()) {
+        line << " " << op.detail;
+    }
+    line << "  (";
+    if (op.selectivity >= 0.0) {
+        line << "selectivity " << std::fixed << std::setprecision(2) << op.selectivity << ", ";
+    }
+    line << "rows ~" << format_rows(op.estimated_rows);
+    if (op.analyzed) {
+        line << "; actual rows " << op.actual_rows << ", " << format_seconds(op.seconds);
+        if (op.memory_bytes > 0) {
+            line << ", " << ExecutionPlanner::format_bytes(op.memory_bytes);
+        }
+    }
+    line << ")";
+    lines.push_back(line.str());
+
+    for (const auto& input : op.inputs) {
+        render_operator(input, depth + 1, lines);
+    }
+}
+
+// Peak growth of the output buffers and dictionaries since `base`
+struct WriterMemory {
+    uint64_t base = 0;
+
+    void start() {
+        MemoryAccounting::reset_peaks();
+        base = MemoryAccounting::category_total(MemoryCategory::BUFFER).current_bytes +
+               MemoryAccounting::category_total(MemoryCategory::HASH_TABLE).current_bytes;
+    }
+
+    uint64_t peak() const {
+        uint64_t peak = MemoryAccounting::category_total(MemoryCategory::BUFFER).peak_bytes +
+                        MemoryAccounting::category_total(MemoryCategory::HASH_TABLE).peak_bytes;
+        return peak > base ? peak - base : 0;
+    }
+};
+
+} // namespace
+
+void QueryExplainer::load_samples(const std::vector<FileInfo>& inputs, Database& samples) {
+    // The samples of a table's partitions make one sample table
+    std::map<std::string, std::vector<std::unique_ptr<PsvTable>>> partitions;
+    for (const auto& input : inputs) {
+        auto sample = ExecutionPlanner::sample_input(input).table;
+        if (input.is_partition()) {
+            partitions[input.table_name].push_back(std::move(sample));
+        } else {
+            samples.load_table(std::move(sample));
+        }
+    }
+    for (auto& entry : partitions) {
+        samples.load_table(TableLoader::merge_partitions(std::move(entry.second)));
+    }
+}
+
+double QueryExplainer::join_rows(double left_rows, double left_distinct,
+                                 double right_rows, double right_distinct) {
+    // Each key matches rows / distinct rows on the other side
+    return left_rows * right_rows / std::max({left_distinct, right_distinct, 1.0});
+}
+
+PlanOperator QueryExplainer::build(const OutputFileInfo& config,
+                                   const ConfigPlan& config_plan,
+                                   const ExecutionPlan& plan,
+                                   const Database& samples,
+                                   const OutputOptions& output_options) {
+    QueryEngine sample_query(samples);
+    TransformationEngine engine(samples, sample_query);
+    engine.set_progress(false);
+    engine.load_output_headers(config.headers_path);
+    engine.load_rules(config.rules_path);
+
+    // The sample run measures what the filters keep of the source rows
+    engine.transform_rows([](std::vector<std::string>&&) {});
+    const TransformStats& sample_stats = engine.get_stats();
+
+    // Source: the tables and the JOIN or UNION that combines them
+    PlanOperator source;
+    if (config_plan.shape == ConfigShape::STATIC) {
+        source = make_operator("Values", "1 row of constants", 1.0);
+    } else if (config_plan.shape == ConfigShape::JOIN) {
+        // describe_config() only calls a config a join when it has a JOIN rule
+        const TransformationRule* join = nullptr;
+        for (const auto& rule : engine.get_rules()) {
+            if (rule.type == TransformationRule::RuleType::GLOBAL_JOIN) {
+                join = &rule;
+                break;
+            }
+        }
+        PlanOperator left = scan_operator(join->left_table, plan);
+        PlanOperator right = scan_operator(join->right_table, plan);
+        KeyStats left_key = key_stats(samples.get_table(join->left_table), join->left_field,
+                                      plan.find_input(join->left_table));
+        KeyStats right_key = key_stats(samples.get_table(join->right_table), join->right_field,
+                                       plan.find_input(join->right_table));
+
+        std::string algorithm = "hash join";
+        if (config_plan.join_memory_bytes > 0) {
+            algorithm += " (spills above " + ExecutionPlanner::format_bytes(config_plan.join_memory_bytes) + ")";
+        }
+        source = make_operator("Join",
+                               algorithm + ", inner, on " + join->left_table + "." + column_of(join->left_field) +
+                                   " = " + join->right_table + "." + column_of(join->right_field),
+                               join_rows(left.estimated_rows * left_key.non_empty, left_key.distinct,
+                                         right.estimated_rows * right_key.non_empty, right_key.distinct));
+        source.inputs.push_back(std::move(left));
+        source.inputs.push_back(std::move(right));
+    } else if (config_plan.shape == ConfigShape::UNION) {
+        source = make_operator("Union", "all, columns of " + config_plan.tables.front(), 0.0);
+        for (const auto& table : config_plan.tables) {
+            source.inputs.push_back(scan_operator(table, plan));
+            source.estimated_rows += source.inputs.back().estimated_rows;
+        }
+    } else {
+        source = scan_operator(config_plan.tables.front(), plan);
+    }
+    double rows = source.estimated_rows;
+    PlanOperator tree = std::move(source);
+
+    // GLOBAL rules, all evaluated on every source row
+    std::string conditions;
+    for (const auto& rule : engine.get_rules()) {
+        if (rule.type == TransformationRule::RuleType::GLOBAL) {
+            conditions += (conditions.empty() ? "" : " AND ") + rule.condition;
+        }
+    }
+    if (!conditions.empty()) {
+        PlanOperator filter = make_operator("Filter", conditions, 0.0);
+        filter.selectivity = sample_stats.source_rows > 0
+            ? static_cast<double>(sample_stats.filtered_rows) / sample_stats.source_rows
+            : 1.0;    // Nothing sampled to judge by
+        rows *= filter.selectivity;
+        filter.estimated_rows = rows;
+        filter.inputs.push_back(std::move(tree));
+        tree = std::move(filter);
+    }
+
+    ProjectionPlan projection;
+    bool fast_projection = config_plan.stream_rows && engine.plan_projection(projection);
+    const auto& headers = engine.get_output_headers();
+    size_t computed = 0;
+    for (const auto& header : headers) {
+        for (const auto& rule : engine.get_rules()) {
+            if (rule.type == TransformationRule::RuleType::FIELD && rule.target_field == header) {
+                computed++;
+                break;
+            }
+        }
+    }
+    PlanOperator project = make_operator(
+        "Project",
+        std::to_string(headers.size()) + (headers.size() == 1 ? " column" : " columns") +
+            (fast_projection ? ", copied from the loaded records"
+                             : " (" + std::to_string(computed) + " from FIELD rules)"),
+        rows);
+    project.inputs.push_back(std::move(tree));
+
+    std::string write_detail = std::string(format_name(output_options.format)) + " " + config.name_prefix +
+                               OutputWriter::extension_for(output_options.format) +
+                               (config_plan.stream_rows ? ", streaming" : ", materialized");
+    if (!output_options.partition_column.empty()) {
+        write_detail += ", partitioned by " + output_options.partition_column;
+    }
+    if (output_options.max_rows_per_file > 0) {
+        write_detail += ", " + std::to_string(output_options.max_rows_per_file) + " rows per file";
+    }
+    PlanOperator write = make_operator("Write", write_detail, rows);
+    write.inputs.push_back(std::move(project));
+    return write;
+}
+
+bool QueryExplainer::analyze(PlanOperator& root,
+                             const OutputFileInfo& config,
+                             const ConfigPlan& config_plan,
+                             const std::vector<FileInfo>& inputs,
+                             const OutputOptions& output_options,
+                             const std::filesystem::path& scratch_dir) {
+    // Every config starts from its own load, so each Scan reports its full cost.
+    // Static configs read no table; the schemas are enough.
+    Database database;
+    if (config_plan.shape == ConfigShape::STATIC) {
+        ExecutionPlanner::load_schemas(inputs, database);
+    }
+    for (const auto& table : config_plan.tables) {
+        if (database.get_table(table)) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        // The first input of that name, or every partition of a directory table
+        std::vector<std::unique_ptr<PsvTable>> parts;
+        for (const auto& input : inputs) {
+            if (input.table() != table) {
+                continue;
+            }
+            parts.push_back(TableLoader::parse_input(input));
+            if (!input.is_partition()) {
+                break;
+            }
+        }
+        if (parts.empty()) {
+            continue;
+        }
+        auto loaded = TableLoader::merge_partitions(std::move(parts));
+        double seconds = seconds_since(start);
+        size_t rows = loaded->row_count();
+        uint64_t bytes = MemoryAccounting::table_bytes(*loaded);
+        database.load_table(std::move(loaded));
+        record(find_operator(root, "Scan", table), rows, seconds, bytes);
+    }
+
+    QueryEngine query_engine(database);
+    TransformationEngine engine(database, query_engine);
+    engine.set_timed(true);
+    engine.load_output_headers(config.headers_path);
+    engine.load_rules(config.rules_path);
+
+    // One directory per config, so its partition files can be totalled
+    auto output_dir = scratch_dir / config.name_prefix;
+    std::filesystem::create_directories(output_dir);
+    auto output_path = output_dir / (config.name_prefix + OutputWriter::extension_for(output_options.format));
+    PlanOperator* filter = find_operator(root, "Filter");
+    PlanOperator* project = find_operator(root, "Project");
+    WriterMemory writer_memory;
+    bool written = false;
+
+    ProjectionPlan projection;
+    if (config_plan.stream_rows && engine.plan_projection(projection)) {
+        // Filter, projection and write are one loop over the records
+        const PsvTable& source = *projection.source;
+        size_t rows_written = 0;
+        size_t rows_kept = 0;
+        double filter_seconds = 0.0;
+        std::vector<std::string> scratch;
+        writer_memory.start();
+        auto start = std::chrono::steady_clock::now();
+        written = CsvWriter::write_projection(
+            engine.get_output_headers(), source, projection.column_indices,
+            [&](size_t row) {
+                auto filter_start = std::chrono::steady_clock::now();
+                bool passes = engine.passes_global_filters(source.row_fields(row, scratch), source.headers);
+                filter_seconds += seconds_since(filter_start);
+                rows_kept += passes ? 1 : 0;
+                return passes;
+            },
+            output_path, rows_written);
+        double seconds = seconds_since(start);
+
+        record(filter, rows_kept, filter_seconds, 0);
+        record(project, rows_written, 0.0, 0);
+        record(&root, rows_written, std::max(0.0, seconds - filter_seconds), writer_memory.peak());
+    } else {
+        std::unique_ptr<QueryResult> result;
+        size_t rows_out = 0;
+        double write_seconds = 0.0;
+        if (config_plan.stream_rows) {
+            CsvStreamWriter writer;
+            writer_memory.start();
+            auto open_start = std::chrono::steady_clock::now();
+            written = writer.open(output_path, engine.get_output_headers());
+            write_seconds += seconds_since(open_start);
+            if (written) {
+                rows_out = engine.transform_rows([&](std::vector<std::string>&& row) {
+                    auto write_start = std::chrono::steady_clock::now();
+                    writer.write_row(row);
+                    write_seconds += seconds_since(write_start);
+                });
+                auto close_start = std::chrono::steady_clock::now();
+                written = writer.close();
+                write_seconds += seconds_since(close_start);
+            }
+        } else {
+            result = engine.transform_data();
+            if (result) {
+                rows_out = result->rows.size();
+                std::vector<std::filesystem::path> written_files;
+                writer_memory.start();
+                auto write_start = std::chrono::steady_clock::now();
+                written = OutputWriter::write(*result, output_path, output_options, written_files);
+                write_seconds = seconds_since(write_start);
+            }
+        }
+
+        const TransformStats& stats = engine.get_stats();
+        if (config_plan.shape == ConfigShape::JOIN) {
+            record(find_operator(root, "Join"), stats.source_rows, stats.source_seconds, stats.source_bytes);
+        } else if (config_plan.shape == ConfigShape::UNION) {
+            record(find_operator(root, "Union"), stats.source_rows, stats.source_seconds, stats.source_bytes);
+        } else if (config_plan.shape == ConfigShape::STATIC) {
+            record(find_operator(root, "Values"), stats.source_rows, stats.source_seconds, 0);
+        } else if (PlanOperator* scan = find_operator(root, "Scan")) {
+            // A select copies the table into its own result before filtering
+            scan->seconds += stats.source_seconds;
+            scan->memory_bytes += stats.source_bytes;
+        }
+        record(filter, stats.filtered_rows, stats.filter_seconds, 0);
+        record(project, rows_out, stats.project_seconds, result ? MemoryAccounting::result_bytes(*result) : 0);
+        record(&root, rows_out, write_seconds, writer_memory.peak());
+    }
+
+    if (written) {
+        // Every file the write produced, including partitions
+        uint64_t bytes = 0;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(output_dir, error)) {
+            bytes += entry.file_size(error);
+        }
+        root.detail += ", " + ExecutionPlanner::format_bytes(bytes) + " written";
+    }
+    return written;
+}
+
+std::vector<std::string> QueryExplainer::render(const PlanOperator& root) {
+    std::vector<std::string> lines;
+    render_operator(root, 0, lines);
+    return lines;
+}
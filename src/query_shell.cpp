@@ -0,0 +1,807 @@
+#include "query_shell.h"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+constexpr size_t kMaxColumnWidth = 40;
+
+struct Token {
+    enum class Kind { WORD, STRING, NUMBER, SYMBOL, END };
+    Kind kind = Kind::END;
+    std::string text;
+};
+
+std::string upper(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::toupper(c); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    return text.substr(start, text.find_last_not_of(" \t\r\n") - start + 1);
+}
+
+std::vector<Token> tokenize(const std::string& sql) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+    while (i < sql.size()) {
+        char c = sql[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = i;
+            while (i < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_' || sql[i] == '.')) {
+                ++i;
+            }
+            tokens.push_back({Token::Kind::WORD, sql.substr(start, i - start)});
+        } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                   (c == '-' && i + 1 < sql.size() && std::isdigit(static_cast<unsigned char>(sql[i + 1])))) {
+            size_t start = i++;
+            while (i < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[i])) || sql[i] == '.')) {
+                ++i;
+            }
+            tokens.push_back({Token::Kind::NUMBER, sql.substr(start, i - start)});
+        } else if (c == '\'') {
+            // '' inside a string is a quote
+            std::string value;
+            ++i;
+            for (;;) {
+                if (i >= sql.size()) {
+                    throw std::runtime_error("Unterminated string literal");
+                }
+                if (sql[i] == '\'') {
+                    if (i + 1 < sql.size() && sql[i + 1] == '\'') {
+                        value += '\'';
+                        i += 2;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+                value += sql[i++];
+            }
+            tokens.push_back({Token::Kind::STRING, value});
+        } else {
+            static const char* two_char[] = {"!=", "<>", "<=", ">="};
+            std::string symbol(1, c);
+            for (const char* candidate : two_char) {
+                if (sql.compare(i, 2, candidate) == 0) {
+                    symbol = candidate;
+                    break;
+                }
+            }
+            if (symbol.size() == 1 && std::string("(),;*=<>").find(c) == std::string::npos) {
+                throw std::runtime_error(std::string("Unexpected character '") + c + "'");
+            }
+            i += symbol.size();
+            tokens.push_back({Token::Kind::SYMBOL, symbol == "<>" ? "!=" : symbol});
+        }
+    }
+    tokens.push_back({Token::Kind::END, ""});
+    return tokens;
+}
+
+class Parser {
+public:
+    explicit Parser(const std::string& sql) : tokens_(tokenize(sql)) {}
+
+    const Token& peek() const { return tokens_[pos_]; }
+
+    bool at_keyword(const char* keyword) const {
+        return peek().kind == Token::Kind::WORD && upper(peek().text) == keyword;
+    }
+
+    bool accept_keyword(const char* keyword) {
+        if (at_keyword(keyword)) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect_keyword(const char* keyword) {
+        if (!accept_keyword(keyword)) {
+            throw std::runtime_error(std::string("Expected ") + keyword + " " + found());
+        }
+    }
+
+    bool accept_symbol(const char* symbol) {
+        if (peek().kind == Token::Kind::SYMBOL && peek().text == symbol) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect_symbol(const char* symbol) {
+        if (!accept_symbol(symbol)) {
+            throw std::runtime_error(std::string("Expected '") + symbol + "' " + found());
+        }
+    }
+
+    std::string expect_word(const char* what) {
+        if (peek().kind != Token::Kind::WORD) {
+            throw std::runtime_error(std::string("Expected ") + what + " " + found());
+        }
+        return tokens_[pos_++].text;
+    }
+
+    const Token& next() { return tokens_[pos_++]; }
+
+    std::string found() const {
+        return peek().kind == Token::Kind::END ? "at end of statement" : "but found '" + peek().text + "'";
+    }
+
+private:
+    std::vector<Token> tokens_;
+    size_t pos_ = 0;
+};
+
+bool parse_number(const std::string& text, double& number) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    number = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size();
+}
+
+std::string format_number(double value) {
+    std::ostringstream out;
+    if (std::floor(value) == value && std::fabs(value) < 1e15) {
+        out << static_cast<long long>(value);
+    } else {
+        out << std::setprecision(12) << value;
+    }
+    return out.str();
+}
+
+// Numeric when both are numbers, otherwise by bytes
+bool value_less(const std::string& a, const std::string& b) {
+    double x, y;
+    if (parse_number(a, x) && parse_number(b, y)) {
+        return x < y;
+    }
+    return a < b;
+}
+
+// Position of a column: exact header match, then the bare name of a qualified
+// reference, then a unique table.column header for a bare name (join results)
+size_t resolve(const std::vector<std::string>& headers, const std::string& name) {
+    auto exact = std::find(headers.begin(), headers.end(), name);
+    if (exact != headers.end()) {
+        return static_cast<size_t>(exact - headers.begin());
+    }
+    size_t dot = name.rfind('.');
+    if (dot != std::string::npos) {
+        auto bare = std::find(headers.begin(), headers.end(), name.substr(dot + 1));
+        if (bare != headers.end()) {
+            return static_cast<size_t>(bare - headers.begin());
+        }
+    } else {
+        size_t found = SIZE_MAX;
+        for (size_t i = 0; i < headers.size(); ++i) {
+            const auto& header = headers[i];
+            if (header.size() > name.size() && header.compare(header.size() - name.size(), name.size(), name) == 0 &&
+                header[header.size() - name.size() - 1] == '.') {
+                if (found != SIZE_MAX) {
+                    throw std::runtime_error("Ambiguous column: " + name + " (qualify it as table." + name + ")");
+                }
+                found = i;
+            }
+        }
+        if (found != SIZE_MAX) {
+            return found;
+        }
+    }
+    throw std::runtime_error("Unknown column: " + name);
+}
+
+struct Aggregate {
+    size_t count = 0;               // Rows (COUNT(*)) or non-empty values
+    size_t numbers = 0;
+    double sum = 0.0;
+    bool all_numeric = true;
+    std::string min;
+    std::string max;
+};
+
+void accumulate(Aggregate& aggregate, const std::string* value) {
+    if (!value) {
+        aggregate.count++;
+        return;
+    }
+    if (value->empty()) {
+        return;
+    }
+    if (aggregate.count == 0 || value_less(*value, aggregate.min)) {
+        aggregate.min = *value;
+    }
+    if (aggregate.count == 0 || value_less(aggregate.max, *value)) {
+        aggregate.max = *value;
+    }
+    aggregate.count++;
+    double number;
+    if (parse_number(*value, number)) {
+        aggregate.sum += number;
+        aggregate.numbers++;
+    } else {
+        aggregate.all_numeric = false;
+    }
+}
+
+std::string finish(const Aggregate& aggregate, const std::string& function) {
+    if (function == "COUNT") {
+        return std::to_string(aggregate.count);
+    }
+    if (function == "MIN") {
+        return aggregate.min;
+    }
+    if (function == "MAX") {
+        return aggregate.max;
+    }
+    if (aggregate.numbers == 0) {
+        return "";
+    }
+    return format_number(function == "SUM" ? aggregate.sum : aggregate.sum / static_cast<double>(aggregate.numbers));
+}
+
+// Index of the ';' ending the first statement in text, npos if none
+size_t statement_end(const std::string& text) {
+    bool quoted = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\'') {
+            quoted = !quoted;
+        } else if (text[i] == ';' && !quoted) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+} // namespace
+
+QueryShell::QueryShell(const Database& database) : database_(database), engine_(database) {
+}
+
+QueryStatement QueryShell::parse(const std::string& sql) {
+    static const std::unordered_set<std::string> aggregates = {"COUNT", "SUM", "AVG", "MIN", "MAX"};
+    Parser parser(sql);
+    QueryStatement statement;
+
+    parser.expect_keyword("SELECT");
+    if (!parser.accept_symbol("*")) {
+        do {
+            QueryStatement::Column column;
+            std::string word = parser.expect_word("a column");
+            if (aggregates.count(upper(word)) && parser.accept_symbol("(")) {
+                column.aggregate = upper(word);
+                if (parser.accept_symbol("*")) {
+                    if (column.aggregate != "COUNT") {
+                        throw std::runtime_error(column.aggregate + "(*) is not supported, name a column");
+                    }
+                    column.name = "*";
+                } else {
+                    column.name = parser.expect_word("a column");
+                }
+                parser.expect_symbol(")");
+                column.label = column.aggregate + "(" + column.name + ")";
+            } else {
+                column.name = word;
+                column.label = word;
+            }
+            if (parser.accept_keyword("AS")) {
+                column.label = parser.expect_word("a label");
+            }
+            statement.columns.push_back(column);
+        } while (parser.accept_symbol(","));
+    }
+
+    parser.expect_keyword("FROM");
+    statement.table = parser.expect_word("a table");
+
+    parser.accept_keyword("INNER");
+    if (parser.accept_keyword("JOIN")) {
+        statement.join_table = parser.expect_word("a table");
+        parser.expect_keyword("ON");
+        std::string left = parser.expect_word("a join column");
+        parser.expect_symbol("=");
+        std::string right = parser.expect_word("a join column");
+        statement.join_condition = left + " = " + right;
+    }
+
+    if (parser.accept_keyword("WHERE")) {
+        do {
+            QueryStatement::Condition condition;
+            condition.column = parser.expect_word("a column");
+            const Token& op = parser.next();
+            static const std::unordered_set<std::string> operators = {"=", "!=", "<", "<=", ">", ">="};
+            if (op.kind != Token::Kind::SYMBOL || !operators.count(op.text)) {
+                throw std::runtime_error("Expected a comparison after " + condition.column);
+            }
+            condition.op = op.text;
+            const Token& value = parser.next();
+            if (value.kind != Token::Kind::STRING && value.kind != Token::Kind::NUMBER) {
+                throw std::runtime_error("Expected a quoted string or number after " + condition.column + " " + op.text);
+            }
+            condition.value = value.text;
+            statement.where.push_back(condition);
+            if (parser.at_keyword("OR")) {
+                throw std::runtime_error("OR is not supported; conditions combine with AND");
+            }
+        } while (parser.accept_keyword("AND"));
+    }
+
+    if (parser.accept_keyword("GROUP")) {
+        parser.expect_keyword("BY");
+        do {
+            statement.group_by.push_back(parser.expect_word("a column"));
+        } while (parser.accept_symbol(","));
+    }
+
+    if (parser.accept_keyword("ORDER")) {
+        parser.expect_keyword("BY");
+        statement.order_by = parser.expect_word("a column");
+        if (parser.accept_keyword("DESC")) {
+            statement.descending = true;
+        } else {
+            parser.accept_keyword("ASC");
+        }
+    }
+
+    if (parser.accept_keyword("LIMIT")) {
+        const Token& limit = parser.next();
+        if (limit.kind != Token::Kind::NUMBER || limit.text.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::runtime_error("LIMIT needs a row count");
+        }
+        statement.limit = std::stoull(limit.text);
+    }
+
+    parser.accept_symbol(";");
+    if (parser.peek().kind != Token::Kind::END) {
+        throw std::runtime_error("Unexpected '" + parser.peek().text + "'");
+    }
+    return statement;
+}
+
+std::shared_ptr<const QueryResult> QueryShell::join(const QueryStatement& statement) {
+    for (const auto& table : {statement.table, statement.join_table}) {
+        if (!database_.get_table(table)) {
+            throw std::runtime_error("Unknown table: " + table);
+        }
+    }
+
+    // QueryEngine reads the first column from the left table; accept either order in ON
+    std::string condition = statement.join_condition;
+    size_t equals = condition.find(" = ");
+    std::string left = condition.substr(0, equals);
+    std::string right = condition.substr(equals + 3);
+    if (left.rfind(statement.join_table + ".", 0) == 0 && right.rfind(statement.table + ".", 0) == 0) {
+        condition = right + " = " + left;
+    }
+
+    std::string key = statement.table + '\x1f' + statement.join_table + '\x1f' + condition;
+    auto cached = joins_.find(key);
+    if (cached != joins_.end()) {
+        return cached->second;
+    }
+    std::shared_ptr<const QueryResult> joined = engine_.join(statement.table, statement.join_table, condition);
+    if (!joined) {
+        throw std::runtime_error("Join condition must be table.column = table.column: " + statement.join_condition);
+    }
+    joins_[key] = joined;
+    return joined;
+}
+
+std::unique_ptr<QueryResult> QueryShell::execute(const QueryStatement& statement) {
+    std::vector<std::string> headers;
+    std::vector<const std::vector<std::string>*> rows;
+    std::shared_ptr<const QueryResult> source;
+
+    if (!statement.join_table.empty()) {
+        source = join(statement);
+        headers = source->headers;
+        std::vector<size_t> where_columns;
+        for (const auto& condition : statement.where) {
+            where_columns.push_back(resolve(headers, condition.column));
+        }
+        for (const auto& row : source->rows) {
+            bool matches = true;
+            for (size_t c = 0; c < statement.where.size() && matches; ++c) {
+                matches = compare(row[where_columns[c]], statement.where[c].op, statement.where[c].value);
+            }
+            if (matches) {
+                rows.push_back(&row);
+            }
+        }
+    } else {
+        const PsvTable* table = database_.get_table(statement.table);
+        if (!table) {
+            throw std::runtime_error("Unknown table: " + statement.table);
+        }
+
+        // Copy only the columns the statement reads out of the matching records
+        std::vector<std::string> needed;
+        auto need = [&](const std::string& name) {
+            const std::string& header = table->headers[resolve(table->headers, name)];
+            if (std::find(needed.begin(), needed.end(), header) == needed.end()) {
+                needed.push_back(header);
+            }
+        };
+        for (const auto& column : statement.columns) {
+            if (column.name != "*") {
+                need(column.name);
+            }
+        }
+        for (const auto& name : statement.group_by) {
+            need(name);
+        }
+        std::vector<size_t> where_fields;
+        for (const auto& condition : statement.where) {
+            where_fields.push_back(resolve(table->headers, condition.column));
+        }
+        if (needed.empty() && !statement.columns.empty()) {
+            // Only COUNT(*): any one column keeps the row count
+            needed.push_back(table->headers.empty() ? "" : table->headers.front());
+        }
+
+        std::string value;
+        source = engine_.select_matching(statement.table, needed, [&](const PsvTable& source_table, size_t row) {
+            for (size_t c = 0; c < statement.where.size(); ++c) {
+                std::string_view field = source_table.field(row, where_fields[c]);
+                value.assign(field.data(), field.size());
+                if (!compare(value, statement.where[c].op, statement.where[c].value)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        headers = source->headers;
+        for (const auto& row : source->rows) {
+            rows.push_back(&row);
+        }
+    }
+
+    auto result = std::make_unique<QueryResult>();
+    bool grouped = !statement.group_by.empty() ||
+                   std::any_of(statement.columns.begin(), statement.columns.end(),
+                               [](const QueryStatement::Column& column) { return !column.aggregate.empty(); });
+
+    if (!grouped) {
+        std::vector<size_t> indices;
+        if (statement.columns.empty()) {
+            result->headers = headers;
+            for (size_t i = 0; i < headers.size(); ++i) {
+                indices.push_back(i);
+            }
+        } else {
+            for (const auto& column : statement.columns) {
+                indices.push_back(resolve(headers, column.name));
+                result->headers.push_back(column.label);
+            }
+        }
+        result->rows.reserve(rows.size());
+        for (const auto* row : rows) {
+            std::vector<std::string> out;
+            out.reserve(indices.size());
+            for (size_t index : indices) {
+                out.push_back((*row)[index]);
+            }
+            result->rows.push_back(std::move(out));
+        }
+    } else {
+        if (statement.columns.empty()) {
+            throw std::runtime_error("SELECT * cannot be grouped; list the GROUP BY columns and aggregates");
+        }
+        std::vector<size_t> group_columns;
+        for (const auto& name : statement.group_by) {
+            group_columns.push_back(resolve(headers, name));
+        }
+        // Per output column: its group key position, or the aggregated input column
+        std::vector<size_t> key_slot(statement.columns.size(), SIZE_MAX);
+        std::vector<size_t> input(statement.columns.size(), SIZE_MAX);
+        for (size_t c = 0; c < statement.columns.size(); ++c) {
+            const auto& column = statement.columns[c];
+            result->headers.push_back(column.label);
+            if (column.aggregate.empty()) {
+                size_t index = resolve(headers, column.name);
+                auto slot = std::find(group_columns.begin(), group_columns.end(), index);
+                if (slot == group_columns.end()) {
+                    throw std::runtime_error(column.name + " must be in GROUP BY or inside an aggregate");
+                }
+                key_slot[c] = static_cast<size_t>(slot - group_columns.begin());
+            } else if (column.name != "*") {
+                input[c] = resolve(headers, column.name);
+            }
+        }
+
+        struct Group {
+            std::vector<std::string> keys;
+            std::vector<Aggregate> aggregates;
+        };
+        std::vector<Group> groups;
+        std::unordered_map<std::string, size_t> group_index;
+        for (const auto* row : rows) {
+            std::string key;
+            for (size_t index : group_columns) {
+                key += (*row)[index];
+                key += '\x1f';
+            }
+            auto found = group_index.find(key);
+            if (found == group_index.end()) {
+                found = group_index.emplace(key, groups.size()).first;
+                Group group;
+                for (size_t index : group_columns) {
+                    group.keys.push_back((*row)[index]);
+                }
+                group.aggregates.resize(statement.columns.size());
+                groups.push_back(std::move(group));
+            }
+            Group& group = groups[found->second];
+            for (size_t c = 0; c < statement.columns.size(); ++c) {
+                if (!statement.columns[c].aggregate.empty()) {
+                    accumulate(group.aggregates[c], input[c] == SIZE_MAX ? nullptr : &(*row)[input[c]]);
+                }
+            }
+        }
+        // Aggregates over no rows still give one row, as in SQL
+        if (groups.empty() && statement.group_by.empty()) {
+            groups.push_back(Group{{}, std::vector<Aggregate>(statement.columns.size())});
+        }
+        for (const auto& group : groups) {
+            std::vector<std::string> out;
+            for (size_t c = 0; c < statement.columns.size(); ++c) {
+                out.push_back(key_slot[c] != SIZE_MAX ? group.keys[key_slot[c]]
+                                                      : finish(group.aggregates[c], statement.columns[c].aggregate));
+            }
+            result->rows.push_back(std::move(out));
+        }
+    }
+
+    if (!statement.order_by.empty()) {
+        size_t order = SIZE_MAX;
+        for (size_t c = 0; c < statement.columns.size() && order == SIZE_MAX; ++c) {
+            if (statement.columns[c].label == statement.order_by || statement.columns[c].name == statement.order_by) {
+                order = c;
+            }
+        }
+        if (order == SIZE_MAX) {
+            order = resolve(result->headers, statement.order_by);
+        }
+        bool descending = statement.descending;
+        std::stable_sort(result->rows.begin(), result->rows.end(),
+                         [order, descending](const std::vector<std::string>& a, const std::vector<std::string>& b) {
+                             return descending ? value_less(b[order], a[order]) : value_less(a[order], b[order]);
+                         });
+    }
+    if (statement.limit > 0 && result->rows.size() > statement.limit) {
+        result->rows.resize(statement.limit);
+    }
+    return result;
+}
+
+bool QueryShell::compare(const std::string& value, const std::string& op, const std::string& literal) {
+    double x, y;
+    int order;
+    if (parse_number(value, x) && parse_number(literal, y)) {
+        order = x < y ? -1 : (x > y ? 1 : 0);
+    } else {
+        order = value.compare(literal);
+        order = order < 0 ? -1 : (order > 0 ? 1 : 0);
+    }
+    if (op == "=") return order == 0;
+    if (op == "!=") return order != 0;
+    if (op == "<") return order < 0;
+    if (op == "<=") return order <= 0;
+    if (op == ">") return order > 0;
+    if (op == ">=") return order >= 0;
+    return false;
+}
+
+const std::vector<ColumnStats>& QueryShell::column_stats(const std::string& table_name) {
+    auto cached = stats_.find(table_name);
+    if (cached != stats_.end()) {
+        return cached->second;
+    }
+    const PsvTable* table = database_.get_table(table_name);
+    if (!table) {
+        throw std::runtime_error("Unknown table: " + table_name);
+    }
+
+    std::vector<ColumnStats> stats;
+    for (size_t c = 0; c < table->headers.size(); ++c) {
+        ColumnStats column;
+        column.name = table->headers[c];
+        std::unordered_set<std::string> distinct;
+        bool first = true;
+        std::string value;
+        for (size_t row = 0; row < table->row_count(); ++row) {
+            std::string_view field = table->field(row, c);
+            value.assign(field.data(), field.size());
+            if (value.empty()) {
+                column.empty++;
+                continue;
+            }
+            distinct.insert(value);
+            double number;
+            if (!parse_number(value, number)) {
+                column.numeric = false;
+            }
+            if (first || value_less(value, column.min)) {
+                column.min = value;
+            }
+            if (first || value_less(column.max, value)) {
+                column.max = value;
+            }
+            first = false;
+        }
+        column.distinct = distinct.size();
+        column.numeric = column.numeric && !first;
+        stats.push_back(column);
+    }
+    return stats_.emplace(table_name, std::move(stats)).first->second;
+}
+
+std::vector<std::string> QueryShell::format_table(const QueryResult& result, size_t max_rows) {
+    auto cell = [](const std::string& value) {
+        return value.size() > kMaxColumnWidth ? value.substr(0, kMaxColumnWidth - 3) + "..." : value;
+    };
+    size_t shown = std::min(max_rows, result.rows.size());
+    std::vector<size_t> widths;
+    for (const auto& header : result.headers) {
+        widths.push_back(cell(header).size());
+    }
+    for (size_t r = 0; r < shown; ++r) {
+        for (size_t c = 0; c < widths.size() && c < result.rows[r].size(); ++c) {
+            widths[c] = std::max(widths[c], cell(result.rows[r][c]).size());
+        }
+    }
+
+    auto line = [&](const std::vector<std::string>& values) {
+        std::string text;
+        for (size_t c = 0; c < widths.size(); ++c) {
+            std::string value = c < values.size() ? cell(values[c]) : "";
+            text += (c ? " | " : "") + value + std::string(widths[c] - value.size(), ' ');
+        }
+        return text.substr(0, text.find_last_not_of(' ') + 1);
+    };
+
+    std::vector<std::string> lines;
+    lines.push_back(line(result.headers));
+    std::string rule;
+    for (size_t c = 0; c < widths.size(); ++c) {
+        rule += (c ? "-+-" : "") + std::string(widths[c], '-');
+    }
+    lines.push_back(rule);
+    for (size_t r = 0; r < shown; ++r) {
+        lines.push_back(line(result.rows[r]));
+    }
+    if (shown < result.rows.size()) {
+        lines.push_back("... " + std::to_string(result.rows.size() - shown) + " more rows (add LIMIT or GROUP BY)");
+    }
+    return lines;
+}
+
+bool QueryShell::run_command(const std::string& command, std::ostream& out) {
+    std::string text = trim(command);
+    if (text.empty()) {
+        return true;
+    }
+
+    try {
+        if (text[0] == '.' || upper(text) == "QUIT" || upper(text) == "EXIT") {
+            std::istringstream words(text);
+            std::string name;
+            std::string argument;
+            words >> name >> argument;
+            name = upper(name);
+
+            if (name == ".QUIT" || name == ".EXIT" || name == "QUIT" || name == "EXIT") {
+                return false;
+            }
+            if (name == ".TABLES") {
+                QueryResult tables;
+                tables.headers = {"table", "rows", "columns"};
+                for (const auto& table_name : database_.get_table_names()) {
+                    const PsvTable* table = database_.get_table(table_name);
+                    tables.rows.push_back({table_name, std::to_string(table->row_count()),
+                                           std::to_string(table->headers.size())});
+                }
+                for (const auto& line : format_table(tables, SIZE_MAX)) {
+                    out << line << '\n';
+                }
+            } else if (name == ".SCHEMA" && !argument.empty()) {
+                const PsvTable* table = database_.get_table(argument);
+                if (!table) {
+                    throw std::runtime_error("Unknown table: " + argument);
+                }
+                for (const auto& header : table->headers) {
+                    out << header << '\n';
+                }
+            } else if (name == ".STATS" && !argument.empty()) {
+                QueryResult stats;
+                stats.headers = {"column", "distinct", "empty", "type", "min", "max"};
+                for (const auto& column : column_stats(argument)) {
+                    stats.rows.push_back({column.name, std::to_string(column.distinct), std::to_string(column.empty),
+                                          column.numeric ? "number" : "text", column.min, column.max});
+                }
+                for (const auto& line : format_table(stats, SIZE_MAX)) {
+                    out << line << '\n';
+                }
+            } else if (name == ".HELP") {
+                out << "SELECT <columns> FROM <table> [JOIN <table> ON <a.col> = <b.col>]\n"
+                       "  [WHERE <col> <op> <value> [AND ...]] [GROUP BY <cols>]\n"
+                       "  [ORDER BY <col> [ASC|DESC]] [LIMIT <n>];\n"
+                       "Columns: *, names, COUNT(*), COUNT/SUM/AVG/MIN/MAX(col), each [AS label]\n"
+                       "Operators: = != < <= > >= (numeric when both sides are numbers)\n"
+                       ".tables             List loaded tables\n"
+                       ".schema <table>     Columns of a table\n"
+                       ".stats <table>      Distinct, empty, min and max per column\n"
+                       ".quit               Leave\n";
+            } else {
+                throw std::runtime_error("Unknown command: " + text + " (try .help)");
+            }
+            return true;
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        auto result = execute(parse(text));
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        for (const auto& line : format_table(*result)) {
+            out << line << '\n';
+        }
+        out << '(' << result->rows.size() << (result->rows.size() == 1 ? " row, " : " rows, ")
+            << std::fixed << std::setprecision(1) << milliseconds << " ms)\n";
+        out.unsetf(std::ios::fixed);
+    } catch (const std::exception& e) {
+        out << "Error: " << e.what() << '\n';
+    }
+    return true;
+}
+
+void QueryShell::run(std::istream& in, std::ostream& out, bool interactive) {
+    std::string pending;
+    std::string line;
+    for (;;) {
+        if (interactive) {
+            out << (trim(pending).empty() ? "query> " : "  ...> ") << std::flush;
+        }
+        if (!std::getline(in, line)) {
+            break;
+        }
+        // Dot commands take one line and need no ';'
+        if (trim(pending).empty()) {
+            std::string command = trim(line);
+            if (!command.empty() && (command[0] == '.' || upper(command) == "QUIT" || upper(command) == "EXIT")) {
+                if (!run_command(command, out)) {
+                    return;
+                }
+                continue;
+            }
+        }
+        pending += line + "\n";
+        size_t end;
+        while ((end = statement_end(pending)) != std::string::npos) {
+            std::string statement = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            run_command(statement, out);
+        }
+    }
+    // A last statement may omit its ';'
+    run_command(pending, out);
+    if (interactive) {
+        out << '\n';
+    }
+}
@@ -0,0 +1,186 @@
+#include "run_checkpoint.h"
+#include "column_store.h"
+#include "psv_parser.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr const char* kDone = "done";
+constexpr const char* kPartial = "partial";
+
+// FNV-1a, so signatures compare equal across builds
+uint64_t fnv1a(const std::string& text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void append_file_state(std::ostringstream& out, const std::filesystem::path& path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (!ec) {
+        out << size;
+    }
+    out << ':';
+    auto modified = std::filesystem::last_write_time(path, ec);
+    if (!ec) {
+        out << modified.time_since_epoch().count();
+    }
+    out << ';';
+}
+
+} // namespace
+
+RunCheckpoint::RunCheckpoint(std::filesystem::path output_root, bool resume)
+    : root_(std::move(output_root)), path_(root_ / kFileName) {
+    std::error_code ec;
+    if (!resume) {
+        std::filesystem::remove(path_, ec);
+        return;
+    }
+    std::ifstream file(path_);
+    std::string line;
+    // The first line names the columns
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        auto fields = PsvParser::split_psv_line(line);
+        if (fields.size() != 6 || (fields[1] != kDone && fields[1] != kPartial)) {
+            continue;
+        }
+        ConfigCheckpoint entry;
+        entry.done = fields[1] == kDone;
+        try {
+            entry.rows = static_cast<size_t>(std::stoull(fields[2]));
+            entry.bytes = std::stoull(fields[3]);
+        } catch (const std::exception&) {
+            continue;
+        }
+        entry.signature = fields[4];
+        std::istringstream names(fields[5]);
+        std::string name;
+        while (std::getline(names, name, ';')) {
+            entry.files.push_back(name);
+        }
+        entries_[fields[0]] = std::move(entry);
+    }
+}
+
+std::string RunCheckpoint::key(const OutputFileInfo& config) const {
+    auto prefix = config.headers_path.parent_path() / config.name_prefix;
+    return prefix.lexically_relative(root_).generic_string();
+}
+
+const ConfigCheckpoint* RunCheckpoint::find(const OutputFileInfo& config, const std::string& signature) const {
+    auto it = entries_.find(key(config));
+    if (it == entries_.end() || it->second.signature != signature || it->second.files.empty()) {
+        return nullptr;
+    }
+    const ConfigCheckpoint& entry = it->second;
+    uint64_t total = 0;
+    for (const auto& name : entry.files) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(config.headers_path.parent_path() / name, ec);
+        if (ec) {
+            return nullptr;
+        }
+        total += size;
+    }
+    // A partial file may have grown past its last checkpoint before the run died
+    bool intact = entry.done ? total == entry.bytes : entry.files.size() == 1 && total >= entry.bytes;
+    return intact ? &entry : nullptr;
+}
+
+bool RunCheckpoint::record(const OutputFileInfo& config, const ConfigCheckpoint& progress) {
+    entries_[key(config)] = progress;
+    return save();
+}
+
+void RunCheckpoint::finish() {
+    entries_.clear();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+bool RunCheckpoint::save() const {
+    auto temporary = path_.string() + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << "config|state|rows|bytes|signature|files\n";
+        for (const auto& entry : entries_) {
+            const ConfigCheckpoint& progress = entry.second;
+            file << entry.first << '|' << (progress.done ? kDone : kPartial) << '|' << progress.rows << '|'
+                 << progress.bytes << '|' << progress.signature << '|';
+            for (size_t i = 0; i < progress.files.size(); ++i) {
+                file << (i > 0 ? ";" : "") << progress.files[i];
+            }
+            file << '\n';
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+    // The checkpoint must not claim more than is on disk
+    sync_file(temporary);
+    std::error_code ec;
+    std::filesystem::rename(temporary, path_, ec);
+    if (ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+std::string RunCheckpoint::signature(const OutputFileInfo& config, const std::vector<FileInfo>& inputs,
+                                     const std::vector<std::string>& tables, const OutputOptions& options) {
+    std::ostringstream out;
+    append_file_state(out, config.headers_path);
+    append_file_state(out, config.rules_path);
+    for (const auto& input : inputs) {
+        if (std::find(tables.begin(), tables.end(), input.table()) != tables.end()) {
+            out << input.path.generic_string() << '=' << ColumnStore::signature(input);
+        }
+    }
+    out << '|' << OutputWriter::extension_for(options.format) << '|' << options.max_rows_per_file << '|'
+        << options.partition_column << '|' << options.diff;
+    for (const auto& column : options.diff_key) {
+        out << ',' << column;
+    }
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << fnv1a(out.str());
+    return hex.str();
+}
+
+bool RunCheckpoint::sync_file(const std::filesystem::path& path) {
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE handle = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool synced = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+    return synced;
+#else
+    int fd = ::open(path.c_str(), O_WRONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
@@ -0,0 +1,367 @@
+#include "run_metrics.h"
+#include "json_lines_writer.h"
+#include "memory_accounting.h"
+#include "tracer.h"
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// One cache line per stripe so threads allocating concurrently do not share counters
+struct alignas(64) AllocationStripe {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+constexpr size_t kStripeCount = 32;
+std::array<AllocationStripe, kStripeCount> g_stripes;
+std::atomic<size_t> g_next_stripe{0};
+
+// Off unless --metrics asks for allocation counts, so other runs pay one load per allocation
+std::atomic<bool> g_counting{false};
+
+inline void count_allocation(std::size_t size) {
+    if (!g_counting.load(std::memory_order_relaxed)) {
+        return;
+    }
+    thread_local size_t stripe = g_next_stripe.fetch_add(1, std::memory_order_relaxed) % kStripeCount;
+    g_stripes[stripe].count.fetch_add(1, std::memory_order_relaxed);
+    g_stripes[stripe].bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* counted_allocate(std::size_t size) {
+    count_allocation(size);
+    if (size == 0) {
+        size = 1;
+    }
+    for (;;) {
+        if (void* memory = std::malloc(size)) {
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+double process_cpu_seconds() {
+#if defined(_WIN32) || defined(_WIN64)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    auto to_seconds = [](const FILETIME& time) {
+        ULARGE_INTEGER ticks;
+        ticks.LowPart = time.dwLowDateTime;
+        ticks.HighPart = time.dwHighDateTime;
+        return static_cast<double>(ticks.QuadPart) / 1e7;   // 100 ns ticks
+    };
+    return to_seconds(kernel) + to_seconds(user);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    auto to_seconds = [](const timeval& time) {
+        return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+    };
+    return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+#endif
+}
+
+void append_field(std::string& out, const char* key, uint64_t value) {
+    out.append(",\"").append(key).append("\":").append(std::to_string(value));
+}
+
+void append_field(std::string& out, const char* key, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.6f", value);
+    out.append(",\"").append(key).append("\":").append(buffer);
+}
+
+// Measured hardware counters only; nothing when --perf-counters is off
+void append_perf(std::string& out, const StageMetrics& stage) {
+    const PerfSample& perf = stage.perf;
+    if (perf.valid == 0) {
+        return;
+    }
+    out.append(",\"perf\":{");
+    size_t mark = out.size();
+    if (perf.has(PerfSample::CYCLES)) append_field(out, "cycles", perf.cycles);
+    if (perf.has(PerfSample::INSTRUCTIONS)) append_field(out, "instructions", perf.instructions);
+    if (perf.has(PerfSample::CYCLES) && perf.has(PerfSample::INSTRUCTIONS)) append_field(out, "ipc", perf.ipc());
+    if (perf.has(PerfSample::CACHE_MISSES)) {
+        append_field(out, "cache_misses", perf.cache_misses);
+        append_field(out, "cache_misses_per_row", stage.per_row(perf.cache_misses));
+    }
+    if (perf.has(PerfSample::BRANCH_MISSES)) {
+        append_field(out, "branch_misses", perf.branch_misses);
+        append_field(out, "branch_misses_per_row", stage.per_row(perf.branch_misses));
+    }
+    out.erase(mark, 1);     // Leading comma of the first field
+    out.push_back('}');
+}
+
+void append_stage(std::string& out, const StageMetrics& stage) {
+    out.append("{\"name\":\"");
+    JsonLinesWriter::append_escaped(out, stage.name);
+    out.push_back('"');
+    append_field(out, "wall_seconds", stage.wall_seconds);
+    append_field(out, "cpu_seconds", stage.cpu_seconds);
+    append_field(out, "bytes_read", stage.bytes_read);
+    append_field(out, "bytes_written", stage.bytes_written);
+    append_field(out, "rows_in", stage.rows_in);
+    append_field(out, "rows_out", stage.rows_out);
+    append_field(out, "rows_per_second", stage.rows_per_second());
+    append_field(out, "mb_per_second", stage.mb_per_second());
+    append_field(out, "peak_rss_bytes", stage.peak_rss_bytes);
+    append_field(out, "allocations", stage.allocations);
+    append_field(out, "allocated_bytes", stage.allocated_bytes);
+    append_perf(out, stage);
+    out.push_back('}');
+}
+
+void append_stage_list(std::string& out, const char* key, const std::vector<StageMetrics>& stages) {
+    out.append(",\n  \"").append(key).append("\": [");
+    for (size_t i = 0; i < stages.size(); ++i) {
+        out.append(i == 0 ? "\n    " : ",\n    ");
+        append_stage(out, stages[i]);
+    }
+    out.append(stages.empty() ? "]" : "\n  ]");
+}
+
+void append_memory_entry(std::string& out, const ComponentMemory& entry, bool with_category) {
+    out.append("{\"name\":\"");
+    JsonLinesWriter::append_escaped(out, entry.name);
+    out.push_back('"');
+    if (with_category) {
+        out.append(",\"category\":\"").append(MemoryAccounting::category_name(entry.category)).append("\"");
+    }
+    append_field(out, "current_bytes", entry.current_bytes);
+    append_field(out, "peak_bytes", entry.peak_bytes);
+    out.push_back('}');
+}
+
+// Accounted bytes per category and per component (tables, results, hash tables, buffers)
+void append_memory(std::string& out) {
+    out.append(",\n  \"memory\": {\"total\": ");
+    append_memory_entry(out, MemoryAccounting::total(), false);
+
+    out.append(",\n    \"categories\": [");
+    const MemoryCategory categories[] = {MemoryCategory::TABLE, MemoryCategory::RESULT,
+                                         MemoryCategory::HASH_TABLE, MemoryCategory::BUFFER};
+    for (size_t i = 0; i < 4; ++i) {
+        if (i > 0) out.append(", ");
+        append_memory_entry(out, MemoryAccounting::category_total(categories[i]), false);
+    }
+
+    out.append("],\n    \"components\": [");
+    auto components = MemoryAccounting::components();
+    for (size_t i = 0; i < components.size(); ++i) {
+        out.append(i == 0 ? "\n      " : ",\n      ");
+        append_memory_entry(out, components[i], true);
+    }
+    out.append(components.empty() ? "]}" : "\n    ]}");
+}
+
+} // namespace
+
+// Replacement global allocation functions: count, then defer to malloc/free
+void* operator new(std::size_t size) { return counted_allocate(size); }
+void* operator new[](std::size_t size) { return counted_allocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+void AllocationCounter::enable() {
+    g_counting.store(true, std::memory_order_relaxed);
+}
+
+void AllocationCounter::disable() {
+    g_counting.store(false, std::memory_order_relaxed);
+}
+
+bool AllocationCounter::enabled() {
+    return g_counting.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::allocations() {
+    uint64_t total = 0;
+    for (const auto& stripe : g_stripes) {
+        total += stripe.count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t AllocationCounter::allocated_bytes() {
+    uint64_t total = 0;
+    for (const auto& stripe : g_stripes) {
+        total += stripe.bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+ResourceSample ResourceSample::now() {
+    ResourceSample sample;
+    sample.wall = std::chrono::steady_clock::now();
+    sample.cpu_seconds = process_cpu_seconds();
+    sample.allocations = AllocationCounter::allocations();
+    sample.allocated_bytes = AllocationCounter::allocated_bytes();
+    sample.perf = PerfCounters::read();
+    return sample;
+}
+
+double StageMetrics::rows_per_second() const {
+    if (wall_seconds <= 0.0) return 0.0;
+    return static_cast<double>(rows_in > 0 ? rows_in : rows_out) / wall_seconds;
+}
+
+double StageMetrics::mb_per_second() const {
+    if (wall_seconds <= 0.0) return 0.0;
+    return static_cast<double>(bytes_read + bytes_written) / 1e6 / wall_seconds;
+}
+
+double StageMetrics::per_row(uint64_t count) const {
+    uint64_t rows = rows_in > 0 ? rows_in : rows_out;
+    if (rows == 0) return 0.0;
+    return static_cast<double>(count) / static_cast<double>(rows);
+}
+
+RunMetrics::Stage::Stage(RunMetrics& owner, Category category, const std::string& name)
+    : owner_(owner), category_(category), start_(ResourceSample::now()) {
+    metrics_.name = name;
+    if (Tracer::enabled()) {
+        trace_start_ns_ = Tracer::now_ns();
+    }
+}
+
+RunMetrics::Stage::~Stage() {
+    finish();
+}
+
+void RunMetrics::Stage::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    if (Tracer::enabled()) {
+        Tracer::record(category_ == Category::PHASE ? "phase" : "config",
+                       metrics_.name.c_str(), trace_start_ns_, Tracer::now_ns());
+    }
+
+    ResourceSample end = ResourceSample::now();
+    metrics_.wall_seconds = std::chrono::duration<double>(end.wall - start_.wall).count();
+    metrics_.cpu_seconds = end.cpu_seconds - start_.cpu_seconds;
+    metrics_.allocations = end.allocations - start_.allocations;
+    metrics_.allocated_bytes = end.allocated_bytes - start_.allocated_bytes;
+    metrics_.perf = end.perf.since(start_.perf);
+    metrics_.peak_rss_bytes = peak_rss_bytes();
+    owner_.record(category_, metrics_);
+}
+
+RunMetrics::RunMetrics() : start_(ResourceSample::now()) {}
+
+void RunMetrics::record(Category category, const StageMetrics& metrics) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    (category == Category::PHASE ? phases_ : configs_).push_back(metrics);
+}
+
+void RunMetrics::set_perf_status(const std::string& status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    perf_status_ = status;
+}
+
+std::vector<StageMetrics> RunMetrics::phases() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return phases_;
+}
+
+std::vector<StageMetrics> RunMetrics::configs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return configs_;
+}
+
+StageMetrics RunMetrics::totals() const {
+    ResourceSample end = ResourceSample::now();
+
+    StageMetrics total;
+    total.name = "run";
+    total.wall_seconds = std::chrono::duration<double>(end.wall - start_.wall).count();
+    total.cpu_seconds = end.cpu_seconds - start_.cpu_seconds;
+    total.allocations = end.allocations - start_.allocations;
+    total.allocated_bytes = end.allocated_bytes - start_.allocated_bytes;
+    total.perf = end.perf.since(start_.perf);
+    total.peak_rss_bytes = peak_rss_bytes();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& phase : phases_) {
+        total.bytes_read += phase.bytes_read;
+        total.bytes_written += phase.bytes_written;
+        total.rows_in += phase.rows_in;
+        total.rows_out += phase.rows_out;
+    }
+    return total;
+}
+
+std::string RunMetrics::to_json() const {
+    std::string out = "{\n  \"version\": 1,\n  \"run\": ";
+    append_stage(out, totals());
+    append_stage_list(out, "phases", phases());
+    append_stage_list(out, "configs", configs());
+    append_memory(out);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!perf_status_.empty()) {
+            out.append(",\n  \"perf_counters\": {\"status\":\"");
+            JsonLinesWriter::append_escaped(out, perf_status_);
+            out.append("\"}");
+        }
+    }
+    out.append("\n}\n");
+    return out;
+}
+
+bool RunMetrics::write_json(const std::filesystem::path& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string json = to_json();
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return file.good();
+}
+
+uint64_t RunMetrics::peak_rss_bytes() {
+#if defined(_WIN32) || defined(_WIN64)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);          // Bytes on macOS
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // Kilobytes on Linux
+#endif
+#endif
+}
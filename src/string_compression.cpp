@@ -0,0 +1,295 @@
+#include "string_compression.h"
+#include "memory_accounting.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <map>
+#include <thread>
+
+namespace {
+
+// Bytes of each column a symbol table is learned from, taken from rows spread
+// over the whole column
+constexpr uint64_t kSampleBytes = 16 * 1024;
+constexpr int kTrainingRounds = 5;
+
+// Training counts symbols and single bytes together: codes below 256 are
+// symbols, 256 + b is the byte b
+constexpr size_t kTrainingCodes = 512;
+
+std::string_view field_at(const PsvTable& table, size_t row, size_t column) {
+    return table.field(row, column);
+}
+
+} // namespace
+
+SymbolTable::SymbolTable(std::vector<std::string> symbols) : symbols_(std::move(symbols)) {
+    for (size_t code = 0; code < symbols_.size(); ++code) {
+        std::memcpy(&words_[code], symbols_[code].data(), symbols_[code].size());
+        lengths_[code] = static_cast<uint8_t>(symbols_[code].size());
+        by_first_[static_cast<unsigned char>(symbols_[code][0])].push_back(static_cast<uint8_t>(code));
+    }
+    for (auto& codes : by_first_) {
+        std::stable_sort(codes.begin(), codes.end(), [this](uint8_t a, uint8_t b) {
+            return lengths_[a] > lengths_[b];
+        });
+    }
+}
+
+SymbolTable SymbolTable::train(const std::vector<std::string_view>& sample) {
+    // Each round encodes the sample with the current symbols and counts how
+    // often each symbol, and each pair of adjacent symbols, occurs. The next
+    // table keeps the symbols and joined pairs that save the most bytes.
+    SymbolTable table;
+    for (int round = 0; round < kTrainingRounds; ++round) {
+        std::vector<uint32_t> single(kTrainingCodes, 0);
+        std::vector<uint32_t> pairs(kTrainingCodes * kTrainingCodes, 0);
+        for (std::string_view value : sample) {
+            size_t previous = kTrainingCodes;
+            size_t position = 0;
+            while (position < value.size()) {
+                uint8_t code = 0;
+                size_t length = table.match(value.substr(position), code);
+                size_t current = length ? code : 256 + static_cast<unsigned char>(value[position]);
+                single[current]++;
+                if (previous < kTrainingCodes) {
+                    pairs[previous * kTrainingCodes + current]++;
+                }
+                previous = current;
+                position += length ? length : 1;
+            }
+        }
+
+        auto text = [&table](size_t code) {
+            return code < 256 ? table.symbols_[code] : std::string(1, static_cast<char>(code - 256));
+        };
+        // Candidates rank by the sample bytes they would cover, as in FSST
+        std::map<std::string, uint64_t> gains;
+        for (size_t code = 0; code < kTrainingCodes; ++code) {
+            if (single[code] > 0) {
+                std::string symbol = text(code);
+                gains[symbol] += static_cast<uint64_t>(single[code]) * symbol.size();
+            }
+        }
+        for (size_t first = 0; first < kTrainingCodes; ++first) {
+            if (single[first] == 0) {
+                continue;
+            }
+            for (size_t second = 0; second < kTrainingCodes; ++second) {
+                uint32_t count = pairs[first * kTrainingCodes + second];
+                if (count > 0) {
+                    std::string joined = (text(first) + text(second)).substr(0, kMaxSymbolLength);
+                    gains[joined] += static_cast<uint64_t>(count) * joined.size();
+                }
+            }
+        }
+
+        std::vector<std::pair<std::string, uint64_t>> candidates(gains.begin(), gains.end());
+        size_t kept = std::min(candidates.size(), kMaxSymbols);
+        std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(),
+                          [](const auto& a, const auto& b) {
+                              return a.second != b.second ? a.second > b.second : a.first < b.first;
+                          });
+        std::vector<std::string> symbols;
+        symbols.reserve(kept);
+        for (size_t i = 0; i < kept; ++i) {
+            symbols.push_back(std::move(candidates[i].first));
+        }
+        table = SymbolTable(std::move(symbols));
+    }
+    return table;
+}
+
+size_t SymbolTable::match(std::string_view text, uint8_t& code) const {
+    if (text.empty()) {
+        return 0;
+    }
+    for (uint8_t candidate : by_first_[static_cast<unsigned char>(text[0])]) {
+        size_t length = lengths_[candidate];
+        if (length <= text.size() && std::memcmp(text.data(), symbols_[candidate].data(), length) == 0) {
+            code = candidate;
+            return length;
+        }
+    }
+    return 0;
+}
+
+void SymbolTable::encode(std::string_view value, std::string& out) const {
+    if (symbols_.empty()) {
+        out.append(value);
+        return;
+    }
+    size_t position = 0;
+    while (position < value.size()) {
+        uint8_t code = 0;
+        size_t length = match(value.substr(position), code);
+        if (length) {
+            out.push_back(static_cast<char>(code));
+            position += length;
+        } else {
+            out.push_back(static_cast<char>(kEscape));
+            out.push_back(value[position++]);
+        }
+    }
+}
+
+void SymbolTable::decode(std::string_view code, std::string& out) const {
+    if (symbols_.empty()) {
+        out.append(code);
+        return;
+    }
+    // Whole 8-byte words are copied and the end moved by each symbol's length,
+    // so decode into a scratch buffer with room for the overshoot; `out` then
+    // grows by the exact size
+    thread_local std::string scratch;
+    if (scratch.size() < code.size() * kMaxSymbolLength) {
+        scratch.resize(code.size() * kMaxSymbolLength);
+    }
+    char* start = &scratch[0];
+    char* dest = start;
+    for (size_t i = 0; i < code.size(); ++i) {
+        uint8_t byte = static_cast<uint8_t>(code[i]);
+        if (byte == kEscape) {
+            *dest++ = code[++i];
+        } else {
+            std::memcpy(dest, &words_[byte], sizeof(uint64_t));
+            dest += lengths_[byte];
+        }
+    }
+    out.append(start, static_cast<size_t>(dest - start));
+}
+
+uint64_t SymbolTable::bytes() const {
+    uint64_t bytes = sizeof(SymbolTable) + symbols_.capacity() * sizeof(std::string);
+    for (const auto& codes : by_first_) {
+        bytes += codes.capacity();
+    }
+    return bytes;
+}
+
+CompressedColumn CompressedColumn::compress(const PsvTable& table, size_t column) {
+    CompressedColumn result;
+    size_t rows = table.row_count();
+
+    uint64_t total_bytes = 0;
+    for (size_t row = 0; row < rows; ++row) {
+        total_bytes += field_at(table, row, column).size();
+    }
+    size_t stride = static_cast<size_t>(std::max<uint64_t>(1, total_bytes / kSampleBytes));
+    std::vector<std::string_view> sample;
+    uint64_t sample_bytes = 0;
+    for (size_t row = 0; row < rows; row += stride) {
+        sample.push_back(field_at(table, row, column));
+        sample_bytes += sample.back().size();
+    }
+
+    // Keep the symbols only when they shorten the sample
+    SymbolTable trained = SymbolTable::train(sample);
+    std::string probe;
+    for (std::string_view value : sample) {
+        trained.encode(value, probe);
+    }
+    uint64_t expected_bytes = total_bytes;
+    if (probe.size() < sample_bytes) {
+        result.symbols_ = std::move(trained);
+        expected_bytes = static_cast<uint64_t>(static_cast<double>(total_bytes) * probe.size() / sample_bytes);
+    }
+
+    result.offsets_.reserve(rows + 1);
+    result.data_.reserve(static_cast<size_t>(expected_bytes));
+    for (size_t row = 0; row < rows; ++row) {
+        result.symbols_.encode(field_at(table, row, column), result.data_);
+        result.offsets_.push_back(result.data_.size());
+    }
+    result.data_.shrink_to_fit();
+    return result;
+}
+
+std::string CompressedColumn::value(size_t row) const {
+    std::string out;
+    append_value(row, out);
+    return out;
+}
+
+void CompressedColumn::append_value(size_t row, std::string& out) const {
+    symbols_.decode(code(row), out);
+}
+
+std::string CompressedColumn::encode(std::string_view value) const {
+    std::string out;
+    symbols_.encode(value, out);
+    return out;
+}
+
+uint64_t CompressedColumn::bytes() const {
+    return sizeof(CompressedColumn) - sizeof(SymbolTable) + symbols_.bytes() + data_.capacity() +
+           offsets_.capacity() * sizeof(uint64_t);
+}
+
+std::unique_ptr<CompressedTable> CompressedTable::compress(const PsvTable& table) {
+    auto result = std::make_unique<CompressedTable>();
+    result->name_ = table.name;
+    result->headers_ = table.headers;
+    result->source_file_ = table.source_file;
+    result->rows_ = table.row_count();
+
+    size_t column_count = table.headers.size();
+    result->columns_.resize(column_count);
+
+    // Compress each column independently on a small pool of threads
+    std::atomic<size_t> next_column{0};
+    size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t worker_count = std::min(column_count, hardware_threads);
+    std::vector<std::future<void>> workers;
+    for (size_t w = 0; w < worker_count; ++w) {
+        workers.push_back(std::async(std::launch::async, [&]() {
+            size_t column;
+            while ((column = next_column.fetch_add(1)) < column_count) {
+                result->columns_[column] = CompressedColumn::compress(table, column);
+            }
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    return result;
+}
+
+std::unique_ptr<PsvTable> CompressedTable::decompress() const {
+    auto table = std::make_unique<PsvTable>();
+    table->name = name_;
+    table->headers = headers_;
+    table->source_file = source_file_;
+    table->records.resize(rows_);
+    for (auto& record : table->records) {
+        record.fields.resize(columns_.size());
+    }
+    // Column by column, so each symbol table stays in cache
+    for (size_t column = 0; column < columns_.size(); ++column) {
+        for (size_t row = 0; row < rows_; ++row) {
+            columns_[column].append_value(row, table->records[row].fields[column]);
+        }
+    }
+    table->build_header_index();
+    return table;
+}
+
+std::string CompressedTable::get_field(size_t row, const std::string& header) const {
+    auto it = std::find(headers_.begin(), headers_.end(), header);
+    if (it == headers_.end() || row >= rows_) {
+        return "";
+    }
+    return columns_[static_cast<size_t>(it - headers_.begin())].value(row);
+}
+
+uint64_t CompressedTable::bytes() const {
+    uint64_t bytes = sizeof(CompressedTable) + MemoryAccounting::string_bytes(name_);
+    for (const auto& header : headers_) {
+        bytes += MemoryAccounting::string_bytes(header);
+    }
+    for (const auto& column : columns_) {
+        bytes += column.bytes();
+    }
+    return bytes;
+}
@@ -0,0 +1,224 @@
+#include "table_cache.h"
+#include "table_loader.h"
+#include "tracer.h"
+#include <sstream>
+
+namespace {
+
+// A table expanded from its compressed form, charged for as long as a job holds it
+struct ExpandedTable {
+    std::unique_ptr<PsvTable> table;
+    MemoryCharge charge;
+};
+
+std::shared_ptr<const PsvTable> charge_expanded(std::unique_ptr<PsvTable> table) {
+    auto expanded = std::make_shared<ExpandedTable>();
+    expanded->charge = MemoryCharge(MemoryCategory::TABLE, "expanded table " + table->name,
+                                    MemoryAccounting::table_bytes(*table));
+    expanded->table = std::move(table);
+    return std::shared_ptr<const PsvTable>(expanded, expanded->table.get());
+}
+
+} // namespace
+
+TableCache::TableCache(uint64_t budget_bytes, bool compress) : budget_bytes_(budget_bytes), compress_(compress) {
+}
+
+std::string TableCache::signature(const std::filesystem::path& first, const std::filesystem::path& second) {
+    std::ostringstream out;
+    for (const auto* path : {&first, &second}) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(*path, ec);
+        if (!ec) {
+            out << size;
+        }
+        out << ':';
+        auto modified = std::filesystem::last_write_time(*path, ec);
+        if (!ec) {
+            out << modified.time_since_epoch().count();
+        }
+        out << ';';
+    }
+    return out.str();
+}
+
+std::shared_ptr<const PsvTable> TableCache::get_table(const FileInfo& file) {
+    return get_table(std::vector<FileInfo>{file});
+}
+
+std::shared_ptr<const PsvTable> TableCache::get_table(const std::vector<FileInfo>& files) {
+    if (files.empty()) {
+        return nullptr;
+    }
+    std::string key;
+    std::string current;
+    for (const auto& file : files) {
+        key += file.path.string() + "\n";
+        current += signature(file.path, file.headers_path);
+    }
+
+    std::promise<CachedTable> loaded;
+    std::shared_future<CachedTable> cached;
+    uint64_t load_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tables_.find(key);
+        if (it != tables_.end() && it->second.signature == current) {
+            hits_++;
+            it->second.last_used = ++clock_;
+            cached = it->second.table;
+        } else {
+            misses_++;
+            if (it != tables_.end()) {
+                bytes_ -= it->second.bytes;
+            }
+            TableEntry& entry = tables_[key];
+            entry = TableEntry();
+            entry.signature = current;
+            entry.table = loaded.get_future().share();
+            entry.load_id = load_id = ++next_load_id_;
+            entry.last_used = ++clock_;
+        }
+    }
+    if (cached.valid()) {
+        // Possibly still loading in another job; rethrows its error if it fails
+        CachedTable entry = cached.get();
+        return entry.table ? entry.table : expand(key, entry.compressed);
+    }
+
+    std::shared_ptr<const PsvTable> table;
+    CachedTable entry;
+    uint64_t bytes = 0;
+    try {
+        TraceSpan span("load", "load " + files[0].table());
+        std::vector<std::unique_ptr<PsvTable>> parts;
+        for (const auto& file : files) {
+            parts.push_back(TableLoader::parse_input(file));
+        }
+        auto merged = TableLoader::merge_partitions(std::move(parts));
+        if (compress_) {
+            TraceSpan compress_span("load", "compress " + merged->name);
+            entry.compressed = CompressedTable::compress(*merged);
+            bytes = entry.compressed->bytes();
+            table = charge_expanded(std::move(merged));
+        } else {
+            bytes = MemoryAccounting::table_bytes(*merged);
+            entry.table = table = std::move(merged);
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = tables_.find(key);
+            if (it != tables_.end() && it->second.load_id == load_id) {
+                tables_.erase(it);
+            }
+        }
+        loaded.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tables_.find(key);
+        if (it != tables_.end() && it->second.load_id == load_id) {
+            it->second.bytes = bytes;
+            it->second.charge = MemoryCharge(MemoryCategory::TABLE, "cached table " + table->name, bytes);
+            it->second.expanded = table;
+            bytes_ += bytes;
+        }
+    }
+    loaded.set_value(entry);
+    return table;
+}
+
+std::shared_ptr<const PsvTable> TableCache::expand(const std::string& key,
+                                                   const std::shared_ptr<const CompressedTable>& compressed) {
+    // The entry may have been replaced or evicted since; its expanded copy is
+    // only shared while it still holds this compressed table
+    auto current = [&]() -> TableEntry* {
+        auto it = tables_.find(key);
+        if (it == tables_.end() || it->second.table.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+            it->second.table.get().compressed != compressed) {
+            return nullptr;
+        }
+        return &it->second;
+    };
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TableEntry* entry = current();
+        if (auto table = entry ? entry->expanded.lock() : nullptr) {
+            return table;
+        }
+    }
+
+    TraceSpan span("load", "expand " + compressed->name());
+    auto table = charge_expanded(compressed->decompress());
+
+    // Another job may have expanded it meanwhile; keep only one copy
+    std::lock_guard<std::mutex> lock(mutex_);
+    TableEntry* entry = current();
+    if (!entry) {
+        return table;
+    }
+    if (auto shared = entry->expanded.lock()) {
+        return shared;
+    }
+    entry->expanded = table;
+    return table;
+}
+
+std::shared_ptr<const ConfigRules> TableCache::get_rules(const OutputFileInfo& config) {
+    std::string key = config.rules_path.string();
+    std::string current = signature(config.headers_path, config.rules_path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = rules_.find(key);
+        if (it != rules_.end() && it->second.signature == current) {
+            return it->second.rules;
+        }
+    }
+
+    // Parsing is cheap; two jobs racing on a changed config may both parse it
+    auto rules = std::make_shared<const ConfigRules>(ConfigRunner::load_rules(config));
+    std::lock_guard<std::mutex> lock(mutex_);
+    rules_[key] = RulesEntry{current, rules};
+    return rules;
+}
+
+void TableCache::trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (budget_bytes_ > 0 && bytes_ > budget_bytes_) {
+        auto victim = tables_.end();
+        for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+            const auto& table = it->second.table;
+            // Skip loads in progress and tables a running job still reads. Jobs
+            // keep their own expanded copy of a compressed table.
+            if (table.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+                table.get().table.use_count() > 1) {
+                continue;
+            }
+            if (victim == tables_.end() || it->second.last_used < victim->second.last_used) {
+                victim = it;
+            }
+        }
+        if (victim == tables_.end()) {
+            break;
+        }
+        bytes_ -= victim->second.bytes;
+        tables_.erase(victim);
+    }
+}
+
+TableCache::Stats TableCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.bytes = bytes_;
+    for (const auto& entry : tables_) {
+        if (entry.second.bytes > 0) {
+            stats.tables++;
+        }
+    }
+    return stats;
+}
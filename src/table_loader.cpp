@@ -0,0 +1,219 @@
+#include "table_loader.h"
+#include "column_store.h"
+#include "progress_manager.h"
+#include "psv_parser.h"
+#include "tracer.h"
+#include <algorithm>
+#include <iterator>
+
+TableLoader::TableLoader(Database& database, std::vector<FileInfo> files, size_t threads,
+                         std::function<void()> on_finished, ColumnStore* store)
+    : database_(database), files_(std::move(files)), on_finished_(std::move(on_finished)), store_(store) {
+    // Small tables first: the configs that only need them can start soonest
+    std::stable_sort(files_.begin(), files_.end(), [](const FileInfo& a, const FileInfo& b) {
+        return a.size_bytes < b.size_bytes;
+    });
+    for (const auto& file : files_) {
+        pending_[file.table()]++;
+    }
+
+    // Partitions are merged in path order, whichever finishes parsing first
+    partition_slot_.resize(files_.size());
+    std::unordered_map<std::string, std::vector<size_t>> partition_files;
+    for (size_t i = 0; i < files_.size(); ++i) {
+        if (files_[i].is_partition()) {
+            partition_files[files_[i].table_name].push_back(i);
+        }
+    }
+    for (auto& entry : partition_files) {
+        auto& indices = entry.second;
+        std::sort(indices.begin(), indices.end(), [this](size_t a, size_t b) {
+            return files_[a].path < files_[b].path;
+        });
+        for (size_t slot = 0; slot < indices.size(); ++slot) {
+            partition_slot_[indices[slot]] = slot;
+        }
+        PartitionSet& set = partitions_[entry.first];
+        set.parts.resize(indices.size());
+        set.remaining = indices.size();
+    }
+
+    if (files_.empty()) {
+        if (on_finished_) {
+            on_finished_();
+        }
+        return;
+    }
+    size_t worker_count = std::max<size_t>(1, std::min(threads, files_.size()));
+    for (size_t w = 0; w < worker_count; ++w) {
+        workers_.emplace_back(&TableLoader::run_worker, this);
+    }
+}
+
+TableLoader::~TableLoader() {
+    stopping_ = true;
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void TableLoader::run_worker() {
+    size_t index;
+    while (!stopping_ && (index = next_file_.fetch_add(1)) < files_.size()) {
+        const auto& file = files_[index];
+        std::string table = file.table();
+        try {
+            TraceSpan span("load", "load " + file.path.filename().string());
+            auto progress = ProgressManager::create_file_progress(
+                file.path.filename().string(), file.size_bytes);
+
+            auto parsed = store_ ? store_->load(file) : parse_input(file);
+            if (file.is_partition()) {
+                // The last partition in merges the set and loads the table
+                std::vector<std::unique_ptr<PsvTable>> parts;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    PartitionSet& set = partitions_[table];
+                    set.parts[partition_slot_[index]] = std::move(parsed);
+                    if (--set.remaining == 0) {
+                        parts = std::move(set.parts);
+                        partitions_.erase(table);
+                    }
+                }
+                if (!parts.empty()) {
+                    database_.load_table(merge_partitions(std::move(parts)));
+                }
+            } else {
+                database_.load_table(std::move(parsed));
+            }
+
+            ProgressManager::complete_progress(*progress);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!failure_) {
+                failure_ = std::current_exception();
+            }
+            stopping_ = true;
+            table_loaded_.notify_all();
+            return;
+        }
+
+        // The last table stays pending until completion has been reported, so
+        // the load is over before the configs waiting on it start
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_[table] == 0) {
+                if (pending_.size() == 1) {
+                    last = true;
+                } else {
+                    pending_.erase(table);
+                }
+            }
+        }
+        if (last) {
+            if (on_finished_) {
+                on_finished_();
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.erase(table);
+        }
+        table_loaded_.notify_all();
+    }
+}
+
+bool TableLoader::ready_locked(const std::vector<std::string>& tables) const {
+    for (const auto& table : tables) {
+        if (pending_.count(table)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TableLoader::ready(const std::vector<std::string>& tables) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ready_locked(tables);
+}
+
+void TableLoader::wait_for(const std::vector<std::string>& tables) {
+    wait_for_any({tables});
+}
+
+size_t TableLoader::wait_for_any(const std::vector<std::vector<std::string>>& candidates) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        if (failure_) {
+            std::rethrow_exception(failure_);
+        }
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (ready_locked(candidates[i])) {
+                return i;
+            }
+        }
+        table_loaded_.wait(lock);
+    }
+}
+
+void TableLoader::wait_all() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    table_loaded_.wait(lock, [this] { return pending_.empty() || failure_; });
+    if (failure_) {
+        std::rethrow_exception(failure_);
+    }
+}
+
+std::unique_ptr<PsvTable> TableLoader::parse_input(const FileInfo& file) {
+    auto table = PsvParser::parse_file(file.path, file.headers_path);
+    if (!file.is_partition()) {
+        return table;
+    }
+
+    table->name = file.table_name;
+    table->source_file = file.headers_path.parent_path();
+    for (const auto& value : file.partition_values) {
+        table->headers.push_back(value.first);
+    }
+    for (auto& record : table->records) {
+        // Short rows are padded so the partition columns stay in place
+        record.fields.resize(table->headers.size() - file.partition_values.size());
+        for (const auto& value : file.partition_values) {
+            record.fields.push_back(value.second);
+        }
+    }
+    table->build_header_index();
+    return table;
+}
+
+std::unique_ptr<PsvTable> TableLoader::merge_partitions(std::vector<std::unique_ptr<PsvTable>> parts) {
+    if (parts.empty()) {
+        return nullptr;
+    }
+    if (parts.size() == 1) {
+        return std::move(parts[0]);
+    }
+    // A table views one mapped file, so parts mapped from the column store are
+    // copied into records to be merged
+    for (auto& part : parts) {
+        if (part && part->columns) {
+            part->records.resize(part->row_count());
+            for (size_t row = 0; row < part->records.size(); ++row) {
+                part->row_fields(row, part->records[row].fields);
+            }
+            part->columns.reset();
+        }
+    }
+    auto table = std::move(parts[0]);
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part ? part->records.size() : 0;
+    }
+    table->records.reserve(total);
+    for (size_t i = 1; i < parts.size(); ++i) {
+        if (!parts[i]) continue;
+        table->records.insert(table->records.end(),
+                              std::make_move_iterator(parts[i]->records.begin()),
+                              std::make_move_iterator(parts[i]->records.end()));
+    }
+    return table;
+}
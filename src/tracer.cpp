@@ -0,0 +1,245 @@
+#include "tracer.h"
+#include "json_lines_writer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Ring buffer written only by its owning thread
+struct ThreadBuffer {
+    uint32_t thread_id = 0;
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head{0};      // Events ever recorded; slot is head % capacity
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::vector<ThreadBuffer*> free_buffers;    // Left by exited threads, for the next new one
+    size_t capacity = Tracer::kDefaultEventsPerThread;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+std::atomic<bool> g_enabled{false};
+std::atomic<uint64_t> g_generation{0};
+std::atomic<int64_t> g_epoch_ns{0};
+
+// A thread's buffer, given back to the registry when the thread exits so
+// short-lived threads (one per output chunk) do not each keep a ring
+struct ThreadSlot {
+    ThreadBuffer* buffer = nullptr;
+    uint64_t generation = 0;
+
+    ~ThreadSlot();
+};
+
+thread_local ThreadSlot t_slot;
+
+int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ThreadSlot::~ThreadSlot() {
+    if (!buffer) {
+        return;
+    }
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    // A buffer from an earlier trace was freed by enable()
+    if (generation == g_generation.load(std::memory_order_acquire)) {
+        reg.free_buffers.push_back(buffer);
+    }
+}
+
+// Buffers are registered lazily, once per thread and trace. A new thread
+// takes over the buffer of an exited one if there is any, continuing its
+// ring, so the registry holds one buffer per thread alive at the same time.
+ThreadBuffer* thread_buffer() {
+    uint64_t generation = g_generation.load(std::memory_order_acquire);
+    ThreadSlot& slot = t_slot;
+    if (slot.buffer && slot.generation == generation) {
+        return slot.buffer;
+    }
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (!reg.free_buffers.empty()) {
+        slot.buffer = reg.free_buffers.back();
+        reg.free_buffers.pop_back();
+    } else {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->thread_id = static_cast<uint32_t>(reg.buffers.size());
+        buffer->events.resize(reg.capacity);
+        slot.buffer = buffer.get();
+        reg.buffers.push_back(std::move(buffer));
+    }
+    slot.generation = generation;
+    return slot.buffer;
+}
+
+// Copy at most kNameSize - 1 bytes without splitting a UTF-8 sequence
+void copy_name(char* destination, const char* source, size_t length) {
+    if (length >= TraceEvent::kNameSize) {
+        length = TraceEvent::kNameSize - 1;
+        while (length > 0 && (static_cast<unsigned char>(source[length]) & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    std::memcpy(destination, source, length);
+    destination[length] = '\0';
+}
+
+void append_microseconds(std::string& out, uint64_t ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", static_cast<double>(ns) / 1000.0);
+    out.append(buffer);
+}
+
+void append_thread_name(std::string& out, uint32_t thread_id) {
+    out.append(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":")
+       .append(std::to_string(thread_id))
+       .append(",\"args\":{\"name\":\"")
+       .append(thread_id == 0 ? "main" : "worker " + std::to_string(thread_id))
+       .append("\"}}");
+}
+
+} // namespace
+
+void Tracer::enable(size_t events_per_thread) {
+    Registry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.buffers.clear();
+        reg.free_buffers.clear();
+        reg.capacity = std::max<size_t>(1, events_per_thread);
+        g_epoch_ns.store(steady_ns(), std::memory_order_relaxed);
+        g_generation.fetch_add(1, std::memory_order_release);
+    }
+    g_enabled.store(true, std::memory_order_release);
+
+    // The enabling thread becomes thread 0 ("main")
+    thread_buffer();
+}
+
+void Tracer::disable() {
+    g_enabled.store(false, std::memory_order_release);
+}
+
+bool Tracer::enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t Tracer::now_ns() {
+    return static_cast<uint64_t>(steady_ns() - g_epoch_ns.load(std::memory_order_relaxed));
+}
+
+void Tracer::record(const char* category, const char* name, uint64_t start_ns, uint64_t end_ns) {
+    if (!enabled()) {
+        return;
+    }
+
+    ThreadBuffer* buffer = thread_buffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[head % buffer->events.size()];
+    copy_name(event.name, name, std::strlen(name));
+    event.category = category;
+    event.start_ns = start_ns;
+    event.duration_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+std::string Tracer::to_json() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::string out = "{\"traceEvents\":[\n"
+                      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"agile-pasta\"}}";
+    uint64_t dropped = 0;
+
+    for (const auto& buffer : reg.buffers) {
+        append_thread_name(out, buffer->thread_id);
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t capacity = buffer->events.size();
+        uint64_t count = std::min(head, capacity);
+        dropped += head - count;
+
+        for (uint64_t i = head - count; i < head; ++i) {
+            const TraceEvent& event = buffer->events[i % capacity];
+            out.append(",\n{\"name\":\"");
+            JsonLinesWriter::append_escaped(out, event.name);
+            out.append("\",\"cat\":\"").append(event.category).append("\",\"ph\":\"X\",\"ts\":");
+            append_microseconds(out, event.start_ns);
+            out.append(",\"dur\":");
+            append_microseconds(out, event.duration_ns);
+            out.append(",\"pid\":1,\"tid\":").append(std::to_string(buffer->thread_id)).append("}");
+        }
+    }
+
+    out.append("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":")
+       .append(std::to_string(dropped))
+       .append("}}\n");
+    return out;
+}
+
+bool Tracer::write_json(const std::filesystem::path& path) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string json = to_json();
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return file.good();
+}
+
+size_t Tracer::thread_buffers() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.buffers.size();
+}
+
+uint64_t Tracer::dropped_events() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    uint64_t dropped = 0;
+    for (const auto& buffer : reg.buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        dropped += head - std::min<uint64_t>(head, buffer->events.size());
+    }
+    return dropped;
+}
+
+TraceSpan::TraceSpan(const char* category, const char* name)
+    : category_(category), start_ns_(0), active_(Tracer::enabled()) {
+    if (active_) {
+        copy_name(name_, name, std::strlen(name));
+        start_ns_ = Tracer::now_ns();
+    }
+}
+
+TraceSpan::TraceSpan(const char* category, const std::string& name)
+    : category_(category), start_ns_(0), active_(Tracer::enabled()) {
+    if (active_) {
+        copy_name(name_, name.data(), name.size());
+        start_ns_ = Tracer::now_ns();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (active_) {
+        Tracer::record(category_, name_, start_ns_, Tracer::now_ns());
+    }
+}
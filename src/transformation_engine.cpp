@@ -1,11 +1,21 @@
 #include "transformation_engine.h"
 #include "progress_manager.h"
+#include "tracer.h"
 #include <fstream>
 #include <sstream>
 #include <regex>
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
 
 TransformationEngine::TransformationEngine(const Database& db, QueryEngine& query_engine)
     : database_(db), query_engine_(query_engine) {}
@@ -63,23 +73,45 @@ void TransformationEngine::load_output_headers(const std::filesystem::path& head
     }
 }
 
+void TransformationEngine::set_rules(std::vector<TransformationRule> rules) {
+    rules_ = std::move(rules);
+}
+
+void TransformationEngine::set_output_headers(std::vector<std::string> headers) {
+    output_headers_ = std::move(headers);
+}
+
 std::unique_ptr<QueryResult> TransformationEngine::transform_data() {
     if (output_headers_.empty()) {
+        stats_ = TransformStats();
         return nullptr; // Handle gracefully when no headers are loaded
     }
     
     auto result = std::make_unique<QueryResult>();
     result->headers = output_headers_;
+    transform_rows([&result](std::vector<std::string>&& row) {
+        result->rows.push_back(std::move(row));
+    });
+    return result;
+}
+
+size_t TransformationEngine::transform_rows(const std::function<void(std::vector<std::string>&&)>& emit) {
+    stats_ = TransformStats();
+    if (output_headers_.empty()) {
+        return 0;
+    }
     
     // Get all table names
     auto table_names = database_.get_table_names();
     if (table_names.empty()) {
-        return result; // Empty result
+        return 0; // Empty result
     }
     
     // Check for JOIN and UNION operations in GLOBAL rules
     std::unique_ptr<QueryResult> source_data;
     std::vector<std::string> source_headers;
+    std::string source_label = "transform source";
+    auto source_start = std::chrono::steady_clock::now();
     
     // First, check if we have any JOIN or UNION operations
     bool has_join_operations = false;
@@ -102,6 +134,7 @@ std::unique_ptr<QueryResult> TransformationEngine::transform_data() {
                 if (!source_data) {
                     // First join operation
                     source_data = query_engine_.join(rule.left_table, rule.right_table, join_condition, JoinType::INNER);
+                    source_label = "join " + rule.left_table + " x " + rule.right_table;
                     if (source_data) {
                         source_headers = source_data->headers;
                     }
@@ -115,6 +148,7 @@ std::unique_ptr<QueryResult> TransformationEngine::transform_data() {
                 if (!source_data) {
                     // First union operation
                     source_data = query_engine_.union_tables(rule.union_tables);
+                    source_label = "union";
                     if (source_data) {
                         source_headers = source_data->headers;
                     }
@@ -128,96 +162,19 @@ std::unique_ptr<QueryResult> TransformationEngine::transform_data() {
         
         if (!source_data) {
             std::cerr << "Warning: JOIN/UNION operation failed." << std::endl;
-            return result; // Empty result
+            return 0; // Empty result
         }
     } else {
-        // No JOIN operations, use existing logic to find source table
+        // No JOIN operations, use the first table that FIELD rules reference
+        std::string source_table = find_source_table(table_names);
         
-        // Check if we have any field rules that reference input fields
-        bool has_input_field_references = false;
-        for (const auto& rule : rules_) {
-            if (rule.type == TransformationRule::RuleType::FIELD) {
-                // Check if the rule condition references any input field
-                // This includes direct field references, complex expressions, and if-else conditions
-                for (const auto& table_name : table_names) {
-                    const PsvTable* table = database_.get_table(table_name);
-                    if (!table) continue;
-                    
-                    // Check if rule.condition contains any field name (with word boundaries)
-                    for (const auto& header : table->headers) {
-                        // Use word boundary search like in field replacement
-                        size_t pos = 0;
-                        bool found_reference = false;
-                        while ((pos = rule.condition.find(header, pos)) != std::string::npos) {
-                            // Make sure it's a whole word (including underscores as part of identifiers)
-                            bool is_start_ok = (pos == 0 || (!std::isalnum(rule.condition[pos-1]) && rule.condition[pos-1] != '_'));
-                            bool is_end_ok = (pos + header.length() == rule.condition.length() || 
-                                             (!std::isalnum(rule.condition[pos + header.length()]) && rule.condition[pos + header.length()] != '_'));
-                            
-                            if (is_start_ok && is_end_ok) {
-                                found_reference = true;
-                                break;
-                            }
-                            pos += header.length();
-                        }
-                        
-                        if (found_reference) {
-                            has_input_field_references = true;
-                            break;
-                        }
-                    }
-                    if (has_input_field_references) break;
-                }
-                if (has_input_field_references) break;
-            }
-        }
-        
-        // If we have input field references, find a suitable source table
-        if (has_input_field_references) {
-            // Try to find a table that contains most of the fields we need
-            for (const auto& table_name : table_names) {
-                const PsvTable* table = database_.get_table(table_name);
-                if (!table) continue;
-                
-                // Count how many of our required fields are in this table
-                int field_matches = 0;
-                for (const auto& rule : rules_) {
-                    if (rule.type == TransformationRule::RuleType::FIELD) {
-                        // Check if rule.condition contains any field name from this table
-                        for (const auto& header : table->headers) {
-                            // Use the same word boundary logic as above
-                            size_t pos = 0;
-                            bool found_reference = false;
-                            while ((pos = rule.condition.find(header, pos)) != std::string::npos) {
-                                bool is_start_ok = (pos == 0 || (!std::isalnum(rule.condition[pos-1]) && rule.condition[pos-1] != '_'));
-                                bool is_end_ok = (pos + header.length() == rule.condition.length() || 
-                                                 (!std::isalnum(rule.condition[pos + header.length()]) && rule.condition[pos + header.length()] != '_'));
-                                
-                                if (is_start_ok && is_end_ok) {
-                                    found_reference = true;
-                                    break;
-                                }
-                                pos += header.length();
-                            }
-                            
-                            if (found_reference) {
-                                field_matches++;
-                                break; // Count each rule only once per table
-                            }
-                        }
-                    }
-                }
-                
-                // Use this table if it has the most matches
-                if (field_matches > 0) {
-                    source_data = query_engine_.select(table_name);
-                    source_headers = table->headers;
-                    break; // Use first matching table for now
-                }
-            }
+        if (!source_table.empty()) {
+            source_data = query_engine_.select(source_table);
+            source_label = "select " + source_table;
+            source_headers = database_.get_table(source_table)->headers;
             
             if (!source_data) {
-                return result; // No suitable source data
+                return 0; // No suitable source data
             }
         } else {
             // All field rules are static (no input field references)
@@ -229,26 +186,10 @@ std::unique_ptr<QueryResult> TransformationEngine::transform_data() {
         }
     }
     
-    // Apply global rules (filtering) - skip JOIN and UNION rules as they were already processed
-    std::vector<std::vector<std::string>> filtered_rows;
-    
-    for (const auto& row : source_data->rows) {
-        bool passes_global_filters = true;
-        
-        for (const auto& rule : rules_) {
-            if (rule.type == TransformationRule::RuleType::GLOBAL) {
-                if (!evaluate_rule_condition(rule.condition, row, source_headers)) {
-                    passes_global_filters = false;
-                    break;
-                }
-            }
-            // Skip GLOBAL_JOIN and GLOBAL_UNION rules as they were already processed
-        }
-        
-        if (passes_global_filters) {
-            filtered_rows.push_back(row);
-        }
-    }
+    stats_.source_seconds = seconds_since(source_start);
+    stats_.source_rows = source_data->rows.size();
+    stats_.source_bytes = MemoryAccounting::result_bytes(*source_data);
+    MemoryCharge source_charge(MemoryCategory::RESULT, source_label, stats_.source_bytes);
     
     // Check for unmapped output fields and warn
     std::vector<std::string> unmapped_fields;
@@ -288,15 +229,35 @@ std::unique_ptr<QueryResult> TransformationEngine::transform_data() {
         std::cerr << "Consider adding FIELD transformation rules for these fields." << std::endl;
     }
     
-    // Apply field transformations
+    // Apply global rules (filtering) and field transformations in one pass, so
+    // rows that pass go straight to the caller without an intermediate copy.
+    // JOIN and UNION rules were already processed above.
     std::unique_ptr<CustomProgressBar> progress;
-    if (!filtered_rows.empty()) {
+    if (show_progress_ && !source_data->rows.empty()) {
         progress = ProgressManager::create_processing_progress(
-            "Processing data", filtered_rows.size());
+            "Processing data", source_data->rows.size());
     }
     
+    TraceSpan transform_span("transform", "filter and transform rows");
     size_t row_index = 0;
-    for (const auto& input_row : filtered_rows) {
+    size_t rows_emitted = 0;
+    for (const auto& input_row : source_data->rows) {
+        row_index++;
+        if (progress && (row_index % 100 == 0 || row_index == source_data->rows.size())) {
+            ProgressManager::update_progress(*progress, row_index);
+        }
+        
+        auto filter_start = timed_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        bool passes = passes_global_filters(input_row, source_headers);
+        if (timed_) {
+            stats_.filter_seconds += seconds_since(filter_start);
+        }
+        if (!passes) {
+            continue;
+        }
+        stats_.filtered_rows++;
+        
+        auto project_start = timed_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
         std::vector<std::string> output_row;
         
         for (const auto& output_header : output_headers_) {
@@ -327,27 +288,148 @@ std::unique_ptr<QueryResult> TransformationEngine::transform_data() {
             
             output_row.push_back(output_value);
         }
-        
-        result->rows.push_back(output_row);
-        
-        // Update progress periodically
-        row_index++;
-        if (progress && (row_index % 100 == 0 || row_index == filtered_rows.size())) {
-            ProgressManager::update_progress(*progress, row_index);
+        if (timed_) {
+            stats_.project_seconds += seconds_since(project_start);
         }
+        
+        emit(std::move(output_row));
+        rows_emitted++;
     }
     
     if (progress) {
         ProgressManager::complete_progress(*progress);
     }
     
-    return result;
+    return rows_emitted;
 }
 
 const std::vector<std::string>& TransformationEngine::get_output_headers() const {
     return output_headers_;
 }
 
+size_t TransformationEngine::get_rows_scanned() const {
+    return stats_.source_rows;
+}
+
+const TransformStats& TransformationEngine::get_stats() const {
+    return stats_;
+}
+
+void TransformationEngine::set_timed(bool timed) {
+    timed_ = timed;
+}
+
+void TransformationEngine::set_progress(bool show_progress) {
+    show_progress_ = show_progress;
+}
+
+const std::vector<TransformationRule>& TransformationEngine::get_rules() const {
+    return rules_;
+}
+
+std::string TransformationEngine::get_source_table() const {
+    return find_source_table(database_.get_table_names());
+}
+
+bool TransformationEngine::plan_projection(ProjectionPlan& plan) const {
+    if (output_headers_.empty()) {
+        return false;
+    }
+    
+    for (const auto& rule : rules_) {
+        if (rule.type == TransformationRule::RuleType::GLOBAL_JOIN ||
+            rule.type == TransformationRule::RuleType::GLOBAL_UNION) {
+            return false;
+        }
+    }
+    
+    std::string source_table = find_source_table(database_.get_table_names());
+    const PsvTable* table = source_table.empty() ? nullptr : database_.get_table(source_table);
+    if (!table) {
+        return false;
+    }
+    
+    plan.source = table;
+    plan.column_indices.clear();
+    
+    for (const auto& output_header : output_headers_) {
+        // The first FIELD rule for a header wins, as in transform_data()
+        const TransformationRule* field_rule = nullptr;
+        for (const auto& rule : rules_) {
+            if (rule.type == TransformationRule::RuleType::FIELD && rule.target_field == output_header) {
+                field_rule = &rule;
+                break;
+            }
+        }
+        
+        // Every output column must be a bare source column reference
+        const std::string& source_column = field_rule ? field_rule->condition : output_header;
+        auto it = table->header_index.find(source_column);
+        if (it == table->header_index.end()) {
+            return false;
+        }
+        
+        plan.column_indices.push_back(it->second);
+    }
+    
+    return true;
+}
+
+bool TransformationEngine::passes_global_filters(const std::vector<std::string>& row,
+                                                 const std::vector<std::string>& headers) {
+    for (const auto& rule : rules_) {
+        if (rule.type == TransformationRule::RuleType::GLOBAL) {
+            if (!evaluate_rule_condition(rule.condition, row, headers)) {
+                return false;
+            }
+        }
+        // Skip GLOBAL_JOIN and GLOBAL_UNION rules as they were already processed
+    }
+    
+    return true;
+}
+
+std::string TransformationEngine::find_source_table(const std::vector<std::string>& table_names) const {
+    // Use the first table (in name order) that any FIELD rule references
+    for (const auto& table_name : table_names) {
+        const PsvTable* table = database_.get_table(table_name);
+        if (!table) continue;
+        
+        for (const auto& rule : rules_) {
+            if (rule.type != TransformationRule::RuleType::FIELD) continue;
+            
+            for (const auto& header : table->headers) {
+                if (references_field(rule.condition, header)) {
+                    return table_name;
+                }
+            }
+        }
+    }
+    
+    return "";
+}
+
+bool TransformationEngine::references_field(const std::string& expression, const std::string& field) {
+    if (field.empty()) {
+        return false;
+    }
+    
+    size_t pos = 0;
+    while ((pos = expression.find(field, pos)) != std::string::npos) {
+        // Make sure it's a whole word (including underscores as part of identifiers)
+        bool is_start_ok = (pos == 0 || (!std::isalnum(expression[pos-1]) && expression[pos-1] != '_'));
+        bool is_end_ok = (pos + field.length() == expression.length() || 
+                         (!std::isalnum(expression[pos + field.length()]) && expression[pos + field.length()] != '_'));
+        
+        if (is_start_ok && is_end_ok) {
+            return true;
+        }
+        pos += field.length();
+    }
+    
+    return false;
+}
+
 TransformationRule TransformationEngine::parse_rule(const std::string& rule_text) {
     // Expected format: GLOBAL|condition|description
     // or: FIELD|target_field|expression|description
@@ -433,7 +515,7 @@ std::string TransformationEngine::apply_rule(const TransformationRule& rule,
     std::string expression = rule.condition;
     
     // Check for if-else (ternary) syntax: condition ? value1 : value2
-    std::regex ternary_regex(R"((.+?)\s*\?\s*(.+?)\s*:\s*(.+))");
+    static const std::regex ternary_regex(R"((.+?)\s*\?\s*(.+?)\s*:\s*(.+))");
     std::smatch ternary_match;
     
     if (std::regex_match(expression, ternary_match, ternary_regex)) {
@@ -479,8 +561,8 @@ std::string TransformationEngine::apply_rule(const TransformationRule& rule,
     // Extract and preserve quoted string literals first
     // Handle both double quotes (new syntax) and single quotes (backward compatibility)
     std::vector<std::pair<std::string, std::string>> string_literals;
-    std::regex double_quote_regex("\"([^\"]*)\"");
-    std::regex single_quote_regex("'([^']*)'");
+    static const std::regex double_quote_regex("\"([^\"]*)\"");
+    static const std::regex single_quote_regex("'([^']*)'");
     std::smatch match;
     int literal_counter = 0;
     
@@ -649,7 +731,7 @@ bool TransformationEngine::evaluate_rule_condition(const std::string& condition,
                                                   const std::vector<std::string>& row,
                                                   const std::vector<std::string>& headers) {
     // Check for if-else (ternary) syntax: condition ? ACCEPT : REJECT
-    std::regex ternary_regex(R"((.+?)\s*\?\s*(ACCEPT|REJECT)\s*:\s*(ACCEPT|REJECT))");
+    static const std::regex ternary_regex(R"((.+?)\s*\?\s*(ACCEPT|REJECT)\s*:\s*(ACCEPT|REJECT))");
     std::smatch ternary_match;
     
     if (std::regex_match(condition, ternary_match, ternary_regex)) {
@@ -673,13 +755,26 @@ bool TransformationEngine::evaluate_rule_condition(const std::string& condition,
     return evaluate_simple_condition(condition, row, headers);
 }
 
+std::string TransformationEngine::condition_field(const std::string& condition) {
+    static const std::regex field_regex(
+        R"((\w+)\s*(=|!=|>|<|>=|<=)\s*'[^']*'(\s*\?\s*(ACCEPT|REJECT)\s*:\s*(ACCEPT|REJECT))?)");
+    std::smatch match;
+    std::string trimmed = condition;
+    trimmed.erase(0, trimmed.find_first_not_of(" \t"));
+    trimmed.erase(trimmed.find_last_not_of(" \t") + 1);
+    if (std::regex_match(trimmed, match, field_regex)) {
+        return match[1].str();
+    }
+    return "";
+}
+
 bool TransformationEngine::evaluate_simple_condition(const std::string& condition,
                                                     const std::vector<std::string>& row,
                                                     const std::vector<std::string>& headers) {
     // Simplified condition evaluation
     // Support: field = 'value', field != 'value', field > 'value', etc.
     
-    std::regex condition_regex(R"((\w+)\s*(=|!=|>|<|>=|<=)\s*'([^']*)')");
+    static const std::regex condition_regex(R"((\w+)\s*(=|!=|>|<|>=|<=)\s*'([^']*)')");
     std::smatch match;
     
     if (std::regex_match(condition, match, condition_regex)) {
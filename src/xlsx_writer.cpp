@@ -0,0 +1,408 @@
+#include "xlsx_writer.h"
+#include "columnar_writer.h"
+#include "memory_accounting.h"
+#include "tracer.h"
+#include "zip_writer.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t kFlushThreshold = 1 << 20;
+
+// Excel keeps 15 significant digits; longer numbers must stay text to survive
+constexpr size_t kMaxNumericDigits = 15;
+
+const char* const kXmlDeclaration = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+const char* const kSpreadsheetNamespace = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+const char* const kRelationshipsNamespace = "http://schemas.openxmlformats.org/package/2006/relationships";
+const char* const kOfficeRelationships = "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+
+// Rows of a result, optionally restricted to a subset of indices
+struct RowSelection {
+    const QueryResult& result;
+    const std::vector<size_t>* indices;
+
+    size_t size() const { return indices ? indices->size() : result.rows.size(); }
+
+    const std::string& value(size_t row, size_t column) const {
+        static const std::string kEmpty;
+        const auto& fields = result.rows[indices ? (*indices)[row] : row];
+        return column < fields.size() ? fields[column] : kEmpty;
+    }
+};
+
+enum class CellKind {
+    NUMBER,         // <v> with the value text
+    SHARED_STRING,  // t="s", index into sharedStrings.xml
+    INLINE_STRING   // t="inlineStr"
+};
+
+// How one column is written, decided once before any sheet XML is generated
+struct ColumnPlan {
+    CellKind kind = CellKind::INLINE_STRING;
+    std::string name;                           // Column letters, e.g. "AB"
+    std::vector<std::string_view> dictionary;   // Distinct values (shared string columns)
+    std::vector<uint32_t> codes;                // Per row: local, then shared-string index
+};
+
+bool fits_excel_precision(const std::string& text) {
+    size_t digits = 0;
+    for (char c : text) {
+        if (c >= '0' && c <= '9') digits++;
+    }
+    return digits <= kMaxNumericDigits;
+}
+
+bool needs_space_preserve(const std::string& value) {
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    return !value.empty() && (is_space(value.front()) || is_space(value.back()));
+}
+
+void plan_column(const RowSelection& rows, size_t column, ColumnPlan& plan) {
+    size_t row_count = rows.size();
+
+    std::vector<const std::string*> values;
+    values.reserve(row_count);
+    for (size_t row = 0; row < row_count; ++row) {
+        values.push_back(&rows.value(row, column));
+    }
+
+    ColumnType type = ColumnarWriter::infer_type(values);
+    if (type != ColumnType::STRING) {
+        bool precise = true;
+        for (const std::string* text : values) {
+            if (!fits_excel_precision(*text)) {
+                precise = false;
+                break;
+            }
+        }
+        if (precise) {
+            plan.kind = CellKind::NUMBER;
+            return;
+        }
+    }
+
+    // Same rule as the columnar dictionary: values must repeat at least twice on average
+    std::unordered_map<std::string_view, uint32_t> dictionary;
+    plan.codes.reserve(row_count);
+    for (size_t row = 0; row < row_count; ++row) {
+        std::string_view value = *values[row];
+        auto it = dictionary.find(value);
+        if (it == dictionary.end()) {
+            it = dictionary.emplace(value, static_cast<uint32_t>(plan.dictionary.size())).first;
+            plan.dictionary.push_back(value);
+            if (plan.dictionary.size() * 2 > row_count) {
+                plan.dictionary.clear();
+                plan.codes.clear();
+                plan.codes.shrink_to_fit();
+                plan.kind = CellKind::INLINE_STRING;
+                return;
+            }
+        }
+        plan.codes.push_back(it->second);
+    }
+    plan.kind = row_count > 0 ? CellKind::SHARED_STRING : CellKind::INLINE_STRING;
+}
+
+void append_inline_string(std::string& out, const std::string& value) {
+    out.append(needs_space_preserve(value) ? "<is><t xml:space=\"preserve\">" : "<is><t>");
+    XlsxWriter::append_xml_escaped(out, value);
+    out.append("</t></is>");
+}
+
+void append_row(std::string& out, const RowSelection& rows, const std::vector<ColumnPlan>& plans,
+                size_t row, size_t sheet_row) {
+    std::string row_number = std::to_string(sheet_row);
+    out.append("<row r=\"").append(row_number).append("\">");
+
+    for (size_t column = 0; column < plans.size(); ++column) {
+        const std::string& value = rows.value(row, column);
+        if (value.empty()) {
+            continue;   // Empty cells are simply omitted
+        }
+
+        const ColumnPlan& plan = plans[column];
+        out.append("<c r=\"").append(plan.name).append(row_number);
+        switch (plan.kind) {
+            case CellKind::NUMBER:
+                out.append("\"><v>").append(value).append("</v></c>");
+                break;
+            case CellKind::SHARED_STRING:
+                out.append("\" t=\"s\"><v>").append(std::to_string(plan.codes[row])).append("</v></c>");
+                break;
+            case CellKind::INLINE_STRING:
+                out.append("\" t=\"inlineStr\">");
+                append_inline_string(out, value);
+                out.append("</c>");
+                break;
+        }
+    }
+    out.append("</row>");
+}
+
+bool write_part(ZipWriter& zip, const std::string& name, const std::string& content) {
+    return zip.begin_entry(name) && zip.write(content) && zip.end_entry();
+}
+
+bool write_package_parts(ZipWriter& zip, size_t sheet_count, bool has_shared_strings) {
+    std::string content_types = kXmlDeclaration;
+    content_types.append("<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+                         "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+                         "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+                         "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>");
+    for (size_t sheet = 1; sheet <= sheet_count; ++sheet) {
+        content_types.append("<Override PartName=\"/xl/worksheets/sheet" + std::to_string(sheet) +
+                             ".xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>");
+    }
+    if (has_shared_strings) {
+        content_types.append("<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>");
+    }
+    content_types.append("</Types>");
+
+    std::string package_rels = kXmlDeclaration;
+    package_rels.append("<Relationships xmlns=\"").append(kRelationshipsNamespace).append("\">"
+                        "<Relationship Id=\"rId1\" Type=\"").append(kOfficeRelationships).append("/officeDocument\" Target=\"xl/workbook.xml\"/>"
+                        "</Relationships>");
+
+    std::string workbook = kXmlDeclaration;
+    workbook.append("<workbook xmlns=\"").append(kSpreadsheetNamespace)
+            .append("\" xmlns:r=\"").append(kOfficeRelationships).append("\"><sheets>");
+    std::string workbook_rels = kXmlDeclaration;
+    workbook_rels.append("<Relationships xmlns=\"").append(kRelationshipsNamespace).append("\">");
+
+    for (size_t sheet = 1; sheet <= sheet_count; ++sheet) {
+        std::string id = std::to_string(sheet);
+        workbook.append("<sheet name=\"Sheet" + id + "\" sheetId=\"" + id + "\" r:id=\"rId" + id + "\"/>");
+        workbook_rels.append("<Relationship Id=\"rId" + id + "\" Type=\"").append(kOfficeRelationships)
+                     .append("/worksheet\" Target=\"worksheets/sheet" + id + ".xml\"/>");
+    }
+    if (has_shared_strings) {
+        workbook_rels.append("<Relationship Id=\"rId" + std::to_string(sheet_count + 1) + "\" Type=\"")
+                     .append(kOfficeRelationships).append("/sharedStrings\" Target=\"sharedStrings.xml\"/>");
+    }
+    workbook.append("</sheets></workbook>");
+    workbook_rels.append("</Relationships>");
+
+    return write_part(zip, "[Content_Types].xml", content_types) &&
+           write_part(zip, "_rels/.rels", package_rels) &&
+           write_part(zip, "xl/workbook.xml", workbook) &&
+           write_part(zip, "xl/_rels/workbook.xml.rels", workbook_rels);
+}
+
+bool write_shared_strings(ZipWriter& zip, const std::vector<std::string_view>& values, size_t reference_count) {
+    if (!zip.begin_entry("xl/sharedStrings.xml")) {
+        return false;
+    }
+
+    std::string out = kXmlDeclaration;
+    out.append("<sst xmlns=\"").append(kSpreadsheetNamespace).append("\" count=\"")
+       .append(std::to_string(reference_count)).append("\" uniqueCount=\"")
+       .append(std::to_string(values.size())).append("\">");
+
+    for (std::string_view view : values) {
+        std::string value(view);
+        out.append(needs_space_preserve(value) ? "<si><t xml:space=\"preserve\">" : "<si><t>");
+        XlsxWriter::append_xml_escaped(out, value);
+        out.append("</t></si>");
+        if (out.size() >= kFlushThreshold) {
+            if (!zip.write(out)) return false;
+            out.clear();
+        }
+    }
+    out.append("</sst>");
+
+    return zip.write(out) && zip.end_entry();
+}
+
+} // namespace
+
+bool XlsxWriter::write_xlsx(const QueryResult& result,
+                            const std::filesystem::path& output_path,
+                            size_t rows_per_sheet,
+                            size_t chunk_rows) {
+    return write_impl(result, nullptr, output_path, rows_per_sheet, chunk_rows);
+}
+
+bool XlsxWriter::write_xlsx_rows(const QueryResult& result,
+                                 const std::vector<size_t>& row_indices,
+                                 const std::filesystem::path& output_path) {
+    return write_impl(result, &row_indices, output_path, kMaxRowsPerSheet, kDefaultChunkRows);
+}
+
+std::string XlsxWriter::column_name(size_t index) {
+    std::string name;
+    for (size_t n = index + 1; n > 0; n = (n - 1) / 26) {
+        name.insert(name.begin(), static_cast<char>('A' + (n - 1) % 26));
+    }
+    return name;
+}
+
+void XlsxWriter::append_xml_escaped(std::string& out, const std::string& value) {
+    size_t run_start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        const char* replacement;
+        switch (c) {
+            case '&': replacement = "&amp;"; break;
+            case '<': replacement = "&lt;"; break;
+            case '>': replacement = "&gt;"; break;
+            case '\r': replacement = "&#13;"; break;    // Kept, parsers would normalize a raw CR
+            case '\t':
+            case '\n':
+                continue;
+            default:
+                if (c >= 0x20) continue;
+                replacement = "";                       // Not representable in XML 1.0
+        }
+        out.append(value, run_start, i - run_start);
+        out.append(replacement);
+        run_start = i + 1;
+    }
+    out.append(value, run_start, std::string::npos);
+}
+
+bool XlsxWriter::write_impl(const QueryResult& result,
+                            const std::vector<size_t>* row_indices,
+                            const std::filesystem::path& output_path,
+                            size_t rows_per_sheet,
+                            size_t chunk_rows) {
+    size_t column_count = result.headers.size();
+    if (column_count > kMaxColumns) {
+        std::cerr << "Error: " << column_count << " columns exceed Excel's limit of "
+                  << kMaxColumns << std::endl;
+        return false;
+    }
+
+    ZipWriter zip(output_path);
+    if (!zip.is_open()) {
+        return false;
+    }
+
+    RowSelection rows{result, row_indices};
+    size_t row_count = rows.size();
+    rows_per_sheet = std::max<size_t>(1, rows_per_sheet);
+    chunk_rows = std::max<size_t>(1, chunk_rows);
+
+    // Plan every column independently on a small pool of threads
+    std::vector<ColumnPlan> plans(column_count);
+    std::atomic<size_t> next_column{0};
+    size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t worker_count = std::min(column_count, hardware_threads);
+    std::vector<std::future<void>> workers;
+
+    for (size_t w = 0; w < worker_count; ++w) {
+        workers.push_back(std::async(std::launch::async, [&]() {
+            size_t column;
+            while ((column = next_column.fetch_add(1)) < column_count) {
+                plans[column].name = column_name(column);
+                plan_column(rows, column, plans[column]);
+            }
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    // Merge the column dictionaries into one shared-strings table
+    std::unordered_map<std::string_view, uint32_t> shared_index;
+    std::vector<std::string_view> shared_values;
+    size_t shared_references = 0;
+
+    for (auto& plan : plans) {
+        if (plan.kind != CellKind::SHARED_STRING) continue;
+
+        std::vector<uint32_t> remap(plan.dictionary.size());
+        for (size_t i = 0; i < plan.dictionary.size(); ++i) {
+            auto it = shared_index.emplace(plan.dictionary[i], static_cast<uint32_t>(shared_values.size()));
+            if (it.second) {
+                shared_values.push_back(plan.dictionary[i]);
+            }
+            remap[i] = it.first->second;
+        }
+        for (size_t row = 0; row < plan.codes.size(); ++row) {
+            if (!plan.dictionary[plan.codes[row]].empty()) shared_references++;
+            plan.codes[row] = remap[plan.codes[row]];
+        }
+    }
+
+    uint64_t shared_bytes = MemoryAccounting::hash_table_bytes(shared_index) +
+                            shared_values.capacity() * sizeof(std::string_view);
+    for (const auto& plan : plans) {
+        shared_bytes += plan.codes.capacity() * sizeof(uint32_t) +
+                        plan.dictionary.capacity() * sizeof(std::string_view);
+    }
+    MemoryCharge shared_charge(MemoryCategory::HASH_TABLE, "xlsx shared strings", shared_bytes);
+
+    size_t sheet_count = std::max<size_t>(1, (row_count + rows_per_sheet - 1) / rows_per_sheet);
+    bool has_shared_strings = !shared_values.empty();
+    if (!write_package_parts(zip, sheet_count, has_shared_strings)) {
+        return false;
+    }
+
+    std::string header_row = "<row r=\"1\">";
+    for (size_t column = 0; column < column_count; ++column) {
+        header_row.append("<c r=\"").append(plans[column].name).append("1\" t=\"inlineStr\">");
+        append_inline_string(header_row, result.headers[column]);
+        header_row.append("</c>");
+    }
+    header_row.append("</row>");
+
+    for (size_t sheet = 0; sheet < sheet_count; ++sheet) {
+        size_t sheet_begin = sheet * rows_per_sheet;
+        size_t sheet_end = std::min(row_count, sheet_begin + rows_per_sheet);
+
+        std::string prologue = kXmlDeclaration;
+        prologue.append("<worksheet xmlns=\"").append(kSpreadsheetNamespace).append("\"><sheetData>");
+        prologue.append(header_row);
+        if (!zip.begin_entry("xl/worksheets/sheet" + std::to_string(sheet + 1) + ".xml") ||
+            !zip.write(prologue)) {
+            return false;
+        }
+
+        // Serialize one wave of row chunks per worker, then stream them into the archive in order
+        size_t chunk_count = (sheet_end - sheet_begin + chunk_rows - 1) / chunk_rows;
+        for (size_t wave_start = 0; wave_start < chunk_count; wave_start += hardware_threads) {
+            size_t wave_end = std::min(chunk_count, wave_start + hardware_threads);
+            std::vector<std::future<std::pair<std::string, MemoryCharge>>> chunks;
+
+            for (size_t chunk = wave_start; chunk < wave_end; ++chunk) {
+                chunks.push_back(std::async(std::launch::async, [&, chunk]() {
+                    TraceSpan span("write", "serialize sheet chunk");
+                    size_t begin = sheet_begin + chunk * chunk_rows;
+                    size_t end = std::min(sheet_end, begin + chunk_rows);
+
+                    std::string out;
+                    out.reserve((end - begin) * (column_count * 24 + 16));
+                    for (size_t row = begin; row < end; ++row) {
+                        // Sheet rows are 1-based and row 1 holds the headers
+                        append_row(out, rows, plans, row, row - sheet_begin + 2);
+                    }
+                    MemoryCharge charge(MemoryCategory::BUFFER, "xlsx sheet chunks", out.capacity());
+                    return std::make_pair(std::move(out), std::move(charge));
+                }));
+            }
+
+            for (auto& chunk : chunks) {
+                if (!zip.write(chunk.get().first)) {
+                    return false;
+                }
+            }
+        }
+
+        if (!zip.write("</sheetData></worksheet>") || !zip.end_entry()) {
+            return false;
+        }
+    }
+
+    if (has_shared_strings && !write_shared_strings(zip, shared_values, shared_references)) {
+        return false;
+    }
+
+    return zip.finish();
+}
@@ -0,0 +1,216 @@
+#include "zip_writer.h"
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+constexpr uint32_t kLocalHeaderSignature = 0x04034b50;
+constexpr uint32_t kCentralHeaderSignature = 0x02014b50;
+constexpr uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+constexpr uint16_t kVersionNeeded = 20;
+constexpr uint16_t kMethodStored = 0;
+constexpr uint64_t kMaxOffset = std::numeric_limits<uint32_t>::max();
+
+// Entries carry a fixed timestamp (1980-01-01 00:00) so identical results give identical archives
+constexpr uint16_t kDosTime = 0;
+constexpr uint16_t kDosDate = (1 << 5) | 1;
+
+// Offset of the CRC field inside a local file header
+constexpr std::streamoff kLocalHeaderCrcOffset = 14;
+
+void put_u16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void put_u32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+// Slicing-by-8 tables: table[0] is the classic byte table, table[k] advances k extra zero bytes
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+CrcTables build_crc_tables() {
+    CrcTables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (size_t k = 1; k < 8; ++k) {
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+} // namespace
+
+ZipWriter::ZipWriter(const std::filesystem::path& path)
+    : file_(path, std::ios::binary) {}
+
+bool ZipWriter::is_open() const {
+    return file_.is_open();
+}
+
+bool ZipWriter::begin_entry(const std::string& name) {
+    if (!ok_ || in_entry_ || finished_) {
+        return false;
+    }
+
+    Entry entry;
+    entry.name = name;
+    entry.header_offset = static_cast<uint64_t>(file_.tellp());
+    if (entry.header_offset > kMaxOffset) {
+        std::cerr << "Error: XLSX archive exceeds 4 GB" << std::endl;
+        ok_ = false;
+        return false;
+    }
+
+    std::string header;
+    put_u32(header, kLocalHeaderSignature);
+    put_u16(header, kVersionNeeded);
+    put_u16(header, 0);                 // Flags
+    put_u16(header, kMethodStored);
+    put_u16(header, kDosTime);
+    put_u16(header, kDosDate);
+    put_u32(header, 0);                 // CRC, patched by end_entry
+    put_u32(header, 0);                 // Compressed size, patched by end_entry
+    put_u32(header, 0);                 // Uncompressed size, patched by end_entry
+    put_u16(header, static_cast<uint16_t>(name.size()));
+    put_u16(header, 0);                 // Extra field length
+    header.append(name);
+
+    entries_.push_back(std::move(entry));
+    in_entry_ = true;
+    ok_ = static_cast<bool>(file_.write(header.data(), static_cast<std::streamsize>(header.size())));
+    return ok_;
+}
+
+bool ZipWriter::write(const char* data, size_t length) {
+    if (!ok_ || !in_entry_) {
+        return false;
+    }
+
+    Entry& entry = entries_.back();
+    entry.crc = crc32(entry.crc, data, length);
+    entry.size += length;
+    if (entry.size > kMaxOffset) {
+        std::cerr << "Error: XLSX entry " << entry.name << " exceeds 4 GB" << std::endl;
+        ok_ = false;
+        return false;
+    }
+
+    ok_ = static_cast<bool>(file_.write(data, static_cast<std::streamsize>(length)));
+    return ok_;
+}
+
+bool ZipWriter::write(const std::string& data) {
+    return write(data.data(), data.size());
+}
+
+bool ZipWriter::end_entry() {
+    if (!ok_ || !in_entry_) {
+        return false;
+    }
+    in_entry_ = false;
+
+    const Entry& entry = entries_.back();
+    std::string fields;
+    put_u32(fields, entry.crc);
+    put_u32(fields, static_cast<uint32_t>(entry.size));
+    put_u32(fields, static_cast<uint32_t>(entry.size));
+
+    // Stored entries have no data descriptor, so patch the sizes into the local header
+    std::streampos end = file_.tellp();
+    file_.seekp(static_cast<std::streamoff>(entry.header_offset) + kLocalHeaderCrcOffset);
+    file_.write(fields.data(), static_cast<std::streamsize>(fields.size()));
+    file_.seekp(end);
+
+    ok_ = file_.good();
+    return ok_;
+}
+
+bool ZipWriter::finish() {
+    if (!ok_ || in_entry_ || finished_) {
+        return false;
+    }
+    finished_ = true;
+
+    uint64_t directory_offset = static_cast<uint64_t>(file_.tellp());
+    std::string directory;
+    for (const auto& entry : entries_) {
+        put_u32(directory, kCentralHeaderSignature);
+        put_u16(directory, kVersionNeeded); // Version made by
+        put_u16(directory, kVersionNeeded);
+        put_u16(directory, 0);              // Flags
+        put_u16(directory, kMethodStored);
+        put_u16(directory, kDosTime);
+        put_u16(directory, kDosDate);
+        put_u32(directory, entry.crc);
+        put_u32(directory, static_cast<uint32_t>(entry.size));
+        put_u32(directory, static_cast<uint32_t>(entry.size));
+        put_u16(directory, static_cast<uint16_t>(entry.name.size()));
+        put_u16(directory, 0);              // Extra field length
+        put_u16(directory, 0);              // Comment length
+        put_u16(directory, 0);              // Disk number
+        put_u16(directory, 0);              // Internal attributes
+        put_u32(directory, 0);              // External attributes
+        put_u32(directory, static_cast<uint32_t>(entry.header_offset));
+        directory.append(entry.name);
+    }
+
+    uint64_t directory_size = directory.size();
+    if (directory_offset + directory_size > kMaxOffset) {
+        std::cerr << "Error: XLSX archive exceeds 4 GB" << std::endl;
+        ok_ = false;
+        return false;
+    }
+
+    put_u32(directory, kEndOfCentralDirectorySignature);
+    put_u16(directory, 0);                  // Disk number
+    put_u16(directory, 0);                  // Disk with central directory
+    put_u16(directory, static_cast<uint16_t>(entries_.size()));
+    put_u16(directory, static_cast<uint16_t>(entries_.size()));
+    put_u32(directory, static_cast<uint32_t>(directory_size));
+    put_u32(directory, static_cast<uint32_t>(directory_offset));
+    put_u16(directory, 0);                  // Comment length
+
+    file_.write(directory.data(), static_cast<std::streamsize>(directory.size()));
+    file_.flush();
+    ok_ = file_.good();
+    return ok_;
+}
+
+uint32_t ZipWriter::crc32(uint32_t crc, const char* data, size_t length) {
+    static const CrcTables tables = build_crc_tables();
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    crc = ~crc;
+
+    // Fold eight bytes per step (little-endian word loads)
+    while (length >= 8) {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, bytes, 4);
+        std::memcpy(&high, bytes + 4, 4);
+        low ^= crc;
+        crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^
+              tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+              tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^
+              tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+        bytes += 8;
+        length -= 8;
+    }
+
+    while (length--) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *bytes++) & 0xFF];
+    }
+    return ~crc;
+}
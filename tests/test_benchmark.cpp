@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "benchmark.h"
+#include "benchmark_compare.h"
+
+TEST(BenchmarkTest, QuantileOfEmptySamplesIsZero) {
+    EXPECT_DOUBLE_EQ(BenchmarkRunner::quantile({}, 0.5), 0.0);
+}
+
+TEST(BenchmarkTest, MedianAveragesMiddlePairForEvenCounts) {
+    EXPECT_DOUBLE_EQ(BenchmarkRunner::quantile({40.0, 10.0, 30.0, 20.0}, 0.5), 25.0);
+    EXPECT_DOUBLE_EQ(BenchmarkRunner::quantile({30.0, 10.0, 20.0}, 0.5), 20.0);
+}
+
+TEST(BenchmarkTest, P95UsesNearestRank) {
+    std::vector<double> samples;
+    for (int i = 1; i <= 20; ++i) {
+        samples.push_back(static_cast<double>(i));
+    }
+    EXPECT_DOUBLE_EQ(BenchmarkRunner::quantile(samples, 0.95), 19.0);
+    EXPECT_DOUBLE_EQ(BenchmarkRunner::quantile({5.0, 1.0}, 0.95), 5.0);
+}
+
+TEST(BenchmarkTest, RunsWarmupAndRepetitions) {
+    BenchmarkOptions options;
+    options.warmup = 2;
+    options.repetitions = 5;
+    BenchmarkRunner runner(options);
+
+    int calls = 0;
+    const BenchmarkResult* result = runner.run("case/a", 100, 0, [&]() { calls++; });
+
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(calls, 7);
+    EXPECT_EQ(result->samples_ns.size(), 5u);
+    EXPECT_GE(result->p95_ns(), result->median_ns());
+    EXPECT_GE(result->median_ns(), result->min_ns());
+}
+
+TEST(BenchmarkTest, FilterSkipsUnmatchedCases) {
+    BenchmarkOptions options;
+    options.warmup = 0;
+    options.repetitions = 1;
+    options.filter = "query/";
+    BenchmarkRunner runner(options);
+
+    int calls = 0;
+    EXPECT_EQ(runner.run("psv/parse_data", 1, 0, [&]() { calls++; }), nullptr);
+    EXPECT_NE(runner.run("query/join", 1, 0, [&]() { calls++; }), nullptr);
+    EXPECT_EQ(calls, 1);
+    EXPECT_FALSE(runner.selected("csv/escape_csv_field"));
+    EXPECT_EQ(runner.results().size(), 1u);
+}
+
+TEST(BenchmarkTest, JsonContainsSamplesAndSummary) {
+    BenchmarkOptions options;
+    options.warmup = 0;
+    options.repetitions = 3;
+    BenchmarkRunner runner(options);
+    runner.run("csv/escape_csv_field", 10, 80, []() {});
+
+    std::string json = runner.to_json(0.5);
+    EXPECT_NE(json.find("\"scale\": 0.5"), std::string::npos);
+    EXPECT_NE(json.find("\"repetitions\": 3"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\": \"csv/escape_csv_field\", \"items\": 10, \"bytes\": 80, \"median_ns\": "),
+              std::string::npos);
+    EXPECT_NE(json.find("\"p95_ns\": "), std::string::npos);
+    EXPECT_NE(json.find("\"samples_ns\": ["), std::string::npos);
+}
+
+namespace {
+
+BenchmarkReport makeReport(const std::string& name, const std::vector<double>& samples) {
+    BenchmarkReport report;
+    report.scale = 1.0;
+    BenchmarkResult result;
+    result.name = name;
+    result.items = 1000;
+    result.samples_ns = samples;
+    report.results.push_back(result);
+    return report;
+}
+
+} // namespace
+
+TEST(BenchmarkCompareTest, ParsesRunnerJson) {
+    BenchmarkOptions options;
+    options.warmup = 0;
+    options.repetitions = 4;
+    BenchmarkRunner runner(options);
+    runner.run("query/join", 50, 0, []() {});
+
+    BenchmarkReport report;
+    std::string error;
+    ASSERT_TRUE(BenchmarkComparator::parse_report(runner.to_json(0.05), report, error)) << error;
+    EXPECT_DOUBLE_EQ(report.scale, 0.05);
+    ASSERT_EQ(report.results.size(), 1u);
+    EXPECT_EQ(report.results[0].name, "query/join");
+    EXPECT_EQ(report.results[0].items, 50u);
+    EXPECT_EQ(report.results[0].samples_ns.size(), 4u);
+}
+
+TEST(BenchmarkCompareTest, RejectsMalformedJson) {
+    BenchmarkReport report;
+    std::string error;
+    EXPECT_FALSE(BenchmarkComparator::parse_report("{\"results\": [", report, error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(BenchmarkComparator::parse_report("{\"scale\": 1}", report, error));
+}
+
+TEST(BenchmarkCompareTest, MannWhitneyExactForSeparatedSamples) {
+    std::vector<double> low = {1, 2, 3, 4, 5};
+    std::vector<double> high = {6, 7, 8, 9, 10};
+
+    // Only 1 of C(10, 5) = 252 orderings puts every high sample above every low one
+    EXPECT_NEAR(BenchmarkComparator::mann_whitney_greater(high, low), 1.0 / 252.0, 1e-12);
+    EXPECT_DOUBLE_EQ(BenchmarkComparator::mann_whitney_greater(low, high), 1.0);
+}
+
+TEST(BenchmarkCompareTest, MannWhitneyInterleavedIsNotSignificant) {
+    std::vector<double> a = {1, 3, 5, 7, 9, 11};
+    std::vector<double> b = {2, 4, 6, 8, 10, 12};
+    EXPECT_GT(BenchmarkComparator::mann_whitney_greater(a, b), 0.3);
+    EXPECT_GT(BenchmarkComparator::mann_whitney_greater(b, a), 0.3);
+
+    // Ties fall back to the normal approximation
+    std::vector<double> tied = {5, 5, 5, 5};
+    EXPECT_GT(BenchmarkComparator::mann_whitney_greater(tied, tied), 0.4);
+}
+
+TEST(BenchmarkCompareTest, FlagsSignificantSlowdownBeyondThreshold) {
+    auto baseline = makeReport("psv/parse_data", {100, 101, 99, 100, 102, 98, 100, 101});
+    auto current = makeReport("psv/parse_data", {120, 121, 119, 122, 118, 120, 121, 119});
+
+    auto comparisons = BenchmarkComparator::compare(baseline, current, CompareOptions{});
+    ASSERT_EQ(comparisons.size(), 1u);
+    EXPECT_EQ(comparisons[0].verdict, CaseComparison::Verdict::REGRESSED);
+    EXPECT_NEAR(comparisons[0].throughput_change, 100.0 / 120.0 - 1.0, 1e-9);
+    EXPECT_LT(comparisons[0].p_slower, 0.01);
+
+    // The same runs in the other direction are an improvement
+    auto reversed = BenchmarkComparator::compare(current, baseline, CompareOptions{});
+    EXPECT_EQ(reversed[0].verdict, CaseComparison::Verdict::IMPROVED);
+}
+
+TEST(BenchmarkCompareTest, IgnoresSlowdownWithinThresholdOrNoise) {
+    auto baseline = makeReport("csv/escape_csv_field", {100, 101, 99, 100, 102, 98});
+    auto slightly_slower = makeReport("csv/escape_csv_field", {103, 104, 102, 103, 105, 101});
+    EXPECT_EQ(BenchmarkComparator::compare(baseline, slightly_slower, CompareOptions{})[0].verdict,
+              CaseComparison::Verdict::UNCHANGED);
+
+    // Median 20% slower, but the samples overlap too much to be significant
+    auto noisy = makeReport("csv/escape_csv_field", {60, 140, 95, 130, 70, 150});
+    EXPECT_EQ(BenchmarkComparator::compare(baseline, noisy, CompareOptions{})[0].verdict,
+              CaseComparison::Verdict::UNCHANGED);
+}
+
+TEST(BenchmarkCompareTest, ReportsMissingCases) {
+    auto baseline = makeReport("query/union_tables", {100, 100, 100, 100});
+    auto current = makeReport("query/select_where", {100, 100, 100, 100});
+
+    auto comparisons = BenchmarkComparator::compare(baseline, current, CompareOptions{});
+    ASSERT_EQ(comparisons.size(), 1u);
+    EXPECT_EQ(comparisons[0].verdict, CaseComparison::Verdict::MISSING);
+}
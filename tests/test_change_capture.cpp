@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include "change_capture.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+class ChangeCaptureTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "change_capture_tests";
+        std::filesystem::create_directories(test_dir);
+        fingerprints = test_dir / "employees_Fingerprints.apfp";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir);
+    }
+
+    using Rows = std::vector<std::vector<std::string>>;
+
+    // Run one diff: classify every row, collect deletes and save the fingerprints
+    std::string runDiff(const Rows& rows, const std::vector<std::string>& key, Rows* deleted = nullptr,
+                        ChangeCounts* counts = nullptr) {
+        ChangeCapture capture(fingerprints, headers, key);
+        std::string operations;
+        for (const auto& row : rows) {
+            char operation = capture.classify(row);
+            operations += operation ? operation : '-';
+        }
+        Rows gone = capture.deleted_rows();
+        if (deleted) {
+            *deleted = gone;
+        }
+        if (counts) {
+            *counts = capture.counts();
+        }
+        EXPECT_TRUE(capture.save());
+        return operations;
+    }
+
+    std::vector<std::string> headers = {"id", "name", "salary"};
+    std::filesystem::path test_dir;
+    std::filesystem::path fingerprints;
+};
+
+TEST_F(ChangeCaptureTest, FirstRunInsertsEveryRow) {
+    ChangeCounts counts;
+    EXPECT_EQ(runDiff({{"1", "Ann", "10"}, {"2", "Bob", "20"}}, {"id"}, nullptr, &counts), "II");
+    EXPECT_EQ(counts.inserted, 2u);
+    EXPECT_TRUE(std::filesystem::exists(fingerprints));
+    EXPECT_FALSE(std::filesystem::exists(fingerprints.string() + ".tmp"));
+}
+
+TEST_F(ChangeCaptureTest, KeyedDiffFindsInsertsUpdatesAndDeletes) {
+    runDiff({{"1", "Ann", "10"}, {"2", "Bob", "20"}, {"3", "Cid", "30"}}, {"id"});
+
+    Rows deleted;
+    ChangeCounts counts;
+    std::string operations = runDiff({{"3", "Cid", "30"}, {"1", "Ann", "15"}, {"4", "Dee", "40"}}, {"id"},
+                                     &deleted, &counts);
+
+    EXPECT_EQ(operations, "-UI");
+    ASSERT_EQ(deleted.size(), 1u);
+    EXPECT_EQ(deleted[0], (std::vector<std::string>{"2", "", ""}));
+    EXPECT_EQ(counts.inserted, 1u);
+    EXPECT_EQ(counts.updated, 1u);
+    EXPECT_EQ(counts.deleted, 1u);
+    EXPECT_EQ(counts.unchanged, 1u);
+
+    // The second run's rows are now the baseline
+    EXPECT_EQ(runDiff({{"1", "Ann", "15"}, {"3", "Cid", "30"}, {"4", "Dee", "40"}}, {"id"}), "---");
+}
+
+TEST_F(ChangeCaptureTest, WholeRowDiffShowsChangesAsDeleteAndInsert) {
+    runDiff({{"1", "Ann", "10"}, {"1", "Ann", "10"}, {"2", "Bob", "20"}}, {});
+
+    Rows deleted;
+    // One of two identical rows went away, and Bob's salary changed
+    EXPECT_EQ(runDiff({{"1", "Ann", "10"}, {"2", "Bob", "25"}}, {}, &deleted), "-I");
+    // Only hashes are kept without a key, so deleted rows carry no values
+    ASSERT_EQ(deleted.size(), 2u);
+    EXPECT_EQ(deleted[0], (std::vector<std::string>{"", "", ""}));
+    EXPECT_EQ(deleted[1], (std::vector<std::string>{"", "", ""}));
+    EXPECT_EQ(std::filesystem::file_size(fingerprints), 32u + 2 * ChangeCapture::kEntryBytes);
+}
+
+TEST_F(ChangeCaptureTest, ManyRowsMatchThroughTheDirectory) {
+    Rows rows;
+    for (int i = 0; i < 20000; ++i) {
+        rows.push_back({std::to_string(i), "name" + std::to_string(i % 97), std::to_string(i * 3)});
+    }
+    runDiff(rows, {"id"});
+
+    rows[10].back() = "changed";
+    rows.erase(rows.begin() + 500);
+    rows.push_back({"new", "x", "1"});
+    ChangeCounts counts;
+    runDiff(rows, {"id"}, nullptr, &counts);
+
+    EXPECT_EQ(counts.unchanged, 19998u);
+    EXPECT_EQ(counts.updated, 1u);
+    EXPECT_EQ(counts.inserted, 1u);
+    EXPECT_EQ(counts.deleted, 1u);
+}
+
+TEST_F(ChangeCaptureTest, BatchesClassifyLikeSingleRows) {
+    Rows rows;
+    for (int i = 0; i < 1000; ++i) {
+        rows.push_back({std::to_string(i % 700), "name", std::to_string(i)});
+    }
+    runDiff(rows, {"id"});
+    for (size_t i = 0; i < rows.size(); i += 7) {
+        rows[i][2] = "raised";
+    }
+    rows.resize(900);
+
+    std::string one_by_one;
+    {
+        ChangeCapture capture(fingerprints, headers, {"id"});
+        for (const auto& row : rows) {
+            char operation = capture.classify(row);
+            one_by_one += operation ? operation : '-';
+        }
+    }
+    ChangeCapture capture(fingerprints, headers, {"id"});
+    std::string batched;
+    capture.classify(rows, batched);
+    for (char& operation : batched) {
+        operation = operation ? operation : '-';
+    }
+
+    EXPECT_EQ(batched, one_by_one);
+    EXPECT_EQ(capture.counts().updated, 129u);
+    EXPECT_EQ(capture.deleted_rows().size(), 100u);
+}
+
+TEST_F(ChangeCaptureTest, OtherColumnsOrKeysStartOver) {
+    runDiff({{"1", "Ann", "10"}}, {"id"});
+
+    ChangeCapture other_key(fingerprints, headers, {"name"});
+    EXPECT_FALSE(other_key.has_previous());
+
+    headers.push_back("bonus");
+    ChangeCapture other_headers(fingerprints, headers, {"id"});
+    EXPECT_FALSE(other_headers.has_previous());
+    EXPECT_EQ(other_headers.classify({"1", "Ann", "10", ""}), ChangeCapture::kInsert);
+}
+
+TEST_F(ChangeCaptureTest, RejectsUnknownKeys) {
+    EXPECT_THROW(ChangeCapture(fingerprints, headers, {"missing"}), std::invalid_argument);
+}
+
+TEST_F(ChangeCaptureTest, CorruptFilesStartOverAndAreReplaced) {
+    std::ofstream(fingerprints) << "not a fingerprint file";
+    {
+        ChangeCapture capture(fingerprints, headers, {"id"});
+        EXPECT_TRUE(capture.previous_damaged());
+        EXPECT_FALSE(capture.has_previous());
+    }
+    EXPECT_EQ(runDiff({{"1", "Ann", "10"}, {"2", "Bob", "20"}}, {"id"}), "II");
+    EXPECT_EQ(runDiff({{"1", "Ann", "10"}}, {"id"}), "-");
+
+    // A key offset pointing past the stored key values is caught on load
+    {
+        std::fstream file(fingerprints, std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t offset = 1000;
+        file.seekp(32 + 2 * sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+    ChangeCapture capture(fingerprints, headers, {"id"});
+    EXPECT_TRUE(capture.previous_damaged());
+    EXPECT_TRUE(capture.deleted_rows().empty());
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+TEST_F(ChangeCaptureTest, FailedWriteKeepsThePreviousFingerprints) {
+    runDiff({{"1", "Ann", "10"}}, {"id"});
+    auto previous_size = std::filesystem::file_size(fingerprints);
+
+    // Writes to /dev/full fail with ENOSPC only once the buffer is flushed
+    if (!std::filesystem::exists("/dev/full")) {
+        return;
+    }
+    std::filesystem::create_symlink("/dev/full", fingerprints.string() + ".tmp");
+    ChangeCapture capture(fingerprints, headers, {"id"});
+    capture.classify({"1", "Ann", "10"});
+    capture.classify({"2", "Bob", "20"});
+    EXPECT_FALSE(capture.save());
+
+    EXPECT_FALSE(std::filesystem::is_symlink(fingerprints));
+    EXPECT_EQ(std::filesystem::file_size(fingerprints), previous_size);
+    EXPECT_EQ(runDiff({{"1", "Ann", "10"}}, {"id"}), "-");
+}
+#endif
+
+TEST_F(ChangeCaptureTest, HashSeparatesFieldBoundaries) {
+    std::vector<size_t> both = {0, 1};
+    EXPECT_NE(ChangeCapture::hash_columns({"ab", "c"}, both), ChangeCapture::hash_columns({"a", "bc"}, both));
+    EXPECT_EQ(ChangeCapture::hash_columns({"x"}, both), ChangeCapture::hash_columns({"x", ""}, both));
+    EXPECT_EQ(ChangeCapture::fingerprint_path_for("/out/employees.csv"),
+              std::filesystem::path("/out/employees_Fingerprints.apfp"));
+}
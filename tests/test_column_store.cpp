@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+#include "column_store.h"
+#include "columnar_writer.h"
+#include "csv_writer.h"
+#include "database.h"
+#include "query_engine.h"
+#include "table_loader.h"
+#include <filesystem>
+#include <fstream>
+
+class ColumnStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "column_store_tests";
+        store_dir = test_dir / "store";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    void createFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream file(path);
+        file << content;
+        file.close();
+    }
+
+    FileInfo createInput(const std::string& name, const std::string& data) {
+        createFile(test_dir / (name + ".psv"), data);
+        createFile(test_dir / (name + "_Headers.psv"), "id|name|salary");
+
+        FileInfo info;
+        info.path = test_dir / (name + ".psv");
+        info.headers_path = test_dir / (name + "_Headers.psv");
+        info.size_bytes = std::filesystem::file_size(info.path);
+        info.name_prefix = name;
+        return info;
+    }
+
+    std::filesystem::path test_dir;
+    std::filesystem::path store_dir;
+};
+
+TEST_F(ColumnStoreTest, StoresOnFirstLoadAndMapsAfterwards) {
+    FileInfo input = createInput("employees", "1|John|75000\n2| Jane |\n3|Bob|085000\n");
+    ColumnStore store(store_dir);
+
+    auto parsed = store.load(input);
+    EXPECT_TRUE(store.contains(input));
+    auto mapped = store.load(input);
+
+    EXPECT_EQ(store.stats().misses, 1u);
+    EXPECT_EQ(store.stats().hits, 1u);
+    EXPECT_TRUE(std::filesystem::exists(store_dir / ColumnStore::kCatalogName));
+    EXPECT_EQ(mapped->name, "employees");
+    EXPECT_EQ(mapped->headers, parsed->headers);
+    // The mapped table reads its fields from the column file rather than holding records
+    EXPECT_TRUE(mapped->columns != nullptr);
+    EXPECT_TRUE(mapped->records.empty());
+    ASSERT_EQ(mapped->row_count(), 3u);
+    for (size_t row = 0; row < 3; ++row) {
+        for (const auto& header : parsed->headers) {
+            EXPECT_EQ(mapped->get_field(row, header), parsed->get_field(row, header));
+        }
+    }
+    // Values round-trip exactly; short rows come back padded to the headers
+    EXPECT_EQ(mapped->get_field(2, "salary"), "085000");
+    EXPECT_EQ(mapped->get_field(1, "salary"), "");
+}
+
+TEST_F(ColumnStoreTest, ChangedInputIsStoredAgain) {
+    FileInfo input = createInput("employees", "1|John|75000\n");
+    ColumnStore store(store_dir);
+    store.load(input);
+
+    input = createInput("employees", "1|John|75000\n2|Jane|65000\n");
+    std::filesystem::last_write_time(input.path, std::filesystem::last_write_time(input.path) +
+                                                 std::chrono::seconds(5));
+    EXPECT_FALSE(store.contains(input));
+    auto table = store.load(input);
+
+    EXPECT_EQ(table->row_count(), 2u);
+    EXPECT_EQ(store.stats().misses, 2u);
+    EXPECT_EQ(store.load(input)->row_count(), 2u);
+    EXPECT_EQ(store.stats().hits, 1u);
+}
+
+TEST_F(ColumnStoreTest, AnotherProcessSeesStoredTables) {
+    FileInfo employees = createInput("employees", "1|John|75000\n");
+    FileInfo contractors = createInput("contractors", "9|Zed|50000\n");
+    ColumnStore first(store_dir);
+    ColumnStore second(store_dir);
+    first.load(employees);
+    second.load(contractors);
+
+    // Each store adds to the catalog on disk rather than replacing it
+    ColumnStore third(store_dir);
+    EXPECT_TRUE(third.contains(employees));
+    EXPECT_TRUE(third.contains(contractors));
+    EXPECT_EQ(third.load(contractors)->get_field(0, "name"), "Zed");
+    EXPECT_EQ(third.stats().hits, 1u);
+}
+
+TEST_F(ColumnStoreTest, DamagedColumnFileIsParsedAgain) {
+    FileInfo input = createInput("employees", "1|John|75000\n");
+    {
+        ColumnStore store(store_dir);
+        store.load(input);
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(store_dir)) {
+        if (entry.path().extension() == ".apcol") {
+            createFile(entry.path(), "not columns");
+        }
+    }
+
+    ColumnStore store(store_dir);
+    auto table = store.load(input);
+
+    EXPECT_EQ(table->get_field(0, "name"), "John");
+    EXPECT_EQ(store.stats().misses, 1u);
+    EXPECT_EQ(store.load(input)->get_field(0, "name"), "John");
+    EXPECT_EQ(store.stats().hits, 1u);
+}
+
+TEST_F(ColumnStoreTest, InflatedRowCountIsParsedAgain) {
+    FileInfo input = createInput("employees", "1|John|75000\n2|Jane|65000\n");
+    {
+        ColumnStore store(store_dir);
+        store.load(input);
+    }
+    // A stored entry claiming more rows than its blocks hold must not be read past its end
+    for (const auto& entry : std::filesystem::directory_iterator(store_dir)) {
+        if (entry.path().extension() == ".apcol") {
+            std::fstream file(entry.path(), std::ios::in | std::ios::out | std::ios::binary);
+            uint64_t rows = 1000;
+            file.seekp(16);
+            file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        }
+    }
+
+    ColumnStore store(store_dir);
+    auto table = store.load(input);
+
+    EXPECT_EQ(store.stats().hits, 0u);
+    EXPECT_EQ(store.stats().misses, 1u);
+    ASSERT_EQ(table->row_count(), 2u);
+    EXPECT_EQ(table->get_field(1, "name"), "Jane");
+    EXPECT_EQ(store.load(input)->get_field(1, "salary"), "65000");
+    EXPECT_EQ(store.stats().hits, 1u);
+}
+
+TEST_F(ColumnStoreTest, TypedColumnFileIsStoredAgainAsStrings) {
+    FileInfo input = createInput("employees", "1|John|75000\n");
+    {
+        ColumnStore store(store_dir);
+        store.load(input);
+    }
+    // A column file with numeric columns, as an older store wrote it, cannot be viewed in place
+    for (const auto& entry : std::filesystem::directory_iterator(store_dir)) {
+        if (entry.path().extension() == ".apcol") {
+            QueryResult typed;
+            typed.headers = {"id", "name", "salary"};
+            typed.rows = {{"1", "John", "75000"}};
+            ASSERT_TRUE(ColumnarWriter::write_columnar(typed, entry.path()));
+        }
+    }
+
+    ColumnStore store(store_dir);
+    EXPECT_EQ(store.load(input)->get_field(0, "salary"), "75000");
+    EXPECT_EQ(store.stats().misses, 1u);
+    auto mapped = store.load(input);
+    EXPECT_EQ(store.stats().hits, 1u);
+    EXPECT_EQ(mapped->get_field(0, "id"), "1");
+}
+
+TEST_F(ColumnStoreTest, MappedPartitionsMerge) {
+    FileInfo january = createInput("2024-01", "1|John|75000\n");
+    FileInfo february = createInput("2024-02", "2|Jane|65000\n3|Bob|\n");
+    for (auto* input : {&january, &february}) {
+        input->table_name = "employees";
+        input->partition_values = {{"month", input->name_prefix}};
+    }
+    ColumnStore store(store_dir);
+    store.load(january);
+    store.load(february);
+
+    std::vector<std::unique_ptr<PsvTable>> parts;
+    parts.push_back(store.load(january));
+    parts.push_back(store.load(february));
+    auto table = TableLoader::merge_partitions(std::move(parts));
+
+    EXPECT_EQ(store.stats().hits, 2u);
+    ASSERT_EQ(table->row_count(), 3u);
+    EXPECT_EQ(table->get_field(0, "month"), "2024-01");
+    EXPECT_EQ(table->get_field(2, "name"), "Bob");
+    EXPECT_EQ(table->get_field(2, "month"), "2024-02");
+}
+
+TEST_F(ColumnStoreTest, MappedTablesServeQueriesAndProjections) {
+    FileInfo employees = createInput("employees", "1|John|75000\n2|Jane|65000\n3|Bob|85000\n");
+    FileInfo managers = createInput("managers", "2|Ann|1\n3|Cid|1\n");
+    ColumnStore store(store_dir);
+    store.load(employees);
+    store.load(managers);
+
+    Database database;
+    database.load_table(store.load(employees));
+    database.load_table(store.load(managers));
+    ASSERT_TRUE(database.get_table("employees")->columns != nullptr);
+    EXPECT_EQ(database.get_total_records(), 5u);
+
+    QueryEngine engine(database);
+    auto high = engine.select_matching("employees", {"name"}, [](const PsvTable& table, size_t row) {
+        return table.field(row, 2) > "70000";
+    });
+    ASSERT_NE(high, nullptr);
+    EXPECT_EQ(high->rows, (std::vector<std::vector<std::string>>{{"John"}, {"Bob"}}));
+
+    auto joined = engine.join("employees", "managers", "employees.id = managers.id");
+    ASSERT_NE(joined, nullptr);
+    ASSERT_EQ(joined->rows.size(), 2u);
+    EXPECT_EQ(joined->rows[0], (std::vector<std::string>{"2", "Jane", "65000", "2", "Ann", "1"}));
+
+    auto output_path = test_dir / "projection.csv";
+    size_t rows_written = 0;
+    ASSERT_TRUE(CsvWriter::write_projection({"name", "id"}, *database.get_table("employees"), {1, 0}, nullptr,
+                                            output_path, rows_written));
+    EXPECT_EQ(rows_written, 3u);
+    std::ifstream file(output_path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, "name,id\nJohn,1\nJane,2\nBob,3\n");
+}
+
+TEST_F(ColumnStoreTest, PartitionsKeepTheirColumns) {
+    FileInfo input = createInput("2024-01", "1|John|75000\n");
+    input.table_name = "employees";
+    input.partition_values = {{"region", "EU"}};
+    ColumnStore store(store_dir);
+    store.load(input);
+
+    auto mapped = store.load(input);
+    EXPECT_EQ(mapped->name, "employees");
+    EXPECT_EQ(mapped->get_field(0, "region"), "EU");
+
+    // A new partition key elsewhere in the table changes every partition's columns
+    input.partition_values.emplace_back("year", "");
+    EXPECT_FALSE(store.contains(input));
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include "columnar_writer.h"
+#include "query_engine.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+class ColumnarWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "columnar_writer_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    std::unique_ptr<QueryResult> createTestResult() {
+        auto result = std::make_unique<QueryResult>();
+        result->headers = {"emp_id", "badge", "salary", "department", "name"};
+        result->rows = {
+            {"1001", "007", "85000.5", "Engineering", "John Doe"},
+            {"1002", "012", "75000", "Engineering", "Jane Smith"},
+            {"1003", "100", "", "Management", "Bob Johnson"},
+            {"1004", "101", "-120.25", "Engineering", "Alice Brown"}
+        };
+        return result;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(ColumnarWriterTest, RoundTripPreservesValues) {
+    auto result = createTestResult();
+    auto path = test_dir / "report.apcol";
+
+    ASSERT_TRUE(ColumnarWriter::write_columnar(*result, path));
+
+    auto decoded = ColumnarReader::read_file(path);
+    ASSERT_TRUE(decoded);
+    EXPECT_EQ(decoded->headers, result->headers);
+    EXPECT_EQ(decoded->rows, result->rows);
+}
+
+TEST_F(ColumnarWriterTest, InfersColumnTypes) {
+    auto result = createTestResult();
+    auto path = test_dir / "types.apcol";
+    ASSERT_TRUE(ColumnarWriter::write_columnar(*result, path));
+
+    std::vector<ColumnDescriptor> descriptors;
+    ColumnarReader::read_file(path, &descriptors);
+    ASSERT_EQ(descriptors.size(), 5);
+
+    EXPECT_EQ(descriptors[0].type, ColumnType::INT64);
+    EXPECT_EQ(descriptors[0].min_int, 1001);
+    EXPECT_EQ(descriptors[0].max_int, 1004);
+
+    // Leading zeros must survive, so badges stay strings
+    EXPECT_EQ(descriptors[1].type, ColumnType::STRING);
+
+    EXPECT_EQ(descriptors[2].type, ColumnType::DOUBLE);
+    EXPECT_EQ(descriptors[2].null_count, 1);
+    EXPECT_DOUBLE_EQ(descriptors[2].min_double, -120.25);
+    EXPECT_DOUBLE_EQ(descriptors[2].max_double, 85000.5);
+}
+
+TEST_F(ColumnarWriterTest, DecimalsThatWouldNotRoundTripStayStrings) {
+    QueryResult result;
+    result.headers = {"price", "rate"};
+    result.rows = {{"1.50", "2.5"}, {"2.0", "0.125"}, {"19.90", "-3"}};
+    auto path = test_dir / "decimals.apcol";
+    ASSERT_TRUE(ColumnarWriter::write_columnar(result, path));
+
+    std::vector<ColumnDescriptor> descriptors;
+    auto decoded = ColumnarReader::read_file(path, &descriptors);
+    ASSERT_TRUE(decoded);
+    // Trailing zeros would be lost as doubles
+    EXPECT_EQ(descriptors[0].type, ColumnType::STRING);
+    EXPECT_EQ(descriptors[1].type, ColumnType::DOUBLE);
+    EXPECT_EQ(decoded->rows, result.rows);
+}
+
+TEST_F(ColumnarWriterTest, RepeatedStringsUseDictionary) {
+    auto result = createTestResult();
+    auto path = test_dir / "dictionary.apcol";
+    ASSERT_TRUE(ColumnarWriter::write_columnar(*result, path));
+
+    std::vector<ColumnDescriptor> descriptors;
+    ColumnarReader::read_file(path, &descriptors);
+
+    EXPECT_EQ(descriptors[3].encoding, ColumnEncoding::DICTIONARY);
+    EXPECT_EQ(descriptors[3].dictionary_size, 2);
+    EXPECT_EQ(descriptors[3].min_string, "Engineering");
+    EXPECT_EQ(descriptors[3].max_string, "Management");
+
+    EXPECT_EQ(descriptors[4].encoding, ColumnEncoding::PLAIN);
+    EXPECT_EQ(descriptors[4].min_string, "Alice Brown");
+}
+
+TEST_F(ColumnarWriterTest, BlocksAreEightByteAligned) {
+    auto result = createTestResult();
+    auto path = test_dir / "aligned.apcol";
+    ASSERT_TRUE(ColumnarWriter::write_columnar(*result, path));
+
+    std::vector<ColumnDescriptor> descriptors;
+    ColumnarReader::read_file(path, &descriptors);
+    for (const auto& desc : descriptors) {
+        EXPECT_EQ(desc.offset % 8, 0u) << desc.name;
+        EXPECT_EQ(desc.length % 8, 0u) << desc.name;
+    }
+}
+
+TEST_F(ColumnarWriterTest, WriteSelectedRows) {
+    auto result = createTestResult();
+    auto path = test_dir / "subset.apcol";
+
+    ASSERT_TRUE(ColumnarWriter::write_columnar_rows(*result, {3, 0}, path));
+
+    auto decoded = ColumnarReader::read_file(path);
+    ASSERT_EQ(decoded->rows.size(), 2);
+    EXPECT_EQ(decoded->rows[0], result->rows[3]);
+    EXPECT_EQ(decoded->rows[1], result->rows[0]);
+}
+
+TEST_F(ColumnarWriterTest, RejectsNonColumnarFile) {
+    auto path = test_dir / "not_columnar.apcol";
+    std::ofstream(path) << "id,name\n1,John\n";
+
+    EXPECT_THROW(ColumnarReader::read_file(path), std::runtime_error);
+}
+
+TEST_F(ColumnarWriterTest, RejectsDamagedBlocksInsteadOfReadingPastThem) {
+    auto result = createTestResult();
+    auto path = test_dir / "damaged.apcol";
+    ASSERT_TRUE(ColumnarWriter::write_columnar(*result, path));
+    std::ifstream file(path, std::ios::binary);
+    std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // More rows than the blocks hold, by a little and by a lot
+    for (uint64_t rows : {uint64_t(5), uint64_t(1) << 40}) {
+        std::string damaged = image;
+        std::memcpy(&damaged[16], &rows, sizeof(rows));
+        EXPECT_THROW(ColumnarReader::decode(damaged.data(), damaged.size()), std::runtime_error);
+    }
+
+    // Any single damaged byte decodes to something or throws, never reads out of bounds
+    for (size_t i = 0; i < image.size(); ++i) {
+        std::string damaged = image;
+        damaged[i] = static_cast<char>(0xff);
+        try {
+            ColumnarReader::decode(damaged.data(), damaged.size());
+        } catch (const std::runtime_error&) {
+        }
+    }
+}
@@ -132,4 +132,215 @@ TEST_F(CommandLineParserTest, TransformMissingParameterValue) {
     auto args = CommandLineParser::parse(argc, argv);
     
     EXPECT_EQ(args.command, CommandLineArgs::Command::INVALID);
-}
\ No newline at end of file
+}
+
+// Test output partitioning options
+TEST_F(CommandLineParserTest, ParseTransformPartitionOptions) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                    "--max-rows-per-file", "1048575", "--partition-by", "department"};
+    int argc = 10;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_EQ(args.max_rows_per_file, 1048575u);
+    EXPECT_EQ(args.partition_column, "department");
+}
+
+TEST_F(CommandLineParserTest, ParseTransformDiffOptions) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                    "--diff-key", "employee_id,department"};
+    int argc = 8;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_TRUE(args.diff);
+    EXPECT_EQ(args.diff_key, (std::vector<std::string>{"employee_id", "department"}));
+    
+    char* empty_key[] = {"agile-pasta", "transform", "--in", "/input/path", "--diff-key", "id,"};
+    EXPECT_EQ(CommandLineParser::parse(6, empty_key).command, CommandLineArgs::Command::INVALID);
+    
+    char* whole_row[] = {"agile-pasta", "explain", "--in", "/input/path", "--diff"};
+    args = CommandLineParser::parse(5, whole_row);
+    EXPECT_TRUE(args.diff);
+    EXPECT_TRUE(args.diff_key.empty());
+}
+
+TEST_F(CommandLineParserTest, ParseTransformResume) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path", "--resume"};
+    int argc = 7;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_TRUE(args.resume);
+    
+    char* explain[] = {"agile-pasta", "explain", "--in", "/input/path", "--resume"};
+    EXPECT_EQ(CommandLineParser::parse(5, explain).command, CommandLineArgs::Command::INVALID);
+}
+
+TEST_F(CommandLineParserTest, TransformRejectsInvalidRowCap) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                    "--max-rows-per-file", "zero"};
+    int argc = 8;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::INVALID);
+}
+
+TEST_F(CommandLineParserTest, ParseTransformFormat) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                    "--format", "columnar"};
+    int argc = 8;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_EQ(args.output_format, "columnar");
+}
+TEST_F(CommandLineParserTest, ParseTransformMetricsPath) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                    "--metrics", "/tmp/run.json"};
+    int argc = 8;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_EQ(args.metrics_path, "/tmp/run.json");
+}
+
+TEST_F(CommandLineParserTest, ParseTransformTracePath) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                    "--trace", "/tmp/trace.json"};
+    int argc = 8;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_EQ(args.trace_path, "/tmp/trace.json");
+}
+
+TEST_F(CommandLineParserTest, ParseTransformPerfCounters) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                    "--perf-counters"};
+    int argc = 7;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_TRUE(args.perf_counters);
+}
+
+TEST_F(CommandLineParserTest, ParseTransformVerbose) {
+    char* argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path", "-v"};
+    int argc = 7;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_TRUE(args.verbose);
+}
+
+TEST_F(CommandLineParserTest, ParseExplainAnalyze) {
+    char* argv[] = {"agile-pasta", "explain", "--in", "/input/path", "--out", "/output/path",
+                    "--analyze", "--format", "jsonl"};
+    int argc = 9;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::EXPLAIN);
+    EXPECT_EQ(args.input_path, "/input/path");
+    EXPECT_EQ(args.output_path, "/output/path");
+    EXPECT_TRUE(args.explain_analyze);
+    EXPECT_EQ(args.output_format, "jsonl");
+}
+
+TEST_F(CommandLineParserTest, ParseExplainRejectsTransformOnlyOptions) {
+    char* argv[] = {"agile-pasta", "explain", "--in", "/input/path", "--out", "/output/path",
+                    "--metrics", "run.json"};
+    int argc = 8;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::INVALID);
+}
+
+TEST_F(CommandLineParserTest, ParseQueryCommand) {
+    char* argv[] = {"agile-pasta", "query", "--in", "/input/path", "-e", "SELECT * FROM employees"};
+    int argc = 6;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::QUERY);
+    EXPECT_EQ(args.input_path, "/input/path");
+    EXPECT_EQ(args.query_sql, "SELECT * FROM employees");
+}
+
+TEST_F(CommandLineParserTest, ParseStoreForTransformAndQuery) {
+    char* transform_argv[] = {"agile-pasta", "transform", "--in", "/input/path", "--out", "/output/path",
+                              "--store", "/var/cache/agile-pasta"};
+    auto args = CommandLineParser::parse(8, transform_argv);
+    EXPECT_EQ(args.command, CommandLineArgs::Command::TRANSFORM);
+    EXPECT_EQ(args.store_path, "/var/cache/agile-pasta");
+    
+    char* query_argv[] = {"agile-pasta", "query", "--in", "/input/path", "--store", "/tmp/store"};
+    args = CommandLineParser::parse(6, query_argv);
+    EXPECT_EQ(args.command, CommandLineArgs::Command::QUERY);
+    EXPECT_EQ(args.store_path, "/tmp/store");
+    
+    char* explain_argv[] = {"agile-pasta", "explain", "--in", "/input/path", "--out", "/output/path",
+                            "--store", "/tmp/store"};
+    EXPECT_EQ(CommandLineParser::parse(8, explain_argv).command, CommandLineArgs::Command::INVALID);
+}
+
+TEST_F(CommandLineParserTest, ParseServeCommand) {
+    char* argv[] = {"agile-pasta", "serve", "--socket", "/run/agile.sock", "--workers", "4", "--cache-mb", "512"};
+    int argc = 8;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::SERVE);
+    EXPECT_EQ(args.socket_path, "/run/agile.sock");
+    EXPECT_EQ(args.serve_workers, 4u);
+    EXPECT_EQ(args.serve_cache_mb, 512u);
+    EXPECT_FALSE(args.serve_compress_cache);
+    
+    char* compress_argv[] = {"agile-pasta", "serve", "--socket", "/run/agile.sock", "--compress-cache"};
+    EXPECT_TRUE(CommandLineParser::parse(5, compress_argv).serve_compress_cache);
+}
+
+TEST_F(CommandLineParserTest, ParseServeRejectsZeroWorkers) {
+    char* argv[] = {"agile-pasta", "serve", "--socket", "/run/agile.sock", "--workers", "0"};
+    int argc = 6;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::INVALID);
+}
+
+TEST_F(CommandLineParserTest, ParseGenerateCommand) {
+    char* argv[] = {"agile-pasta", "gen", "--out", "/data/bench", "--scale", "2.5",
+                    "--skew", "1.1", "--sortedness", "0.25", "--seed", "7", "--departments", "300"};
+    int argc = 14;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::GENERATE);
+    EXPECT_EQ(args.output_path, "/data/bench");
+    EXPECT_DOUBLE_EQ(args.gen_scale, 2.5);
+    EXPECT_DOUBLE_EQ(args.gen_skew, 1.1);
+    EXPECT_DOUBLE_EQ(args.gen_sortedness, 0.25);
+    EXPECT_EQ(args.gen_seed, 7u);
+    EXPECT_EQ(args.gen_departments, 300u);
+}
+
+TEST_F(CommandLineParserTest, ParseGenerateRejectsOutOfRangeSortedness) {
+    char* argv[] = {"agile-pasta", "gen", "--out", "/data/bench", "--sortedness", "2"};
+    int argc = 6;
+    
+    auto args = CommandLineParser::parse(argc, argv);
+    
+    EXPECT_EQ(args.command, CommandLineArgs::Command::INVALID);
+}
@@ -231,4 +231,73 @@ TEST_F(CsvWriterTest, ResultWithMismatchedRowLength) {
     
     // Should handle mismatched rows appropriately
     // (exact behavior depends on implementation)
-}
\ No newline at end of file
+}
+TEST_F(CsvWriterTest, StreamWriterResumesFromCheckpoint) {
+    auto output_path = test_dir / "resumed.csv";
+    std::vector<std::vector<std::string>> rows;
+    for (int i = 0; i < 200; ++i) {
+        rows.push_back({std::to_string(i), "name, " + std::to_string(i)});
+    }
+
+    // A full run, remembering every durable checkpoint
+    std::vector<std::pair<size_t, uint64_t>> chunks;
+    StreamCheckpoint checkpoint;
+    checkpoint.chunk_bytes = 500;
+    checkpoint.on_chunk = [&](size_t written, uint64_t bytes) { chunks.emplace_back(written, bytes); };
+    CsvStreamWriter writer;
+    ASSERT_TRUE(writer.open(output_path, {"id", "name"}, &checkpoint));
+    for (const auto& row : rows) {
+        writer.write_row(row);
+    }
+    ASSERT_TRUE(writer.close());
+    std::string complete = readFile(output_path);
+    ASSERT_GT(chunks.size(), 3u);
+    // Checkpoints fall on row boundaries
+    EXPECT_EQ(complete[chunks[1].second - 1], '\n');
+    std::string next_row = std::to_string(chunks[1].first) + ",\"name, ";
+    EXPECT_EQ(complete.substr(chunks[1].second, next_row.size()), next_row);
+
+    // A run that died after the second checkpoint, leaving a torn last row
+    std::filesystem::resize_file(output_path, chunks[1].second + 7);
+    StreamCheckpoint resume;
+    resume.resume_rows = chunks[1].first;
+    resume.resume_bytes = chunks[1].second;
+    CsvStreamWriter resumed;
+    ASSERT_TRUE(resumed.open(output_path, {"id", "name"}, &resume));
+    for (const auto& row : rows) {
+        resumed.write_row(row);
+    }
+    ASSERT_TRUE(resumed.close());
+
+    EXPECT_EQ(resumed.rows_written(), rows.size());
+    EXPECT_EQ(readFile(output_path), complete);
+
+    // A file shorter than its checkpoint cannot be continued
+    std::filesystem::resize_file(output_path, 10);
+    CsvStreamWriter truncated;
+    EXPECT_FALSE(truncated.open(output_path, {"id", "name"}, &resume));
+}
+
+TEST_F(CsvWriterTest, ProjectionResumesFromCheckpoint) {
+    PsvTable table;
+    table.headers = {"id", "name", "note"};
+    for (int i = 0; i < 100; ++i) {
+        table.records.push_back({{std::to_string(i), "n" + std::to_string(i), "skip"}});
+    }
+    auto output_path = test_dir / "projection.csv";
+    auto even = [&](size_t row) { return std::stoi(table.records[row].fields[0]) % 2 == 0; };
+    size_t rows_written = 0;
+    ASSERT_TRUE(CsvWriter::write_projection({"name", "id"}, table, {1, 0}, even, output_path, rows_written));
+    std::string complete = readFile(output_path);
+
+    // Continue after the first 20 projected rows
+    StreamCheckpoint resume;
+    resume.resume_rows = 20;
+    resume.resume_bytes = complete.find("n40,");
+    std::ofstream(output_path, std::ios::app) << "torn";
+    ASSERT_TRUE(CsvWriter::write_projection({"name", "id"}, table, {1, 0}, even, output_path, rows_written,
+                                            &resume));
+
+    EXPECT_EQ(rows_written, 50u);
+    EXPECT_EQ(readFile(output_path), complete);
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include "data_generator.h"
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+class DataGeneratorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "data_generator_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    static GeneratorOptions smallOptions() {
+        GeneratorOptions options;
+        options.scale = 0.001;      // 16,000 employees
+        options.chunk_rows = 1000;
+        return options;
+    }
+
+    static std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    static std::vector<std::string> splitLine(const std::string& line) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '|')) {
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(DataGeneratorTest, CardinalitiesFollowScale) {
+    DataGenerator generator(smallOptions());
+    EXPECT_EQ(generator.employee_rows(), 16000u);
+    EXPECT_EQ(generator.department_rows(), 15u);
+    EXPECT_EQ(generator.cost_center_rows(), 5u);
+    EXPECT_EQ(generator.location_rows(), 20u);
+
+    GeneratorOptions options = smallOptions();
+    options.departments = 40;
+    options.locations = 7;
+    options.cost_centers = 9;
+    DataGenerator overridden(options);
+    EXPECT_EQ(overridden.department_rows(), 40u);
+    EXPECT_EQ(overridden.location_rows(), 7u);
+    EXPECT_EQ(overridden.cost_center_rows(), 9u);
+}
+
+TEST_F(DataGeneratorTest, RejectsInvalidOptions) {
+    GeneratorOptions options = smallOptions();
+    options.sortedness = 1.5;
+    EXPECT_THROW(DataGenerator generator(options), std::invalid_argument);
+
+    options = smallOptions();
+    options.scale = 0.0;
+    EXPECT_THROW(DataGenerator generator(options), std::invalid_argument);
+}
+
+TEST_F(DataGeneratorTest, WritesTablesHeadersAndSampleRules) {
+    DataGenerator generator(smallOptions());
+    auto tables = generator.generate(test_dir);
+
+    ASSERT_EQ(tables.size(), 4u);
+    for (const auto& table : tables) {
+        EXPECT_TRUE(std::filesystem::exists(table.path));
+        EXPECT_TRUE(std::filesystem::exists(test_dir / "input" / (table.name + "_Headers.psv")));
+        EXPECT_EQ(std::filesystem::file_size(table.path), table.bytes);
+    }
+
+    EXPECT_EQ(readFile(test_dir / "input" / "employees_Headers.psv"),
+              "emp_id|name|position|hire_date|salary|department|dept_id\n");
+    EXPECT_TRUE(std::filesystem::exists(test_dir / "output" / "gen_employee_summary_Rules.psv"));
+    EXPECT_TRUE(std::filesystem::exists(test_dir / "output" / "gen_employee_summary_Headers.psv"));
+    EXPECT_TRUE(std::filesystem::exists(test_dir / "output" / "gen_department_locations_Rules.psv"));
+
+    std::ifstream employees(test_dir / "input" / "employees.psv");
+    std::string line;
+    size_t rows = 0;
+    while (std::getline(employees, line)) {
+        auto fields = splitLine(line);
+        ASSERT_EQ(fields.size(), 7u);
+        uint64_t dept_id = std::stoull(fields[6]);
+        EXPECT_GE(dept_id, 1u);
+        EXPECT_LE(dept_id, generator.department_rows());
+        rows++;
+    }
+    EXPECT_EQ(rows, generator.employee_rows());
+}
+
+TEST_F(DataGeneratorTest, OutputIsIndependentOfThreadsAndChunks) {
+    GeneratorOptions options = smallOptions();
+    options.threads = 1;
+    options.chunk_rows = 10000;
+    DataGenerator(options).generate(test_dir / "a");
+
+    options.threads = 8;
+    options.chunk_rows = 333;
+    DataGenerator(options).generate(test_dir / "b");
+
+    EXPECT_EQ(readFile(test_dir / "a" / "input" / "employees.psv"),
+              readFile(test_dir / "b" / "input" / "employees.psv"));
+    EXPECT_EQ(readFile(test_dir / "a" / "input" / "departments.psv"),
+              readFile(test_dir / "b" / "input" / "departments.psv"));
+}
+
+TEST_F(DataGeneratorTest, SeedChangesData) {
+    GeneratorOptions options = smallOptions();
+    DataGenerator first(options);
+    options.seed = 7;
+    DataGenerator second(options);
+
+    std::string a, b;
+    first.append_employee(a, 0);
+    second.append_employee(b, 0);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a.substr(0, 2), "1|");
+}
+
+TEST_F(DataGeneratorTest, SortednessControlsKeyOrder) {
+    GeneratorOptions options = smallOptions();
+    DataGenerator sorted(options);
+    for (uint64_t i = 0; i < sorted.employee_rows(); ++i) {
+        ASSERT_EQ(sorted.employee_key(i), i + 1);
+    }
+
+    for (double sortedness : {0.0, 0.5}) {
+        options.sortedness = sortedness;
+        DataGenerator shuffled(options);
+        std::set<uint64_t> keys;
+        uint64_t in_order = 0;
+        for (uint64_t i = 0; i < shuffled.employee_rows(); ++i) {
+            uint64_t key = shuffled.employee_key(i);
+            EXPECT_GE(key, 1u);
+            EXPECT_LE(key, shuffled.employee_rows());
+            keys.insert(key);
+            in_order += key == i + 1;
+        }
+        // Still a permutation of 1..n, but not the identity
+        EXPECT_EQ(keys.size(), shuffled.employee_rows());
+        EXPECT_LT(in_order, shuffled.employee_rows() / 10);
+    }
+}
+
+TEST_F(DataGeneratorTest, SkewConcentratesForeignKeys) {
+    GeneratorOptions options = smallOptions();
+    options.departments = 100;
+
+    auto hottest_share = [](const DataGenerator& generator) {
+        std::vector<uint64_t> counts(generator.department_rows() + 1, 0);
+        for (uint64_t i = 0; i < generator.employee_rows(); ++i) {
+            std::string row;
+            generator.append_employee(row, i);
+            counts[std::stoull(row.substr(row.rfind('|') + 1))]++;
+        }
+        return static_cast<double>(counts[1]) / generator.employee_rows();
+    };
+
+    double uniform = hottest_share(DataGenerator(options));
+    options.skew = 1.2;
+    double skewed = hottest_share(DataGenerator(options));
+
+    EXPECT_LT(uniform, 0.03);
+    EXPECT_GT(skewed, 0.2);
+}
+
+TEST_F(DataGeneratorTest, FormatsDates) {
+    EXPECT_EQ(DataGenerator::format_date(0), "1970-01-01");
+    EXPECT_EQ(DataGenerator::format_date(16436), "2015-01-01");
+    EXPECT_EQ(DataGenerator::format_date(19782), "2024-02-29");
+}
@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 #include "database.h"
 #include "psv_parser.h"
+#include <atomic>
 #include <memory>
+#include <thread>
 
 class DatabaseTest : public ::testing::Test {
 protected:
@@ -193,4 +195,108 @@ TEST_F(DatabaseTest, TotalRecordsCalculation) {
     
     database.load_table(std::move(table3));
     EXPECT_EQ(database.get_total_records(), 5); // 3 + 2 + 0
-}
\ No newline at end of file
+}
+
+TEST_F(DatabaseTest, DropTable) {
+    database.load_table(createTestTable("employees", {"id"}, {{"1"}, {"2"}}));
+    database.load_table(createTestTable("departments", {"id"}, {{"10"}}));
+    
+    database.drop_table("employees");
+    
+    EXPECT_EQ(database.get_table("employees"), nullptr);
+    EXPECT_NE(database.get_table("departments"), nullptr);
+    EXPECT_EQ(database.get_total_records(), 1);
+    
+    // Dropping an unknown table is a no-op
+    database.drop_table("missing");
+    EXPECT_EQ(database.get_table_names().size(), 1);
+}
+
+TEST_F(DatabaseTest, SharedTableOutlivesDatabase) {
+    std::shared_ptr<const PsvTable> shared = createTestTable("employees", {"id"}, {{"1"}, {"2"}});
+    {
+        Database job;
+        job.share_table(shared);
+        ASSERT_EQ(job.get_table("employees"), shared.get());
+        EXPECT_EQ(job.get_total_records(), 2);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+    EXPECT_EQ(shared->records.size(), 2u);
+}
+
+TEST_F(DatabaseTest, SnapshotIsUnaffectedByLaterChanges) {
+    database.load_table(createTestTable("employees", {"id"}, {{"1"}, {"2"}}));
+    database.load_table(createTestTable("departments", {"id"}, {{"10"}}));
+    
+    Database snapshot = database.snapshot();
+    const PsvTable* employees = snapshot.get_table("employees");
+    
+    database.load_table(createTestTable("employees", {"id"}, {{"3"}}));
+    database.drop_table("departments");
+    database.load_table(createTestTable("projects", {"id"}, {{"7"}}));
+    
+    // The snapshot still holds the tables it was taken with
+    ASSERT_EQ(snapshot.get_table("employees"), employees);
+    EXPECT_EQ(employees->records.size(), 2u);
+    EXPECT_NE(snapshot.get_table("departments"), nullptr);
+    EXPECT_EQ(snapshot.get_table("projects"), nullptr);
+    EXPECT_EQ(snapshot.get_total_records(), 3u);
+    
+    EXPECT_EQ(database.get_table("employees")->records.size(), 1u);
+    EXPECT_EQ(database.get_table_names(), (std::vector<std::string>{"employees", "projects"}));
+}
+
+TEST_F(DatabaseTest, DroppedTableStaysChargedWhileASnapshotHoldsIt) {
+    MemoryAccounting::reset();
+    database.load_table(createTestTable("employees", {"id"}, {{"1"}, {"2"}}));
+    uint64_t loaded = MemoryAccounting::category_total(MemoryCategory::TABLE).current_bytes;
+    ASSERT_GT(loaded, 0u);
+    
+    {
+        Database snapshot = database.snapshot();
+        database.drop_table("employees");
+        EXPECT_EQ(MemoryAccounting::category_total(MemoryCategory::TABLE).current_bytes, loaded);
+    }
+    EXPECT_EQ(MemoryAccounting::category_total(MemoryCategory::TABLE).current_bytes, 0u);
+    MemoryAccounting::reset();
+}
+
+TEST_F(DatabaseTest, ReadersSeeWholeVersionsWhileTablesChange) {
+    // A snapshot always sees one whole version of "orders", never one being replaced
+    auto publish = [&](size_t rows) {
+        std::vector<std::vector<std::string>> data(rows, {"x"});
+        database.load_table(createTestTable("orders", {"id"}, data));
+    };
+    publish(1);
+    
+    std::atomic<bool> done{false};
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                Database snapshot = database.snapshot();
+                const PsvTable* orders = snapshot.get_table("orders");
+                size_t rows = orders->records.size();
+                for (const auto& record : orders->records) {
+                    if (record.fields.size() != 1) {
+                        mismatches++;
+                    }
+                }
+                if (snapshot.get_total_records() != rows) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (size_t rows = 2; rows <= 200; ++rows) {
+        publish(rows);
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    
+    EXPECT_EQ(mismatches, 0u);
+    EXPECT_EQ(database.get_total_records(), 200u);
+}
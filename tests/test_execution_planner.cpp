@@ -0,0 +1,366 @@
+#include <gtest/gtest.h>
+#include "execution_planner.h"
+#include "change_capture.h"
+#include <filesystem>
+#include <fstream>
+
+class ExecutionPlannerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "execution_planner_tests";
+        std::filesystem::create_directories(test_dir);
+        
+        input_dir = test_dir / "input";
+        output_dir = test_dir / "output";
+        std::filesystem::create_directories(input_dir);
+        std::filesystem::create_directories(output_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    void createFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream file(path);
+        file << content;
+        file.close();
+    }
+
+    FileInfo createInput(const std::string& name, const std::string& headers, const std::string& data) {
+        createFile(input_dir / (name + ".psv"), data);
+        createFile(input_dir / (name + "_Headers.psv"), headers);
+        
+        FileInfo info;
+        info.path = input_dir / (name + ".psv");
+        info.headers_path = input_dir / (name + "_Headers.psv");
+        info.size_bytes = std::filesystem::file_size(info.path);
+        info.name_prefix = name;
+        return info;
+    }
+
+    OutputFileInfo createConfig(const std::string& name, const std::string& headers, const std::string& rules) {
+        createFile(output_dir / (name + "_Headers.psv"), headers);
+        createFile(output_dir / (name + "_Rules.psv"), rules);
+        
+        OutputFileInfo info;
+        info.headers_path = output_dir / (name + "_Headers.psv");
+        info.rules_path = output_dir / (name + "_Rules.psv");
+        info.name_prefix = name;
+        return info;
+    }
+
+    std::vector<FileInfo> createSampleInputs() {
+        return {
+            createInput("employees", "id|first_name|salary|dept_id",
+                        "1|John|75000|10\n2|Jane|65000|20\n3|Bob|85000|10\n"),
+            createInput("departments", "dept_id|dept_name", "10|Engineering\n20|Marketing\n"),
+            createInput("contractors", "id|first_name|salary|dept_id", "9|Zed|50000|20\n")
+        };
+    }
+
+    static InputEstimate makeEstimate(const std::string& table, uint64_t rows, double memory_per_row) {
+        InputEstimate estimate;
+        estimate.table = table;
+        estimate.columns = 4;
+        estimate.estimated_rows = rows;
+        estimate.sampled_rows = rows;
+        estimate.bytes_per_row = 40.0;
+        estimate.file_bytes = static_cast<uint64_t>(rows * 40);
+        estimate.memory_per_row = memory_per_row;
+        estimate.memory_bytes = static_cast<uint64_t>(rows * memory_per_row);
+        return estimate;
+    }
+
+    static ConfigDescription makeConfig(const std::string& name, ConfigShape shape,
+                                        std::vector<std::string> tables) {
+        ConfigDescription config;
+        config.name = name;
+        config.shape = shape;
+        config.tables = std::move(tables);
+        config.output_columns = 3;
+        return config;
+    }
+
+    std::filesystem::path test_dir;
+    std::filesystem::path input_dir;
+    std::filesystem::path output_dir;
+};
+
+TEST_F(ExecutionPlannerTest, EstimateSmallFileIsExact) {
+    auto input = createInput("employees", "id|name", "1|John\n2|Jane\n3|Bob\n");
+    
+    InputEstimate estimate = ExecutionPlanner::estimate_input(input);
+    EXPECT_EQ(estimate.table, "employees");
+    EXPECT_EQ(estimate.sampled_rows, 3u);
+    EXPECT_EQ(estimate.estimated_rows, 3u);
+    EXPECT_EQ(estimate.columns, 2u);
+    EXPECT_GT(estimate.memory_per_row, 2.0 * sizeof(std::string));
+    EXPECT_GT(estimate.memory_bytes, estimate.file_bytes);
+}
+
+TEST_F(ExecutionPlannerTest, EstimateExtrapolatesFromSample) {
+    // Fixed-width rows well past the sample size
+    std::string data;
+    const size_t rows = 20000;
+    for (size_t i = 0; i < rows; ++i) {
+        char line[32];
+        std::snprintf(line, sizeof(line), "%08zu|name%06zu\n", i, i);
+        data += line;
+    }
+    auto input = createInput("wide", "id|name", data);
+    ASSERT_GT(input.size_bytes, ExecutionPlanner::kSampleBytes);
+    
+    InputEstimate estimate = ExecutionPlanner::estimate_input(input);
+    EXPECT_LT(estimate.sampled_rows, rows);
+    EXPECT_NEAR(static_cast<double>(estimate.estimated_rows), static_cast<double>(rows), rows * 0.01);
+}
+
+TEST_F(ExecutionPlannerTest, DescribesConfigShapes) {
+    auto inputs = createSampleInputs();
+    Database schema;
+    ExecutionPlanner::load_schemas(inputs, schema);
+    EXPECT_EQ(schema.get_total_records(), 0u);
+    
+    auto projection = ExecutionPlanner::describe_config(
+        createConfig("projection", "first_name|salary", "FIELD|first_name|first_name|Copy\nFIELD|salary|salary|Copy"),
+        schema);
+    EXPECT_EQ(projection.shape, ConfigShape::PROJECTION);
+    
+    auto select = ExecutionPlanner::describe_config(
+        createConfig("select", "name", "GLOBAL|salary >= '70000'|High\nFIELD|name|UPPER(dept_name)|Upper"),
+        schema);
+    EXPECT_EQ(select.shape, ConfigShape::SELECT);
+    EXPECT_EQ(select.tables, std::vector<std::string>{"departments"});
+    EXPECT_EQ(select.global_filters, 1u);
+    
+    auto join = ExecutionPlanner::describe_config(
+        createConfig("join", "first_name|dept_name",
+                     "GLOBAL|Join employees.dept_id = departments.dept_id|Join\n"
+                     "FIELD|first_name|first_name|Copy\nFIELD|dept_name|dept_name|Copy"),
+        schema);
+    EXPECT_EQ(join.shape, ConfigShape::JOIN);
+    EXPECT_EQ(join.tables, (std::vector<std::string>{"employees", "departments"}));
+    
+    auto union_config = ExecutionPlanner::describe_config(
+        createConfig("union", "first_name", "GLOBAL|Union employees,contractors|All\nFIELD|first_name|first_name|Copy"),
+        schema);
+    EXPECT_EQ(union_config.shape, ConfigShape::UNION);
+    EXPECT_EQ(union_config.tables, (std::vector<std::string>{"employees", "contractors"}));
+    
+    auto constant = ExecutionPlanner::describe_config(
+        createConfig("constant", "greeting", "FIELD|greeting|\"Hello\"|Constant"), schema);
+    EXPECT_EQ(constant.shape, ConfigShape::STATIC);
+    EXPECT_TRUE(constant.tables.empty());
+}
+
+TEST_F(ExecutionPlannerTest, SingleCsvStreamsOtherFormatsMaterialize) {
+    std::vector<InputEstimate> inputs = {makeEstimate("employees", 1000, 200.0)};
+    std::vector<ConfigDescription> configs = {makeConfig("report", ConfigShape::SELECT, {"employees"})};
+    
+    OutputOptions csv;
+    auto plan = ExecutionPlanner::plan(inputs, configs, csv, 1ull << 30, 8);
+    ASSERT_EQ(plan.configs.size(), 1u);
+    EXPECT_TRUE(plan.load_up_front);
+    EXPECT_EQ(plan.configs[0].mode, ExecutionMode::STREAMING);
+    EXPECT_TRUE(plan.configs[0].stream_rows);
+    
+    OutputOptions xlsx;
+    xlsx.format = OutputFormat::XLSX;
+    plan = ExecutionPlanner::plan(inputs, configs, xlsx, 1ull << 30, 8);
+    EXPECT_EQ(plan.configs[0].mode, ExecutionMode::IN_MEMORY);
+    EXPECT_FALSE(plan.configs[0].stream_rows);
+    
+    OutputOptions split;
+    split.max_rows_per_file = 100;
+    plan = ExecutionPlanner::plan(inputs, configs, split, 1ull << 30, 8);
+    EXPECT_EQ(plan.configs[0].mode, ExecutionMode::IN_MEMORY);
+}
+
+TEST_F(ExecutionPlannerTest, MaterializingNeedsMoreMemoryThanStreaming) {
+    std::vector<InputEstimate> inputs = {makeEstimate("employees", 1000, 200.0)};
+    std::vector<ConfigDescription> configs = {makeConfig("report", ConfigShape::SELECT, {"employees"})};
+    
+    OutputOptions csv;
+    OutputOptions jsonl;
+    jsonl.format = OutputFormat::JSON_LINES;
+    auto streaming = ExecutionPlanner::plan(inputs, configs, csv, 0, 8);
+    auto materialized = ExecutionPlanner::plan(inputs, configs, jsonl, 0, 8);
+    
+    EXPECT_EQ(streaming.configs[0].estimated_rows, 1000u);
+    EXPECT_EQ(streaming.configs[0].tables_bytes, 200000u);
+    EXPECT_GT(materialized.configs[0].working_bytes, streaming.configs[0].working_bytes);
+}
+
+TEST_F(ExecutionPlannerTest, DiffCountsFingerprintsAndKeyValues) {
+    std::vector<InputEstimate> inputs = {makeEstimate("employees", 1000, 200.0)};
+    std::vector<ConfigDescription> configs = {makeConfig("report", ConfigShape::SELECT, {"employees"})};
+
+    OutputOptions plain;
+    OutputOptions whole_row;
+    whole_row.diff = true;
+    OutputOptions keyed = whole_row;
+    keyed.diff_key = {"id"};
+    uint64_t base = ExecutionPlanner::plan(inputs, configs, plain, 0, 8).configs[0].working_bytes;
+
+    // Previous and current fingerprints; a declared key adds its values (200 / 4 bytes per field)
+    EXPECT_EQ(ExecutionPlanner::plan(inputs, configs, whole_row, 0, 8).configs[0].working_bytes,
+              base + 2 * ChangeCapture::kEntryBytes * 1000);
+    EXPECT_EQ(ExecutionPlanner::plan(inputs, configs, keyed, 0, 8).configs[0].working_bytes,
+              base + 2 * (ChangeCapture::kEntryBytes + ChangeCapture::kKeyLengthBytes + 50) * 1000);
+}
+
+TEST_F(ExecutionPlannerTest, SpillsWhenOverBudget) {
+    std::vector<InputEstimate> inputs = {
+        makeEstimate("employees", 100000, 200.0),
+        makeEstimate("departments", 100, 100.0)
+    };
+    std::vector<ConfigDescription> configs = {
+        makeConfig("join", ConfigShape::JOIN, {"employees", "departments"}),
+        makeConfig("constant", ConfigShape::STATIC, {})
+    };
+    
+    OutputOptions jsonl;
+    jsonl.format = OutputFormat::JSON_LINES;
+    auto plan = ExecutionPlanner::plan(inputs, configs, jsonl, 10 * 1024 * 1024, 8);
+    
+    EXPECT_FALSE(plan.load_up_front);
+    EXPECT_EQ(plan.memory_budget, 8u * 1024 * 1024);
+    EXPECT_EQ(plan.configs[0].mode, ExecutionMode::SPILLING);
+    EXPECT_EQ(plan.configs[0].estimated_rows, 100000u);
+    EXPECT_NE(plan.configs[0].reason.find("even alone"), std::string::npos);
+    EXPECT_EQ(plan.configs[1].mode, ExecutionMode::SPILLING);
+    
+    // No room left for the join's hash table: it gets the minimum and spills above it
+    EXPECT_EQ(plan.configs[0].join_memory_bytes, ExecutionPlanner::kMinJoinMemory);
+    EXPECT_EQ(plan.configs[1].join_memory_bytes, 0u);
+}
+
+TEST_F(ExecutionPlannerTest, UnknownMemoryNeverSpills) {
+    std::vector<InputEstimate> inputs = {makeEstimate("employees", 100000000, 200.0)};
+    std::vector<ConfigDescription> configs = {makeConfig("report", ConfigShape::SELECT, {"employees"})};
+    
+    auto plan = ExecutionPlanner::plan(inputs, configs, OutputOptions{}, 0, 8);
+    EXPECT_TRUE(plan.load_up_front);
+    EXPECT_EQ(plan.memory_budget, 0u);
+    EXPECT_EQ(plan.configs[0].mode, ExecutionMode::STREAMING);
+}
+
+TEST_F(ExecutionPlannerTest, UnreadTablesAreNotLoaded) {
+    std::vector<InputEstimate> inputs = {
+        makeEstimate("employees", 100, 200.0),
+        makeEstimate("archive", 100000, 200.0)
+    };
+    std::vector<ConfigDescription> configs = {makeConfig("report", ConfigShape::SELECT, {"employees"})};
+    
+    auto plan = ExecutionPlanner::plan(inputs, configs, OutputOptions{}, 1ull << 30, 8);
+    EXPECT_EQ(plan.unused_tables, std::vector<std::string>{"archive"});
+    EXPECT_EQ(plan.tables_bytes, 20000u);
+}
+
+TEST_F(ExecutionPlannerTest, LoadThreadsFollowInputSize) {
+    std::vector<ConfigDescription> configs = {
+        makeConfig("union", ConfigShape::UNION, {"a", "b", "c"})
+    };
+    
+    // Small inputs load on one thread
+    std::vector<InputEstimate> small = {makeEstimate("a", 10, 100.0), makeEstimate("b", 10, 100.0),
+                                        makeEstimate("c", 10, 100.0)};
+    EXPECT_EQ(ExecutionPlanner::plan(small, configs, OutputOptions{}, 0, 8).load_threads, 1u);
+    
+    // Large inputs use one thread per table, capped by the hardware
+    std::vector<InputEstimate> large = {makeEstimate("a", 100000, 100.0), makeEstimate("b", 100000, 100.0),
+                                        makeEstimate("c", 100000, 100.0)};
+    EXPECT_EQ(ExecutionPlanner::plan(large, configs, OutputOptions{}, 0, 8).load_threads, 3u);
+    EXPECT_EQ(ExecutionPlanner::plan(large, configs, OutputOptions{}, 0, 2).load_threads, 2u);
+}
+
+TEST_F(ExecutionPlannerTest, ExplainDescribesDecisions) {
+    std::vector<InputEstimate> inputs = {makeEstimate("employees", 1000, 200.0)};
+    std::vector<ConfigDescription> configs = {makeConfig("report", ConfigShape::SELECT, {"employees"})};
+    
+    auto lines = ExecutionPlanner::plan(inputs, configs, OutputOptions{}, 1ull << 30, 4).explain();
+    std::string text;
+    for (const auto& line : lines) {
+        text += line + "\n";
+    }
+    EXPECT_NE(text.find("Memory: 1.0 GB available"), std::string::npos);
+    EXPECT_NE(text.find("Input employees:"), std::string::npos);
+    EXPECT_NE(text.find("Load: all tables up front"), std::string::npos);
+    EXPECT_NE(text.find("Config report: streaming (select of employees"), std::string::npos);
+}
+
+TEST_F(ExecutionPlannerTest, PrunesPartitionsEveryReaderFiltersOut) {
+    std::filesystem::create_directories(input_dir / "sales");
+    createFile(input_dir / "sales" / "_Headers.psv", "id|amount");
+    std::vector<FileInfo> inputs;
+    for (const std::string region : {"EU", "US", "APAC"}) {
+        FileInfo info;
+        info.path = input_dir / "sales" / (region + ".psv");
+        info.headers_path = input_dir / "sales" / "_Headers.psv";
+        info.size_bytes = 10;
+        info.table_name = "sales";
+        info.partition_values = {{"region", region}};
+        inputs.push_back(info);
+    }
+    Database schema;
+    ExecutionPlanner::load_schemas(inputs, schema);
+    ASSERT_NE(schema.get_table("sales"), nullptr);
+    EXPECT_EQ(schema.get_table("sales")->headers, (std::vector<std::string>{"id", "amount", "region"}));
+    
+    ConfigDescription eu = makeConfig("eu", ConfigShape::PROJECTION, {"sales"});
+    eu.global_conditions = {"region = 'EU'", "amount > '100'"};
+    ConfigDescription us = makeConfig("us", ConfigShape::SELECT, {"sales"});
+    us.global_conditions = {"region = 'US' ? ACCEPT : REJECT"};
+    
+    auto kept = ExecutionPlanner::prune_partitions(inputs, {eu, us}, schema);
+    ASSERT_EQ(kept.size(), 2u);
+    EXPECT_EQ(kept[0].partition_values[0].second, "EU");
+    EXPECT_EQ(kept[1].partition_values[0].second, "US");
+    
+    // A join filters joined rows, so it needs every partition
+    ConfigDescription join = makeConfig("join", ConfigShape::JOIN, {"sales", "regions"});
+    join.global_conditions = {"region = 'EU'"};
+    EXPECT_EQ(ExecutionPlanner::prune_partitions(inputs, {eu, join}, schema).size(), 3u);
+    
+    // Unread tables are left for the plan to report
+    EXPECT_EQ(ExecutionPlanner::prune_partitions(inputs, {}, schema).size(), 3u);
+}
+
+TEST_F(ExecutionPlannerTest, PartitionColumnShadowedByDataColumnIsNotPruned) {
+    std::filesystem::create_directories(input_dir / "sales");
+    createFile(input_dir / "sales" / "_Headers.psv", "id|region");
+    FileInfo info;
+    info.path = input_dir / "sales" / "old.psv";
+    info.headers_path = input_dir / "sales" / "_Headers.psv";
+    info.size_bytes = 10;
+    info.table_name = "sales";
+    info.partition_values = {{"region", "US"}};
+    Database schema;
+    ExecutionPlanner::load_schemas({info}, schema);
+    
+    // The filter tests the data column, which may hold EU
+    ConfigDescription eu = makeConfig("eu", ConfigShape::SELECT, {"sales"});
+    eu.global_conditions = {"region = 'EU'"};
+    EXPECT_EQ(ExecutionPlanner::prune_partitions({info}, {eu}, schema).size(), 1u);
+}
+
+TEST_F(ExecutionPlannerTest, PartitionEstimatesAddUpPerTable) {
+    std::vector<InputEstimate> inputs = {makeEstimate("sales", 100000, 100.0), makeEstimate("sales", 300000, 200.0),
+                                         makeEstimate("regions", 10, 100.0)};
+    std::vector<ConfigDescription> configs = {makeConfig("report", ConfigShape::SELECT, {"sales"})};
+    
+    auto plan = ExecutionPlanner::plan(inputs, configs, OutputOptions{}, 0, 8);
+    
+    ASSERT_EQ(plan.inputs.size(), 2u);
+    const InputEstimate* sales = plan.find_input("sales");
+    ASSERT_NE(sales, nullptr);
+    EXPECT_EQ(sales->files, 2u);
+    EXPECT_EQ(sales->estimated_rows, 400000u);
+    EXPECT_EQ(sales->memory_bytes, 70000000u);
+    EXPECT_DOUBLE_EQ(sales->memory_per_row, 175.0);
+    EXPECT_EQ(plan.unused_tables, std::vector<std::string>{"regions"});
+    // One table, but each partition loads on its own thread
+    EXPECT_EQ(plan.load_threads, 2u);
+}
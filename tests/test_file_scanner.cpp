@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "file_scanner.h"
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 
@@ -234,4 +235,126 @@ TEST_F(FileScannerTest, MixedFileTypes) {
     // Should only find the PSV files
     EXPECT_EQ(files.size(), 1);
     EXPECT_EQ(files[0].name_prefix, "employees");
-}
\ No newline at end of file
+}
+// Test parallel listing of large trees
+TEST_F(FileScannerTest, ParallelScanPairsWithinEachDirectory) {
+    // 40 directories, 3 levels deep, each with one pair and one orphan data file
+    for (int top = 0; top < 4; ++top) {
+        for (int mid = 0; mid < 10; ++mid) {
+            auto dir = input_dir / ("region" + std::to_string(top)) / ("day" + std::to_string(mid));
+            std::filesystem::create_directories(dir);
+            createFile(dir / "sales.psv", std::string(100 + mid, 'x'));
+            createFile(dir / "sales_Headers.psv", "id|amount");
+            createFile(dir / "orphan.psv", "1|2");
+        }
+    }
+    
+    auto files = FileScanner::scan_input_files(input_dir.string(), 8);
+    
+    ASSERT_EQ(files.size(), 40u);
+    EXPECT_TRUE(std::is_sorted(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b) {
+        return a.path < b.path;
+    }));
+    for (const auto& file : files) {
+        EXPECT_EQ(file.name_prefix, "sales");
+        EXPECT_EQ(file.headers_path.parent_path(), file.path.parent_path());
+        EXPECT_EQ(file.size_bytes, std::filesystem::file_size(file.path));
+    }
+}
+
+TEST_F(FileScannerTest, ScanDoesNotPairAcrossDirectories) {
+    std::filesystem::create_directories(input_dir / "a");
+    std::filesystem::create_directories(input_dir / "b");
+    createFile(input_dir / "a" / "employees.psv", "1|John");
+    createFile(input_dir / "b" / "employees_Headers.psv", "id|name");
+    
+    EXPECT_TRUE(FileScanner::scan_input_files(input_dir.string()).empty());
+}
+
+TEST_F(FileScannerTest, ScanResultIndependentOfThreadCount) {
+    for (int i = 0; i < 12; ++i) {
+        auto dir = input_dir / ("part" + std::to_string(i % 3));
+        std::filesystem::create_directories(dir);
+        createFile(dir / ("table" + std::to_string(i) + ".psv"), "1");
+        createFile(dir / ("table" + std::to_string(i) + "_Headers.psv"), "id");
+        createFile(output_dir / ("report" + std::to_string(i) + "_Headers.psv"), "id");
+        createFile(output_dir / ("report" + std::to_string(i) + "_Rules.psv"), "FIELD|id|id|Copy");
+    }
+    
+    auto single = FileScanner::scan_input_files(input_dir.string(), 1);
+    auto parallel = FileScanner::scan_input_files(input_dir.string(), 6);
+    ASSERT_EQ(single.size(), 12u);
+    ASSERT_EQ(parallel.size(), single.size());
+    for (size_t i = 0; i < single.size(); ++i) {
+        EXPECT_EQ(parallel[i].path, single[i].path);
+    }
+    
+    auto outputs = FileScanner::scan_output_files(output_dir.string(), 6);
+    ASSERT_EQ(outputs.size(), 12u);
+    EXPECT_EQ(outputs[0].name_prefix, "report0");
+    EXPECT_TRUE(std::is_sorted(outputs.begin(), outputs.end(), [](const OutputFileInfo& a, const OutputFileInfo& b) {
+        return a.headers_path < b.headers_path;
+    }));
+}
+
+TEST_F(FileScannerTest, ListPsvFilesSizesOnlyDataFiles) {
+    createFile(input_dir / "employees.psv", "1|John Doe|30\n");
+    createFile(input_dir / "employees_Headers.psv", "id|name|age");
+    createFile(input_dir / "notes.txt", "ignored");
+    
+    auto listing = FileScanner::list_psv_files(input_dir, true, 2);
+    
+    ASSERT_EQ(listing.size(), 2u);
+    for (const auto& file : listing) {
+        if (file.path.filename() == "employees.psv") {
+            EXPECT_EQ(file.size_bytes, 14u);
+        } else {
+            EXPECT_EQ(file.path.filename(), "employees_Headers.psv");
+            EXPECT_EQ(file.size_bytes, 0u);
+        }
+    }
+}
+
+TEST_F(FileScannerTest, DirectoryWithHeadersIsOnePartitionedTable) {
+    auto table_dir = input_dir / "employees";
+    std::filesystem::create_directories(table_dir / "region=EU" / "year=2024");
+    std::filesystem::create_directories(table_dir / "region=US");
+    createFile(table_dir / "_Headers.psv", "id|name");
+    createFile(table_dir / "region=EU" / "year=2024" / "01.psv", "1|Ann\n");
+    createFile(table_dir / "region=US" / "01.psv", "2|Bo\n");
+    createFile(table_dir / "loose.psv", "3|Cy\n");
+    createFile(input_dir / "departments.psv", "10|Engineering\n");
+    createFile(input_dir / "departments_Headers.psv", "id|name");
+    
+    auto files = FileScanner::scan_input_files(input_dir.string(), 2);
+    
+    ASSERT_EQ(files.size(), 4u);
+    EXPECT_FALSE(files[0].is_partition());
+    EXPECT_EQ(files[0].table(), "departments");
+    
+    // Every partition carries every key of its table, empty where its path has none
+    using Values = std::vector<std::pair<std::string, std::string>>;
+    EXPECT_EQ(files[1].path, table_dir / "loose.psv");
+    EXPECT_EQ(files[1].partition_values, (Values{{"region", ""}, {"year", ""}}));
+    EXPECT_EQ(files[2].partition_values, (Values{{"region", "EU"}, {"year", "2024"}}));
+    EXPECT_EQ(files[3].partition_values, (Values{{"region", "US"}, {"year", ""}}));
+    for (size_t i = 1; i < files.size(); ++i) {
+        EXPECT_EQ(files[i].table(), "employees");
+        EXPECT_EQ(files[i].headers_path, table_dir / "_Headers.psv");
+    }
+}
+
+TEST_F(FileScannerTest, NearestTableDirectoryClaimsItsFiles) {
+    std::filesystem::create_directories(input_dir / "sales" / "archive" / "2023");
+    createFile(input_dir / "sales" / "_Headers.psv", "id|amount");
+    createFile(input_dir / "sales" / "q1.psv", "1|10\n");
+    createFile(input_dir / "sales" / "archive" / "_Headers.psv", "id|amount|note");
+    createFile(input_dir / "sales" / "archive" / "2023" / "q4.psv", "2|20|late\n");
+    
+    auto files = FileScanner::scan_input_files(input_dir.string());
+    
+    ASSERT_EQ(files.size(), 2u);
+    EXPECT_EQ(files[0].table(), "archive");
+    EXPECT_TRUE(files[0].partition_values.empty());
+    EXPECT_EQ(files[1].table(), "sales");
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "hash_join.h"
+#include <filesystem>
+#include <random>
+
+class HashJoinTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        spill_dir = std::filesystem::temp_directory_path() / "hash_join_tests";
+        std::filesystem::create_directories(spill_dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(spill_dir);
+    }
+
+    // One key column; keys repeat, some are empty and some rows are short
+    PsvTable createTable(size_t rows, size_t distinct_keys, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        PsvTable table;
+        table.headers = {"id", "key"};
+        for (size_t i = 0; i < rows; ++i) {
+            PsvRecord record;
+            record.fields.push_back(std::to_string(i));
+            if (i % 17 != 0) {
+                record.fields.push_back(i % 11 == 0 ? "" : "k" + std::to_string(rng() % distinct_keys));
+            }
+            table.records.push_back(std::move(record));
+        }
+        table.build_header_index();
+        return table;
+    }
+
+    static std::vector<std::pair<size_t, size_t>> nestedLoop(const PsvTable& left, const PsvTable& right) {
+        std::vector<std::pair<size_t, size_t>> pairs;
+        for (size_t l = 0; l < left.records.size(); ++l) {
+            for (size_t r = 0; r < right.records.size(); ++r) {
+                std::string a = left.get_field(l, "key");
+                if (!a.empty() && a == right.get_field(r, "key")) {
+                    pairs.emplace_back(l, r);
+                }
+            }
+        }
+        return pairs;
+    }
+
+    bool spillDirIsEmpty() const {
+        return std::filesystem::is_empty(spill_dir);
+    }
+
+    std::filesystem::path spill_dir;
+};
+
+TEST_F(HashJoinTest, InMemoryMatchesNestedLoopOrder) {
+    PsvTable left = createTable(500, 40, 1);
+    PsvTable right = createTable(300, 60, 2);
+    JoinStats stats;
+
+    auto pairs = HashJoin::match(left, 1, right, 1, 0, spill_dir, &stats);
+
+    EXPECT_EQ(pairs, nestedLoop(left, right));
+    EXPECT_FALSE(pairs.empty());
+    EXPECT_FALSE(stats.spilled);
+    EXPECT_EQ(stats.partitions, 1u);
+}
+
+TEST_F(HashJoinTest, SpillsPartitionsWhenOverBudget) {
+    PsvTable left = createTable(2000, 300, 3);
+    PsvTable right = createTable(1500, 300, 4);
+    JoinStats stats;
+
+    // Room for about a quarter of the right side's hash table
+    uint64_t budget = HashJoin::hash_table_bytes(right.records.size()) / 4;
+    auto pairs = HashJoin::match(left, 1, right, 1, budget, spill_dir, &stats);
+
+    EXPECT_EQ(pairs, nestedLoop(left, right));
+    EXPECT_TRUE(stats.spilled);
+    EXPECT_EQ(stats.depth, 0u);
+    EXPECT_GT(stats.partitions, 1u);
+    EXPECT_GT(stats.spilled_bytes, 0u);
+    EXPECT_TRUE(spillDirIsEmpty());
+}
+
+TEST_F(HashJoinTest, LargePartitionsArePartitionedAgain) {
+    PsvTable left = createTable(3000, 2000, 5);
+    PsvTable right = createTable(3000, 2000, 6);
+    JoinStats stats;
+
+    uint64_t budget = HashJoin::hash_table_bytes(right.records.size()) / 100;
+    auto pairs = HashJoin::match(left, 1, right, 1, budget, spill_dir, &stats);
+
+    EXPECT_EQ(pairs, nestedLoop(left, right));
+    EXPECT_GE(stats.depth, 1u);
+    EXPECT_LE(stats.depth, HashJoin::kMaxDepth);
+    EXPECT_TRUE(spillDirIsEmpty());
+}
+
+TEST_F(HashJoinTest, SkewedKeyStopsRepartitioning) {
+    // Every right row has the same key, so no hash can split the partition
+    PsvTable left = createTable(200, 1, 7);
+    PsvTable right;
+    right.headers = {"id", "key"};
+    for (size_t i = 0; i < 400; ++i) {
+        right.records.push_back({{std::to_string(i), "k0"}});
+    }
+    right.build_header_index();
+    JoinStats stats;
+
+    auto pairs = HashJoin::match(left, 1, right, 1, 64, spill_dir, &stats);
+
+    EXPECT_EQ(pairs, nestedLoop(left, right));
+    EXPECT_EQ(stats.depth, 1u);
+    EXPECT_EQ(stats.partitions, 1u);
+}
+
+TEST_F(HashJoinTest, MissingKeyColumnMatchesNothing) {
+    PsvTable left = createTable(50, 5, 8);
+    PsvTable right = createTable(50, 5, 9);
+
+    EXPECT_TRUE(HashJoin::match(left, 7, right, 1, 0).empty());
+    EXPECT_TRUE(HashJoin::match(left, 1, right, 7, 1, spill_dir).empty());
+}
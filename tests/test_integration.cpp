@@ -185,6 +185,115 @@ TEST_F(IntegrationTest, TransformationPipeline) {
                csv_content.find("Bob Johnson") != std::string::npos); // High earners
 }
 
+// Test that the projection fast path writes the same CSV as the general path
+TEST_F(IntegrationTest, ProjectionFastPathMatchesTransform) {
+    createSampleData();
+    
+    createFile(output_dir / "projection_Headers.psv", "start_salary|first_name|dept_id");
+    createFile(output_dir / "projection_Rules.psv",
+        "GLOBAL|salary >= '70000'|Only high earners\n"
+        "FIELD|start_salary|salary|Rename salary\n"
+        "FIELD|first_name|first_name|Copy name");
+    
+    auto input_files = FileScanner::scan_input_files(input_dir.string());
+    Database database;
+    for (const auto& file : input_files) {
+        database.load_table(PsvParser::parse_file(file.path, file.headers_path));
+    }
+    
+    QueryEngine query_engine(database);
+    TransformationEngine transform_engine(database, query_engine);
+    transform_engine.load_output_headers(output_dir / "projection_Headers.psv");
+    transform_engine.load_rules(output_dir / "projection_Rules.psv");
+    
+    ProjectionPlan plan;
+    ASSERT_TRUE(transform_engine.plan_projection(plan));
+    ASSERT_NE(plan.source, nullptr);
+    EXPECT_EQ(plan.source->name, "employees");
+    EXPECT_EQ(plan.column_indices, (std::vector<size_t>{4, 1, 5}));
+    
+    size_t rows_written = 0;
+    auto fast_path = output_dir / "projection_fast.csv";
+    ASSERT_TRUE(CsvWriter::write_projection(
+        transform_engine.get_output_headers(), *plan.source, plan.column_indices,
+        [&](size_t row) {
+            return transform_engine.passes_global_filters(plan.source->records[row].fields, plan.source->headers);
+        },
+        fast_path, rows_written));
+    EXPECT_EQ(rows_written, 3);
+    
+    auto general_path = output_dir / "projection_general.csv";
+    auto result = transform_engine.transform_data();
+    ASSERT_NE(result, nullptr);
+    ASSERT_TRUE(CsvWriter::write_csv(*result, general_path));
+    
+    EXPECT_EQ(readFile(fast_path), readFile(general_path));
+}
+
+// Test that streaming rows to CSV writes the same file as materializing the result
+TEST_F(IntegrationTest, StreamingTransformMatchesMaterialized) {
+    createSampleData();
+    
+    createFile(output_dir / "streamed_Headers.psv", "full_name|salary_band");
+    createFile(output_dir / "streamed_Rules.psv",
+        "GLOBAL|age >= '28'|Experienced staff\n"
+        "FIELD|full_name|UPPER(first_name)|Upper-case name\n"
+        "FIELD|salary_band|salary >= '75000' ? 'high' : 'standard'|Band");
+    
+    auto input_files = FileScanner::scan_input_files(input_dir.string());
+    Database database;
+    for (const auto& file : input_files) {
+        database.load_table(PsvParser::parse_file(file.path, file.headers_path));
+    }
+    
+    QueryEngine query_engine(database);
+    TransformationEngine transform_engine(database, query_engine);
+    transform_engine.load_output_headers(output_dir / "streamed_Headers.psv");
+    transform_engine.load_rules(output_dir / "streamed_Rules.psv");
+    
+    auto streamed_path = output_dir / "streamed.csv";
+    CsvStreamWriter writer;
+    ASSERT_TRUE(writer.open(streamed_path, transform_engine.get_output_headers()));
+    size_t emitted = transform_engine.transform_rows([&writer](std::vector<std::string>&& row) {
+        writer.write_row(row);
+    });
+    ASSERT_TRUE(writer.close());
+    EXPECT_EQ(emitted, 3);
+    EXPECT_EQ(writer.rows_written(), 3);
+    EXPECT_EQ(transform_engine.get_rows_scanned(), 4);
+    
+    auto materialized_path = output_dir / "materialized.csv";
+    auto result = transform_engine.transform_data();
+    ASSERT_NE(result, nullptr);
+    ASSERT_TRUE(CsvWriter::write_csv(*result, materialized_path));
+    
+    EXPECT_EQ(readFile(streamed_path), readFile(materialized_path));
+}
+
+// Test that computed columns disable the projection fast path
+TEST_F(IntegrationTest, ProjectionFastPathRequiresDirectColumns) {
+    createSampleData();
+    
+    createFile(output_dir / "computed_Headers.psv", "first_name|upper_last");
+    createFile(output_dir / "computed_Rules.psv",
+        "FIELD|first_name|first_name|Copy name\n"
+        "FIELD|upper_last|UPPER(last_name)|Uppercase last name");
+    
+    auto input_files = FileScanner::scan_input_files(input_dir.string());
+    Database database;
+    for (const auto& file : input_files) {
+        database.load_table(PsvParser::parse_file(file.path, file.headers_path));
+    }
+    
+    QueryEngine query_engine(database);
+    TransformationEngine transform_engine(database, query_engine);
+    transform_engine.load_output_headers(output_dir / "computed_Headers.psv");
+    transform_engine.load_rules(output_dir / "computed_Rules.psv");
+    
+    ProjectionPlan plan;
+    EXPECT_FALSE(transform_engine.plan_projection(plan));
+}
+
 // Test file scanning integration
 TEST_F(IntegrationTest, FileScanningIntegration) {
     createSampleData();
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include "job_server.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+class JobServerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "job_server_tests";
+        input_dir = test_dir / "input";
+        output_dir = test_dir / "output";
+        std::filesystem::create_directories(input_dir);
+        std::filesystem::create_directories(output_dir);
+
+        createFile(input_dir / "employees.psv", "1|John|75000\n2|Jane|65000\n3|Bob|85000\n");
+        createFile(input_dir / "employees_Headers.psv", "id|first_name|salary");
+        createFile(output_dir / "high_paid_Headers.psv", "first_name|salary");
+        createFile(output_dir / "high_paid_Rules.psv",
+                   "GLOBAL|salary >= '70000'|High\nFIELD|first_name|UPPER(first_name)|Upper");
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    void createFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream file(path);
+        file << content;
+        file.close();
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    std::filesystem::path test_dir;
+    std::filesystem::path input_dir;
+    std::filesystem::path output_dir;
+};
+
+TEST_F(JobServerTest, RunJobWritesOutputsAndReusesTables) {
+    JobServer server(1, 0);
+    JobRequest request;
+    request.input_path = input_dir.string();
+    request.output_path = output_dir.string();
+
+    JobResult first = server.run_job(request);
+    ASSERT_TRUE(first.success) << first.error;
+    ASSERT_EQ(first.configs.size(), 1u);
+    EXPECT_EQ(first.configs[0].first, "high_paid");
+    EXPECT_EQ(first.configs[0].second.rows_in, 3u);
+    EXPECT_EQ(first.configs[0].second.rows_out, 2u);
+    EXPECT_EQ(readFile(output_dir / "high_paid.csv"), "first_name,salary\nJOHN,75000\nBOB,85000\n");
+
+    JobResult second = server.run_job(request);
+    ASSERT_TRUE(second.success);
+    std::string metrics = server.metrics_text();
+    EXPECT_NE(metrics.find("agile_pasta_table_cache_misses_total 1\n"), std::string::npos);
+    EXPECT_NE(metrics.find("agile_pasta_table_cache_hits_total 1\n"), std::string::npos);
+    EXPECT_NE(metrics.find("agile_pasta_jobs_total{status=\"ok\"} 2\n"), std::string::npos);
+    EXPECT_NE(metrics.find("agile_pasta_rows_written_total 4\n"), std::string::npos);
+    EXPECT_NE(metrics.find("agile_pasta_job_duration_seconds_count 2\n"), std::string::npos);
+    EXPECT_NE(metrics.find("# TYPE agile_pasta_job_duration_seconds histogram"), std::string::npos);
+}
+
+TEST_F(JobServerTest, MissingInputIsAFailedJob) {
+    JobServer server(1, 0);
+    JobRequest request;
+    request.input_path = (test_dir / "missing").string();
+    request.output_path = output_dir.string();
+
+    JobResult result = server.run_job(request);
+
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.error.find("missing"), std::string::npos);
+    EXPECT_NE(server.metrics_text().find("agile_pasta_jobs_total{status=\"error\"} 1\n"), std::string::npos);
+}
+
+TEST_F(JobServerTest, TransformEndpointTakesFormParameters) {
+    JobServer server(1, 0);
+    std::string query = "in=" + input_dir.string() + "&out=" + output_dir.string() + "&format=jsonl";
+
+    HttpResponse response = server.handle("POST", "/transform?" + query, "");
+
+    EXPECT_EQ(response.status, 200);
+    EXPECT_EQ(response.content_type, "application/json");
+    EXPECT_EQ(response.body.rfind("{\"status\":\"ok\"", 0), 0u);
+    EXPECT_NE(response.body.find("\"rows_out\":2"), std::string::npos);
+    EXPECT_TRUE(std::filesystem::exists(output_dir / "high_paid.jsonl"));
+
+    // Parameters may come in a form body as well
+    response = server.handle("POST", "/transform", query);
+    EXPECT_EQ(response.status, 200);
+}
+
+TEST_F(JobServerTest, BadRequestsAreRejected) {
+    JobServer server(1, 0);
+
+    EXPECT_EQ(server.handle("POST", "/transform?in=/data", "").status, 400);
+    EXPECT_EQ(server.handle("POST", "/transform?in=/a&out=/b&format=parquet", "").status, 400);
+    EXPECT_EQ(server.handle("POST", "/transform?in=/a&out=/b&max_rows_per_file=ten", "").status, 400);
+    EXPECT_EQ(server.handle("GET", "/transform", "").status, 405);
+    EXPECT_EQ(server.handle("GET", "/nowhere", "").status, 404);
+    EXPECT_EQ(server.handle("GET", "/health", "").body, "ok\n");
+}
+
+TEST_F(JobServerTest, ParseFormDecodesEscapes) {
+    auto values = JobServer::parse_form("in=%2Fdata%2Fmy+input&out=/out%20dir&flag&bad=%zz");
+
+    EXPECT_EQ(values["in"], "/data/my input");
+    EXPECT_EQ(values["out"], "/out dir");
+    EXPECT_EQ(values["flag"], "");
+    EXPECT_EQ(values["bad"], "%zz");
+}
+
+TEST_F(JobServerTest, ResultJsonListsConfigsAndEscapesErrors) {
+    JobResult result;
+    result.error = "bad \"path\"";
+    ConfigRunResult config;
+    config.success = true;
+    config.rows_out = 5;
+    config.files = {"/out/a.csv"};
+    result.configs.emplace_back("a", config);
+
+    std::string json = JobServer::result_json(result);
+
+    EXPECT_NE(json.find("\"status\":\"error\""), std::string::npos);
+    EXPECT_NE(json.find("\"error\":\"bad \\\"path\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"a\",\"status\":\"ok\""), std::string::npos);
+    EXPECT_NE(json.find("\"files\":[\"/out/a.csv\"]"), std::string::npos);
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+namespace {
+
+// Send one HTTP request over the socket and return the whole reply
+std::string request_over_socket(const std::string& socket_path, const std::string& request) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    int client = -1;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        client = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            break;
+        }
+        close(client);
+        client = -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    if (client < 0) {
+        return "";
+    }
+    send(client, request.data(), request.size(), 0);
+    std::string reply;
+    char buffer[4096];
+    ssize_t got;
+    while ((got = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+        reply.append(buffer, static_cast<size_t>(got));
+    }
+    close(client);
+    return reply;
+}
+
+} // namespace
+
+TEST_F(JobServerTest, ServesJobsAndMetricsOnUnixSocket) {
+    std::string socket_path = (test_dir / "agile.sock").string();
+    JobServer server(2, 0);
+    bool served = false;
+    std::thread serving([&]() { served = server.serve(socket_path); });
+
+    std::string body = "in=" + input_dir.string() + "&out=" + output_dir.string();
+    std::string job = request_over_socket(socket_path,
+        "POST /transform HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+    std::string metrics = request_over_socket(socket_path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    std::string stop = request_over_socket(socket_path, "POST /shutdown HTTP/1.1\r\n\r\n");
+    serving.join();
+
+    EXPECT_TRUE(served);
+    EXPECT_EQ(job.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+    EXPECT_NE(job.find("\"rows_out\":2"), std::string::npos);
+    EXPECT_NE(metrics.find("agile_pasta_jobs_total{status=\"ok\"} 1"), std::string::npos);
+    EXPECT_NE(metrics.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_EQ(stop.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+    EXPECT_FALSE(std::filesystem::exists(socket_path));
+}
+
+TEST_F(JobServerTest, RefusesToReplaceNonSocketFile) {
+    std::filesystem::path not_socket = test_dir / "notes.txt";
+    createFile(not_socket, "keep me");
+    JobServer server(1, 0);
+
+    EXPECT_FALSE(server.serve(not_socket.string()));
+    EXPECT_EQ(readFile(not_socket), "keep me");
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "json_lines_writer.h"
+#include "query_engine.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+class JsonLinesWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "json_lines_writer_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    std::string escape(const std::string& value) {
+        std::string out;
+        JsonLinesWriter::append_escaped(out, value);
+        return out;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(JsonLinesWriterTest, WriteBasicRows) {
+    QueryResult result;
+    result.headers = {"id", "name"};
+    result.rows = {{"1", "John Doe"}, {"2", "Jane Smith"}};
+
+    auto path = test_dir / "basic.jsonl";
+    ASSERT_TRUE(JsonLinesWriter::write_jsonl(result, path));
+
+    EXPECT_EQ(readFile(path),
+              "{\"id\":\"1\",\"name\":\"John Doe\"}\n"
+              "{\"id\":\"2\",\"name\":\"Jane Smith\"}\n");
+}
+
+TEST_F(JsonLinesWriterTest, EscapesSpecialCharacters) {
+    EXPECT_EQ(escape("plain text value"), "plain text value");
+    EXPECT_EQ(escape("say \"hi\""), "say \\\"hi\\\"");
+    EXPECT_EQ(escape("C:\\Data\\Input"), "C:\\\\Data\\\\Input");
+    EXPECT_EQ(escape("line1\nline2\ttab"), "line1\\nline2\\ttab");
+    EXPECT_EQ(escape(std::string("bell\x07", 5)), "bell\\u0007");
+    // Non-ASCII UTF-8 passes through untouched
+    EXPECT_EQ(escape("Zo\xC3\xAB M\xC3\xBCller"), "Zo\xC3\xAB M\xC3\xBCller");
+}
+
+TEST_F(JsonLinesWriterTest, EscapesAtEveryWordPosition) {
+    // Special bytes inside, before and after the eight-byte scanning window
+    for (size_t pos = 0; pos < 20; ++pos) {
+        std::string value(20, 'a');
+        value[pos] = '"';
+        std::string expected = value.substr(0, pos) + "\\\"" + value.substr(pos + 1);
+        EXPECT_EQ(escape(value), expected) << "quote at " << pos;
+    }
+}
+
+TEST_F(JsonLinesWriterTest, MissingFieldsAreEmptyStrings) {
+    QueryResult result;
+    result.headers = {"id", "name", "age"};
+    result.rows = {{"1"}};
+
+    auto path = test_dir / "short.jsonl";
+    ASSERT_TRUE(JsonLinesWriter::write_jsonl(result, path));
+
+    EXPECT_EQ(readFile(path), "{\"id\":\"1\",\"name\":\"\",\"age\":\"\"}\n");
+}
+
+TEST_F(JsonLinesWriterTest, ParallelMatchesStreaming) {
+    QueryResult result;
+    result.headers = {"id", "comment"};
+    for (int i = 0; i < 1000; ++i) {
+        result.rows.push_back({std::to_string(i), "row \"" + std::to_string(i) + "\"\n"});
+    }
+
+    auto streaming = test_dir / "streaming.jsonl";
+    auto parallel = test_dir / "parallel.jsonl";
+    ASSERT_TRUE(JsonLinesWriter::write_jsonl(result, streaming));
+    ASSERT_TRUE(JsonLinesWriter::write_jsonl_parallel(result, parallel, 64));
+
+    EXPECT_EQ(readFile(streaming), readFile(parallel));
+}
+
+TEST_F(JsonLinesWriterTest, WriteSelectedRows) {
+    QueryResult result;
+    result.headers = {"id"};
+    result.rows = {{"1"}, {"2"}, {"3"}};
+
+    auto path = test_dir / "subset.jsonl";
+    ASSERT_TRUE(JsonLinesWriter::write_jsonl_rows(result, {2, 0}, path));
+
+    EXPECT_EQ(readFile(path), "{\"id\":\"3\"}\n{\"id\":\"1\"}\n");
+}
+
+TEST_F(JsonLinesWriterTest, WriteToInvalidPath) {
+    QueryResult result;
+    result.headers = {"id"};
+
+    EXPECT_FALSE(JsonLinesWriter::write_jsonl(result, "/invalid/nonexistent/path/output.jsonl"));
+}
\ No newline at end of file
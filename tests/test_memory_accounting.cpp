@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "memory_accounting.h"
+#include "database.h"
+#include "query_engine.h"
+#include "run_metrics.h"
+#include <memory>
+#include <unordered_map>
+
+class MemoryAccountingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        MemoryAccounting::reset();
+    }
+
+    void TearDown() override {
+        MemoryAccounting::reset();
+    }
+
+    static ComponentMemory find_component(const std::string& name) {
+        for (const auto& component : MemoryAccounting::components()) {
+            if (component.name == name) {
+                return component;
+            }
+        }
+        return ComponentMemory{};
+    }
+
+    static std::unique_ptr<PsvTable> make_table(const std::string& name, size_t rows) {
+        auto table = std::make_unique<PsvTable>();
+        table->name = name;
+        table->headers = {"id", "description"};
+        for (size_t i = 0; i < rows; ++i) {
+            PsvRecord record;
+            record.fields = {std::to_string(i), "a description long enough to leave the small buffer"};
+            table->records.push_back(record);
+        }
+        table->build_header_index();
+        return table;
+    }
+};
+
+TEST_F(MemoryAccountingTest, TracksCurrentAndPeakPerComponent) {
+    MemoryAccounting::acquire(MemoryCategory::BUFFER, "buffer", 100);
+    MemoryAccounting::acquire(MemoryCategory::BUFFER, "buffer", 50);
+    MemoryAccounting::release(MemoryCategory::BUFFER, "buffer", 120);
+
+    ComponentMemory buffer = find_component("buffer");
+    EXPECT_EQ(buffer.current_bytes, 30u);
+    EXPECT_EQ(buffer.peak_bytes, 150u);
+    EXPECT_EQ(buffer.category, MemoryCategory::BUFFER);
+}
+
+TEST_F(MemoryAccountingTest, ResetPeaksStartsNewWindow) {
+    MemoryAccounting::acquire(MemoryCategory::BUFFER, "buffer", 1000);
+    MemoryAccounting::release(MemoryCategory::BUFFER, "buffer", 800);
+    MemoryAccounting::reset_peaks();
+    
+    EXPECT_EQ(find_component("buffer").peak_bytes, 200u);
+    EXPECT_EQ(MemoryAccounting::category_total(MemoryCategory::BUFFER).peak_bytes, 200u);
+    EXPECT_EQ(MemoryAccounting::total().peak_bytes, 200u);
+    
+    MemoryAccounting::acquire(MemoryCategory::BUFFER, "buffer", 300);
+    EXPECT_EQ(MemoryAccounting::total().peak_bytes, 500u);
+}
+
+TEST_F(MemoryAccountingTest, ReleaseNeverUnderflows) {
+    MemoryAccounting::acquire(MemoryCategory::TABLE, "t", 10);
+    MemoryAccounting::release(MemoryCategory::TABLE, "t", 25);
+
+    EXPECT_EQ(find_component("t").current_bytes, 0u);
+    EXPECT_EQ(MemoryAccounting::total().current_bytes, 0u);
+}
+
+TEST_F(MemoryAccountingTest, CategoryPeakIsPeakOfSum) {
+    MemoryAccounting::acquire(MemoryCategory::RESULT, "first", 100);
+    MemoryAccounting::release(MemoryCategory::RESULT, "first", 100);
+    MemoryAccounting::acquire(MemoryCategory::RESULT, "second", 80);
+
+    ComponentMemory results = MemoryAccounting::category_total(MemoryCategory::RESULT);
+    EXPECT_EQ(results.name, "results");
+    EXPECT_EQ(results.current_bytes, 80u);
+    EXPECT_EQ(results.peak_bytes, 100u);
+
+    MemoryAccounting::acquire(MemoryCategory::TABLE, "table", 40);
+    EXPECT_EQ(MemoryAccounting::total().current_bytes, 120u);
+    EXPECT_EQ(MemoryAccounting::total().peak_bytes, 120u);
+}
+
+TEST_F(MemoryAccountingTest, ComponentsSortedByPeak) {
+    MemoryAccounting::acquire(MemoryCategory::TABLE, "small", 10);
+    MemoryAccounting::acquire(MemoryCategory::TABLE, "large", 1000);
+    MemoryAccounting::acquire(MemoryCategory::HASH_TABLE, "medium", 100);
+
+    auto components = MemoryAccounting::components();
+    ASSERT_EQ(components.size(), 3u);
+    EXPECT_EQ(components[0].name, "large");
+    EXPECT_EQ(components[1].name, "medium");
+    EXPECT_EQ(components[2].name, "small");
+}
+
+TEST_F(MemoryAccountingTest, ChargeReleasesOnDestruction) {
+    {
+        MemoryCharge charge(MemoryCategory::BUFFER, "scoped", 64);
+        charge.update(256);
+        EXPECT_EQ(find_component("scoped").current_bytes, 256u);
+        charge.update(32);
+        EXPECT_EQ(find_component("scoped").current_bytes, 32u);
+    }
+    ComponentMemory scoped = find_component("scoped");
+    EXPECT_EQ(scoped.current_bytes, 0u);
+    EXPECT_EQ(scoped.peak_bytes, 256u);
+}
+
+TEST_F(MemoryAccountingTest, MovedChargeReleasesOnce) {
+    std::unordered_map<std::string, MemoryCharge> charges;
+    {
+        MemoryCharge charge(MemoryCategory::TABLE, "moved", 100);
+        charges["moved"] = std::move(charge);
+    }
+    EXPECT_EQ(find_component("moved").current_bytes, 100u);
+
+    charges.clear();
+    EXPECT_EQ(find_component("moved").current_bytes, 0u);
+    EXPECT_EQ(MemoryAccounting::total().current_bytes, 0u);
+}
+
+TEST_F(MemoryAccountingTest, SizeEstimatesGrowWithData) {
+    auto small = make_table("small", 10);
+    auto large = make_table("large", 1000);
+    uint64_t small_bytes = MemoryAccounting::table_bytes(*small);
+    uint64_t large_bytes = MemoryAccounting::table_bytes(*large);
+
+    EXPECT_GT(large_bytes, small_bytes);
+    // Each row holds at least its field objects and the long description
+    EXPECT_GE(large_bytes, 1000 * (2 * sizeof(std::string) + 50));
+
+    QueryResult result;
+    result.headers = {"id"};
+    result.rows.assign(100, std::vector<std::string>{"value"});
+    EXPECT_GE(MemoryAccounting::result_bytes(result), 100 * sizeof(std::string));
+
+    std::unordered_map<std::string, size_t> map{{"a", 1}, {"b", 2}};
+    EXPECT_GT(MemoryAccounting::hash_table_bytes(map), 2 * sizeof(std::pair<const std::string, size_t>));
+}
+
+TEST_F(MemoryAccountingTest, DatabaseChargesLoadedTables) {
+    Database db;
+    db.load_table(make_table("employees", 100));
+
+    ComponentMemory table = find_component("table employees");
+    EXPECT_EQ(table.category, MemoryCategory::TABLE);
+    EXPECT_GT(table.current_bytes, 0u);
+
+    db.clear();
+    EXPECT_EQ(find_component("table employees").current_bytes, 0u);
+    EXPECT_EQ(find_component("table employees").peak_bytes, table.peak_bytes);
+}
+
+TEST_F(MemoryAccountingTest, MetricsReportIncludesMemory) {
+    MemoryCharge charge(MemoryCategory::HASH_TABLE, "partition map", 2048);
+
+    RunMetrics metrics;
+    std::string json = metrics.to_json();
+    EXPECT_NE(json.find("\"memory\": {\"total\": {\"name\":\"total\""), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"hash_tables\",\"current_bytes\":2048,\"peak_bytes\":2048}"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"partition map\",\"category\":\"hash_tables\",\"current_bytes\":2048,\"peak_bytes\":2048}"),
+              std::string::npos);
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "output_writer.h"
+#include "query_engine.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+class OutputWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "output_writer_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    std::unique_ptr<QueryResult> createTestResult() {
+        auto result = std::make_unique<QueryResult>();
+        result->headers = {"id", "name", "department"};
+        result->rows = {
+            {"1", "John Doe", "Engineering"},
+            {"2", "Jane Smith", "Marketing"},
+            {"3", "Bob Johnson", "Engineering"},
+            {"4", "Alice Brown", "Sales"},
+            {"5", "Carol White", "Engineering"}
+        };
+        return result;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(OutputWriterTest, WriteWithoutPartitioningProducesSingleFile) {
+    auto result = createTestResult();
+    auto output_path = test_dir / "report.csv";
+
+    std::vector<std::filesystem::path> written;
+    EXPECT_TRUE(OutputWriter::write(*result, output_path, OutputOptions{}, written));
+
+    ASSERT_EQ(written.size(), 1);
+    EXPECT_EQ(written[0], output_path);
+    EXPECT_TRUE(readFile(output_path).find("5,Carol White,Engineering") != std::string::npos);
+}
+
+TEST_F(OutputWriterTest, SplitByRowCount) {
+    auto result = createTestResult();
+    OutputOptions options;
+    options.max_rows_per_file = 2;
+
+    std::vector<std::filesystem::path> written;
+    EXPECT_TRUE(OutputWriter::write(*result, test_dir / "report.csv", options, written));
+
+    ASSERT_EQ(written.size(), 3);
+    EXPECT_EQ(written[0].filename(), "report_part0001.csv");
+    EXPECT_EQ(written[2].filename(), "report_part0003.csv");
+
+    // Every part carries the header row
+    std::string last = readFile(written[2]);
+    EXPECT_EQ(last, "id,name,department\n5,Carol White,Engineering\n");
+}
+
+TEST_F(OutputWriterTest, SplitByColumnValue) {
+    auto result = createTestResult();
+    OutputOptions options;
+    options.partition_column = "department";
+
+    std::vector<std::filesystem::path> written;
+    EXPECT_TRUE(OutputWriter::write(*result, test_dir / "report.csv", options, written));
+
+    ASSERT_EQ(written.size(), 3);
+    std::string engineering = readFile(test_dir / "report_Engineering.csv");
+    EXPECT_EQ(engineering,
+              "id,name,department\n"
+              "1,John Doe,Engineering\n"
+              "3,Bob Johnson,Engineering\n"
+              "5,Carol White,Engineering\n");
+    EXPECT_TRUE(std::filesystem::exists(test_dir / "report_Marketing.csv"));
+    EXPECT_TRUE(std::filesystem::exists(test_dir / "report_Sales.csv"));
+}
+
+TEST_F(OutputWriterTest, SplitByColumnValueAndRowCount) {
+    auto result = createTestResult();
+    OutputOptions options;
+    options.partition_column = "department";
+    options.max_rows_per_file = 2;
+
+    auto partitions = OutputWriter::plan_partitions(*result, test_dir / "report.csv", options);
+
+    ASSERT_EQ(partitions.size(), 4);
+    EXPECT_EQ(partitions[0].path.filename(), "report_Engineering_part0001.csv");
+    EXPECT_EQ(partitions[0].row_indices, (std::vector<size_t>{0, 2}));
+    EXPECT_EQ(partitions[1].path.filename(), "report_Marketing_part0001.csv");
+    EXPECT_EQ(partitions[3].path.filename(), "report_Engineering_part0002.csv");
+    EXPECT_EQ(partitions[3].row_indices, (std::vector<size_t>{4}));
+}
+
+TEST_F(OutputWriterTest, PartitionValuesAreSanitized) {
+    QueryResult result;
+    result.headers = {"id", "region"};
+    result.rows = {{"1", "North/East"}, {"2", "North_East"}, {"3", ""}};
+
+    OutputOptions options;
+    options.partition_column = "region";
+
+    auto partitions = OutputWriter::plan_partitions(result, test_dir / "report.csv", options);
+
+    ASSERT_EQ(partitions.size(), 3);
+    EXPECT_EQ(partitions[0].path.filename(), "report_North_East.csv");
+    EXPECT_EQ(partitions[1].path.filename(), "report_North_East_2.csv");
+    EXPECT_EQ(partitions[2].path.filename(), "report_empty.csv");
+}
+
+TEST_F(OutputWriterTest, NumberedNamesSkipNamesAlreadyTaken) {
+    QueryResult result;
+    result.headers = {"id", "region"};
+    result.rows = {{"1", "a_b_2"}, {"2", "a b"}, {"3", "a/b"}, {"4", "a_b_3"}};
+
+    OutputOptions options;
+    options.partition_column = "region";
+
+    auto partitions = OutputWriter::plan_partitions(result, test_dir / "report.csv", options);
+
+    // "a/b" must not be numbered onto the file of the value "a_b_2"
+    ASSERT_EQ(partitions.size(), 4);
+    EXPECT_EQ(partitions[0].path.filename(), "report_a_b_2.csv");
+    EXPECT_EQ(partitions[1].path.filename(), "report_a_b.csv");
+    EXPECT_EQ(partitions[2].path.filename(), "report_a_b_3.csv");
+    EXPECT_EQ(partitions[3].path.filename(), "report_a_b_3_2.csv");
+}
+
+TEST_F(OutputWriterTest, UnknownPartitionColumnFallsBackToSingleFile) {
+    auto result = createTestResult();
+    OutputOptions options;
+    options.partition_column = "missing";
+
+    auto partitions = OutputWriter::plan_partitions(*result, test_dir / "report.csv", options);
+
+    ASSERT_EQ(partitions.size(), 1);
+    EXPECT_EQ(partitions[0].path.filename(), "report.csv");
+    EXPECT_EQ(partitions[0].row_indices.size(), 5);
+}
+
+TEST_F(OutputWriterTest, EmptyResultStillWritesHeaders) {
+    QueryResult result;
+    result.headers = {"id", "name"};
+
+    OutputOptions options;
+    options.max_rows_per_file = 10;
+
+    std::vector<std::filesystem::path> written;
+    EXPECT_TRUE(OutputWriter::write(result, test_dir / "report.csv", options, written));
+
+    ASSERT_EQ(written.size(), 1);
+    EXPECT_EQ(readFile(written[0]), "id,name\n");
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "perf_counters.h"
+#include "run_metrics.h"
+#include <cstdint>
+
+class PerfCountersTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        PerfCounters::disable();
+    }
+};
+
+TEST_F(PerfCountersTest, IpcNeedsCyclesAndInstructions) {
+    PerfSample sample;
+    sample.cycles = 200;
+    sample.instructions = 500;
+    sample.valid = PerfSample::CYCLES;
+    EXPECT_DOUBLE_EQ(sample.ipc(), 0.0);
+
+    sample.valid |= PerfSample::INSTRUCTIONS;
+    EXPECT_DOUBLE_EQ(sample.ipc(), 2.5);
+}
+
+TEST_F(PerfCountersTest, SinceKeepsCountersValidInBoth) {
+    PerfSample start;
+    start.cycles = 100;
+    start.cache_misses = 10;
+    start.valid = PerfSample::CYCLES | PerfSample::CACHE_MISSES;
+
+    PerfSample end;
+    end.cycles = 350;
+    end.cache_misses = 25;
+    end.branch_misses = 7;
+    end.valid = PerfSample::CYCLES | PerfSample::CACHE_MISSES | PerfSample::BRANCH_MISSES;
+
+    PerfSample delta = end.since(start);
+    EXPECT_TRUE(delta.has(PerfSample::CYCLES));
+    EXPECT_TRUE(delta.has(PerfSample::CACHE_MISSES));
+    EXPECT_FALSE(delta.has(PerfSample::BRANCH_MISSES));
+    EXPECT_EQ(delta.cycles, 250u);
+    EXPECT_EQ(delta.cache_misses, 15u);
+    EXPECT_EQ(delta.branch_misses, 0u);
+}
+
+TEST_F(PerfCountersTest, DisabledReadIsEmpty) {
+    EXPECT_FALSE(PerfCounters::enabled());
+    EXPECT_EQ(PerfCounters::read().valid, 0u);
+    EXPECT_EQ(PerfCounters::reason(), "not enabled");
+}
+
+TEST_F(PerfCountersTest, EnableMeasuresOrExplains) {
+    bool opened = PerfCounters::enable();
+    EXPECT_EQ(PerfCounters::enabled(), opened);
+    EXPECT_FALSE(PerfCounters::reason().empty());
+
+    if (!opened) {
+        // No PMU access here (container, VM or paranoid setting): samples stay empty
+        EXPECT_EQ(PerfCounters::read().valid, 0u);
+        return;
+    }
+
+    PerfSample start = PerfCounters::read();
+    volatile uint64_t sum = 0;
+    for (uint64_t i = 0; i < 1000000; ++i) {
+        sum = sum + i;
+    }
+    PerfSample delta = PerfCounters::read().since(start);
+    EXPECT_NE(delta.valid, 0u);
+    if (delta.has(PerfSample::INSTRUCTIONS)) {
+        EXPECT_GT(delta.instructions, 1000000u);
+    }
+}
+
+TEST_F(PerfCountersTest, MetricsReportIncludesPerfFields) {
+    RunMetrics metrics;
+    metrics.set_perf_status("measuring cycles, instructions, cache-misses");
+
+    StageMetrics stage;
+    stage.name = "load";
+    stage.rows_in = 100;
+    stage.perf.cycles = 1000;
+    stage.perf.instructions = 3000;
+    stage.perf.cache_misses = 50;
+    stage.perf.valid = PerfSample::CYCLES | PerfSample::INSTRUCTIONS | PerfSample::CACHE_MISSES;
+    metrics.record(RunMetrics::Category::PHASE, stage);
+
+    std::string json = metrics.to_json();
+    EXPECT_NE(json.find("\"perf\":{\"cycles\":1000,\"instructions\":3000,\"ipc\":3.000000,"
+                        "\"cache_misses\":50,\"cache_misses_per_row\":0.500000}"),
+              std::string::npos);
+    EXPECT_EQ(json.find("branch_misses"), std::string::npos);
+    EXPECT_NE(json.find("\"perf_counters\": {\"status\":\"measuring cycles, instructions, cache-misses\"}"),
+              std::string::npos);
+}
+
+TEST_F(PerfCountersTest, MetricsReportOmitsPerfWhenOff) {
+    RunMetrics metrics;
+    StageMetrics stage;
+    stage.name = "load";
+    metrics.record(RunMetrics::Category::PHASE, stage);
+
+    std::string json = metrics.to_json();
+    EXPECT_EQ(json.find("\"perf\""), std::string::npos);
+    EXPECT_EQ(json.find("perf_counters"), std::string::npos);
+}
@@ -200,10 +200,36 @@ TEST_F(QueryEngineTest, JoinNonExistentTable) {
     EXPECT_EQ(result, nullptr);
 }
 
+TEST_F(QueryEngineTest, JoinOverMemoryBudgetSpillsWithSameResult) {
+    auto in_memory = query_engine->join("employees", "departments", "dept_id = id", JoinType::INNER);
+    EXPECT_FALSE(query_engine->last_join_stats().spilled);
+    
+    query_engine->set_join_memory_budget(1);
+    auto spilled = query_engine->join("employees", "departments", "dept_id = id", JoinType::INNER);
+    
+    ASSERT_NE(spilled, nullptr);
+    EXPECT_TRUE(query_engine->last_join_stats().spilled);
+    EXPECT_EQ(spilled->headers, in_memory->headers);
+    EXPECT_EQ(spilled->rows, in_memory->rows);
+}
+
 TEST_F(QueryEngineTest, JoinWithInvalidCondition) {
     auto result = query_engine->join("employees", "departments", "");
     
     // Should handle gracefully - implementation dependent
     // At minimum should not crash
     EXPECT_TRUE(result == nullptr || result->rows.empty());
-}
\ No newline at end of file
+}
+TEST_F(QueryEngineTest, SelectMatchingCopiesOnlyAcceptedRecords) {
+    const PsvTable* employees = database.get_table("employees");
+    size_t salary = employees->header_index.at("salary");
+    
+    auto result = query_engine->select_matching("employees", {"name", "missing"},
+        [salary](const PsvTable& table, size_t row) { return table.field(row, salary) == "85000"; });
+    
+    ASSERT_NE(result, nullptr);
+    ASSERT_EQ(result->rows.size(), 1);
+    EXPECT_EQ(result->rows[0][0], "Bob Johnson");
+    EXPECT_EQ(result->rows[0][1], "");
+    EXPECT_EQ(query_engine->select_matching("nonexistent", {}, [](const PsvTable&, size_t) { return true; }), nullptr);
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "query_explainer.h"
+#include <filesystem>
+#include <fstream>
+
+class QueryExplainerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "query_explainer_tests";
+        std::filesystem::create_directories(test_dir);
+
+        input_dir = test_dir / "input";
+        output_dir = test_dir / "output";
+        scratch_dir = test_dir / "scratch";
+        std::filesystem::create_directories(input_dir);
+        std::filesystem::create_directories(output_dir);
+        std::filesystem::create_directories(scratch_dir);
+
+        inputs = {
+            createInput("employees", "id|first_name|salary|dept_id",
+                        "1|John|75000|10\n2|Jane|65000|20\n3|Bob|85000|10\n"),
+            createInput("departments", "dept_id|dept_name", "10|Engineering\n20|Marketing\n"),
+            createInput("temps", "id|first_name|salary|dept_id", "9|Zed|50000|20\n")
+        };
+        QueryExplainer::load_samples(inputs, samples);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    void createFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream file(path);
+        file << content;
+        file.close();
+    }
+
+    FileInfo createInput(const std::string& name, const std::string& headers, const std::string& data) {
+        createFile(input_dir / (name + ".psv"), data);
+        createFile(input_dir / (name + "_Headers.psv"), headers);
+
+        FileInfo info;
+        info.path = input_dir / (name + ".psv");
+        info.headers_path = input_dir / (name + "_Headers.psv");
+        info.size_bytes = std::filesystem::file_size(info.path);
+        info.name_prefix = name;
+        return info;
+    }
+
+    OutputFileInfo createConfig(const std::string& name, const std::string& headers, const std::string& rules) {
+        createFile(output_dir / (name + "_Headers.psv"), headers);
+        createFile(output_dir / (name + "_Rules.psv"), rules);
+
+        OutputFileInfo info;
+        info.headers_path = output_dir / (name + "_Headers.psv");
+        info.rules_path = output_dir / (name + "_Rules.psv");
+        info.name_prefix = name;
+        return info;
+    }
+
+    // Plan one config the way the explain command does
+    ExecutionPlan planFor(const OutputFileInfo& config, const OutputOptions& options = OutputOptions()) {
+        std::vector<InputEstimate> estimates;
+        for (const auto& input : inputs) {
+            estimates.push_back(ExecutionPlanner::estimate_input(input));
+        }
+        Database schema;
+        ExecutionPlanner::load_schemas(inputs, schema);
+        return ExecutionPlanner::plan(estimates, {ExecutionPlanner::describe_config(config, schema)},
+                                      options, 0, 4);
+    }
+
+    static const PlanOperator* find(const PlanOperator& root, const std::string& name) {
+        if (root.name == name) {
+            return &root;
+        }
+        for (const auto& input : root.inputs) {
+            if (const PlanOperator* found = find(input, name)) {
+                return found;
+            }
+        }
+        return nullptr;
+    }
+
+    std::filesystem::path test_dir;
+    std::filesystem::path input_dir;
+    std::filesystem::path output_dir;
+    std::filesystem::path scratch_dir;
+    std::vector<FileInfo> inputs;
+    Database samples;
+};
+
+TEST_F(QueryExplainerTest, SelectTreeHasFilterSelectivityFromSample) {
+    auto config = createConfig("high_paid", "first_name|salary",
+                               "GLOBAL|salary >= '70000'|High\nFIELD|first_name|UPPER(first_name)|Upper");
+    ExecutionPlan plan = planFor(config);
+
+    PlanOperator root = QueryExplainer::build(config, plan.configs[0], plan, samples, OutputOptions());
+
+    EXPECT_EQ(root.name, "Write");
+    ASSERT_EQ(root.inputs.size(), 1u);
+    EXPECT_EQ(root.inputs[0].name, "Project");
+
+    const PlanOperator* filter = find(root, "Filter");
+    ASSERT_NE(filter, nullptr);
+    EXPECT_EQ(filter->detail, "salary >= '70000'");
+    EXPECT_NEAR(filter->selectivity, 2.0 / 3.0, 1e-9);
+    EXPECT_NEAR(filter->estimated_rows, 2.0, 1e-9);
+
+    const PlanOperator* scan = find(root, "Scan");
+    ASSERT_NE(scan, nullptr);
+    EXPECT_EQ(scan->detail, "employees");
+    EXPECT_DOUBLE_EQ(scan->estimated_rows, 3.0);
+    EXPECT_NEAR(root.estimated_rows, 2.0, 1e-9);
+}
+
+TEST_F(QueryExplainerTest, JoinEstimateUsesKeyDistinctCounts) {
+    auto config = createConfig("staff", "first_name|dept_name",
+                               "GLOBAL|Join employees.dept_id = departments.dept_id|Join\n"
+                               "FIELD|first_name|first_name|Copy\nFIELD|dept_name|dept_name|Copy");
+    ExecutionPlan plan = planFor(config);
+
+    PlanOperator root = QueryExplainer::build(config, plan.configs[0], plan, samples, OutputOptions());
+
+    const PlanOperator* join = find(root, "Join");
+    ASSERT_NE(join, nullptr);
+    EXPECT_NE(join->detail.find("hash join"), std::string::npos);
+    EXPECT_NE(join->detail.find("employees.dept_id = departments.dept_id"), std::string::npos);
+    ASSERT_EQ(join->inputs.size(), 2u);
+    EXPECT_EQ(join->inputs[0].detail, "employees");
+    EXPECT_EQ(join->inputs[1].detail, "departments");
+    // 3 x 2 rows over 2 distinct departments
+    EXPECT_DOUBLE_EQ(join->estimated_rows, 3.0);
+    EXPECT_EQ(find(root, "Filter"), nullptr);
+}
+
+TEST_F(QueryExplainerTest, JoinRowsFormula) {
+    // Foreign key into a unique key: one match per row
+    EXPECT_DOUBLE_EQ(QueryExplainer::join_rows(1000, 10, 10, 10), 1000.0);
+    // Unique on both sides
+    EXPECT_DOUBLE_EQ(QueryExplainer::join_rows(500, 500, 500, 500), 500.0);
+    // No distinct counts known
+    EXPECT_DOUBLE_EQ(QueryExplainer::join_rows(4, 0, 5, 0), 20.0);
+}
+
+TEST_F(QueryExplainerTest, UnionSumsInputs) {
+    auto config = createConfig("everyone", "first_name",
+                               "GLOBAL|Union employees,temps|All\nFIELD|first_name|first_name|Copy");
+    ExecutionPlan plan = planFor(config);
+
+    PlanOperator root = QueryExplainer::build(config, plan.configs[0], plan, samples, OutputOptions());
+
+    const PlanOperator* union_op = find(root, "Union");
+    ASSERT_NE(union_op, nullptr);
+    EXPECT_EQ(union_op->inputs.size(), 2u);
+    EXPECT_DOUBLE_EQ(union_op->estimated_rows, 4.0);
+}
+
+TEST_F(QueryExplainerTest, StaticConfigIsOneValuesRow) {
+    auto config = createConfig("constant", "greeting", "FIELD|greeting|\"Hello\"|Constant");
+    ExecutionPlan plan = planFor(config);
+
+    PlanOperator root = QueryExplainer::build(config, plan.configs[0], plan, samples, OutputOptions());
+
+    const PlanOperator* values = find(root, "Values");
+    ASSERT_NE(values, nullptr);
+    EXPECT_DOUBLE_EQ(values->estimated_rows, 1.0);
+    EXPECT_EQ(find(root, "Scan"), nullptr);
+}
+
+TEST_F(QueryExplainerTest, AnalyzeRecordsActualRowsWithoutTouchingOutputDir) {
+    auto config = createConfig("high_paid", "first_name|salary",
+                               "GLOBAL|salary >= '70000'|High\nFIELD|first_name|UPPER(first_name)|Upper");
+    ExecutionPlan plan = planFor(config);
+    PlanOperator root = QueryExplainer::build(config, plan.configs[0], plan, samples, OutputOptions());
+
+    ASSERT_TRUE(QueryExplainer::analyze(root, config, plan.configs[0], inputs, OutputOptions(), scratch_dir));
+
+    EXPECT_TRUE(root.analyzed);
+    EXPECT_EQ(root.actual_rows, 2u);
+    EXPECT_EQ(find(root, "Filter")->actual_rows, 2u);
+    EXPECT_EQ(find(root, "Scan")->actual_rows, 3u);
+    EXPECT_GT(find(root, "Scan")->memory_bytes, 0u);
+    EXPECT_NE(root.detail.find("written"), std::string::npos);
+
+    EXPECT_TRUE(std::filesystem::exists(scratch_dir / "high_paid" / "high_paid.csv"));
+    EXPECT_FALSE(std::filesystem::exists(output_dir / "high_paid.csv"));
+}
+
+TEST_F(QueryExplainerTest, AnalyzeMaterializedJoin) {
+    auto config = createConfig("staff", "first_name|dept_name",
+                               "GLOBAL|Join employees.dept_id = departments.dept_id|Join\n"
+                               "FIELD|first_name|first_name|Copy\nFIELD|dept_name|dept_name|Copy");
+    OutputOptions options;
+    options.format = OutputFormat::JSON_LINES;
+    ExecutionPlan plan = planFor(config, options);
+    ASSERT_FALSE(plan.configs[0].stream_rows);
+    PlanOperator root = QueryExplainer::build(config, plan.configs[0], plan, samples, options);
+
+    ASSERT_TRUE(QueryExplainer::analyze(root, config, plan.configs[0], inputs, options, scratch_dir));
+
+    const PlanOperator* join = find(root, "Join");
+    EXPECT_TRUE(join->analyzed);
+    EXPECT_EQ(join->actual_rows, 3u);
+    EXPECT_GT(join->memory_bytes, 0u);
+    EXPECT_EQ(find(root, "Project")->actual_rows, 3u);
+    EXPECT_GT(find(root, "Project")->memory_bytes, 0u);
+    EXPECT_TRUE(std::filesystem::exists(scratch_dir / "staff" / "staff.jsonl"));
+}
+
+TEST_F(QueryExplainerTest, RenderIndentsInputsAndShowsActuals) {
+    auto config = createConfig("high_paid", "first_name|salary",
+                               "GLOBAL|salary >= '70000'|High\nFIELD|first_name|UPPER(first_name)|Upper");
+    ExecutionPlan plan = planFor(config);
+    PlanOperator root = QueryExplainer::build(config, plan.configs[0], plan, samples, OutputOptions());
+
+    auto lines = QueryExplainer::render(root);
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(lines[0].rfind("Write csv high_paid.csv", 0), 0u);
+    EXPECT_EQ(lines[1].rfind("   -> Project", 0), 0u);
+    EXPECT_NE(lines[2].find("selectivity 0.67, rows ~2"), std::string::npos);
+    EXPECT_EQ(lines[3].rfind("         -> Scan employees", 0), 0u);
+    EXPECT_EQ(lines[0].find("actual"), std::string::npos);
+
+    QueryExplainer::analyze(root, config, plan.configs[0], inputs, OutputOptions(), scratch_dir);
+    lines = QueryExplainer::render(root);
+    EXPECT_NE(lines[3].find("actual rows 3"), std::string::npos);
+}
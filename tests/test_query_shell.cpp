@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "query_shell.h"
+#include <sstream>
+
+class QueryShellTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        database.load_table(createTable("employees", {"id", "name", "dept_id", "salary"},
+                                        {{"1", "John", "10", "75000"},
+                                         {"2", "Jane", "20", "65000"},
+                                         {"3", "Bob", "10", "85000"},
+                                         {"4", "Alice", "30", "9000"}}));
+        database.load_table(createTable("departments", {"dept_id", "dept_name"},
+                                        {{"10", "Engineering"}, {"20", "Marketing"}}));
+    }
+
+    std::unique_ptr<PsvTable> createTable(const std::string& name,
+                                          const std::vector<std::string>& headers,
+                                          const std::vector<std::vector<std::string>>& data) {
+        auto table = std::make_unique<PsvTable>();
+        table->name = name;
+        table->headers = headers;
+        for (const auto& row : data) {
+            PsvRecord record;
+            record.fields = row;
+            table->records.push_back(record);
+        }
+        table->build_header_index();
+        return table;
+    }
+
+    std::unique_ptr<QueryResult> run(QueryShell& shell, const std::string& sql) {
+        return shell.execute(QueryShell::parse(sql));
+    }
+
+    Database database;
+};
+
+TEST_F(QueryShellTest, ParseFullStatement) {
+    auto statement = QueryShell::parse(
+        "select dept_name, count(*) as staff, AVG(salary) FROM employees "
+        "JOIN departments ON employees.dept_id = departments.dept_id "
+        "WHERE salary >= 70000 AND name != 'O''Brien' GROUP BY dept_name ORDER BY staff DESC LIMIT 5;");
+
+    ASSERT_EQ(statement.columns.size(), 3u);
+    EXPECT_EQ(statement.columns[0].label, "dept_name");
+    EXPECT_EQ(statement.columns[1].aggregate, "COUNT");
+    EXPECT_EQ(statement.columns[1].label, "staff");
+    EXPECT_EQ(statement.columns[2].label, "AVG(salary)");
+    EXPECT_EQ(statement.table, "employees");
+    EXPECT_EQ(statement.join_table, "departments");
+    EXPECT_EQ(statement.join_condition, "employees.dept_id = departments.dept_id");
+    ASSERT_EQ(statement.where.size(), 2u);
+    EXPECT_EQ(statement.where[0].op, ">=");
+    EXPECT_EQ(statement.where[1].value, "O'Brien");
+    EXPECT_EQ(statement.group_by, std::vector<std::string>{"dept_name"});
+    EXPECT_EQ(statement.order_by, "staff");
+    EXPECT_TRUE(statement.descending);
+    EXPECT_EQ(statement.limit, 5u);
+}
+
+TEST_F(QueryShellTest, ParseErrorsNameTheProblem) {
+    EXPECT_THROW(QueryShell::parse("SELECT name employees"), std::runtime_error);
+    EXPECT_THROW(QueryShell::parse("SELECT * FROM employees WHERE id = 1 OR id = 2"), std::runtime_error);
+    EXPECT_THROW(QueryShell::parse("SELECT * FROM employees LIMIT many"), std::runtime_error);
+    EXPECT_THROW(QueryShell::parse("SELECT * FROM employees WHERE name = 'open"), std::runtime_error);
+    EXPECT_THROW(QueryShell::parse("SELECT SUM(*) FROM employees"), std::runtime_error);
+    try {
+        QueryShell::parse("SELECT * FROM employees extra");
+        FAIL();
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("extra"), std::string::npos);
+    }
+}
+
+TEST_F(QueryShellTest, WhereComparesNumbersNumerically) {
+    QueryShell shell(database);
+
+    // "9000" sorts after "70000" as text, but not as a number
+    auto result = run(shell, "SELECT name FROM employees WHERE salary < 70000");
+    ASSERT_EQ(result->rows.size(), 2u);
+    EXPECT_EQ(result->rows[0][0], "Jane");
+    EXPECT_EQ(result->rows[1][0], "Alice");
+
+    result = run(shell, "SELECT employees.name, id FROM employees WHERE name = 'Bob' AND dept_id = 10");
+    ASSERT_EQ(result->rows.size(), 1u);
+    EXPECT_EQ(result->headers, (std::vector<std::string>{"employees.name", "id"}));
+    EXPECT_EQ(result->rows[0], (std::vector<std::string>{"Bob", "3"}));
+}
+
+TEST_F(QueryShellTest, JoinResolvesBareAndQualifiedColumns) {
+    QueryShell shell(database);
+
+    auto result = run(shell, "SELECT name, dept_name FROM employees JOIN departments "
+                             "ON departments.dept_id = employees.dept_id WHERE salary > 70000");
+    ASSERT_EQ(result->rows.size(), 2u);
+    EXPECT_EQ(result->rows[0], (std::vector<std::string>{"John", "Engineering"}));
+    EXPECT_EQ(result->rows[1], (std::vector<std::string>{"Bob", "Engineering"}));
+
+    EXPECT_THROW(run(shell, "SELECT dept_id FROM employees JOIN departments ON employees.dept_id = departments.dept_id"),
+                 std::runtime_error);
+    EXPECT_EQ(run(shell, "SELECT departments.dept_id FROM employees JOIN departments "
+                         "ON employees.dept_id = departments.dept_id")->rows.size(), 3u);
+}
+
+TEST_F(QueryShellTest, GroupByWithAggregatesOrderAndLimit) {
+    QueryShell shell(database);
+
+    auto result = run(shell, "SELECT dept_id, COUNT(*) AS staff, SUM(salary), MAX(name) FROM employees "
+                             "GROUP BY dept_id ORDER BY staff DESC LIMIT 2");
+
+    EXPECT_EQ(result->headers, (std::vector<std::string>{"dept_id", "staff", "SUM(salary)", "MAX(name)"}));
+    ASSERT_EQ(result->rows.size(), 2u);
+    EXPECT_EQ(result->rows[0], (std::vector<std::string>{"10", "2", "160000", "John"}));
+    EXPECT_EQ(result->rows[1][0], "20");
+
+    EXPECT_THROW(run(shell, "SELECT name, COUNT(*) FROM employees GROUP BY dept_id"), std::runtime_error);
+}
+
+TEST_F(QueryShellTest, AggregatesOverNoRowsGiveOneRow) {
+    QueryShell shell(database);
+
+    auto result = run(shell, "SELECT COUNT(*), AVG(salary) FROM employees WHERE salary > 1000000");
+
+    ASSERT_EQ(result->rows.size(), 1u);
+    EXPECT_EQ(result->rows[0], (std::vector<std::string>{"0", ""}));
+    EXPECT_EQ(run(shell, "SELECT AVG(salary) FROM employees WHERE dept_id = 10")->rows[0][0], "80000");
+}
+
+TEST_F(QueryShellTest, UnknownTablesAndColumnsAreErrors) {
+    QueryShell shell(database);
+
+    EXPECT_THROW(run(shell, "SELECT * FROM payroll"), std::runtime_error);
+    EXPECT_THROW(run(shell, "SELECT bonus FROM employees"), std::runtime_error);
+    EXPECT_THROW(run(shell, "SELECT * FROM employees JOIN payroll ON employees.id = payroll.id"), std::runtime_error);
+}
+
+TEST_F(QueryShellTest, ColumnStatsAreComputedOnce) {
+    QueryShell shell(database);
+
+    const auto& stats = shell.column_stats("employees");
+    ASSERT_EQ(stats.size(), 4u);
+    EXPECT_EQ(stats[2].name, "dept_id");
+    EXPECT_EQ(stats[2].distinct, 3u);
+    EXPECT_EQ(stats[3].min, "9000");
+    EXPECT_EQ(stats[3].max, "85000");
+    EXPECT_TRUE(stats[3].numeric);
+    EXPECT_FALSE(stats[1].numeric);
+    EXPECT_EQ(&shell.column_stats("employees"), &stats);
+}
+
+TEST_F(QueryShellTest, RunReadsMultiLineStatementsAndDotCommands) {
+    QueryShell shell(database);
+    std::istringstream in("SELECT name\n  FROM employees\n  WHERE id = 3;\n.tables\nSELECT * FROM nowhere;\n"
+                          ".quit\nSELECT * FROM employees;\n");
+    std::ostringstream out;
+
+    shell.run(in, out, false);
+
+    std::string text = out.str();
+    EXPECT_NE(text.find("name\n----\nBob\n(1 row,"), std::string::npos);
+    EXPECT_NE(text.find("departments | 2    | 2"), std::string::npos);
+    EXPECT_NE(text.find("Error: Unknown table: nowhere"), std::string::npos);
+    // Nothing runs after .quit
+    EXPECT_EQ(text.find("Alice"), std::string::npos);
+}
+
+TEST_F(QueryShellTest, FormatTableAlignsColumnsAndCapsRows) {
+    QueryResult result;
+    result.headers = {"id", "name"};
+    result.rows = {{"1", "John"}, {"22", std::string(50, 'x')}, {"3", "Bob"}};
+
+    auto lines = QueryShell::format_table(result, 2);
+
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(lines[0], "id | name");
+    EXPECT_EQ(lines[1].substr(0, 5), "---+-");
+    EXPECT_EQ(lines[2], "1  | John");
+    EXPECT_EQ(lines[3].size(), 5u + 40u);
+    EXPECT_EQ(lines[3].substr(lines[3].size() - 3), "...");
+    EXPECT_EQ(lines[4], "... 1 more rows (add LIMIT or GROUP BY)");
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "run_checkpoint.h"
+#include <filesystem>
+#include <fstream>
+
+class RunCheckpointTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "run_checkpoint_tests";
+        std::filesystem::create_directories(root / "reports");
+        config.headers_path = root / "reports" / "summary_Headers.psv";
+        config.rules_path = root / "reports" / "summary_Rules.psv";
+        config.name_prefix = "summary";
+        writeFile(config.headers_path, "name|salary\n");
+        writeFile(config.rules_path, "FIELD|name|name|Copy\n");
+        writeFile(root / "reports" / "summary.csv", "name,salary\nAnn,10\n");
+
+        input.path = root / "employees.psv";
+        input.headers_path = root / "employees_Headers.psv";
+        input.name_prefix = "employees";
+        writeFile(input.path, "Ann|10\n");
+        writeFile(input.headers_path, "name|salary\n");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    static void writeFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream(path, std::ios::trunc) << content;
+    }
+
+    ConfigCheckpoint completed(const std::string& signature) {
+        return ConfigCheckpoint{true, 1, 19, signature, {"summary.csv"}};
+    }
+
+    std::filesystem::path root;
+    OutputFileInfo config;
+    FileInfo input;
+};
+
+TEST_F(RunCheckpointTest, ResumedRunFindsRecordedConfigs) {
+    {
+        RunCheckpoint checkpoint(root, false);
+        EXPECT_EQ(checkpoint.key(config), "reports/summary");
+        ASSERT_TRUE(checkpoint.record(config, completed("abc")));
+    }
+    EXPECT_TRUE(std::filesystem::exists(root / RunCheckpoint::kFileName));
+
+    RunCheckpoint resumed(root, true);
+    const ConfigCheckpoint* entry = resumed.find(config, "abc");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_TRUE(entry->done);
+    EXPECT_EQ(entry->rows, 1u);
+    EXPECT_EQ(entry->files, std::vector<std::string>{"summary.csv"});
+    EXPECT_EQ(resumed.find(config, "other"), nullptr);
+}
+
+TEST_F(RunCheckpointTest, ChangedOrMissingFilesAreRedone) {
+    RunCheckpoint checkpoint(root, false);
+    checkpoint.record(config, completed("abc"));
+
+    writeFile(root / "reports" / "summary.csv", "name,salary\nAnn,11\nBob,20\n");
+    EXPECT_EQ(RunCheckpoint(root, true).find(config, "abc"), nullptr);
+
+    std::filesystem::remove(root / "reports" / "summary.csv");
+    EXPECT_EQ(RunCheckpoint(root, true).find(config, "abc"), nullptr);
+}
+
+TEST_F(RunCheckpointTest, PartialOutputMayHaveGrownPastItsCheckpoint) {
+    RunCheckpoint checkpoint(root, false);
+    checkpoint.record(config, ConfigCheckpoint{false, 0, 12, "abc", {"summary.csv"}});
+
+    RunCheckpoint resumed(root, true);
+    const ConfigCheckpoint* entry = resumed.find(config, "abc");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_FALSE(entry->done);
+
+    checkpoint.record(config, ConfigCheckpoint{false, 5, 500, "abc", {"summary.csv"}});
+    EXPECT_EQ(RunCheckpoint(root, true).find(config, "abc"), nullptr);
+}
+
+TEST_F(RunCheckpointTest, NewRunDiscardsAndFinishRemovesTheCheckpoint) {
+    RunCheckpoint(root, false).record(config, completed("abc"));
+
+    RunCheckpoint fresh(root, false);
+    EXPECT_EQ(fresh.size(), 0u);
+    EXPECT_FALSE(std::filesystem::exists(fresh.path()));
+
+    fresh.record(config, completed("abc"));
+    fresh.finish();
+    EXPECT_FALSE(std::filesystem::exists(fresh.path()));
+}
+
+TEST_F(RunCheckpointTest, SignatureFollowsInputsRulesAndOptions) {
+    OutputOptions options;
+    std::string base = RunCheckpoint::signature(config, {input}, {"employees"}, options);
+    EXPECT_EQ(base.size(), 16u);
+    EXPECT_EQ(RunCheckpoint::signature(config, {input}, {"employees"}, options), base);
+
+    // Inputs of tables the config does not read do not count
+    EXPECT_EQ(RunCheckpoint::signature(config, {input}, {"departments"}, options),
+              RunCheckpoint::signature(config, {}, {"departments"}, options));
+
+    OutputOptions split = options;
+    split.max_rows_per_file = 100;
+    EXPECT_NE(RunCheckpoint::signature(config, {input}, {"employees"}, split), base);
+
+    writeFile(input.path, "Ann|10\nBob|20\n");
+    EXPECT_NE(RunCheckpoint::signature(config, {input}, {"employees"}, options), base);
+
+    writeFile(config.rules_path, "FIELD|name|UPPER(name)|Upper\n");
+    std::string changed_rules = RunCheckpoint::signature(config, {input}, {"employees"}, options);
+    EXPECT_NE(changed_rules, base);
+}
+
+TEST_F(RunCheckpointTest, SyncFileNeedsAnExistingFile) {
+    EXPECT_TRUE(RunCheckpoint::sync_file(input.path));
+    EXPECT_FALSE(RunCheckpoint::sync_file(root / "missing.psv"));
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "run_metrics.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+class RunMetricsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "run_metrics_tests";
+        std::filesystem::create_directories(test_dir);
+        // As a run with --metrics does
+        AllocationCounter::enable();
+    }
+
+    void TearDown() override {
+        AllocationCounter::disable();
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(RunMetricsTest, CountsAllocations) {
+    uint64_t allocations = AllocationCounter::allocations();
+    uint64_t bytes = AllocationCounter::allocated_bytes();
+
+    std::vector<std::unique_ptr<int>> values;
+    values.reserve(16);
+    for (int i = 0; i < 16; ++i) {
+        values.push_back(std::make_unique<int>(i));
+    }
+
+    EXPECT_GE(AllocationCounter::allocations() - allocations, 17u);
+    EXPECT_GE(AllocationCounter::allocated_bytes() - bytes, 16 * sizeof(int));
+
+    // Switched off, allocations go uncounted
+    AllocationCounter::disable();
+    allocations = AllocationCounter::allocations();
+    values.push_back(std::make_unique<int>(16));
+    EXPECT_EQ(AllocationCounter::allocations(), allocations);
+}
+
+TEST_F(RunMetricsTest, StageRecordsOnFinish) {
+    RunMetrics metrics;
+    {
+        RunMetrics::Stage stage(metrics, RunMetrics::Category::PHASE, "load");
+        stage.counters().rows_in = 1000;
+        stage.counters().bytes_read = 4096;
+        std::vector<std::string> strings(100, std::string(64, 'x'));
+        EXPECT_TRUE(metrics.phases().empty());
+    }
+
+    auto phases = metrics.phases();
+    ASSERT_EQ(phases.size(), 1u);
+    EXPECT_EQ(phases[0].name, "load");
+    EXPECT_EQ(phases[0].rows_in, 1000u);
+    EXPECT_EQ(phases[0].bytes_read, 4096u);
+    EXPECT_GE(phases[0].wall_seconds, 0.0);
+    EXPECT_GE(phases[0].cpu_seconds, 0.0);
+    EXPECT_GE(phases[0].allocations, 101u);
+    EXPECT_GT(phases[0].peak_rss_bytes, 0u);
+    EXPECT_TRUE(metrics.configs().empty());
+}
+
+TEST_F(RunMetricsTest, FinishIsIdempotent) {
+    RunMetrics metrics;
+    {
+        RunMetrics::Stage stage(metrics, RunMetrics::Category::CONFIG, "report");
+        stage.finish();
+        stage.finish();
+    }
+    EXPECT_EQ(metrics.configs().size(), 1u);
+}
+
+TEST_F(RunMetricsTest, Rates) {
+    StageMetrics stage;
+    stage.wall_seconds = 2.0;
+    stage.rows_out = 500;
+    stage.bytes_read = 3000000;
+    stage.bytes_written = 1000000;
+    EXPECT_DOUBLE_EQ(stage.rows_per_second(), 250.0);
+    EXPECT_DOUBLE_EQ(stage.mb_per_second(), 2.0);
+
+    stage.rows_in = 1000;
+    EXPECT_DOUBLE_EQ(stage.rows_per_second(), 500.0);
+
+    stage.wall_seconds = 0.0;
+    EXPECT_DOUBLE_EQ(stage.rows_per_second(), 0.0);
+}
+
+TEST_F(RunMetricsTest, TotalsSumPhases) {
+    RunMetrics metrics;
+    StageMetrics load;
+    load.name = "load";
+    load.bytes_read = 100;
+    load.rows_in = 10;
+    metrics.record(RunMetrics::Category::PHASE, load);
+
+    StageMetrics transform;
+    transform.name = "transform";
+    transform.bytes_written = 50;
+    transform.rows_in = 10;
+    transform.rows_out = 4;
+    metrics.record(RunMetrics::Category::PHASE, transform);
+
+    // Configs roll up into the transform phase and are not counted again
+    metrics.record(RunMetrics::Category::CONFIG, transform);
+
+    auto totals = metrics.totals();
+    EXPECT_EQ(totals.bytes_read, 100u);
+    EXPECT_EQ(totals.bytes_written, 50u);
+    EXPECT_EQ(totals.rows_in, 20u);
+    EXPECT_EQ(totals.rows_out, 4u);
+}
+
+TEST_F(RunMetricsTest, WritesJsonReport) {
+    RunMetrics metrics;
+    StageMetrics config;
+    config.name = "sales \"q1\"";
+    config.rows_out = 7;
+    metrics.record(RunMetrics::Category::CONFIG, config);
+
+    auto path = test_dir / "metrics.json";
+    ASSERT_TRUE(metrics.write_json(path));
+
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string json = buffer.str();
+
+    EXPECT_NE(json.find("\"version\": 1"), std::string::npos);
+    EXPECT_NE(json.find("\"run\": {\"name\":\"run\""), std::string::npos);
+    EXPECT_NE(json.find("\"phases\": []"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"sales \\\"q1\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"rows_out\":7"), std::string::npos);
+    EXPECT_NE(json.find("\"peak_rss_bytes\":"), std::string::npos);
+    EXPECT_NE(json.find("\"allocations\":"), std::string::npos);
+}
+
+TEST_F(RunMetricsTest, WriteToInvalidPath) {
+    RunMetrics metrics;
+    EXPECT_FALSE(metrics.write_json("/invalid/nonexistent/path/metrics.json"));
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "memory_accounting.h"
+#include "string_compression.h"
+#include <string>
+#include <vector>
+
+class StringCompressionTest : public ::testing::Test {
+protected:
+    std::unique_ptr<PsvTable> createTable(size_t rows) {
+        const char* first_names[] = {"John", "Jane", "Robert", "Alice", "Margaret", "William"};
+        const char* streets[] = {"Main Street", "Oak Avenue", "Maple Drive", "Washington Boulevard"};
+        auto table = std::make_unique<PsvTable>();
+        table->name = "customers";
+        table->headers = {"id", "name", "address", "note"};
+        for (size_t i = 0; i < rows; ++i) {
+            PsvRecord record;
+            record.fields = {std::to_string(100000 + i),
+                             std::string(first_names[i % 6]) + " " + first_names[(i / 6) % 6] + "son",
+                             std::to_string(i % 900 + 1) + " " + streets[i % 4] + ", Springfield"};
+            // Short rows leave the last column empty
+            if (i % 3 != 0) {
+                record.fields.push_back(i % 2 ? "Preferred customer since 2019" : "");
+            }
+            table->records.push_back(std::move(record));
+        }
+        table->build_header_index();
+        return table;
+    }
+};
+
+TEST_F(StringCompressionTest, SymbolTableRoundTripsAndShortensText) {
+    std::vector<std::string> values = {"Washington Boulevard", "Washington Street", "Boulevard Saint-Michel",
+                                       "", "|\xff\x01 binary", "Street"};
+    std::vector<std::string_view> sample;
+    for (int copy = 0; copy < 50; ++copy) {
+        sample.insert(sample.end(), values.begin(), values.end());
+    }
+
+    SymbolTable table = SymbolTable::train(sample);
+    ASSERT_GT(table.size(), 0u);
+    EXPECT_LE(table.size(), SymbolTable::kMaxSymbols);
+
+    for (const auto& value : values) {
+        std::string code;
+        table.encode(value, code);
+        std::string decoded;
+        table.decode(code, decoded);
+        EXPECT_EQ(decoded, value);
+    }
+    std::string code;
+    table.encode("Washington Boulevard", code);
+    EXPECT_LT(code.size() * 2, std::string("Washington Boulevard").size());
+
+    // Bytes never seen in training are escaped
+    std::string unseen;
+    table.encode("~~", unseen);
+    std::string decoded;
+    table.decode(unseen, decoded);
+    EXPECT_EQ(decoded, "~~");
+}
+
+TEST_F(StringCompressionTest, EmptySymbolTableStoresValuesUnchanged) {
+    SymbolTable table = SymbolTable::train({});
+    EXPECT_EQ(table.size(), 0u);
+
+    std::string code;
+    table.encode("plain", code);
+    EXPECT_EQ(code, "plain");
+}
+
+TEST_F(StringCompressionTest, ColumnGivesRandomAccessAndComparesCompressed) {
+    auto table = createTable(1000);
+    auto column = CompressedColumn::compress(*table, 2);
+
+    ASSERT_EQ(column.size(), 1000u);
+    EXPECT_EQ(column.value(517), table->records[517].fields[2]);
+    EXPECT_EQ(column.value(0), "1 Main Street, Springfield");
+
+    std::string wanted = column.encode("3 Maple Drive, Springfield");
+    size_t matches = 0;
+    for (size_t row = 0; row < column.size(); ++row) {
+        if (column.equals(row, wanted)) {
+            EXPECT_EQ(table->records[row].fields[2], "3 Maple Drive, Springfield");
+            matches++;
+        }
+    }
+    EXPECT_EQ(matches, 2u);  // Rows 2 and 902
+    EXPECT_FALSE(column.equals(0, column.encode("1 Main Street")));
+}
+
+TEST_F(StringCompressionTest, ValuesSymbolsCannotShortenAreKeptPlain) {
+    auto table = std::make_unique<PsvTable>();
+    table->headers = {"flag"};
+    for (int i = 0; i < 100; ++i) {
+        table->records.push_back({{std::string(1, static_cast<char>('a' + i % 26))}});
+    }
+
+    auto column = CompressedColumn::compress(*table, 0);
+
+    EXPECT_EQ(column.symbols().size(), 0u);
+    EXPECT_EQ(column.code(3), "d");
+    EXPECT_EQ(column.value(27), "b");
+}
+
+TEST_F(StringCompressionTest, TableRoundTripsAndShrinks) {
+    auto table = createTable(5000);
+    table->source_file = "customers.psv";
+
+    auto compressed = CompressedTable::compress(*table);
+    auto restored = compressed->decompress();
+
+    EXPECT_EQ(compressed->name(), "customers");
+    EXPECT_EQ(compressed->row_count(), 5000u);
+    EXPECT_EQ(compressed->get_field(4, "name"), table->get_field(4, "name"));
+    EXPECT_EQ(compressed->get_field(4, "missing"), "");
+    EXPECT_EQ(compressed->get_field(5000, "name"), "");
+
+    EXPECT_EQ(restored->headers, table->headers);
+    EXPECT_EQ(restored->source_file, table->source_file);
+    ASSERT_EQ(restored->records.size(), table->records.size());
+    for (size_t row = 0; row < table->records.size(); ++row) {
+        ASSERT_EQ(restored->records[row].fields.size(), 4u);
+        for (const auto& header : table->headers) {
+            ASSERT_EQ(restored->get_field(row, header), table->get_field(row, header));
+        }
+    }
+
+    EXPECT_LT(compressed->bytes() * 2, MemoryAccounting::table_bytes(*table));
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include "table_cache.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+class TableCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "table_cache_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    void createFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream file(path);
+        file << content;
+        file.close();
+    }
+
+    FileInfo createInput(const std::string& name, size_t rows) {
+        std::string data;
+        for (size_t i = 0; i < rows; ++i) {
+            data += std::to_string(i) + "|name" + std::to_string(i) + "\n";
+        }
+        createFile(test_dir / (name + ".psv"), data);
+        createFile(test_dir / (name + "_Headers.psv"), "id|name");
+
+        FileInfo info;
+        info.path = test_dir / (name + ".psv");
+        info.headers_path = test_dir / (name + "_Headers.psv");
+        info.size_bytes = std::filesystem::file_size(info.path);
+        info.name_prefix = name;
+        return info;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(TableCacheTest, SecondRequestIsServedFromCache) {
+    TableCache cache;
+    FileInfo input = createInput("employees", 10);
+
+    auto first = cache.get_table(input);
+    auto second = cache.get_table(input);
+
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(second->records.size(), 10u);
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.tables, 1u);
+    EXPECT_GT(stats.bytes, 0u);
+}
+
+TEST_F(TableCacheTest, ChangedFileIsParsedAgain) {
+    TableCache cache;
+    FileInfo input = createInput("employees", 10);
+    auto before = cache.get_table(input);
+
+    input = createInput("employees", 25);
+    auto after = cache.get_table(input);
+
+    EXPECT_EQ(before->records.size(), 10u);
+    EXPECT_EQ(after->records.size(), 25u);
+    EXPECT_EQ(cache.stats().misses, 2u);
+    EXPECT_EQ(cache.stats().tables, 1u);
+}
+
+TEST_F(TableCacheTest, FailedLoadIsNotCached) {
+    TableCache cache;
+    FileInfo input = createInput("broken", 5);
+    std::filesystem::remove(input.headers_path);
+
+    EXPECT_THROW(cache.get_table(input), std::runtime_error);
+    EXPECT_EQ(cache.stats().tables, 0u);
+
+    createFile(input.headers_path, "id|name");
+    EXPECT_EQ(cache.get_table(input)->records.size(), 5u);
+}
+
+TEST_F(TableCacheTest, ConcurrentRequestsParseOnce) {
+    TableCache cache;
+    FileInfo input = createInput("large", 5000);
+
+    std::vector<std::shared_ptr<const PsvTable>> tables(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < tables.size(); ++t) {
+        threads.emplace_back([&, t]() { tables[t] = cache.get_table(input); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& table : tables) {
+        EXPECT_EQ(table.get(), tables[0].get());
+    }
+    EXPECT_EQ(cache.stats().misses, 1u);
+    EXPECT_EQ(cache.stats().hits, 3u);
+}
+
+TEST_F(TableCacheTest, TrimEvictsLeastRecentlyUsedTablesNotInUse) {
+    TableCache cache(1);
+    FileInfo a = createInput("a", 100);
+    FileInfo b = createInput("b", 100);
+    FileInfo c = createInput("c", 100);
+
+    cache.get_table(a);
+    cache.get_table(b);
+    auto held = cache.get_table(c);
+    cache.trim();
+
+    // Over budget, but c is still read by a job
+    EXPECT_EQ(cache.stats().tables, 1u);
+    EXPECT_EQ(cache.get_table(c).get(), held.get());
+
+    held.reset();
+    cache.trim();
+    EXPECT_EQ(cache.stats().tables, 0u);
+    EXPECT_EQ(cache.stats().bytes, 0u);
+}
+
+TEST_F(TableCacheTest, RulesAreParsedAgainAfterChange) {
+    TableCache cache;
+    OutputFileInfo config;
+    config.headers_path = test_dir / "report_Headers.psv";
+    config.rules_path = test_dir / "report_Rules.psv";
+    config.name_prefix = "report";
+    createFile(config.headers_path, "name");
+    createFile(config.rules_path, "FIELD|name|name|Copy");
+
+    auto first = cache.get_rules(config);
+    EXPECT_EQ(cache.get_rules(config).get(), first.get());
+    ASSERT_EQ(first->headers.size(), 1u);
+    EXPECT_EQ(first->rules.size(), 1u);
+
+    createFile(config.headers_path, "id|name");
+    auto second = cache.get_rules(config);
+    EXPECT_NE(second.get(), first.get());
+    EXPECT_EQ(second->headers.size(), 2u);
+}
+
+TEST_F(TableCacheTest, PartitionSetIsCachedAsOneTable) {
+    TableCache cache;
+    std::vector<FileInfo> parts = {createInput("p1", 3), createInput("p2", 4)};
+    for (size_t i = 0; i < parts.size(); ++i) {
+        parts[i].table_name = "sales";
+        parts[i].partition_values = {{"part", std::to_string(i + 1)}};
+    }
+
+    auto both = cache.get_table(parts);
+    auto again = cache.get_table(parts);
+    auto first_only = cache.get_table(std::vector<FileInfo>{parts[0]});
+
+    EXPECT_EQ(both.get(), again.get());
+    EXPECT_EQ(both->name, "sales");
+    ASSERT_EQ(both->records.size(), 7u);
+    EXPECT_EQ(both->get_field(6, "part"), "2");
+    // Another set of the same table's files is its own entry
+    EXPECT_EQ(first_only->records.size(), 3u);
+    EXPECT_EQ(cache.stats().misses, 2u);
+    EXPECT_EQ(cache.stats().tables, 2u);
+}
+
+TEST_F(TableCacheTest, CompressedEntriesAreSmallerAndShareOneExpandedCopy) {
+    FileInfo input = createInput("employees", 2000);
+    TableCache plain;
+    TableCache compressed(0, true);
+
+    auto original = plain.get_table(input);
+    auto first = compressed.get_table(input);
+    EXPECT_LT(compressed.stats().bytes * 2, plain.stats().bytes);
+
+    // Jobs running together read the same expanded copy
+    auto second = compressed.get_table(input);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(compressed.stats().hits, 1u);
+
+    // Once no job holds it, the next job expands the table again
+    first.reset();
+    second.reset();
+    auto third = compressed.get_table(input);
+    ASSERT_EQ(third->records.size(), original->records.size());
+    for (size_t row = 0; row < original->records.size(); ++row) {
+        ASSERT_EQ(third->records[row].fields, original->records[row].fields);
+    }
+    EXPECT_EQ(third->get_field(1999, "name"), "name1999");
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "table_loader.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+class TableLoaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "table_loader_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    void createFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream file(path);
+        file << content;
+        file.close();
+    }
+
+    FileInfo createInput(const std::string& name, size_t rows) {
+        std::string data;
+        for (size_t i = 0; i < rows; ++i) {
+            data += std::to_string(i) + "|name" + std::to_string(i) + "\n";
+        }
+        createFile(test_dir / (name + ".psv"), data);
+        createFile(test_dir / (name + "_Headers.psv"), "id|name");
+
+        FileInfo info;
+        info.path = test_dir / (name + ".psv");
+        info.headers_path = test_dir / (name + "_Headers.psv");
+        info.size_bytes = std::filesystem::file_size(info.path);
+        info.name_prefix = name;
+        return info;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(TableLoaderTest, LoadsEveryTableAndReportsCompletionOnce) {
+    Database database;
+    std::atomic<int> finished{0};
+    {
+        TableLoader loader(database, {createInput("large", 500), createInput("small", 2), createInput("medium", 50)},
+                           2, [&finished]() { finished++; });
+        loader.wait_all();
+
+        EXPECT_TRUE(loader.ready({"large", "small", "medium"}));
+    }
+
+    EXPECT_EQ(finished.load(), 1);
+    ASSERT_NE(database.get_table("large"), nullptr);
+    EXPECT_EQ(database.get_table("large")->records.size(), 500u);
+    EXPECT_EQ(database.get_table("small")->records.size(), 2u);
+    EXPECT_EQ(database.get_table("medium")->records.size(), 50u);
+}
+
+TEST_F(TableLoaderTest, WaitForReturnsWithOwnTablesLoaded) {
+    Database database;
+    TableLoader loader(database, {createInput("large", 2000), createInput("small", 3)}, 1);
+
+    loader.wait_for({"small"});
+
+    ASSERT_NE(database.get_table("small"), nullptr);
+    EXPECT_EQ(database.get_table("small")->records.size(), 3u);
+    loader.wait_all();
+}
+
+TEST_F(TableLoaderTest, TablesNotGivenCountAsReady) {
+    Database database;
+    TableLoader loader(database, {createInput("employees", 10)}, 1);
+
+    // A static config reads no table, so it is ready even before any load finishes;
+    // a table loaded elsewhere is not waited for
+    EXPECT_EQ(loader.wait_for_any({{}, {"employees"}}), 0u);
+    EXPECT_TRUE(loader.ready({"departments"}));
+    loader.wait_all();
+}
+
+TEST_F(TableLoaderTest, WaitForAnyPrefersEarliestReadyCandidate) {
+    Database database;
+    TableLoader loader(database, {createInput("a", 5), createInput("b", 5)}, 2);
+    loader.wait_all();
+
+    EXPECT_EQ(loader.wait_for_any({{"a", "b"}, {"b"}}), 0u);
+}
+
+TEST_F(TableLoaderTest, LoadErrorIsRethrownToWaiters) {
+    FileInfo missing_headers = createInput("broken", 5);
+    std::filesystem::remove(missing_headers.headers_path);
+
+    Database database;
+    bool finished = false;
+    TableLoader loader(database, {missing_headers}, 1, [&finished]() { finished = true; });
+
+    EXPECT_THROW(loader.wait_for({"broken"}), std::runtime_error);
+    EXPECT_THROW(loader.wait_all(), std::runtime_error);
+    EXPECT_FALSE(finished);
+}
+
+TEST_F(TableLoaderTest, EmptyFileListIsFinishedImmediately) {
+    Database database;
+    bool finished = false;
+    TableLoader loader(database, {}, 4, [&finished]() { finished = true; });
+
+    EXPECT_TRUE(finished);
+    loader.wait_all();
+    EXPECT_EQ(loader.wait_for_any({{"anything"}}), 0u);
+}
+
+TEST_F(TableLoaderTest, DestroyWithoutWaiting) {
+    Database database;
+    {
+        TableLoader loader(database, {createInput("a", 100), createInput("b", 100), createInput("c", 100)}, 1);
+    }
+    // Whatever was loaded before destruction is complete; nothing is half-inserted
+    for (const auto& name : database.get_table_names()) {
+        EXPECT_EQ(database.get_table(name)->records.size(), 100u);
+    }
+}
+
+TEST_F(TableLoaderTest, PartitionsBecomeOneTableInPathOrder) {
+    std::filesystem::create_directories(test_dir / "sales");
+    createFile(test_dir / "sales" / "_Headers.psv", "id|amount");
+    std::vector<FileInfo> files;
+    // The largest partition sorts first by path but loads last
+    for (const auto& part : std::vector<std::pair<std::string, size_t>>{{"a", 300}, {"b", 1}, {"c", 20}}) {
+        std::string data;
+        for (size_t i = 0; i < part.second; ++i) {
+            data += part.first + std::to_string(i) + "|" + std::to_string(i) + "\n";
+        }
+        createFile(test_dir / "sales" / (part.first + ".psv"), data);
+        FileInfo info;
+        info.path = test_dir / "sales" / (part.first + ".psv");
+        info.headers_path = test_dir / "sales" / "_Headers.psv";
+        info.size_bytes = std::filesystem::file_size(info.path);
+        info.name_prefix = part.first;
+        info.table_name = "sales";
+        info.partition_values = {{"part", part.first}};
+        files.push_back(info);
+    }
+    
+    Database database;
+    TableLoader loader(database, files, 3);
+    loader.wait_for({"sales"});
+    
+    const PsvTable* table = database.get_table("sales");
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(database.get_table_names(), std::vector<std::string>{"sales"});
+    EXPECT_EQ(table->headers, (std::vector<std::string>{"id", "amount", "part"}));
+    ASSERT_EQ(table->records.size(), 321u);
+    EXPECT_EQ(table->records[0].fields, (std::vector<std::string>{"a0", "0", "a"}));
+    EXPECT_EQ(table->records[300].fields, (std::vector<std::string>{"b0", "0", "b"}));
+    EXPECT_EQ(table->get_field(320, "part"), "c");
+}
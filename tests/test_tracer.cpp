@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "tracer.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+class TracerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "tracer_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        Tracer::disable();
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    static size_t countOccurrences(const std::string& text, const std::string& pattern) {
+        size_t count = 0;
+        for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+            count++;
+        }
+        return count;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(TracerTest, DisabledSpansRecordNothing) {
+    Tracer::enable();
+    Tracer::disable();
+    {
+        TraceSpan span("parse", "parse ignored.psv");
+    }
+
+    std::string json = Tracer::to_json();
+    EXPECT_EQ(json.find("ignored.psv"), std::string::npos);
+}
+
+TEST_F(TracerTest, RecordsCompleteEvents) {
+    Tracer::enable();
+    {
+        TraceSpan outer("phase", "load");
+        TraceSpan inner("parse", std::string("parse employees.psv"));
+    }
+    Tracer::disable();
+
+    std::string json = Tracer::to_json();
+    EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("{\"name\":\"load\",\"cat\":\"phase\",\"ph\":\"X\",\"ts\":"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"parse employees.psv\",\"cat\":\"parse\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"name\":\"main\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"dropped_events\":0"), std::string::npos);
+}
+
+TEST_F(TracerTest, EachThreadGetsItsOwnBuffer) {
+    Tracer::enable();
+    std::atomic<int> started{0};
+    std::vector<std::future<void>> workers;
+    for (int i = 0; i < 4; ++i) {
+        workers.push_back(std::async(std::launch::async, [i, &started]() {
+            {
+                TraceSpan span("load", "load file" + std::to_string(i));
+            }
+            // Stay alive until every worker has its buffer
+            started++;
+            while (started < 4) {
+                std::this_thread::yield();
+            }
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    Tracer::disable();
+
+    std::string json = Tracer::to_json();
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_NE(json.find("load file" + std::to_string(i)), std::string::npos);
+    }
+    // Main thread plus one buffer per worker thread
+    EXPECT_EQ(countOccurrences(json, "\"thread_name\""), 5u);
+}
+
+TEST_F(TracerTest, ExitedThreadsHandTheirBufferOn) {
+    Tracer::enable();
+    // One short-lived thread per chunk, as the JSONL and XLSX writers start them
+    for (int chunk = 0; chunk < 200; ++chunk) {
+        std::async(std::launch::async, [chunk]() {
+            TraceSpan span("write", "write chunk" + std::to_string(chunk));
+        }).get();
+    }
+    Tracer::disable();
+
+    // Main thread plus one ring shared by the workers in turn, keeping all their events
+    EXPECT_EQ(Tracer::thread_buffers(), 2u);
+    std::string json = Tracer::to_json();
+    EXPECT_NE(json.find("write chunk0"), std::string::npos);
+    EXPECT_NE(json.find("write chunk199"), std::string::npos);
+    EXPECT_EQ(countOccurrences(json, "\"thread_name\""), 2u);
+}
+
+TEST_F(TracerTest, FullRingDropsOldestEvents) {
+    Tracer::enable(4);
+    for (int i = 0; i < 10; ++i) {
+        Tracer::record("filter", ("span " + std::to_string(i)).c_str(), i * 1000, i * 1000 + 500);
+    }
+    Tracer::disable();
+
+    EXPECT_EQ(Tracer::dropped_events(), 6u);
+    std::string json = Tracer::to_json();
+    EXPECT_EQ(json.find("\"span 5\""), std::string::npos);
+    EXPECT_NE(json.find("\"span 6\""), std::string::npos);
+    EXPECT_NE(json.find("\"span 9\",\"cat\":\"filter\",\"ph\":\"X\",\"ts\":9.000,\"dur\":0.500"), std::string::npos);
+    EXPECT_NE(json.find("\"dropped_events\":6"), std::string::npos);
+}
+
+TEST_F(TracerTest, LongNamesAreTruncated) {
+    Tracer::enable();
+    std::string long_name(200, 'x');
+    {
+        TraceSpan span("write", long_name);
+    }
+    Tracer::disable();
+
+    std::string json = Tracer::to_json();
+    EXPECT_NE(json.find("\"" + std::string(TraceEvent::kNameSize - 1, 'x') + "\""), std::string::npos);
+    EXPECT_EQ(json.find(std::string(TraceEvent::kNameSize, 'x')), std::string::npos);
+}
+
+TEST_F(TracerTest, WritesTraceFile) {
+    Tracer::enable();
+    {
+        TraceSpan span("join", "join a x b");
+    }
+    Tracer::disable();
+
+    auto path = test_dir / "trace.json";
+    ASSERT_TRUE(Tracer::write_json(path));
+
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    EXPECT_NE(buffer.str().find("join a x b"), std::string::npos);
+}
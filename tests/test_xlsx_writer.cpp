@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include "xlsx_writer.h"
+#include "zip_writer.h"
+#include "query_engine.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+class XlsxWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_dir = std::filesystem::temp_directory_path() / "xlsx_writer_tests";
+        std::filesystem::create_directories(test_dir);
+    }
+
+    void TearDown() override {
+        if (std::filesystem::exists(test_dir)) {
+            std::filesystem::remove_all(test_dir);
+        }
+    }
+
+    static uint32_t u32(const std::string& data, size_t pos) {
+        uint32_t value;
+        std::memcpy(&value, data.data() + pos, 4);
+        return value;
+    }
+
+    static uint16_t u16(const std::string& data, size_t pos) {
+        uint16_t value;
+        std::memcpy(&value, data.data() + pos, 2);
+        return value;
+    }
+
+    // Extract every entry of a stored ZIP via its central directory, checking each CRC
+    std::map<std::string, std::string> readArchive(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string data = buffer.str();
+
+        std::map<std::string, std::string> entries;
+        EXPECT_GE(data.size(), 22u);
+        if (data.size() < 22) return entries;
+
+        size_t eocd = data.size() - 22;
+        EXPECT_EQ(u32(data, eocd), 0x06054b50u);
+        size_t count = u16(data, eocd + 10);
+        size_t pos = u32(data, eocd + 16);
+        EXPECT_EQ(pos + u32(data, eocd + 12), eocd);
+
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(u32(data, pos), 0x02014b50u);
+            uint32_t crc = u32(data, pos + 16);
+            uint32_t size = u32(data, pos + 24);
+            size_t name_length = u16(data, pos + 28);
+            size_t local = u32(data, pos + 42);
+            std::string name = data.substr(pos + 46, name_length);
+
+            // The local header must carry the same (patched) CRC and size
+            EXPECT_EQ(u32(data, local), 0x04034b50u);
+            EXPECT_EQ(u32(data, local + 14), crc) << name;
+            EXPECT_EQ(u32(data, local + 22), size) << name;
+
+            std::string content = data.substr(local + 30 + u16(data, local + 26), size);
+            EXPECT_EQ(ZipWriter::crc32(0, content.data(), content.size()), crc) << name;
+            entries[name] = content;
+            pos += 46 + name_length;
+        }
+        return entries;
+    }
+
+    std::unique_ptr<QueryResult> createTestResult() {
+        auto result = std::make_unique<QueryResult>();
+        result->headers = {"emp_id", "badge", "salary", "department", "name"};
+        result->rows = {
+            {"1001", "007", "85000.5", "Engineering", "John Doe"},
+            {"1002", "012", "75000", "Engineering", "Jane & Smith"},
+            {"1003", "100", "", "Management", "Bob <Johnson>"},
+            {"1004", "101", "-120.25", "Engineering", "Alice Brown"}
+        };
+        return result;
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(XlsxWriterTest, Crc32MatchesReferenceValue) {
+    const char* text = "123456789";
+    EXPECT_EQ(ZipWriter::crc32(0, text, 9), 0xCBF43926u);
+
+    // Incremental updates give the same result as one pass
+    uint32_t crc = ZipWriter::crc32(0, text, 4);
+    EXPECT_EQ(ZipWriter::crc32(crc, text + 4, 5), 0xCBF43926u);
+}
+
+TEST_F(XlsxWriterTest, ColumnNames) {
+    EXPECT_EQ(XlsxWriter::column_name(0), "A");
+    EXPECT_EQ(XlsxWriter::column_name(25), "Z");
+    EXPECT_EQ(XlsxWriter::column_name(26), "AA");
+    EXPECT_EQ(XlsxWriter::column_name(701), "ZZ");
+    EXPECT_EQ(XlsxWriter::column_name(16383), "XFD");
+}
+
+TEST_F(XlsxWriterTest, WritesWorkbookParts) {
+    auto result = createTestResult();
+    auto path = test_dir / "report.xlsx";
+    ASSERT_TRUE(XlsxWriter::write_xlsx(*result, path));
+
+    auto entries = readArchive(path);
+    EXPECT_TRUE(entries.count("[Content_Types].xml"));
+    EXPECT_TRUE(entries.count("_rels/.rels"));
+    EXPECT_TRUE(entries.count("xl/workbook.xml"));
+    EXPECT_TRUE(entries.count("xl/_rels/workbook.xml.rels"));
+    ASSERT_TRUE(entries.count("xl/worksheets/sheet1.xml"));
+    ASSERT_TRUE(entries.count("xl/sharedStrings.xml"));
+
+    const std::string& sheet = entries["xl/worksheets/sheet1.xml"];
+    EXPECT_NE(sheet.find("<row r=\"1\"><c r=\"A1\" t=\"inlineStr\"><is><t>emp_id</t></is></c>"), std::string::npos);
+    EXPECT_NE(sheet.find("</sheetData></worksheet>"), std::string::npos);
+}
+
+TEST_F(XlsxWriterTest, TypedCells) {
+    auto result = createTestResult();
+    auto path = test_dir / "typed.xlsx";
+    ASSERT_TRUE(XlsxWriter::write_xlsx(*result, path));
+
+    const std::string sheet = readArchive(path)["xl/worksheets/sheet1.xml"];
+
+    // Integers and decimals are numeric cells
+    EXPECT_NE(sheet.find("<c r=\"A2\"><v>1001</v></c>"), std::string::npos);
+    EXPECT_NE(sheet.find("<c r=\"C2\"><v>85000.5</v></c>"), std::string::npos);
+    // Leading zeros keep the badge column as text
+    EXPECT_NE(sheet.find("<c r=\"B2\" t=\"inlineStr\"><is><t>007</t></is></c>"), std::string::npos);
+    // Empty values produce no cell
+    EXPECT_EQ(sheet.find("r=\"C4\""), std::string::npos);
+    // Markup characters are escaped
+    EXPECT_NE(sheet.find("Jane &amp; Smith"), std::string::npos);
+    EXPECT_NE(sheet.find("Bob &lt;Johnson&gt;"), std::string::npos);
+}
+
+TEST_F(XlsxWriterTest, SharedStringsOnlyForRepetitiveColumns) {
+    auto result = createTestResult();
+    auto path = test_dir / "shared.xlsx";
+    ASSERT_TRUE(XlsxWriter::write_xlsx(*result, path));
+
+    auto entries = readArchive(path);
+    const std::string& sheet = entries["xl/worksheets/sheet1.xml"];
+    const std::string& shared = entries["xl/sharedStrings.xml"];
+
+    EXPECT_NE(shared.find("count=\"4\" uniqueCount=\"2\""), std::string::npos);
+    EXPECT_NE(shared.find("<si><t>Engineering</t></si><si><t>Management</t></si>"), std::string::npos);
+    EXPECT_NE(sheet.find("<c r=\"D2\" t=\"s\"><v>0</v></c>"), std::string::npos);
+    EXPECT_NE(sheet.find("<c r=\"D4\" t=\"s\"><v>1</v></c>"), std::string::npos);
+
+    // Names are unique, so they stay inline
+    EXPECT_EQ(shared.find("John Doe"), std::string::npos);
+    EXPECT_NE(sheet.find("<c r=\"E2\" t=\"inlineStr\"><is><t>John Doe</t></is></c>"), std::string::npos);
+}
+
+TEST_F(XlsxWriterTest, LongNumbersStayText) {
+    QueryResult result;
+    result.headers = {"account"};
+    result.rows = {{"1234567890123456"}, {"42"}};
+
+    auto path = test_dir / "precision.xlsx";
+    ASSERT_TRUE(XlsxWriter::write_xlsx(result, path));
+
+    const std::string sheet = readArchive(path)["xl/worksheets/sheet1.xml"];
+    EXPECT_NE(sheet.find("<is><t>1234567890123456</t></is>"), std::string::npos);
+    EXPECT_NE(sheet.find("<is><t>42</t></is>"), std::string::npos);
+}
+
+TEST_F(XlsxWriterTest, EscapesXmlText) {
+    std::string out;
+    XlsxWriter::append_xml_escaped(out, std::string("a<b>&c\r\n\td\x01" "e", 13));
+    EXPECT_EQ(out, "a&lt;b&gt;&amp;c&#13;\n\tde");
+}
+
+TEST_F(XlsxWriterTest, SplitsRowsAcrossSheetsAndChunks) {
+    QueryResult result;
+    result.headers = {"id", "label"};
+    for (int i = 0; i < 25; ++i) {
+        result.rows.push_back({std::to_string(i), "row " + std::to_string(i)});
+    }
+
+    auto path = test_dir / "sheets.xlsx";
+    ASSERT_TRUE(XlsxWriter::write_xlsx(result, path, 10, 3));
+
+    auto entries = readArchive(path);
+    ASSERT_TRUE(entries.count("xl/worksheets/sheet3.xml"));
+    EXPECT_FALSE(entries.count("xl/worksheets/sheet4.xml"));
+    EXPECT_NE(entries["xl/workbook.xml"].find("<sheet name=\"Sheet3\" sheetId=\"3\" r:id=\"rId3\"/>"), std::string::npos);
+
+    // Every sheet restarts after its own header row, rows stay in order across chunks
+    const std::string& second = entries["xl/worksheets/sheet2.xml"];
+    EXPECT_NE(second.find("<c r=\"A1\" t=\"inlineStr\"><is><t>id</t></is></c>"), std::string::npos);
+    EXPECT_NE(second.find("<row r=\"2\"><c r=\"A2\"><v>10</v></c>"), std::string::npos);
+    EXPECT_LT(second.find("<v>13</v>"), second.find("<v>14</v>"));
+    EXPECT_NE(second.find("<row r=\"11\"><c r=\"A11\"><v>19</v></c>"), std::string::npos);
+    EXPECT_EQ(second.find("<v>20</v>"), std::string::npos);
+}
+
+TEST_F(XlsxWriterTest, WriteSelectedRows) {
+    auto result = createTestResult();
+    auto path = test_dir / "subset.xlsx";
+    ASSERT_TRUE(XlsxWriter::write_xlsx_rows(*result, {3, 0}, path));
+
+    const std::string sheet = readArchive(path)["xl/worksheets/sheet1.xml"];
+    EXPECT_NE(sheet.find("<c r=\"A2\"><v>1004</v></c>"), std::string::npos);
+    EXPECT_NE(sheet.find("<c r=\"A3\"><v>1001</v></c>"), std::string::npos);
+    EXPECT_EQ(sheet.find("1002"), std::string::npos);
+}
+
+TEST_F(XlsxWriterTest, WriteToInvalidPath) {
+    auto result = createTestResult();
+    EXPECT_FALSE(XlsxWriter::write_xlsx(*result, "/invalid/nonexistent/path/output.xlsx"));
+}